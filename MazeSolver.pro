@@ -4,21 +4,88 @@
 #
 #-------------------------------------------------
 
-QT       += core gui widgets
+QT       += core gui widgets concurrent network
 
 TARGET = MazeSolver
 TEMPLATE = app
+CONFIG   += c++11
+
+# Timeline tracing of the solver, the event handlers and painting: qmake CONFIG+=timeline
+timeline {
+    DEFINES += MAZESOLVER_TIMELINE
+}
 
 SOURCES += main.cpp\
         mainwindow.cpp \
     mazenode.cpp \
+    mazenodearena.cpp \
     mazeui.cpp \
-    msolver.cpp
+    msolver.cpp \
+    mazekernels.cpp \
+    searchstepper.cpp \
+    searchtrace.cpp \
+    mazefile.cpp \
+    mazegrid.cpp \
+    layoutbenchmark.cpp \
+    batchsolver.cpp \
+    latencyhistogram.cpp \
+    mazeservice.cpp \
+    mazeclient.cpp \
+    boundedsearch.cpp \
+    anytimesearch.cpp \
+    encodedpath.cpp \
+    logview.cpp \
+    landmarktable.cpp \
+    mazeimage.cpp \
+    rectanglesearch.cpp \
+    mazeeditor.cpp \
+    searchcheckpoint.cpp \
+    shardedsearch.cpp \
+    mazefuzzer.cpp \
+    solverrace.cpp \
+    racewindow.cpp \
+    mazeanalytics.cpp \
+    framerenderer.cpp \
+    opendirectiontable.cpp \
+    layeredmaze.cpp \
+    solvecache.cpp \
+    timelinetrace.cpp
 
 HEADERS  += mainwindow.h \
     mazenode.h \
+    mazenodearena.h \
     mazeui.h \
-    msolver.h
+    msolver.h \
+    mazekernels.h \
+    searchstepper.h \
+    searchcontrol.h \
+    searchtrace.h \
+    mazefile.h \
+    mazegrid.h \
+    layoutbenchmark.h \
+    batchsolver.h \
+    latencyhistogram.h \
+    mazeservice.h \
+    mazeclient.h \
+    boundedsearch.h \
+    anytimesearch.h \
+    encodedpath.h \
+    logview.h \
+    landmarktable.h \
+    mazeimage.h \
+    rectanglesearch.h \
+    mazeeditor.h \
+    searchcheckpoint.h \
+    shardedsearch.h \
+    mazefuzzer.h \
+    solverrace.h \
+    racewindow.h \
+    mazeanalytics.h \
+    framerenderer.h \
+    opendirectiontable.h \
+    layeredmaze.h \
+    solvecache.h \
+    timelinetrace.h
 OTHER_FILES += Doxyfile \
             README.md
 
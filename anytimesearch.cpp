@@ -0,0 +1,324 @@
+#include "anytimesearch.h"
+#include "timelinetrace.h"
+
+#include <algorithm>
+
+/// Expansions between two looks at the clock, small enough to stay within a few microseconds
+static const int deadlineInterval = 32;
+/// Cost of cells that haven't been reached
+static const int unreached = 0x7fffffff;
+
+/// Cells per chunk of the state table
+static const int chunkShift = 8;
+
+/// The search state of one cell
+struct CellState
+{
+    int g; ///< Cost of the cheapest path found
+    int parent; ///< Storage index of the cell before, -1 for none
+    int closed; ///< Iteration that expanded the cell
+    int inconsistent; ///< Iteration that put the cell on the inconsistent list
+};
+
+/// An entry of the open list, stale once the cell got a lower cost or has been expanded
+struct OpenEntry
+{
+    double key; ///< Cost plus the weighted estimate
+    int g; ///< Cost when the entry was pushed
+    int index; ///< Storage index
+};
+
+/// Orders the heap by the smallest key first, deeper cells first among equal keys
+static bool laterEntry(const OpenEntry &a, const OpenEntry &b)
+{
+    return a.key > b.key || (a.key == b.key && a.g < b.g);
+}
+
+/**
+ * @brief The state of one ARA* run, kept across the searches with decreasing weights
+ */
+class AnytimeState
+{
+public:
+    AnytimeState(const AnytimeSearch::Request &searchRequest, SearchControl *searchControl, AnytimeSearch::Result &searchResult) :
+        request(searchRequest), grid(searchRequest.grid), control(searchControl), result(searchResult), iteration(1)
+    {
+        // The table is filled in chunks as the search reaches them, so setting up the
+        // search doesn't take time in proportion to the maze
+        chunks = QVector<CellState*>((grid.getStorageSize() >> chunkShift) + 1, 0);
+        columns = grid.getColumns();
+        goalRow = request.goal / columns;
+        goalColumn = request.goal % columns;
+        if(request.landmarks != 0){
+            goalDistances = request.landmarks->distancesOf(request.goal);
+        }
+    }
+
+    ~AnytimeState()
+    {
+        foreach(CellState *chunk, chunks){
+            delete[] chunk;
+        }
+    }
+
+    /// Gets the state of a cell, setting up its chunk on first use
+    CellState &cell(int index)
+    {
+        CellState *&chunk = chunks[index >> chunkShift];
+        if(chunk == 0){
+            chunk = new CellState[1 << chunkShift];
+            for(int ii = 0; ii < (1 << chunkShift); ii++){
+                chunk[ii].g = unreached;
+                chunk[ii].parent = -1;
+                chunk[ii].closed = 0;
+                chunk[ii].inconsistent = 0;
+            }
+        }
+        return chunk[index & ((1 << chunkShift) - 1)];
+    }
+
+    /// True once the deadline has passed, remembered for the result
+    bool expired()
+    {
+        if(request.clock.nsecsElapsed() / 1000 >= request.deadlineUs){
+            result.deadlineReached = true;
+        }
+        return result.deadlineReached;
+    }
+
+    /// Manhattan distance from a cell to the goal, or the landmark bound if that's larger
+    int estimate(int index) const
+    {
+        int id = grid.idOf(index);
+        int manhattan = qAbs(id / columns - goalRow) + qAbs(id % columns - goalColumn);
+        if(request.landmarks == 0){
+            return manhattan;
+        }
+        return qMax(manhattan, request.landmarks->estimate(id, goalDistances));
+    }
+
+    void push(int index, double weight)
+    {
+        OpenEntry entry;
+        entry.g = cell(index).g;
+        entry.key = entry.g + weight * estimate(index);
+        entry.index = index;
+        open.append(entry);
+        std::push_heap(open.begin(), open.end(), laterEntry);
+    }
+
+    bool isStale(const OpenEntry &entry)
+    {
+        const CellState &state = cell(entry.index);
+        return entry.g != state.g || state.closed == iteration;
+    }
+
+    /**
+     * @brief Expands cells until none on the open list can lead to a cheaper path to the goal
+     * @return False if the deadline or a cancel request stopped it
+     */
+    bool improvePath(int goalIndex, double weight)
+    {
+        const CellState &goal = cell(goalIndex);
+        while(!open.isEmpty() && goal.g > open.first().key){
+            OpenEntry top = open.first();
+            std::pop_heap(open.begin(), open.end(), laterEntry);
+            open.removeLast();
+            if(isStale(top)){
+                continue;
+            }
+            cell(top.index).closed = iteration;
+
+            result.expanded++;
+            if(result.expanded % deadlineInterval == 0 && expired()){
+                return false;
+            }
+            if(control != 0 && result.expanded % SearchControl::PollInterval == 0
+                    && control->poll(int(qMin(result.expanded, qint64(unreached))), open.size())){
+                result.cancelled = true;
+                return false;
+            }
+
+            int cost = top.g + 1;
+            for(int direction = 0; direction < 4; direction++){
+                int next = grid.neighbour(top.index, direction);
+                if(grid.isWall(next)){
+                    continue;
+                }
+                CellState &state = cell(next);
+                if(cost >= state.g){
+                    continue;
+                }
+                state.g = cost;
+                state.parent = top.index;
+                if(state.closed == iteration){
+                    // Expanded in this search already, it's picked up again by the next one
+                    if(state.inconsistent != iteration){
+                        state.inconsistent = iteration;
+                        inconsistentCells.append(next);
+                    }
+                }
+                else{
+                    push(next, weight);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Gets the smallest unweighted cost estimate of the cells left to search
+     * @param lowest Receives the estimate, unreached if there are none
+     * @return False if the deadline passed while scanning
+     */
+    bool lowestEstimate(int &lowest)
+    {
+        lowest = unreached;
+        for(int ii = 0; ii < open.size(); ii++){
+            if(ii % 1024 == 1023 && expired()){
+                return false;
+            }
+            if(!isStale(open.at(ii))){
+                lowest = qMin(lowest, open.at(ii).g + estimate(open.at(ii).index));
+            }
+        }
+        foreach(int index, inconsistentCells){
+            lowest = qMin(lowest, cell(index).g + estimate(index));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Starts the next search: the inconsistent cells join the open list and all keys
+     * are recomputed with the new weight
+     * @return False if the deadline passed while rebuilding
+     */
+    bool reopen(double weight)
+    {
+        QVector<OpenEntry> previous;
+        previous.swap(open);
+        iteration++;
+        for(int ii = 0; ii < previous.size(); ii++){
+            if(ii % 1024 == 1023 && expired()){
+                return false;
+            }
+            const OpenEntry &entry = previous.at(ii);
+            const CellState &state = cell(entry.index);
+            if(entry.g == state.g && state.closed != iteration - 1){
+                push(entry.index, weight);
+            }
+        }
+        foreach(int index, inconsistentCells){
+            push(index, weight);
+        }
+        inconsistentCells.clear();
+        return !expired();
+    }
+
+    /// Follows the parents back from the goal
+    QVector<int> tracePath(int goalIndex)
+    {
+        QVector<int> reversed;
+        for(int index = goalIndex; index != -1; index = cell(index).parent){
+            reversed.append(grid.idOf(index));
+        }
+        QVector<int> path;
+        path.reserve(reversed.size());
+        for(int ii = reversed.size() - 1; ii >= 0; ii--){
+            path.append(reversed.at(ii));
+        }
+        return path;
+    }
+
+    const AnytimeSearch::Request &request;
+    const MazeGrid &grid;
+    SearchControl *control;
+    AnytimeSearch::Result &result;
+    int columns;
+    int goalRow;
+    int goalColumn;
+    QVector<int> goalDistances; ///< Distances of the goal to the landmarks
+    int iteration; ///< Stamps the cells closed and made inconsistent by the current search
+    QVector<CellState*> chunks; ///< The state of every cell, in chunks of 1 << chunkShift cells
+    QVector<int> inconsistentCells; ///< Cells whose cost dropped after they were expanded
+    QVector<OpenEntry> open; ///< Binary heap, may hold stale entries
+};
+
+/**
+ * @brief Constructor for the anytime search
+ * @param parent The parent for reference purposes
+ */
+AnytimeSearch::AnytimeSearch(QObject *parent) :
+    QObject(parent)
+{
+}
+
+/**
+ * @brief Runs ARA* until the path is optimal, the search is cancelled or the deadline passes.
+ * The clock is looked at every few expansions and while the open list is rebuilt, so the
+ * search returns within microseconds of the deadline with the best path found until then.
+ * @param request The maze, the cells and the deadline
+ * @param control Polled for cancellation and fed with progress, may be 0
+ * @return The best path and its bound
+ */
+AnytimeSearch::Result AnytimeSearch::run(const Request &request, SearchControl *control)
+{
+    TIMELINE_SCOPE("AnytimeSearch::run", "solver");
+    Result result;
+    const MazeGrid &grid = request.grid;
+    int cells = grid.getCellCount();
+    if(request.start < 0 || request.start >= cells || request.goal < 0 || request.goal >= cells
+            || grid.isWall(grid.indexOfId(request.start)) || grid.isWall(grid.indexOfId(request.goal))){
+        result.elapsedUs = request.clock.nsecsElapsed() / 1000;
+        return result;
+    }
+
+    AnytimeState state(request, control, result);
+    int startIndex = grid.indexOfId(request.start);
+    int goalIndex = grid.indexOfId(request.goal);
+    double weight = qMax(1.0, request.initialWeight);
+    int bestCost = unreached;
+    double bestBound = weight + 1;
+
+    state.cell(startIndex).g = 0;
+    state.push(startIndex, weight);
+    while(!state.expired()){
+        if(!state.improvePath(goalIndex, weight)){
+            break;
+        }
+        int cost = state.cell(goalIndex).g;
+        if(cost == unreached){
+            break; // The goal can't be reached
+        }
+
+        int lowest;
+        if(!state.lowestEstimate(lowest)){
+            break;
+        }
+        double bound = weight <= 1.0 || lowest <= 0 || lowest == unreached ? 1.0 : qBound(1.0, double(cost) / lowest, weight);
+        if(cost < bestCost || bound < bestBound){
+            bestCost = cost;
+            bestBound = bound;
+            result.found = true;
+            result.bound = bound;
+            result.path = state.tracePath(goalIndex);
+            result.solutions++;
+            emit improved(result.path, bound, request.clock.nsecsElapsed() / 1000);
+        }
+        if(bound <= 1.0){
+            result.optimal = true;
+            break;
+        }
+
+        weight = qMax(1.0, weight - request.weightStep);
+        if(!state.reopen(weight)){
+            break;
+        }
+    }
+
+    if(result.optimal){
+        result.deadlineReached = false;
+    }
+    result.elapsedUs = request.clock.nsecsElapsed() / 1000;
+    return result;
+}
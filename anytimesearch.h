@@ -0,0 +1,66 @@
+#ifndef ANYTIMESEARCH_H
+#define ANYTIMESEARCH_H
+
+#include <QObject>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include "mazegrid.h"
+#include "searchcontrol.h"
+#include "landmarktable.h"
+
+/**
+ * @brief Anytime repairing A* (ARA*) under a hard deadline.
+ * The first search runs with a heavily weighted Manhattan estimate and finds a path quickly.
+ * Each following search lowers the weight and reuses the costs found so far, only the cells
+ * whose cost went down are searched again, until the weight reaches 1 and the path is optimal
+ * or the deadline runs out. Every better path is published through improved() together with
+ * a bound on how much longer than the shortest path it can be. With a landmark table the
+ * estimate is the larger of the grid distance and the landmark bound.
+ *
+ * run() is meant to be called on a worker thread, improved() then reaches receivers in the
+ * thread of this object through a queued connection.
+ */
+class AnytimeSearch : public QObject
+{
+    Q_OBJECT
+public:
+    /// What to search and how long it may take
+    struct Request
+    {
+        Request() : start(0), goal(0), deadlineUs(0), initialWeight(3.0), weightStep(0.5), landmarks(0) {}
+        MazeGrid grid; ///< The maze, only read
+        int start; ///< Node id to start from
+        int goal; ///< Node id to reach
+        qint64 deadlineUs; ///< Time from the start of the clock until the search has to return
+        QElapsedTimer clock; ///< Started when the caller asked for the path
+        double initialWeight; ///< Weight of the estimate in the first search
+        double weightStep; ///< How much the weight drops between searches
+        const LandmarkTable *landmarks; ///< Distances to landmarks of this maze, may be 0
+    };
+
+    /// The outcome of an anytime search
+    struct Result
+    {
+        Result() : found(false), optimal(false), cancelled(false), deadlineReached(false), expanded(0),
+            solutions(0), bound(0), elapsedUs(0) {}
+        bool found; ///< True if a path has been found before the deadline
+        bool optimal; ///< True if the path is known to be a shortest one
+        bool cancelled; ///< True if the search stopped on a cancel request
+        bool deadlineReached; ///< True if the deadline stopped the refinement
+        qint64 expanded; ///< Cells expanded over all searches
+        int solutions; ///< Number of improvements published
+        double bound; ///< The path is at most this many times longer than the shortest one
+        qint64 elapsedUs; ///< Time on the clock when the search returned
+        QVector<int> path; ///< Node ids of the best path from the start to the goal
+    };
+
+    explicit AnytimeSearch(QObject *parent = 0);
+    Result run(const Request &request, SearchControl *control); ///< Searches until optimal, cancelled or out of time
+
+signals:
+    void improved(QVector<int> path, double bound, qint64 elapsedUs); ///< A better path or a tighter bound has been found
+
+};
+
+#endif // ANYTIMESEARCH_H
@@ -0,0 +1,232 @@
+#include "batchsolver.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QtConcurrentMap>
+
+/**
+ * @brief The search state of one worker thread. A cell counts as visited if its stamp is
+ * the current epoch, so starting the next query is an increment instead of a clear.
+ */
+struct QueryScratch
+{
+    QueryScratch() : epoch(0) {}
+    QVector<quint32> stamps; ///< Epoch in which each storage slot has been reached
+    QVector<quint8> parents; ///< Direction back to the parent, valid for stamped slots
+    QVector<int> queue;
+    quint32 epoch;
+};
+
+static QThreadStorage<QueryScratch*> scratchStorage;
+
+/**
+ * @brief Gets the scratch of the calling thread, ready for a query on a grid with the given
+ * number of storage slots
+ */
+static QueryScratch &localScratch(int storageSize)
+{
+    if(!scratchStorage.hasLocalData()){
+        scratchStorage.setLocalData(new QueryScratch);
+    }
+    QueryScratch &scratch = *scratchStorage.localData();
+
+    if(scratch.stamps.size() != storageSize){
+        scratch.stamps.fill(0, storageSize);
+        scratch.parents.resize(storageSize);
+        scratch.epoch = 0;
+    }
+
+    scratch.epoch++;
+    if(scratch.epoch == 0){
+        scratch.stamps.fill(0);
+        scratch.epoch = 1;
+    }
+    scratch.queue.clear();
+    return scratch;
+}
+
+/**
+ * @brief Answers the queries handed out by QtConcurrent
+ */
+struct QueryRunner
+{
+    typedef PathAnswer result_type;
+
+    explicit QueryRunner(const MazeGrid *mazeGrid) : grid(mazeGrid) {}
+    PathAnswer operator()(const PathQuery &query) const
+    {
+        return BatchSolver::answer(*grid, query);
+    }
+
+    const MazeGrid *grid;
+};
+
+/**
+ * @brief Creates a batch solver for a maze
+ * @param mazeGrid The maze, only read. It has to stay unchanged while queries run.
+ */
+BatchSolver::BatchSolver(const MazeGrid *mazeGrid)
+{
+    grid = mazeGrid;
+}
+
+/**
+ * @brief Answers all queries on the global thread pool and waits for them
+ * @param queries The queries
+ * @return One answer per query, in the same order
+ */
+QVector<PathAnswer> BatchSolver::solve(const QVector<PathQuery> &queries) const
+{
+    return QtConcurrent::blockingMapped<QVector<PathAnswer> >(queries, QueryRunner(grid));
+}
+
+/**
+ * @brief Answers all queries on the global thread pool without waiting
+ * @param queries The queries
+ * @return A future with one answer per query, in the same order
+ */
+QFuture<PathAnswer> BatchSolver::start(const QVector<PathQuery> &queries) const
+{
+    return QtConcurrent::mapped(queries, QueryRunner(grid));
+}
+
+/**
+ * @brief Answers one query with a breadth first search. The grid is only read, all search
+ * state is in the scratch of the calling thread.
+ * @param grid The maze
+ * @param query The start and the goal
+ * @return The shortest path, if there is one
+ */
+PathAnswer BatchSolver::answer(const MazeGrid &grid, const PathQuery &query)
+{
+    PathAnswer result;
+    int cells = grid.getCellCount();
+    if(query.start < 0 || query.start >= cells || query.goal < 0 || query.goal >= cells){
+        return result;
+    }
+
+    int start = grid.indexOfId(query.start);
+    int goal = grid.indexOfId(query.goal);
+    if(grid.isWall(start) || grid.isWall(goal)){
+        return result;
+    }
+
+    QueryScratch &scratch = localScratch(grid.getStorageSize());
+    quint32 epoch = scratch.epoch;
+    quint32 *stamps = scratch.stamps.data();
+    quint8 *parents = scratch.parents.data();
+    QVector<int> &queue = scratch.queue;
+
+    stamps[start] = epoch;
+    queue.append(start);
+
+    int head = 0;
+    while(head < queue.size()){
+        int current = queue.at(head++);
+        if(current == goal){
+            result.found = true;
+            break;
+        }
+        for(int direction = 0; direction < 4; direction++){
+            int next = grid.neighbour(current, direction);
+            if(stamps[next] != epoch && !grid.isWall(next)){
+                stamps[next] = epoch;
+                parents[next] = quint8(MazeGrid::opposite(direction));
+                queue.append(next);
+            }
+        }
+    }
+    result.expanded = head;
+
+    if(result.found){
+        QVector<int> reversed;
+        for(int current = goal; current != start; current = grid.neighbour(current, parents[current])){
+            reversed.append(grid.idOf(current));
+        }
+        reversed.append(query.start);
+
+        result.path.resize(reversed.size());
+        for(int ii = 0; ii < reversed.size(); ii++){
+            result.path[ii] = reversed.at(reversed.size() - 1 - ii);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Answers the same random queries with 1, 2, 4 ... threads up to the number of cores
+ * and prints the throughput. Started with --benchmark-batch on the command line.
+ * @param size The number of rows and columns of the random maze
+ * @param queries The number of queries
+ * @param out Where the table goes
+ * @return 0 if all thread counts gave the same answers, 1 otherwise
+ */
+int BatchSolver::runBenchmark(int size, int queries, QTextStream &out)
+{
+    size = qMax(size, 2);
+    queries = qMax(queries, 1);
+
+    MazeGrid grid(size, size);
+    grid.randomize(0x9e3779b9u);
+
+    // Random open cells as starts and goals
+    QVector<PathQuery> batch;
+    quint32 state = 0x2545f491u;
+    while(batch.size() < queries){
+        int ids[2];
+        for(int ii = 0; ii < 2; ii++){
+            do{
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                ids[ii] = int(state % quint32(grid.getCellCount()));
+            } while(grid.isWall(grid.indexOfId(ids[ii])));
+        }
+        batch.append(PathQuery(ids[0], ids[1]));
+    }
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int defaultThreads = pool->maxThreadCount();
+    BatchSolver solver(&grid);
+
+    out << "Batch benchmark, " << size << "x" << size << " random maze, " << queries << " queries\n";
+    out << QString("Threads").leftJustified(10) << QString("ms").rightJustified(12)
+        << QString("queries/s").rightJustified(14) << QString("speedup").rightJustified(10) << "\n";
+
+    QVector<PathAnswer> reference;
+    double singleThreadMs = 0;
+    bool consistent = true;
+    for(int threads = 1; threads <= QThread::idealThreadCount(); threads *= 2){
+        pool->setMaxThreadCount(threads);
+        QElapsedTimer timer;
+        timer.start();
+        QVector<PathAnswer> answers = solver.solve(batch);
+        double milliseconds = qMax(timer.nsecsElapsed() / 1e6, 0.001);
+
+        if(threads == 1){
+            reference = answers;
+            singleThreadMs = milliseconds;
+        }
+        else{
+            for(int ii = 0; ii < answers.size(); ii++){
+                consistent = consistent && answers.at(ii).path.size() == reference.at(ii).path.size();
+            }
+        }
+
+        out << QString::number(threads).leftJustified(10)
+            << QString::number(milliseconds, 'f', 2).rightJustified(12)
+            << QString::number(queries * 1000.0 / milliseconds, 'f', 0).rightJustified(14)
+            << QString::number(singleThreadMs / milliseconds, 'f', 2).rightJustified(10) << "\n";
+    }
+    pool->setMaxThreadCount(defaultThreads);
+
+    int found = 0;
+    foreach(const PathAnswer &answer, reference){
+        found += answer.found ? 1 : 0;
+    }
+    out << found << " of " << queries << " queries have a path\n";
+    out.flush();
+    return consistent ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#ifndef BATCHSOLVER_H
+#define BATCHSOLVER_H
+
+#include <QFuture>
+#include <QTextStream>
+#include <QVector>
+
+#include "mazegrid.h"
+
+/// One path query, from a start node id to a goal node id
+struct PathQuery
+{
+    PathQuery() : start(0), goal(0) {}
+    PathQuery(int startId, int goalId) : start(startId), goal(goalId) {}
+    int start;
+    int goal;
+};
+
+/// The answer to a path query
+struct PathAnswer
+{
+    PathAnswer() : found(false), expanded(0) {}
+    bool found; ///< True if the goal can be reached
+    int expanded; ///< Number of cells taken off the queue
+    QVector<int> path; ///< Node ids from the start to the goal, empty if not found
+};
+
+/**
+ * @brief Answers many path queries on one maze at the same time. The maze is only read,
+ * every worker thread keeps its own search scratch (visited stamps, parent directions and
+ * queue), so queries never share anything writable and spread over the global thread pool.
+ */
+class BatchSolver
+{
+public:
+    explicit BatchSolver(const MazeGrid *mazeGrid); ///< The grid has to outlive all running queries
+    QVector<PathAnswer> solve(const QVector<PathQuery> &queries) const; ///< Answers all queries, blocks until done
+    QFuture<PathAnswer> start(const QVector<PathQuery> &queries) const; ///< Answers all queries in the background
+    static PathAnswer answer(const MazeGrid &grid, const PathQuery &query); ///< Answers one query with the scratch of the calling thread
+
+    static int runBenchmark(int size, int queries, QTextStream &out); ///< Measures throughput for increasing thread counts
+
+private:
+    const MazeGrid *grid;
+};
+
+#endif // BATCHSOLVER_H
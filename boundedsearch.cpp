@@ -0,0 +1,329 @@
+#include "boundedsearch.h"
+#include "timelinetrace.h"
+
+#include <algorithm>
+
+namespace BoundedSearch {
+
+/// Row and column steps of the MazeGrid directions
+static const int rowStep[4] = { 1, -1, 0, 0 };
+static const int columnStep[4] = { 0, 0, 1, -1 };
+
+/**
+ * @brief Bookkeeping shared by all parts of one search
+ */
+struct Context
+{
+    Context(Result &searchResult, SearchControl *searchControl) : result(searchResult), control(searchControl) {}
+
+    Result &result;
+    SearchControl *control;
+
+    /// Counts expansions, polls for cancellation every PollInterval of them
+    bool expand(qint64 count, int frontierSize)
+    {
+        qint64 before = result.expanded;
+        result.expanded += count;
+        if(control != 0 && (before / SearchControl::PollInterval) != (result.expanded / SearchControl::PollInterval)){
+            if(control->poll(int(qMin(result.expanded, qint64(0x7fffffff))), frontierSize)){
+                result.cancelled = true;
+            }
+        }
+        return !result.cancelled;
+    }
+
+    /// Records the memory in use, false if it's over the budget
+    bool account(qint64 bytes)
+    {
+        result.peakBytes = qMax(result.peakBytes, bytes);
+        if(bytes > result.budgetBytes){
+            result.budgetExceeded = true;
+        }
+        return !result.budgetExceeded;
+    }
+};
+
+/// One cell on the IDA* path
+struct Frame
+{
+    int index; ///< Storage index
+    int row;
+    int column;
+    int g; ///< Steps from the start
+    int direction; ///< Next direction to try
+};
+
+/// A transposition table slot, the shortest path length a cell has been reached with
+struct TableEntry
+{
+    int index;
+    int g;
+    int iteration;
+};
+
+/**
+ * @brief IDA* with a Manhattan distance estimate and a direct-mapped transposition table.
+ * Half of the budget goes to the table, the rest bounds the depth of the path stack.
+ */
+static void iterativeDeepening(const MazeGrid &grid, int start, int goal, Context &context)
+{
+    Result &result = context.result;
+    int columns = grid.getColumns();
+    int goalRow = goal / columns;
+    int goalColumn = goal % columns;
+    int goalIndex = grid.indexOfId(goal);
+
+    // The largest power of two number of entries within half the budget
+    int tableSize = 0;
+    qint64 tableBudget = result.budgetBytes / 2;
+    while(qint64(tableSize == 0 ? 1 : tableSize * 2) * qint64(sizeof(TableEntry)) <= tableBudget && tableSize < (1 << 28)){
+        tableSize = tableSize == 0 ? 1 : tableSize * 2;
+    }
+    QVector<TableEntry> table(tableSize);
+    for(int ii = 0; ii < tableSize; ii++){
+        table[ii].index = -1;
+    }
+    qint64 tableBytes = qint64(tableSize) * sizeof(TableEntry);
+    int maximumDepth = int(qMin(qint64(0x7fffffff), (result.budgetBytes - tableBytes) / qint64(sizeof(Frame))));
+
+    Frame first;
+    first.index = grid.indexOfId(start);
+    first.row = start / columns;
+    first.column = start % columns;
+    first.g = 0;
+    first.direction = 0;
+    int threshold = qAbs(first.row - goalRow) + qAbs(first.column - goalColumn);
+
+    QVector<Frame> stack;
+    while(true){
+        result.iterations++;
+        int nextThreshold = 0x7fffffff;
+        stack.clear();
+        stack.append(first);
+        if(!context.account(tableBytes + qint64(stack.capacity()) * sizeof(Frame))){
+            return;
+        }
+
+        while(!stack.isEmpty()){
+            Frame &top = stack.last();
+            if(top.index == goalIndex){
+                result.found = true;
+                foreach(const Frame &frame, stack){
+                    result.path.append(frame.row * columns + frame.column);
+                }
+                return;
+            }
+            if(top.direction == 4){
+                stack.removeLast();
+                continue;
+            }
+
+            int direction = top.direction++;
+            int next = grid.neighbour(top.index, direction);
+            if(grid.isWall(next)){
+                continue;
+            }
+            if(stack.size() >= 2 && next == stack.at(stack.size() - 2).index){
+                continue; // Straight back to the parent
+            }
+
+            Frame child;
+            child.index = next;
+            child.row = top.row + rowStep[direction];
+            child.column = top.column + columnStep[direction];
+            child.g = top.g + 1;
+            child.direction = 0;
+            int f = child.g + qAbs(child.row - goalRow) + qAbs(child.column - goalColumn);
+            if(f > threshold){
+                nextThreshold = qMin(nextThreshold, f);
+                continue;
+            }
+
+            // Cut off cells this iteration has already reached on a path that wasn't longer
+            if(tableSize > 0){
+                TableEntry &entry = table[(quint32(next) * 2654435761u) & quint32(tableSize - 1)];
+                if(entry.index == next && entry.iteration == result.iterations && entry.g <= child.g){
+                    continue;
+                }
+                entry.index = next;
+                entry.g = child.g;
+                entry.iteration = result.iterations;
+            }
+
+            if(stack.size() >= maximumDepth){
+                context.account(tableBytes + qint64(stack.size() + 1) * sizeof(Frame));
+                return;
+            }
+            stack.append(child);
+            context.account(tableBytes + qint64(stack.capacity()) * sizeof(Frame));
+            if(!context.expand(1, stack.size())){
+                return;
+            }
+        }
+
+        if(nextThreshold == 0x7fffffff){
+            return; // Everything reachable has been searched
+        }
+        threshold = nextThreshold;
+    }
+}
+
+/// The last three breadth first layers of one side of the frontier search, sorted by storage index
+struct Side
+{
+    Side() : depth(0) {}
+    QVector<int> previous;
+    QVector<int> current;
+    QVector<int> next;
+    int depth;
+
+    qint64 bytes() const
+    {
+        return qint64(previous.capacity() + current.capacity() + next.capacity()) * sizeof(int);
+    }
+};
+
+/**
+ * @brief Runs a bidirectional frontier search between two cells
+ * @param grid The maze
+ * @param from The storage index to start from
+ * @param to The storage index to reach
+ * @param fixedBytes Memory held outside of this search, counted against the budget
+ * @param context The bookkeeping
+ * @param fromDistance Receives the distance from the start to the middle cell
+ * @param toDistance Receives the distance from the middle cell to the goal
+ * @param middle Receives a cell on a shortest path, about halfway
+ * @return False if the cells aren't connected or the search has been stopped
+ */
+static bool meetInTheMiddle(const MazeGrid &grid, int from, int to, qint64 fixedBytes, Context &context,
+                            int &fromDistance, int &toDistance, int &middle)
+{
+    Side forward;
+    Side backward;
+    forward.current.append(from);
+    backward.current.append(to);
+
+    while(true){
+        // Grow the shallower side, so both meet halfway
+        bool forwardTurn = forward.depth <= backward.depth;
+        Side &side = forwardTurn ? forward : backward;
+        const Side &other = forwardTurn ? backward : forward;
+        if(side.current.isEmpty()){
+            return false;
+        }
+
+        // In an undirected maze the neighbours of a layer are in the layer before, the layer
+        // itself or the next one, so these two are all it takes to not go back
+        side.next.clear();
+        foreach(int cell, side.current){
+            for(int direction = 0; direction < 4; direction++){
+                int neighbour = grid.neighbour(cell, direction);
+                if(grid.isWall(neighbour)
+                        || std::binary_search(side.previous.begin(), side.previous.end(), neighbour)
+                        || std::binary_search(side.current.begin(), side.current.end(), neighbour)){
+                    continue;
+                }
+                side.next.append(neighbour);
+            }
+        }
+        std::sort(side.next.begin(), side.next.end());
+        side.next.erase(std::unique(side.next.begin(), side.next.end()), side.next.end());
+        side.depth++;
+
+        if(!context.account(fixedBytes + forward.bytes() + backward.bytes())
+                || !context.expand(side.current.size(), side.next.size())){
+            return false;
+        }
+
+        // The first layer touching the newest layer of the other side holds a middle cell
+        foreach(int cell, side.next){
+            if(std::binary_search(other.current.begin(), other.current.end(), cell)){
+                fromDistance = forward.depth;
+                toDistance = backward.depth;
+                middle = cell;
+                return true;
+            }
+        }
+
+        side.previous.swap(side.current);
+        side.current.swap(side.next);
+    }
+}
+
+/**
+ * @brief Appends the cells of a shortest path from one cell up to, but not including,
+ * another one by splitting it at its middle cell until the pieces are single steps
+ * @param grid The maze
+ * @param from The storage index to start from
+ * @param to The storage index to reach
+ * @param distance The length of the shortest path, -1 if not known yet
+ * @param context The bookkeeping
+ * @param path Receives the storage indexes
+ * @return False if the cells aren't connected or the search has been stopped
+ */
+static bool buildPath(const MazeGrid &grid, int from, int to, int distance, Context &context, QVector<int> &path)
+{
+    if(from == to || distance == 0){
+        return true;
+    }
+    if(distance == 1){
+        path.append(from);
+        return true;
+    }
+
+    int fromDistance;
+    int toDistance;
+    int middle;
+    context.result.iterations++;
+    if(!meetInTheMiddle(grid, from, to, qint64(path.capacity()) * sizeof(int), context, fromDistance, toDistance, middle)){
+        return false;
+    }
+    return buildPath(grid, from, middle, fromDistance, context, path)
+            && buildPath(grid, middle, to, toDistance, context, path);
+}
+
+/**
+ * @brief Runs a bounded search between two cells
+ * @param grid The maze, only read
+ * @param start The node id to start from
+ * @param goal The node id to reach
+ * @param method The search to run
+ * @param budgetBytes How much memory the search state may use
+ * @param control Polled for cancellation and fed with progress, may be 0
+ * @return The path, the counters and the peak memory use
+ */
+Result run(const MazeGrid &grid, int start, int goal, Method method, qint64 budgetBytes, SearchControl *control)
+{
+    TIMELINE_SCOPE("BoundedSearch::run", "solver");
+    Result result;
+    result.budgetBytes = budgetBytes;
+    int cells = grid.getCellCount();
+    if(start < 0 || start >= cells || goal < 0 || goal >= cells
+            || grid.isWall(grid.indexOfId(start)) || grid.isWall(grid.indexOfId(goal))){
+        return result;
+    }
+
+    Context context(result, control);
+    if(method == IterativeDeepeningAStar){
+        iterativeDeepening(grid, start, goal, context);
+    }
+    else{
+        QVector<int> indexes;
+        int goalIndex = grid.indexOfId(goal);
+        if(buildPath(grid, grid.indexOfId(start), goalIndex, -1, context, indexes)){
+            indexes.append(goalIndex);
+            result.found = true;
+            foreach(int index, indexes){
+                result.path.append(grid.idOf(index));
+            }
+        }
+    }
+
+    if(result.cancelled || result.budgetExceeded){
+        result.found = false;
+        result.path.clear();
+    }
+    return result;
+}
+
+}
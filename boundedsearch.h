@@ -0,0 +1,48 @@
+#ifndef BOUNDEDSEARCH_H
+#define BOUNDEDSEARCH_H
+
+#include <QVector>
+
+#include "mazegrid.h"
+#include "searchcontrol.h"
+
+/**
+ * @brief Searches whose memory stays within a budget instead of growing with the maze.
+ * Neither keeps a visited flag or a parent per cell, the grid is only read.
+ *
+ * IDA* runs depth first searches with a growing bound on the Manhattan distance estimate.
+ * It only keeps the current path on a stack plus a fixed-size transposition table that cuts
+ * off cells reached before on a path that wasn't longer.
+ *
+ * Frontier search is a bidirectional breadth first search that keeps only the last three
+ * layers of each side, which is enough to not generate a cell twice in an undirected maze.
+ * The sides meet in a cell halfway along a shortest path, and the path is rebuilt by solving
+ * both halves the same way (divide and conquer).
+ */
+namespace BoundedSearch {
+
+/// The available searches
+enum Method {
+    IterativeDeepeningAStar = 0,
+    FrontierBreadthFirst
+};
+
+/// The outcome of a bounded search
+struct Result
+{
+    Result() : found(false), budgetExceeded(false), cancelled(false), expanded(0), peakBytes(0), budgetBytes(0), iterations(0) {}
+    bool found; ///< True if the goal has been reached
+    bool budgetExceeded; ///< True if the search stopped because it needed more memory
+    bool cancelled; ///< True if the search stopped on a cancel request
+    qint64 expanded; ///< Cells expanded, over all iterations or subproblems
+    qint64 peakBytes; ///< Most memory held by the search state at once
+    qint64 budgetBytes; ///< The budget the search ran with
+    int iterations; ///< IDA* bound increases, or frontier subproblems solved
+    QVector<int> path; ///< Node ids from the start to the goal, empty if not found
+};
+
+Result run(const MazeGrid &grid, int start, int goal, Method method, qint64 budgetBytes, SearchControl *control); ///< Runs a search within the budget
+
+}
+
+#endif // BOUNDEDSEARCH_H
@@ -0,0 +1,339 @@
+#include "encodedpath.h"
+
+/// Letters of the directions in the text form, in the order of MazeGrid::Direction
+static const char directionLetters[4] = { 'S', 'N', 'E', 'W' };
+
+const char *const EncodedPath::mimeType = "application/x-mazesolver-path";
+
+/**
+ * @brief Appends an unsigned varint
+ */
+static void appendVarint(QByteArray &data, quint64 value)
+{
+    while(value >= 0x80){
+        data.append(char(value | 0x80));
+        value >>= 7;
+    }
+    data.append(char(value));
+}
+
+/**
+ * @brief Reads an unsigned varint
+ * @param data The encoded bytes
+ * @param offset The position to read from, moved past the value
+ * @param value Receives the value
+ * @return False if the data ends in the middle of the value or it doesn't fit in 63 bits
+ */
+static bool readVarint(const QByteArray &data, int &offset, quint64 &value)
+{
+    value = 0;
+    int shift = 0;
+    quint8 byte;
+    do{
+        if(offset >= data.size() || shift > 56){
+            return false;
+        }
+        byte = quint8(data.at(offset++));
+        value |= quint64(byte & 0x7f) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    return true;
+}
+
+/**
+ * @brief Creates an empty path
+ */
+EncodedPath::EncodedPath()
+{
+    start = 0;
+    columns = 0;
+    cells = 0;
+}
+
+/**
+ * @brief Encodes a path of row-major node ids
+ * @param ids The node ids from the start to the end
+ * @param mazeColumns The number of columns in the maze
+ * @param path Receives the encoded path
+ * @return False if two consecutive ids aren't neighbours in the maze
+ */
+bool EncodedPath::fromIds(const QVector<int> &ids, int mazeColumns, EncodedPath &path)
+{
+    path = EncodedPath();
+    if(ids.isEmpty() || mazeColumns <= 0){
+        return ids.isEmpty();
+    }
+
+    path.start = ids.first();
+    path.columns = mazeColumns;
+    path.cells = ids.size();
+    for(int ii = 1; ii < ids.size(); ii++){
+        int from = ids.at(ii - 1);
+        int to = ids.at(ii);
+        int direction;
+        if(to == from + mazeColumns){
+            direction = 0;
+        }
+        else if(to == from - mazeColumns){
+            direction = 1;
+        }
+        else if(to == from + 1 && to / mazeColumns == from / mazeColumns){
+            direction = 2;
+        }
+        else if(to == from - 1 && to / mazeColumns == from / mazeColumns){
+            direction = 3;
+        }
+        else{
+            path = EncodedPath();
+            return false;
+        }
+
+        if(!path.runs.isEmpty() && path.runs.last().direction == direction){
+            path.runs.last().length++;
+        }
+        else{
+            Run run;
+            run.direction = quint8(direction);
+            run.length = 1;
+            path.runs.append(run);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes the node ids
+ * @return The node ids from the start to the end, empty for an empty path
+ */
+QVector<int> EncodedPath::toIds() const
+{
+    QVector<int> ids;
+    if(cells == 0){
+        return ids;
+    }
+
+    int steps[4] = { columns, -columns, 1, -1 };
+    ids.reserve(cells);
+    int id = start;
+    ids.append(id);
+    foreach(const Run &run, runs){
+        for(int ii = 0; ii < run.length; ii++){
+            id += steps[run.direction];
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+/**
+ * @brief Checks if the path has any cells
+ * @return True if there is no path
+ */
+bool EncodedPath::isEmpty() const
+{
+    return cells == 0;
+}
+
+/**
+ * @brief Gets the node id the path starts at
+ * @return The id of the first cell
+ */
+int EncodedPath::getStart() const
+{
+    return start;
+}
+
+/**
+ * @brief Gets the number of columns of the grid the ids were encoded for
+ * @return The number of columns
+ */
+int EncodedPath::getColumns() const
+{
+    return columns;
+}
+
+/**
+ * @brief Gets the length of the path
+ * @return The number of cells on the path, the start included
+ */
+int EncodedPath::getCellCount() const
+{
+    return cells;
+}
+
+/**
+ * @brief Gets the runs of moves after the start
+ * @return The runs in the order they are walked
+ */
+const QVector<EncodedPath::Run> &EncodedPath::getRuns() const
+{
+    return runs;
+}
+
+/**
+ * @brief Writes the text form as lines, for the log
+ * @param runsPerLine The most runs on one line
+ * @return The header line followed by the lines of runs
+ */
+QStringList EncodedPath::toTextLines(int runsPerLine) const
+{
+    QStringList lines;
+    lines.append("path start " + QString::number(start) + " columns " + QString::number(columns)
+                 + " cells " + QString::number(cells));
+
+    runsPerLine = qMax(1, runsPerLine);
+    QString line;
+    for(int ii = 0; ii < runs.size(); ii++){
+        if(ii % runsPerLine != 0){
+            line.append(' ');
+        }
+        line.append(QLatin1Char(directionLetters[runs.at(ii).direction]));
+        line.append(QString::number(runs.at(ii).length));
+        if(ii % runsPerLine == runsPerLine - 1 || ii == runs.size() - 1){
+            lines.append(line);
+            line.clear();
+        }
+    }
+    return lines;
+}
+
+/**
+ * @brief Writes the text form
+ * @return The header line followed by the runs, one line per runsPerTextLine runs
+ */
+QString EncodedPath::toText() const
+{
+    return toTextLines(runsPerTextLine).join("\n") + "\n";
+}
+
+/**
+ * @brief Parses the text form
+ * @param text The header line followed by the runs, separated by any whitespace
+ * @param path Receives the path
+ * @return False if the text isn't a valid path
+ */
+bool EncodedPath::fromText(const QString &text, EncodedPath &path)
+{
+    path = EncodedPath();
+    QStringList tokens = text.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    if(tokens.size() < 7 || tokens.at(0) != "path" || tokens.at(1) != "start"
+            || tokens.at(3) != "columns" || tokens.at(5) != "cells"){
+        return false;
+    }
+
+    bool startOk;
+    bool columnsOk;
+    bool cellsOk;
+    EncodedPath parsed;
+    parsed.start = tokens.at(2).toInt(&startOk);
+    parsed.columns = tokens.at(4).toInt(&columnsOk);
+    parsed.cells = tokens.at(6).toInt(&cellsOk);
+    if(!startOk || !columnsOk || !cellsOk || parsed.columns <= 0 || parsed.cells < 0){
+        return false;
+    }
+
+    qint64 steps = 0;
+    for(int ii = 7; ii < tokens.size(); ii++){
+        const QString &token = tokens.at(ii);
+        int direction = -1;
+        for(int letter = 0; letter < 4 && !token.isEmpty(); letter++){
+            if(token.at(0) == QLatin1Char(directionLetters[letter])){
+                direction = letter;
+            }
+        }
+        bool lengthOk;
+        Run run;
+        run.length = token.mid(1).toInt(&lengthOk);
+        if(direction < 0 || !lengthOk || run.length <= 0){
+            return false;
+        }
+        run.direction = quint8(direction);
+        parsed.runs.append(run);
+        steps += run.length;
+    }
+
+    if((parsed.cells == 0 && !parsed.runs.isEmpty()) || (parsed.cells > 0 && steps != parsed.cells - 1)){
+        return false;
+    }
+    path = parsed;
+    return true;
+}
+
+/**
+ * @brief Writes the binary form
+ * @return The magic number followed by the varints
+ */
+QByteArray EncodedPath::toBinary() const
+{
+    QByteArray data;
+    data.reserve(16 + runs.size() * 2);
+    for(int shift = 24; shift >= 0; shift -= 8){
+        data.append(char((magic >> shift) & 0xff));
+    }
+    appendVarint(data, quint64(start));
+    appendVarint(data, quint64(columns));
+    appendVarint(data, quint64(cells));
+    appendVarint(data, quint64(runs.size()));
+    foreach(const Run &run, runs){
+        appendVarint(data, (quint64(run.length) << 2) | run.direction);
+    }
+    return data;
+}
+
+/**
+ * @brief Parses the binary form
+ * @param data The magic number followed by the varints
+ * @param path Receives the path
+ * @return False if the data isn't a valid path
+ */
+bool EncodedPath::fromBinary(const QByteArray &data, EncodedPath &path)
+{
+    path = EncodedPath();
+    if(data.size() < 4){
+        return false;
+    }
+    quint32 dataMagic = 0;
+    for(int ii = 0; ii < 4; ii++){
+        dataMagic = (dataMagic << 8) | quint8(data.at(ii));
+    }
+    if(dataMagic != magic){
+        return false;
+    }
+
+    int offset = 4;
+    quint64 values[4];
+    for(int ii = 0; ii < 4; ii++){
+        if(!readVarint(data, offset, values[ii]) || values[ii] > 0x7fffffff){
+            return false;
+        }
+    }
+
+    EncodedPath parsed;
+    parsed.start = int(values[0]);
+    parsed.columns = int(values[1]);
+    parsed.cells = int(values[2]);
+    int runCount = int(values[3]);
+    if(parsed.columns <= 0 || runCount > data.size() - offset){
+        return false;
+    }
+
+    qint64 steps = 0;
+    parsed.runs.reserve(runCount);
+    for(int ii = 0; ii < runCount; ii++){
+        quint64 value;
+        if(!readVarint(data, offset, value) || (value >> 2) == 0 || (value >> 2) > 0x7fffffff){
+            return false;
+        }
+        Run run;
+        run.direction = quint8(value & 3);
+        run.length = int(value >> 2);
+        parsed.runs.append(run);
+        steps += run.length;
+    }
+
+    if((parsed.cells == 0 && runCount > 0) || (parsed.cells > 0 && steps != parsed.cells - 1)){
+        return false;
+    }
+    path = parsed;
+    return true;
+}
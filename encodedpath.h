@@ -0,0 +1,56 @@
+#ifndef ENCODEDPATH_H
+#define ENCODEDPATH_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief A path stored as its start cell and runs of moves in the same direction, so a long
+ * straight corridor takes one run instead of one node id per cell.
+ *
+ * The text form is a header line followed by the runs, e.g. "S12 E3 N1", with the direction
+ * letters in the order of MazeGrid::Direction. The binary form is the big-endian magic number
+ * followed by varints: the start, the number of columns, the number of cells on the path, the
+ * number of runs and one value per run holding the length shifted left by two and the
+ * direction in the low bits.
+ */
+class EncodedPath
+{
+public:
+    /// A number of steps in one direction, directions as in MazeGrid::Direction
+    struct Run
+    {
+        quint8 direction;
+        int length;
+    };
+
+    EncodedPath();
+    static bool fromIds(const QVector<int> &ids, int columns, EncodedPath &path); ///< Encodes row-major node ids, false if two of them aren't neighbours
+    QVector<int> toIds() const; ///< Decodes the node ids from the start to the end
+    bool isEmpty() const;
+    int getStart() const;
+    int getColumns() const;
+    int getCellCount() const; ///< Number of cells on the path, the start included
+    const QVector<Run> &getRuns() const;
+
+    QStringList toTextLines(int runsPerLine) const; ///< The text form, split into lines of at most the given number of runs
+    QString toText() const; ///< The text form with line breaks
+    static bool fromText(const QString &text, EncodedPath &path); ///< Parses the text form
+    QByteArray toBinary() const; ///< The binary form
+    static bool fromBinary(const QByteArray &data, EncodedPath &path); ///< Parses the binary form
+
+    static const char *const mimeType; ///< Clipboard type of the binary form
+
+private:
+    static const quint32 magic = 0x4d5a5031; ///< "MZP1"
+    static const int runsPerTextLine = 32;
+
+    int start;
+    int columns;
+    int cells;
+    QVector<Run> runs;
+};
+
+#endif // ENCODEDPATH_H
@@ -0,0 +1,365 @@
+#include "framerenderer.h"
+#include "mazefile.h"
+#include "mazegrid.h"
+#include "mazenodearena.h"
+#include "searchstepper.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <cstring>
+
+namespace FrameRenderer {
+
+/// Frames per thread in a batch, so no thread idles while the pool works through a batch
+static const int framesPerThread = 4;
+/// QImage quality of the PNG files, low zlib compression since encoding takes most of the time
+static const int pngQuality = 80;
+
+/// Palette entries: the colours of the cells before the search, then those of the trace states
+enum Colour {
+    OpenColour,
+    WallColour,
+    EntranceColour,
+    ExitColour,
+    ActiveColour,
+    VisitedColour,
+    PathColour,
+    ColourCount
+};
+
+/// The colours of the maze view as RGB, see MazeNode::getColor
+static const uchar palette[ColourCount][3] = {
+    {255, 255, 255},
+    {0, 0, 0},
+    {255, 255, 0},
+    {0, 0, 255},
+    {255, 255, 0},
+    {255, 0, 0},
+    {0, 255, 0}
+};
+
+/// What all frames have in common: their size, which cell each pixel shows and where they go
+struct Canvas
+{
+    int width;
+    int height;
+    int columns; ///< Of the maze
+    QVector<int> columnOf; ///< Maze column shown by every pixel column
+    QVector<int> rowOf; ///< Maze row shown by every pixel row
+    QByteArray baseColours; ///< Palette entry of every cell before the search paints it
+    Format format;
+    QString directory; ///< Where PNG frames go
+};
+
+/// One frame on its way from the trace to the output
+struct Frame
+{
+    Frame() : index(0), written(false) {}
+    int index;
+    QByteArray states; ///< The trace states of all cells, one byte each
+    QByteArray pixels; ///< RGB, three bytes per pixel, kept between batches so it's not reallocated
+    bool written; ///< PNG: the file has been saved
+};
+
+/**
+ * @brief Draws a frame and encodes it, handed out by QtConcurrent
+ */
+struct FrameEncoder
+{
+    FrameEncoder(const Canvas *frameCanvas) : canvas(frameCanvas) {}
+
+    void operator()(Frame &frame) const
+    {
+        int rowBytes = canvas->width * 3;
+        frame.pixels.resize(rowBytes * canvas->height);
+        uchar *pixels = reinterpret_cast<uchar*>(frame.pixels.data());
+        const char *states = frame.states.constData();
+        const char *base = canvas->baseColours.constData();
+
+        for(int y = 0; y < canvas->height; y++){
+            uchar *line = pixels + qint64(y) * rowBytes;
+
+            // Pixel rows showing the same maze row are the same
+            if(y > 0 && canvas->rowOf.at(y) == canvas->rowOf.at(y - 1)){
+                memcpy(line, line - rowBytes, rowBytes);
+                continue;
+            }
+
+            qint64 firstCell = qint64(canvas->rowOf.at(y)) * canvas->columns;
+            for(int x = 0; x < canvas->width; x++){
+                qint64 cell = firstCell + canvas->columnOf.at(x);
+                int state = states[cell];
+                const uchar *colour = palette[state != SearchTrace::None ? ActiveColour - SearchTrace::Active + state : int(base[cell])];
+                line[3 * x] = colour[0];
+                line[3 * x + 1] = colour[1];
+                line[3 * x + 2] = colour[2];
+            }
+        }
+
+        if(canvas->format == Png){
+            QImage image(pixels, canvas->width, canvas->height, rowBytes, QImage::Format_RGB888);
+            QString name = QString("frame_%1.png").arg(frame.index, 6, 10, QChar('0'));
+            frame.written = image.save(QDir(canvas->directory).filePath(name), "PNG", pngQuality);
+        }
+    }
+
+    const Canvas *canvas;
+};
+
+/**
+ * @brief Gets how many frames a trace makes: the maze before the search, then one every stride
+ * events, the last one with all events
+ * @param trace The recorded search
+ * @param stride Events per frame
+ * @return The number of frames
+ */
+int frameCount(const SearchTrace &trace, int stride)
+{
+    stride = qMax(1, stride);
+    return (trace.getEventCount() + stride - 1) / stride + 1;
+}
+
+/**
+ * @brief Writes the raw frames of an encoded batch in order and checks the PNG frames
+ * @return False if a frame couldn't be written, the error is in the result
+ */
+static bool finishBatch(const QVector<Frame> &batch, const Canvas &canvas, QFile &raw, Result &result)
+{
+    for(int ii = 0; ii < batch.size(); ii++){
+        const Frame &frame = batch.at(ii);
+        if(canvas.format == RawRgb){
+            if(raw.write(frame.pixels) != frame.pixels.size()){
+                result.error = "Could not write frame " + QString::number(frame.index);
+                return false;
+            }
+            result.bytes += frame.pixels.size();
+        }
+        else if(!frame.written){
+            result.error = "Could not save frame " + QString::number(frame.index) + " in " + canvas.directory;
+            return false;
+        }
+        result.frames++;
+    }
+    return true;
+}
+
+/**
+ * @brief Replays a trace into frames and writes them. The cell states of a batch of frames are
+ * cut from the trace while the batch before is drawn and encoded on the thread pool.
+ * @param rows The height of the maze
+ * @param columns The width of the maze
+ * @param walls One bit per node id, set for walls
+ * @param trace The recorded search, of a maze of this size
+ * @param settings The frame size, the events per frame and the format
+ * @param output A directory for PNG frames, created if needed, or a file for raw frames, - for standard output
+ * @return The frames written and the time it took
+ */
+Result render(int rows, int columns, const QBitArray &walls, const SearchTrace &trace, const Settings &settings, const QString &output)
+{
+    Result result;
+    QElapsedTimer clock;
+    clock.start();
+    int cells = rows * columns;
+    if(rows <= 0 || columns <= 0 || trace.getCellCount() != cells || walls.size() != cells){
+        result.error = "The trace doesn't belong to the maze";
+        return result;
+    }
+
+    Canvas canvas;
+    canvas.width = qMax(1, settings.width);
+    canvas.height = settings.height;
+    if(canvas.height <= 0){
+        // Rounded up to an even height, video encoders halve it for the chroma planes
+        canvas.height = qMax(2, int((qint64(canvas.width) * rows + columns - 1) / columns + 1) & ~1);
+    }
+    canvas.columns = columns;
+    canvas.columnOf.resize(canvas.width);
+    for(int x = 0; x < canvas.width; x++){
+        canvas.columnOf[x] = int(qint64(x) * columns / canvas.width);
+    }
+    canvas.rowOf.resize(canvas.height);
+    for(int y = 0; y < canvas.height; y++){
+        canvas.rowOf[y] = int(qint64(y) * rows / canvas.height);
+    }
+    canvas.baseColours.fill(char(OpenColour), cells);
+    for(int id = 0; id < cells; id++){
+        if(walls.testBit(id)){
+            canvas.baseColours[id] = char(WallColour);
+        }
+    }
+    if(!walls.testBit(0)){
+        canvas.baseColours[0] = char(EntranceColour);
+    }
+    if(!walls.testBit(cells - 1)){
+        canvas.baseColours[cells - 1] = char(ExitColour);
+    }
+    canvas.format = settings.format;
+    canvas.directory = output;
+    result.width = canvas.width;
+    result.height = canvas.height;
+
+    QFile raw(output);
+    if(settings.format == RawRgb){
+        bool opened = output == "-" ? raw.open(stdout, QIODevice::WriteOnly) : raw.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        if(!opened){
+            result.error = "Could not open " + output;
+            return result;
+        }
+    }
+    else if(!QDir().mkpath(output)){
+        result.error = "Could not create " + output;
+        return result;
+    }
+
+    int stride = qMax(1, settings.stride);
+    int frames = frameCount(trace, stride);
+    int batchFrames = qMax(1, QThread::idealThreadCount()) * framesPerThread;
+    QVector<Frame> batches[2];
+    QFuture<void> encoding;
+    int pending = -1;
+    int next = 0;
+    QByteArray states;
+    SearchTrace::Cursor cursor = trace.seek(0, states);
+
+    for(int first = 0; first < frames; first += batchFrames){
+        // Each frame shares the states with the one before until the trace moves on
+        QVector<Frame> &batch = batches[next];
+        batch.resize(qMin(batchFrames, frames - first));
+        for(int ii = 0; ii < batch.size(); ii++){
+            int index = first + ii;
+            trace.advance(cursor, states, int(qMin(qint64(index) * stride, qint64(trace.getEventCount()))));
+            batch[ii].index = index;
+            batch[ii].states = states;
+            batch[ii].written = false;
+        }
+
+        // The batch before has been encoding meanwhile, its frames are written now
+        if(pending >= 0){
+            encoding.waitForFinished();
+            if(!finishBatch(batches[pending], canvas, raw, result)){
+                return result;
+            }
+            pending = -1;
+        }
+        encoding = QtConcurrent::map(batch, FrameEncoder(&canvas));
+        pending = next;
+        next ^= 1;
+    }
+
+    if(pending >= 0){
+        encoding.waitForFinished();
+        if(!finishBatch(batches[pending], canvas, raw, result)){
+            return result;
+        }
+    }
+    if(settings.format == RawRgb){
+        raw.flush();
+    }
+
+    result.ok = true;
+    result.elapsedMs = clock.elapsed();
+    return result;
+}
+
+/**
+ * @brief Records a breadth first search from the top left to the bottom right corner the way a
+ * search in the maze view does, the path from the exit back to the entrance included
+ * @param rows The height of the maze
+ * @param columns The width of the maze
+ * @param walls One bit per node id, set for walls
+ * @param trace Reset and filled with the events of the search
+ */
+void recordSearch(int rows, int columns, const QBitArray &walls, SearchTrace &trace)
+{
+    int cells = rows * columns;
+    MazeNodeArena arena;
+    arena.reserve(rows, columns);
+    QHash<int,MazeNode*> nodeHash;
+    nodeHash.reserve(cells);
+    for(int id = 0; id < cells; id++){
+        nodeHash.insert(id, arena.create(id % columns, id / columns, 1));
+    }
+    nodeHash.value(0)->setEntrance(true);
+    nodeHash.value(cells - 1)->setExit(true);
+    arena.assignAllWalls(walls);
+
+    trace.reset(cells);
+    SearchStepper stepper;
+    stepper.setTrace(&trace);
+    stepper.start(SearchStepper::BreadthFirst, &nodeHash, rows, columns, arena.getOpenDirections());
+    stepper.run();
+
+    // Painted from the exit back to the entrance, as MazeUi::tracePath does
+    MazeNode *node = stepper.getExitNode();
+    for(int steps = 0; node != 0 && steps < cells; steps++){
+        trace.record(node->getId(), SearchTrace::Path);
+        node = node->getPreviousNode();
+    }
+}
+
+/**
+ * @brief Renders the recorded search of a maze file into frames. A maze file without a trace,
+ * or a random maze of the given size, gets the trace of a BFS first.
+ * @param maze A maze file or the side of a random maze, seed 1
+ * @param output A directory for PNG frames or a file for raw frames, - for standard output
+ * @param settings The frame size, the events per frame and the format
+ * @param out Receives the report, standard error takes over when the frames go to standard output
+ * @return The exit code of the process
+ */
+int runRender(const QString &maze, const QString &output, const Settings &settings, QTextStream &out)
+{
+    QTextStream errorStream(stderr);
+    QTextStream &report = settings.format == RawRgb && output == "-" ? errorStream : out;
+
+    int rows = 0;
+    int columns = 0;
+    QBitArray walls;
+    SearchTrace trace;
+    bool isSize = false;
+    int side = maze.toInt(&isSize);
+    if(isSize){
+        MazeGrid grid(side, side);
+        grid.randomize(1);
+        rows = side;
+        columns = side;
+        walls = grid.getWalls();
+    }
+    else if(!MazeFile::load(maze, rows, columns, walls, trace)){
+        report << "Could not load a maze from " << maze << "\n";
+        return 1;
+    }
+    if(rows <= 0 || columns <= 0){
+        report << "The maze is empty\n";
+        return 1;
+    }
+
+    if(trace.isEmpty()){
+        QElapsedTimer clock;
+        clock.start();
+        recordSearch(rows, columns, walls, trace);
+        report << "Recorded a BFS of " << trace.getEventCount() << " events in " << clock.elapsed() << " ms\n";
+    }
+    report << "Rendering " << frameCount(trace, settings.stride) << " frames of " << trace.getEventCount() << " events\n";
+    report.flush();
+
+    Result result = render(rows, columns, walls, trace, settings, output);
+    if(!result.ok){
+        report << result.error << "\n";
+        return 1;
+    }
+    report << "Rendered " << result.frames << " frames of " << result.width << "x" << result.height << " in " << result.elapsedMs << " ms, "
+           << QString::number(result.frames * 1000.0 / qMax(qint64(1), result.elapsedMs), 'f', 1) << " frames per second on "
+           << QThread::idealThreadCount() << " threads\n";
+    if(settings.format == RawRgb){
+        report << "Wrote " << result.bytes << " bytes of RGB24, for example for ffmpeg -f rawvideo -pix_fmt rgb24 -s "
+               << result.width << "x" << result.height << " -i " << output << " solve.mp4\n";
+    }
+    return 0;
+}
+
+}
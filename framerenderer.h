@@ -0,0 +1,59 @@
+#ifndef FRAMERENDERER_H
+#define FRAMERENDERER_H
+
+#include <QBitArray>
+#include <QString>
+#include <QTextStream>
+
+#include "searchtrace.h"
+
+/**
+ * @brief Replays a recorded search into a sequence of images without a display, for videos of
+ * solves that are too large or too slow to screen record.
+ *
+ * Every frame shows the trace after a fixed number of further events, in the colours of the
+ * maze view, each pixel taking the cell under it. The frames are cut from the trace in order on
+ * the calling thread, which only copies the cell states, and are drawn and encoded in batches
+ * on the thread pool while the next batch is cut. PNG frames go into a directory one file each,
+ * raw RGB frames are written back to back into one file or to standard output, ready to be
+ * piped into a video encoder.
+ */
+namespace FrameRenderer {
+
+/// How the frames are written
+enum Format {
+    Png, ///< One numbered PNG file per frame in a directory
+    RawRgb ///< Three bytes per pixel, rows top to bottom, frames back to back
+};
+
+/// The look and the pace of the video
+struct Settings
+{
+    Settings() : width(1280), height(0), stride(64), format(Png) {}
+    int width; ///< Frame width in pixels
+    int height; ///< Frame height in pixels, 0 keeps the aspect ratio of the maze
+    int stride; ///< Trace events per frame
+    Format format;
+};
+
+/// What a rendering produced
+struct Result
+{
+    Result() : ok(false), frames(0), width(0), height(0), bytes(0), elapsedMs(0) {}
+    bool ok;
+    QString error; ///< Why the frames couldn't be written
+    int frames;
+    int width; ///< The frame size used, with the height worked out if it wasn't given
+    int height;
+    qint64 bytes; ///< Raw bytes written, 0 for PNG
+    qint64 elapsedMs;
+};
+
+int frameCount(const SearchTrace &trace, int stride); ///< Frames of a trace, the empty maze and the complete trace included
+Result render(int rows, int columns, const QBitArray &walls, const SearchTrace &trace, const Settings &settings, const QString &output); ///< Writes all frames, output is a directory for PNG and a file or - for raw
+void recordSearch(int rows, int columns, const QBitArray &walls, SearchTrace &trace); ///< Records a BFS from the entrance to the exit as the maze view paints it
+int runRender(const QString &maze, const QString &output, const Settings &settings, QTextStream &out); ///< Renders the trace of a maze file, or of a BFS on a random maze of the given size
+
+}
+
+#endif // FRAMERENDERER_H
@@ -0,0 +1,428 @@
+#include "landmarktable.h"
+
+#include <QDataStream>
+#include <QThread>
+#include <QtConcurrentMap>
+
+/// Marks cells a breadth first search hasn't reached
+static const quint32 noDistance = 0xffffffff;
+
+/**
+ * @brief Runs a breadth first search over the whole maze
+ * @param grid The maze, only read
+ * @param id The node id to start from
+ * @return The steps to every node id, noDistance where it can't be reached
+ */
+static QVector<quint32> distancesFrom(const MazeGrid &grid, int id)
+{
+    QVector<quint32> distances(grid.getCellCount(), noDistance);
+    QVector<int> queue;
+    queue.reserve(grid.getCellCount());
+    queue.append(grid.indexOfId(id));
+    distances[id] = 0;
+
+    for(int head = 0; head < queue.size(); head++){
+        int index = queue.at(head);
+        quint32 next = distances.at(grid.idOf(index)) + 1;
+        for(int direction = 0; direction < 4; direction++){
+            int neighbour = grid.neighbour(index, direction);
+            if(grid.isWall(neighbour)){
+                continue;
+            }
+            quint32 &distance = distances[grid.idOf(neighbour)];
+            if(distance == noDistance){
+                distance = next;
+                queue.append(neighbour);
+            }
+        }
+    }
+    return distances;
+}
+
+/**
+ * @brief Runs the breadth first searches of a batch handed out by QtConcurrent
+ */
+struct LandmarkSearch
+{
+    typedef QVector<quint32> result_type;
+
+    explicit LandmarkSearch(const MazeGrid *mazeGrid) : grid(mazeGrid) {}
+    QVector<quint32> operator()(int landmark) const
+    {
+        return distancesFrom(*grid, landmark);
+    }
+
+    const MazeGrid *grid;
+};
+
+/**
+ * @brief Creates an empty table
+ */
+LandmarkTable::LandmarkTable()
+{
+    rows = 0;
+    columns = 0;
+    width = 2;
+    wallHash = 0;
+    mappedFile = 0;
+    table = 0;
+}
+
+LandmarkTable::~LandmarkTable()
+{
+    clear();
+}
+
+/**
+ * @brief Drops the distances and unmaps the file
+ */
+void LandmarkTable::clear()
+{
+    if(mappedFile != 0){
+        mappedFile->close(); // Unmaps the distances as well
+        delete mappedFile;
+        mappedFile = 0;
+    }
+    ownedTable.clear();
+    table = 0;
+    landmarks.clear();
+    rows = 0;
+    columns = 0;
+    wallHash = 0;
+}
+
+/**
+ * @brief Picks the landmarks and measures their distance to every cell. Only the cells
+ * connected to the entrance (or the first open cell, if the entrance is a wall) are candidates.
+ * @param grid The maze, only read
+ * @param landmarkCount The number of landmarks to pick, fewer if the maze runs out of cells
+ * @return False if there's no open cell
+ */
+bool LandmarkTable::build(const MazeGrid &grid, int landmarkCount)
+{
+    clear();
+    int cells = grid.getCellCount();
+    int seed = 0;
+    while(seed < cells && grid.isWall(grid.indexOfId(seed))){
+        seed++;
+    }
+    if(seed == cells || landmarkCount <= 0){
+        return false;
+    }
+    int mazeColumns = grid.getColumns();
+
+    // The distance of each cell to the closest landmark, the seed stands in for the first one
+    QVector<quint32> closest = distancesFrom(grid, seed);
+    QVector<QVector<quint32> > columnsByLandmark;
+    int batchSize = qMax(1, QThread::idealThreadCount());
+
+    while(landmarks.size() < landmarkCount){
+        QVector<int> picks;
+        while(picks.size() < batchSize && landmarks.size() + picks.size() < landmarkCount){
+            int best = -1;
+            quint32 bestScore = 0;
+            for(int id = 0; id < cells; id++){
+                quint32 score = closest.at(id);
+                if(score == noDistance || score <= bestScore){
+                    continue;
+                }
+                foreach(int pick, picks){
+                    quint32 gridDistance = qAbs(id / mazeColumns - pick / mazeColumns) + qAbs(id % mazeColumns - pick % mazeColumns);
+                    score = qMin(score, gridDistance);
+                }
+                if(score > bestScore){
+                    best = id;
+                    bestScore = score;
+                }
+            }
+            if(best < 0){
+                break; // Every candidate is a landmark already
+            }
+            picks.append(best);
+        }
+        if(picks.isEmpty()){
+            break;
+        }
+
+        QVector<QVector<quint32> > batch = QtConcurrent::blockingMapped<QVector<QVector<quint32> > >(picks, LandmarkSearch(&grid));
+        for(int ii = 0; ii < picks.size(); ii++){
+            const QVector<quint32> &distances = batch.at(ii);
+            for(int id = 0; id < cells; id++){
+                closest[id] = qMin(closest.at(id), distances.at(id));
+            }
+            landmarks.append(picks.at(ii));
+            columnsByLandmark.append(distances);
+        }
+    }
+
+    // Distances that fit in 16 bits leave room for the unreachable marker
+    quint32 longest = 0;
+    foreach(const QVector<quint32> &distances, columnsByLandmark){
+        foreach(quint32 distance, distances){
+            if(distance != noDistance){
+                longest = qMax(longest, distance);
+            }
+        }
+    }
+    width = longest < 0xffff ? 2 : 4;
+
+    int count = landmarks.size();
+    ownedTable.resize(cells * count * width);
+    for(int kk = 0; kk < count; kk++){
+        const QVector<quint32> &distances = columnsByLandmark.at(kk);
+        for(int id = 0; id < cells; id++){
+            if(width == 2){
+                reinterpret_cast<quint16*>(ownedTable.data())[id * count + kk] = distances.at(id) == noDistance ? 0xffff : quint16(distances.at(id));
+            }
+            else{
+                reinterpret_cast<quint32*>(ownedTable.data())[id * count + kk] = distances.at(id);
+            }
+        }
+    }
+    table = reinterpret_cast<const uchar*>(ownedTable.constData());
+
+    rows = grid.getRows();
+    columns = mazeColumns;
+    wallHash = hashWalls(grid.getWalls());
+    return true;
+}
+
+/**
+ * @brief Writes the table. The header goes through a QDataStream, the distances are written
+ * as they are in memory so load can map them.
+ * @param fileName The file to write to
+ * @return True on success
+ */
+bool LandmarkTable::save(const QString &fileName) const
+{
+    if(isEmpty()){
+        return false;
+    }
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << magic << version << qint32(rows) << qint32(columns) << qint32(width) << wallHash
+        << bool(Q_BYTE_ORDER == Q_LITTLE_ENDIAN) << landmarks;
+    if(out.status() != QDataStream::Ok){
+        return false;
+    }
+
+    QByteArray padding((tableAlignment - file.pos() % tableAlignment) % tableAlignment, 0);
+    return file.write(padding) == padding.size()
+            && file.write(reinterpret_cast<const char*>(table), getByteSize()) == getByteSize();
+}
+
+/**
+ * @brief Maps a table written by save. Tables of the other byte order are refused.
+ * @param fileName The file to map
+ * @return True on success, the table is empty otherwise
+ */
+bool LandmarkTable::load(const QString &fileName)
+{
+    clear();
+    QFile *file = new QFile(fileName);
+    if(!file->open(QIODevice::ReadOnly)){
+        delete file;
+        return false;
+    }
+
+    QDataStream in(file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 fileMagic;
+    qint32 fileVersion;
+    qint32 fileRows;
+    qint32 fileColumns;
+    qint32 fileWidth;
+    bool littleEndian;
+    in >> fileMagic >> fileVersion;
+    if(fileMagic != magic || fileVersion > version){
+        delete file;
+        return false;
+    }
+    in >> fileRows >> fileColumns >> fileWidth >> wallHash >> littleEndian >> landmarks;
+
+    qint64 offset = (file->pos() + tableAlignment - 1) / tableAlignment * tableAlignment;
+    qint64 size = qint64(fileRows) * fileColumns * landmarks.size() * fileWidth;
+    uchar *mapped = 0;
+    if(in.status() == QDataStream::Ok && littleEndian == (Q_BYTE_ORDER == Q_LITTLE_ENDIAN)
+            && (fileWidth == 2 || fileWidth == 4) && fileRows > 0 && fileColumns > 0
+            && !landmarks.isEmpty() && offset + size <= file->size()){
+        mapped = file->map(offset, size);
+    }
+    if(mapped == 0){
+        delete file;
+        landmarks.clear();
+        wallHash = 0;
+        return false;
+    }
+
+    rows = fileRows;
+    columns = fileColumns;
+    width = fileWidth;
+    mappedFile = file;
+    table = mapped;
+    return true;
+}
+
+/**
+ * @brief Checks if the table has been built or loaded
+ * @return True if there are no distances
+ */
+bool LandmarkTable::isEmpty() const
+{
+    return table == 0;
+}
+
+/**
+ * @brief Gets the number of landmarks
+ * @return The number of landmarks
+ */
+int LandmarkTable::getLandmarkCount() const
+{
+    return landmarks.size();
+}
+
+/**
+ * @brief Gets the cells the distances are measured from
+ * @return The node ids of the landmarks
+ */
+const QVector<int> &LandmarkTable::getLandmarks() const
+{
+    return landmarks;
+}
+
+/**
+ * @brief Gets the size of the distances, one entry per cell and landmark
+ * @return The size in bytes
+ */
+qint64 LandmarkTable::getByteSize() const
+{
+    return qint64(rows) * columns * landmarks.size() * width;
+}
+
+/**
+ * @brief Checks if the distances are read from a mapped file instead of memory
+ * @return True if the table is mapped
+ */
+bool LandmarkTable::isMapped() const
+{
+    return mappedFile != 0;
+}
+
+/**
+ * @brief Checks whether the table has been built for a maze
+ * @param mazeRows Number of rows in the maze
+ * @param mazeColumns Number of columns in the maze
+ * @param walls One bit per node id, set for walls
+ * @return True if the size and the walls are the same
+ */
+bool LandmarkTable::matches(int mazeRows, int mazeColumns, const QBitArray &walls) const
+{
+    return !isEmpty() && rows == mazeRows && columns == mazeColumns && wallHash == hashWalls(walls);
+}
+
+/**
+ * @brief Gets the stored value for a cell a landmark can't reach, which depends on the
+ * width of the entries
+ * @return The largest value an entry can hold
+ */
+quint32 LandmarkTable::unreachable() const
+{
+    return width == 2 ? 0xffff : noDistance;
+}
+
+/**
+ * @brief Reads an entry as it is stored, the landmarks of a cell lie next to each other
+ * @param landmark The number of the landmark
+ * @param id The node id of the cell
+ * @return The steps, or unreachable()
+ */
+quint32 LandmarkTable::rawDistance(int landmark, int id) const
+{
+    int slot = id * landmarks.size() + landmark;
+    return width == 2 ? reinterpret_cast<const quint16*>(table)[slot] : reinterpret_cast<const quint32*>(table)[slot];
+}
+
+/**
+ * @brief Gets the steps from a landmark to a cell
+ * @param landmark The number of the landmark
+ * @param id The node id of the cell
+ * @return The steps, -1 if the cell can't be reached from the landmark
+ */
+int LandmarkTable::distance(int landmark, int id) const
+{
+    quint32 raw = rawDistance(landmark, id);
+    return raw == unreachable() ? -1 : int(raw);
+}
+
+/**
+ * @brief Gets the distances of a cell to all landmarks, read once per search for the goal
+ * @param id The node id of the cell
+ * @return One distance per landmark, -1 where it can't be reached
+ */
+QVector<int> LandmarkTable::distancesOf(int id) const
+{
+    QVector<int> distances(landmarks.size());
+    for(int kk = 0; kk < landmarks.size(); kk++){
+        distances[kk] = distance(kk, id);
+    }
+    return distances;
+}
+
+/**
+ * @brief Gets a lower bound on the steps from a cell to the goal from the triangle inequality
+ * @param id The node id of the cell
+ * @param goalDistances The distances of the goal to the landmarks, from distancesOf
+ * @return The largest |d(L,goal) - d(L,cell)| over the landmarks that reach both
+ */
+int LandmarkTable::estimate(int id, const QVector<int> &goalDistances) const
+{
+    quint32 none = unreachable();
+    int best = 0;
+    int count = landmarks.size();
+    for(int kk = 0; kk < count; kk++){
+        quint32 raw = rawDistance(kk, id);
+        if(raw == none || goalDistances.at(kk) < 0){
+            continue;
+        }
+        best = qMax(best, qAbs(goalDistances.at(kk) - int(raw)));
+    }
+    return best;
+}
+
+/**
+ * @brief Gets the name of the table file belonging to a maze file
+ * @param mazeFileName The maze file, usually ending in .maze
+ * @return The same name ending in .alt
+ */
+QString LandmarkTable::tableFileName(const QString &mazeFileName)
+{
+    QString base = mazeFileName;
+    if(base.endsWith(".maze")){
+        base.chop(5);
+    }
+    return base + ".alt";
+}
+
+/**
+ * @brief Hashes the walls with 64 bit FNV-1a, so a table can tell if the maze changed
+ * @param walls One bit per node id, set for walls
+ * @return The fingerprint
+ */
+quint64 LandmarkTable::hashWalls(const QBitArray &walls)
+{
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    quint8 byte = 0;
+    for(int ii = 0; ii < walls.size(); ii++){
+        byte = quint8(byte << 1) | quint8(walls.testBit(ii));
+        if(ii % 8 == 7 || ii == walls.size() - 1){
+            hash = (hash ^ byte) * Q_UINT64_C(1099511628211);
+            byte = 0;
+        }
+    }
+    return (hash ^ quint64(walls.size())) * Q_UINT64_C(1099511628211);
+}
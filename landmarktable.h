@@ -0,0 +1,69 @@
+#ifndef LANDMARKTABLE_H
+#define LANDMARKTABLE_H
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "mazegrid.h"
+
+/**
+ * @brief Distances from a few landmark cells to every cell, for the ALT (A*, landmarks,
+ * triangle inequality) estimate. For a landmark L the distance between two cells is at least
+ * |d(L,goal) - d(L,cell)|, which follows the walls of the maze where the grid distance doesn't.
+ *
+ * The landmarks are picked farthest-point first: each one is the cell whose distance to the
+ * landmarks picked so far is largest. They're picked in batches of one per thread, the
+ * breadth first searches of a batch run in parallel. Within a batch the grid distance to the
+ * other picks stands in for the walking distance, which it never overestimates.
+ *
+ * The table holds the distances of a cell next to each other, 16 bits wide if they fit and
+ * 32 bits otherwise. It's saved next to the maze file and memory-mapped when loaded, so a
+ * large table costs neither a read nor a copy.
+ */
+class LandmarkTable
+{
+public:
+    LandmarkTable();
+    ~LandmarkTable();
+
+    bool build(const MazeGrid &grid, int landmarkCount); ///< Picks the landmarks and fills the table, false if no cell is open
+    bool save(const QString &fileName) const; ///< Writes the table
+    bool load(const QString &fileName); ///< Maps a table written by save
+    void clear();
+
+    bool isEmpty() const;
+    int getLandmarkCount() const;
+    const QVector<int> &getLandmarks() const; ///< Node ids of the landmarks
+    qint64 getByteSize() const; ///< Size of the distances
+    bool isMapped() const; ///< True if the distances are read from the file
+    bool matches(int mazeRows, int mazeColumns, const QBitArray &walls) const; ///< True if the table has been built for this maze
+
+    int distance(int landmark, int id) const; ///< Steps from a landmark to a cell, -1 if it can't be reached
+    QVector<int> distancesOf(int id) const; ///< The distances of a cell to all landmarks, -1 where unreachable
+    int estimate(int id, const QVector<int> &goalDistances) const; ///< Lower bound on the steps from a cell to the goal
+
+    static QString tableFileName(const QString &mazeFileName); ///< The table file belonging to a maze file
+    static quint64 hashWalls(const QBitArray &walls); ///< Fingerprint of the walls a table belongs to
+
+private:
+    static const quint32 magic = 0x4d5a4c31; ///< "MZL1"
+    static const qint32 version = 1;
+    static const int tableAlignment = 16; ///< Offset of the distances in the file is a multiple of this
+
+    int rows;
+    int columns;
+    int width; ///< Bytes per distance, 2 or 4
+    quint64 wallHash;
+    QVector<int> landmarks;
+    QByteArray ownedTable; ///< The distances after a build
+    QFile *mappedFile; ///< The file the distances are mapped from after a load
+    const uchar *table; ///< The distances, cell by cell
+
+    quint32 rawDistance(int landmark, int id) const;
+    quint32 unreachable() const;
+};
+
+#endif // LANDMARKTABLE_H
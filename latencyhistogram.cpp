@@ -0,0 +1,120 @@
+#include "latencyhistogram.h"
+
+#include <QJsonArray>
+
+/**
+ * @brief Creates an empty histogram
+ */
+LatencyHistogram::LatencyHistogram()
+{
+    buckets.fill(0, BucketCount);
+    count = 0;
+    total = 0;
+    maximum = 0;
+}
+
+/**
+ * @brief Counts one latency
+ * @param microseconds The latency
+ */
+void LatencyHistogram::add(qint64 microseconds)
+{
+    microseconds = qMax(microseconds, qint64(0));
+    int bucket = 0;
+    while(bucket < BucketCount - 1 && (qint64(1) << bucket) <= microseconds){
+        bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    total += microseconds;
+    maximum = qMax(maximum, microseconds);
+}
+
+/**
+ * @brief Adds the counts of another histogram to this one
+ * @param other The other histogram
+ */
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for(int ii = 0; ii < BucketCount; ii++){
+        buckets[ii] += other.buckets.at(ii);
+    }
+    count += other.count;
+    total += other.total;
+    maximum = qMax(maximum, other.maximum);
+}
+
+/**
+ * @brief Gets the number of latencies counted
+ * @return The count
+ */
+qint64 LatencyHistogram::getCount() const
+{
+    return count;
+}
+
+/**
+ * @brief Gets the largest latency counted
+ * @return The latency in microseconds
+ */
+qint64 LatencyHistogram::getMaximum() const
+{
+    return maximum;
+}
+
+/**
+ * @brief Gets the mean of all latencies counted
+ * @return The mean in microseconds, 0 if nothing has been counted
+ */
+double LatencyHistogram::getMean() const
+{
+    return count > 0 ? double(total) / count : 0.0;
+}
+
+/**
+ * @brief Finds the bucket below which the given fraction of all latencies lie
+ * @param fraction Between 0 and 1, 0.99 for the 99th percentile
+ * @return The upper bound of that bucket in microseconds, capped at the maximum
+ */
+qint64 LatencyHistogram::percentile(double fraction) const
+{
+    if(count == 0){
+        return 0;
+    }
+    qint64 wanted = qMax(qint64(1), qint64(fraction * count + 0.5));
+    qint64 seen = 0;
+    for(int ii = 0; ii < BucketCount; ii++){
+        seen += buckets.at(ii);
+        if(seen >= wanted){
+            return qMin(maximum, (qint64(1) << ii) - 1);
+        }
+    }
+    return maximum;
+}
+
+/**
+ * @brief Summarizes the histogram for a stats reply
+ * @return Count, mean, percentiles, maximum and the non-empty buckets as [upper bound, count] pairs
+ */
+QJsonObject LatencyHistogram::toJson() const
+{
+    QJsonObject summary;
+    summary.insert("count", double(count));
+    summary.insert("meanUs", getMean());
+    summary.insert("p50Us", double(percentile(0.5)));
+    summary.insert("p90Us", double(percentile(0.9)));
+    summary.insert("p99Us", double(percentile(0.99)));
+    summary.insert("maxUs", double(maximum));
+
+    QJsonArray nonEmpty;
+    for(int ii = 0; ii < BucketCount; ii++){
+        if(buckets.at(ii) > 0){
+            QJsonArray bucket;
+            bucket.append(double((qint64(1) << ii) - 1));
+            bucket.append(double(buckets.at(ii)));
+            nonEmpty.append(bucket);
+        }
+    }
+    summary.insert("buckets", nonEmpty);
+    return summary;
+}
@@ -0,0 +1,33 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QJsonObject>
+#include <QVector>
+
+/**
+ * @brief Counts latencies in power of two microsecond buckets. Bucket i holds latencies
+ * from 2^(i-1) up to 2^i - 1 microseconds, so percentiles are accurate to a factor of two
+ * at a fixed, tiny memory cost.
+ */
+class LatencyHistogram
+{
+public:
+    enum { BucketCount = 40 };
+
+    LatencyHistogram();
+    void add(qint64 microseconds); ///< Counts one latency
+    void merge(const LatencyHistogram &other); ///< Adds the counts of another histogram
+    qint64 getCount() const;
+    qint64 getMaximum() const; ///< The largest latency added, in microseconds
+    double getMean() const; ///< The mean latency in microseconds
+    qint64 percentile(double fraction) const; ///< Upper bound of the bucket holding the given fraction of latencies
+    QJsonObject toJson() const; ///< Count, mean, percentiles and the non-empty buckets
+
+private:
+    QVector<qint64> buckets;
+    qint64 count;
+    qint64 total;
+    qint64 maximum;
+};
+
+#endif // LATENCYHISTOGRAM_H
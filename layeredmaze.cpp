@@ -0,0 +1,769 @@
+#include "layeredmaze.h"
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include "mazegrid.h"
+
+/**
+ * @brief The A* estimate: the Manhattan distance over rows, columns and floors, which no step
+ * shortens by more than one. Where a portal could be shorter, the distance to the nearest
+ * portal end plus the step through and the least distance from a portal end to the goal is
+ * taken instead, which no step shortens by more than one either. The nearest portal end is
+ * bounded by the rectangle around the portal ends of each floor, so an estimate costs one
+ * distance per floor however many portals there are. The distance to a rectangle is zero at
+ * every portal end and changes by at most one per step like the distance to a cell.
+ */
+struct DistanceEstimate
+{
+    int goalLayer;
+    int goalRow;
+    int goalColumn;
+    QVector<int> portalBounds; ///< Per floor the first and last row and column with portal ends, first after last without any
+    int portalToGoal; ///< Least distance from a portal end to the goal, -1 without portals
+
+    int manhattan(int layer, int row, int column) const
+    {
+        return qAbs(layer - goalLayer) + qAbs(row - goalRow) + qAbs(column - goalColumn);
+    }
+
+    int operator()(int layer, int row, int column) const
+    {
+        int distance = manhattan(layer, row, column);
+        if(portalToGoal < 0 || distance <= portalToGoal + 1){
+            return distance;
+        }
+        int nearest = distance;
+        for(int ii = 0; ii < portalBounds.size(); ii += 4){
+            if(portalBounds.at(ii) > portalBounds.at(ii + 1)){
+                continue;
+            }
+            int rowDistance = qMax(0, qMax(portalBounds.at(ii) - row, row - portalBounds.at(ii + 1)));
+            int columnDistance = qMax(0, qMax(portalBounds.at(ii + 2) - column, column - portalBounds.at(ii + 3)));
+            nearest = qMin(nearest, qAbs(layer - ii / 4) + rowDistance + columnDistance);
+        }
+        return qMin(distance, nearest + 1 + portalToGoal);
+    }
+};
+
+/// A cell on the A* open list with the direction back to the cell that put it there
+struct OpenCell
+{
+    int index;
+    int parentDirection; ///< -1 for the start
+};
+
+/**
+ * @brief Creates an empty maze
+ */
+LayeredMaze::LayeredMaze()
+{
+    resize(0, 0, 0);
+}
+
+/**
+ * @brief Creates open floors without stairs or portals
+ * @param nlayers Number of floors
+ * @param nrows Rows per floor
+ * @param ncolumns Columns per floor
+ */
+LayeredMaze::LayeredMaze(int nlayers, int nrows, int ncolumns)
+{
+    resize(nlayers, nrows, ncolumns);
+}
+
+/**
+ * @brief Reallocates the planes. Every floor is padded with a border of walls like the
+ * row-major MazeGrid, so the searches step off a floor only by stairs and portals.
+ * @param nlayers Number of floors
+ * @param nrows Rows per floor
+ * @param ncolumns Columns per floor
+ */
+void LayeredMaze::resize(int nlayers, int nrows, int ncolumns)
+{
+    layers = qMax(nlayers, 0);
+    rows = qMax(nrows, 0);
+    columns = qMax(ncolumns, 0);
+    stride = columns + 2;
+    layerSlots = (rows + 2) * stride;
+    storageSize = layers * layerSlots;
+    stairCount = 0;
+
+    offsets[South] = stride;
+    offsets[North] = -stride;
+    offsets[East] = 1;
+    offsets[West] = -1;
+    offsets[Up] = layerSlots;
+    offsets[Down] = -layerSlots;
+
+    int words = (storageSize + 63) / 64;
+    wallPlane.fill(~quint64(0), words);
+    stairUpPlane.fill(0, words);
+    stairDownPlane.fill(0, words);
+    portalPlane.fill(0, words);
+    linkPlane.fill(0, words);
+    portals.clear();
+    for(int layer = 0; layer < layers; layer++){
+        for(int row = 0; row < rows; row++){
+            for(int column = 0; column < columns; column++){
+                assignBit(wallPlane, indexOfId(idOf(layer, row, column)), false);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gets the number of floors
+ * @return The number of floors
+ */
+int LayeredMaze::getLayers() const
+{
+    return layers;
+}
+
+/**
+ * @brief Gets the number of rows of every floor
+ * @return The number of rows
+ */
+int LayeredMaze::getRows() const
+{
+    return rows;
+}
+
+/**
+ * @brief Gets the number of columns of every floor
+ * @return The number of columns
+ */
+int LayeredMaze::getColumns() const
+{
+    return columns;
+}
+
+/**
+ * @brief Gets the number of cells on one floor, the padding left out
+ * @return Rows times columns
+ */
+int LayeredMaze::getLayerSize() const
+{
+    return rows * columns;
+}
+
+/**
+ * @brief Gets the number of cells on all floors, which is also the first id past the last
+ * @return Floors times rows times columns
+ */
+int LayeredMaze::getCellCount() const
+{
+    return layers * rows * columns;
+}
+
+/**
+ * @brief Gets the memory held by the maze, five bit planes and a hash entry per portal end
+ * @return Bytes
+ */
+qint64 LayeredMaze::getMemoryUsage() const
+{
+    return qint64(wallPlane.size()) * 5 * sizeof(quint64) + qint64(portals.size()) * 3 * sizeof(int);
+}
+
+/**
+ * @brief Checks if a cell is a wall
+ * @param id The node id, has to be in the maze
+ * @return True for a wall
+ */
+bool LayeredMaze::isWall(int id) const
+{
+    return testBit(wallPlane, indexOfId(id));
+}
+
+/**
+ * @brief Makes a cell a wall or opens it. Stairs and portals of the cell stay, the searches
+ * never enter a wall through them.
+ * @param id The node id, has to be in the maze
+ * @param wall True for a wall
+ */
+void LayeredMaze::setWall(int id, bool wall)
+{
+    assignBit(wallPlane, indexOfId(id), wall);
+}
+
+/**
+ * @brief Sets the walls of one floor, as collected from the maze view
+ * @param layer The floor
+ * @param walls One bit per 2D node id, set for walls
+ */
+void LayeredMaze::setLayerWalls(int layer, const QBitArray &walls)
+{
+    if(layer < 0 || layer >= layers){
+        return;
+    }
+    int first = layer * getLayerSize();
+    int count = qMin(walls.size(), getLayerSize());
+    for(int id = 0; id < count; id++){
+        setWall(first + id, walls.testBit(id));
+    }
+}
+
+/**
+ * @brief Gets the walls of one floor
+ * @param layer The floor
+ * @return One bit per 2D node id, set for walls
+ */
+QBitArray LayeredMaze::getLayerWalls(int layer) const
+{
+    QBitArray walls(getLayerSize());
+    if(layer < 0 || layer >= layers){
+        return walls;
+    }
+    int first = layer * getLayerSize();
+    for(int id = 0; id < walls.size(); id++){
+        if(isWall(first + id)){
+            walls.setBit(id);
+        }
+    }
+    return walls;
+}
+
+/**
+ * @brief Fills every floor with random walls from an xorshift generator, about a third of the
+ * cells, as MazeGrid::randomize does for one floor
+ * @param seed The generator seed, 0 picks a fixed one
+ */
+void LayeredMaze::randomize(quint32 seed)
+{
+    quint32 state = seed ? seed : 0x9e3779b9u;
+    int cells = getCellCount();
+    for(int id = 0; id < cells; id++){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        setWall(id, state % 3 >= 2);
+    }
+    if(cells > 0){
+        setWall(0, false);
+        setWall(cells - 1, false);
+    }
+}
+
+/**
+ * @brief Checks if stairs lead from a cell to the cell above
+ * @param id The node id, has to be in the maze
+ * @return True if there are stairs up
+ */
+bool LayeredMaze::hasStairUp(int id) const
+{
+    return testBit(stairUpPlane, indexOfId(id));
+}
+
+/**
+ * @brief Checks if stairs lead from a cell to the cell below
+ * @param id The node id, has to be in the maze
+ * @return True if there are stairs down
+ */
+bool LayeredMaze::hasStairDown(int id) const
+{
+    return testBit(stairDownPlane, indexOfId(id));
+}
+
+/**
+ * @brief Adds or removes the stairs from a cell to the cell right above it. The top floor has
+ * no stairs up.
+ * @param id The node id of the lower cell
+ * @param stair True to add the stairs
+ */
+void LayeredMaze::setStair(int id, bool stair)
+{
+    if(id < 0 || id >= getCellCount() - getLayerSize()){
+        return;
+    }
+    int index = indexOfId(id);
+    if(testBit(stairUpPlane, index) != stair){
+        stairCount += stair ? 1 : -1;
+    }
+    assignBit(stairUpPlane, index, stair);
+    assignBit(stairDownPlane, index + layerSlots, stair);
+    updateLink(index);
+    updateLink(index + layerSlots);
+}
+
+/**
+ * @brief Gets the other end of the portal of a cell
+ * @param id The node id, has to be in the maze
+ * @return The node id of the other end, -1 if the cell has no portal
+ */
+int LayeredMaze::portalOf(int id) const
+{
+    int index = indexOfId(id);
+    if(!testBit(portalPlane, index)){
+        return -1;
+    }
+    return idOfIndex(portals.value(index));
+}
+
+/**
+ * @brief Joins two cells with a portal both ways. A cell has at most one portal, portals the
+ * two cells had before are removed.
+ * @param from The node id of one end
+ * @param to The node id of the other end
+ */
+void LayeredMaze::setPortal(int from, int to)
+{
+    int cells = getCellCount();
+    if(from == to || from < 0 || to < 0 || from >= cells || to >= cells){
+        return;
+    }
+    removePortal(from);
+    removePortal(to);
+    int fromIndex = indexOfId(from);
+    int toIndex = indexOfId(to);
+    portals.insert(fromIndex, toIndex);
+    portals.insert(toIndex, fromIndex);
+    assignBit(portalPlane, fromIndex, true);
+    assignBit(portalPlane, toIndex, true);
+    updateLink(fromIndex);
+    updateLink(toIndex);
+}
+
+/**
+ * @brief Removes the portal of a cell at both ends
+ * @param id The node id of either end, has to be in the maze
+ */
+void LayeredMaze::removePortal(int id)
+{
+    int index = indexOfId(id);
+    if(!testBit(portalPlane, index)){
+        return;
+    }
+    int other = portals.take(index);
+    portals.remove(other);
+    assignBit(portalPlane, index, false);
+    assignBit(portalPlane, other, false);
+    updateLink(index);
+    updateLink(other);
+}
+
+/**
+ * @brief Removes all stairs and portals, the walls stay
+ */
+void LayeredMaze::clearConnections()
+{
+    stairUpPlane.fill(0);
+    stairDownPlane.fill(0);
+    portalPlane.fill(0);
+    linkPlane.fill(0);
+    portals.clear();
+    stairCount = 0;
+}
+
+/**
+ * @brief Replaces the stairs and portals with random ones. Stairs join an open cell to the open
+ * cell above it, portals join two open cells without a portal anywhere in the maze. Crowded
+ * floors may get fewer of them than asked for.
+ * @param stairsPerLayer Stairs from every floor but the top one to the floor above
+ * @param portalCount Portals in the whole maze
+ * @param seed The generator seed, 0 picks a fixed one
+ */
+void LayeredMaze::placeConnections(int stairsPerLayer, int portalCount, quint32 seed)
+{
+    clearConnections();
+    int layerSize = getLayerSize();
+    if(layerSize == 0){
+        return;
+    }
+    quint32 state = seed ? seed : 0x2545f491u;
+    for(int layer = 0; layer + 1 < layers; layer++){
+        int placed = 0;
+        for(int attempt = 0; placed < stairsPerLayer && attempt < stairsPerLayer * 64; attempt++){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            int id = layer * layerSize + int(state % quint32(layerSize));
+            if(!isWall(id) && !isWall(id + layerSize) && !hasStairUp(id)){
+                setStair(id, true);
+                placed++;
+            }
+        }
+    }
+
+    int cells = getCellCount();
+    int placed = 0;
+    for(int attempt = 0; placed < portalCount && attempt < portalCount * 64; attempt++){
+        int ends[2];
+        for(int ii = 0; ii < 2; ii++){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            ends[ii] = int(state % quint32(cells));
+        }
+        if(ends[0] != ends[1] && !isWall(ends[0]) && !isWall(ends[1])
+                && portalOf(ends[0]) < 0 && portalOf(ends[1]) < 0){
+            setPortal(ends[0], ends[1]);
+            placed++;
+        }
+    }
+}
+
+/**
+ * @brief Gets the number of stairs, each joining two floors both ways
+ * @return The number of stairs
+ */
+int LayeredMaze::getStairCount() const
+{
+    return stairCount;
+}
+
+/**
+ * @brief Gets the number of portals, the hash holds both ends of each
+ * @return The number of portals
+ */
+int LayeredMaze::getPortalCount() const
+{
+    return portals.size() / 2;
+}
+
+/**
+ * @brief Finds a shortest path over all floors, every step, stair and portal counting one.
+ * The search state lives in the call, so several searches can run on one maze at once.
+ * @param start The node id to start from
+ * @param goal The node id to find
+ * @param algorithm BFS or A*
+ * @param control Polled for cancellation every SearchControl::PollInterval expansions, if not 0
+ * @return The path and the counters
+ */
+LayeredMaze::Result LayeredMaze::search(int start, int goal, Algorithm algorithm, SearchControl *control) const
+{
+    Result result;
+    QElapsedTimer clock;
+    clock.start();
+    int cells = getCellCount();
+    if(start < 0 || goal < 0 || start >= cells || goal >= cells || isWall(start) || isWall(goal)){
+        return result;
+    }
+
+    int startIndex = indexOfId(start);
+    int goalIndex = indexOfId(goal);
+    QVector<quint64> visited((storageSize + 63) / 64, 0);
+    QVector<quint64> parents((storageSize + 15) / 16, 0); // Four bits per slot
+    if(algorithm == AStar){
+        result.found = searchAStar(startIndex, goalIndex, visited, parents, control, result);
+    }
+    else{
+        result.found = searchBreadthFirst(startIndex, goalIndex, visited, parents, control, result);
+    }
+
+    if(result.found){
+        QVector<int> reversed;
+        for(int current = goalIndex; current != startIndex;){
+            reversed.append(idOfIndex(current));
+            int direction = (parents.at(current >> 4) >> ((current & 15) * 4)) & 15;
+            current = neighbourOf(current, direction);
+        }
+        reversed.append(start);
+
+        result.path.resize(reversed.size());
+        for(int ii = 0; ii < reversed.size(); ii++){
+            result.path[ii] = reversed.at(reversed.size() - 1 - ii);
+            if(ii > 0 && layerOf(result.path.at(ii)) != layerOf(result.path.at(ii - 1))){
+                result.floorChanges++;
+            }
+        }
+    }
+    result.elapsedUs = clock.nsecsElapsed() / 1000;
+    return result;
+}
+
+/**
+ * @brief Breadth first over the planes. Cells are marked as they're queued, with the
+ * direction back to the cell that queued them.
+ * @param startIndex The storage index to start from
+ * @param goalIndex The storage index to find
+ * @param visited One bit per slot, cleared, marks the queued cells
+ * @param parents Four bits per slot, cleared, receive the direction back to the parent
+ * @param control Polled for cancel requests, may be 0
+ * @param result Receives the expanded count and the cancel state
+ * @return True if the goal was reached
+ */
+bool LayeredMaze::searchBreadthFirst(int startIndex, int goalIndex, QVector<quint64> &visited, QVector<quint64> &parents, SearchControl *control, Result &result) const
+{
+    QVector<int> queue;
+    queue.reserve(qMin(getCellCount(), 1 << 16));
+    queue.append(startIndex);
+    assignBit(visited, startIndex, true);
+
+    int head = 0;
+    while(head < queue.size()){
+        int current = queue.at(head++);
+        if(current == goalIndex){
+            result.expanded = head;
+            return true;
+        }
+        if(control != 0 && (head & (SearchControl::PollInterval - 1)) == 0
+                && control->poll(head, queue.size() - head)){
+            result.cancelled = true;
+            break;
+        }
+
+        for(int direction = 0; direction < 4; direction++){
+            int next = current + offsets[direction];
+            if(!testBit(wallPlane, next) && !testBit(visited, next)){
+                assignBit(visited, next, true);
+                parents[next >> 4] |= quint64(opposite(direction)) << ((next & 15) * 4);
+                queue.append(next);
+            }
+        }
+        if(!testBit(linkPlane, current)){
+            continue;
+        }
+        const QVector<quint64> *linkPlanes[3] = { &stairUpPlane, &stairDownPlane, &portalPlane };
+        for(int direction = Up; direction <= Through; direction++){
+            if(!testBit(*linkPlanes[direction - Up], current)){
+                continue;
+            }
+            int next = neighbourOf(current, direction);
+            if(!testBit(wallPlane, next) && !testBit(visited, next)){
+                assignBit(visited, next, true);
+                parents[next >> 4] |= quint64(opposite(direction)) << ((next & 15) * 4);
+                queue.append(next);
+            }
+        }
+    }
+    result.expanded = head;
+    return false;
+}
+
+/**
+ * @brief A* over the planes. A step changes the estimate by at most one, so the estimated path
+ * length of a new cell is the one being expanded or one of the next two, and three buckets
+ * indexed by that length modulo 3 make up the open list. Later cells come off a bucket first,
+ * which follows one path deep on ties. The length walked so far is the estimated length minus
+ * the estimate, so no per-cell lengths are kept.
+ * @param startIndex The storage index to start from
+ * @param goalIndex The storage index to find
+ * @param visited One bit per slot, cleared, marks the closed cells
+ * @param parents Four bits per slot, cleared, receive the direction back to the parent
+ * @param control Polled for cancel requests, may be 0
+ * @param result Receives the expanded count and the cancel state
+ * @return True if the goal was reached
+ */
+bool LayeredMaze::searchAStar(int startIndex, int goalIndex, QVector<quint64> &visited, QVector<quint64> &parents, SearchControl *control, Result &result) const
+{
+    DistanceEstimate estimate;
+    coordinatesOf(goalIndex, estimate.goalLayer, estimate.goalRow, estimate.goalColumn);
+    estimate.portalToGoal = -1;
+    for(int floor = 0; floor < layers; floor++){
+        estimate.portalBounds << rows << -1 << columns << -1;
+    }
+    for(QHash<int,int>::const_iterator it = portals.constBegin(); it != portals.constEnd(); ++it){
+        int layer, row, column;
+        coordinatesOf(it.key(), layer, row, column);
+        int *bounds = estimate.portalBounds.data() + layer * 4;
+        bounds[0] = qMin(bounds[0], row);
+        bounds[1] = qMax(bounds[1], row);
+        bounds[2] = qMin(bounds[2], column);
+        bounds[3] = qMax(bounds[3], column);
+        int distance = estimate.manhattan(layer, row, column);
+        if(estimate.portalToGoal < 0 || distance < estimate.portalToGoal){
+            estimate.portalToGoal = distance;
+        }
+    }
+
+    static const int rowSteps[Through] = { 1, -1, 0, 0, 0, 0 };
+    static const int columnSteps[Through] = { 0, 0, 1, -1, 0, 0 };
+    static const int layerSteps[Through] = { 0, 0, 0, 0, 1, -1 };
+
+    QVector<OpenCell> buckets[3];
+    int layer, row, column;
+    coordinatesOf(startIndex, layer, row, column);
+    int length = estimate(layer, row, column);
+    OpenCell first = { startIndex, -1 };
+    buckets[length % 3].append(first);
+    int pending = 1;
+
+    while(pending > 0){
+        QVector<OpenCell> &bucket = buckets[length % 3];
+        if(bucket.isEmpty()){
+            length++;
+            continue;
+        }
+        OpenCell cell = bucket.last();
+        bucket.removeLast();
+        pending--;
+        if(testBit(visited, cell.index)){
+            continue;
+        }
+        assignBit(visited, cell.index, true);
+        if(cell.parentDirection >= 0){
+            parents[cell.index >> 4] |= quint64(cell.parentDirection) << ((cell.index & 15) * 4);
+        }
+        result.expanded++;
+        if(cell.index == goalIndex){
+            return true;
+        }
+        if(control != 0 && (result.expanded & (SearchControl::PollInterval - 1)) == 0
+                && control->poll(int(qMin(result.expanded, qint64(0x7fffffff))), pending)){
+            result.cancelled = true;
+            return false;
+        }
+
+        coordinatesOf(cell.index, layer, row, column);
+        int walked = length - estimate(layer, row, column);
+        int directions = testBit(linkPlane, cell.index) ? int(Through) : 4;
+        for(int direction = 0; direction < directions; direction++){
+            int next = cell.index + offsets[direction];
+            if(direction == Up && !testBit(stairUpPlane, cell.index)){
+                continue;
+            }
+            if(direction == Down && !testBit(stairDownPlane, cell.index)){
+                continue;
+            }
+            if(testBit(wallPlane, next) || testBit(visited, next)){
+                continue;
+            }
+            int nextLength = walked + 1 + estimate(layer + layerSteps[direction], row + rowSteps[direction],
+                                                   column + columnSteps[direction]);
+            OpenCell nextCell = { next, opposite(direction) };
+            buckets[nextLength % 3].append(nextCell);
+            pending++;
+        }
+        if(directions == Through && testBit(portalPlane, cell.index)){
+            int next = portals.value(cell.index);
+            if(!testBit(wallPlane, next) && !testBit(visited, next)){
+                int nextLayer, nextRow, nextColumn;
+                coordinatesOf(next, nextLayer, nextRow, nextColumn);
+                OpenCell nextCell = { next, Through };
+                buckets[(walked + 1 + estimate(nextLayer, nextRow, nextColumn)) % 3].append(nextCell);
+                pending++;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Builds random floors, times BFS and A* from the first cell of the bottom floor to the
+ * last cell of the top floor, and times the 2D BFS of MazeGrid on one floor with as many cells
+ * for the cost per cell
+ * @param nlayers Number of floors
+ * @param size Rows and columns per floor
+ * @param stairsPerLayer Stairs from every floor to the next
+ * @param portalCount Portals in the whole maze
+ * @param seed The generator seed
+ * @param out Receives the report
+ * @return A process exit code, 1 if the two searches disagree on the path length
+ */
+int LayeredMaze::runComparison(int nlayers, int size, int stairsPerLayer, int portalCount, quint32 seed, QTextStream &out)
+{
+    nlayers = qMax(nlayers, 1);
+    size = qMax(size, 2);
+
+    QElapsedTimer clock;
+    clock.start();
+    LayeredMaze maze(nlayers, size, size);
+    maze.randomize(seed);
+    maze.placeConnections(stairsPerLayer, portalCount, seed);
+    out << "Floors: " << nlayers << " of " << size << "x" << size << ", " << maze.getStairCount() << " stairs, "
+        << maze.getPortalCount() << " portals, " << maze.getMemoryUsage() << " bytes, built in "
+        << clock.elapsed() << " ms\n";
+
+    int goal = maze.getCellCount() - 1;
+    const char *names[2] = { "BFS", "A*" };
+    Result results[2];
+    for(int ii = 0; ii < 2; ii++){
+        results[ii] = maze.search(0, goal, ii == 0 ? BreadthFirst : AStar);
+        const Result &result = results[ii];
+        out << QString(names[ii]).leftJustified(5);
+        if(result.found){
+            out << "path of " << result.path.size() << " cells over " << result.floorChanges << " floor changes, ";
+        }
+        else{
+            out << "no path, ";
+        }
+        out << result.expanded << " expanded in " << QString::number(result.elapsedUs / 1000.0, 'f', 2) << " ms, "
+            << QString::number(result.elapsedUs * 1000.0 / qMax(result.expanded, qint64(1)), 'f', 1)
+            << " ns per cell\n";
+    }
+
+    MazeGrid flat(nlayers * size, size);
+    flat.randomize(seed);
+    QVector<int> path;
+    int expanded = 0;
+    clock.restart();
+    bool found = flat.findPath(0, flat.getCellCount() - 1, path, &expanded);
+    qint64 flatNs = clock.nsecsElapsed();
+    out << QString("2D").leftJustified(5) << (found ? "path found, " : "no path, ") << expanded << " expanded on "
+        << nlayers * size << "x" << size << " in " << QString::number(flatNs / 1e6, 'f', 2) << " ms, "
+        << QString::number(double(flatNs) / qMax(expanded, 1), 'f', 1) << " ns per cell\n";
+
+    if(results[0].found != results[1].found || results[0].path.size() != results[1].path.size()){
+        out << "BFS and A* disagree on the shortest path\n";
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Maps a node id to its slot in the planes. The floors lie one after the other, each
+ * padded with a row of walls above and below and a column of walls on either side, so a
+ * cell at row r and column c of floor l is at l * layerSlots + (r + 1) * stride + c + 1
+ * with stride = columns + 2 and layerSlots = (rows + 2) * stride. Stepping north, south,
+ * east or west from any cell lands on a cell or a padding wall of the same floor, and the
+ * padding is never a cell of another floor.
+ * @param id The node id, floor-major and row-major without padding
+ * @return The storage index
+ */
+int LayeredMaze::indexOfId(int id) const
+{
+    int layerSize = rows * columns;
+    int layer = id / layerSize;
+    int rest = id - layer * layerSize;
+    return layer * layerSlots + (rest / columns + 1) * stride + rest % columns + 1;
+}
+
+/**
+ * @brief Maps a slot in the planes back to its node id, the inverse of indexOfId
+ * @param index The storage index of a cell, not of the padding
+ * @return The node id
+ */
+int LayeredMaze::idOfIndex(int index) const
+{
+    int layer, row, column;
+    coordinatesOf(index, layer, row, column);
+    return idOf(layer, row, column);
+}
+
+/**
+ * @brief Splits a slot in the planes into the floor, row and column of the cell. The padding
+ * gives row or column -1 or the size of the floor.
+ * @param index The storage index
+ * @param layer Receives the floor
+ * @param row Receives the row
+ * @param column Receives the column
+ */
+void LayeredMaze::coordinatesOf(int index, int &layer, int &row, int &column) const
+{
+    layer = index / layerSlots;
+    int rest = index - layer * layerSlots;
+    row = rest / stride - 1;
+    column = rest % stride - 1;
+}
+
+/**
+ * @brief Gets the slot a step leads to. The planar steps and the stairs are fixed offsets,
+ * stairs lead a whole padded floor up or down, only the step through a portal is looked up.
+ * @param index The storage index of the cell
+ * @param direction The direction of the step
+ * @return The storage index of the neighbour, unchecked for walls
+ */
+int LayeredMaze::neighbourOf(int index, int direction) const
+{
+    return direction == Through ? portals.value(index) : index + offsets[direction];
+}
+
+/**
+ * @brief Sets the link bit of a slot from its stairs and portal bits, after any of them changed
+ * @param index The storage index
+ */
+void LayeredMaze::updateLink(int index)
+{
+    assignBit(linkPlane, index, testBit(stairUpPlane, index) || testBit(stairDownPlane, index) || testBit(portalPlane, index));
+}
@@ -0,0 +1,137 @@
+#ifndef LAYEREDMAZE_H
+#define LAYEREDMAZE_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QTextStream>
+#include <QVector>
+
+#include "searchcontrol.h"
+
+/**
+ * @brief A maze of several floors stacked on top of each other, joined by stairs between a cell
+ * and the cell right above it and by portals between any two cells.
+ *
+ * Like the row-major MazeGrid the cells are bits in planes with a border of walls around every
+ * floor, and the floors follow one another in memory, so a neighbour on the same floor is a
+ * fixed offset away without a bounds check and the cell above or below is one floor further.
+ * Stairs are a bit per cell for each way, portals a bit per cell and a hash of the few cells
+ * that have one. Node ids are layer-major, layer * rows * columns + row * columns + column, so
+ * the first floor has the ids of a 2D maze.
+ *
+ * The searches keep their state in a visited plane and four bits per cell for the direction
+ * back to the parent. BFS marks cells as it queues them. A* estimates the Manhattan distance
+ * plus the floors in between, lowered where a way through a portal could be shorter. A step
+ * changes that estimate by at most one, so the open list is three buckets of cells for the
+ * current and the next two estimated lengths, and cells are marked as they're expanded.
+ */
+class LayeredMaze
+{
+public:
+    /// Ways out of a cell, the first four in the same order as MazeGrid
+    enum Direction {
+        South = 0,
+        North,
+        East,
+        West,
+        Up, ///< Up the stairs
+        Down, ///< Down the stairs
+        Through, ///< Through the portal
+        DirectionCount
+    };
+
+    /// The searches over all floors
+    enum Algorithm {
+        BreadthFirst = 0,
+        AStar
+    };
+
+    /// The outcome of a search
+    struct Result
+    {
+        Result() : found(false), cancelled(false), expanded(0), floorChanges(0), elapsedUs(0) {}
+        bool found; ///< True if the goal has been reached
+        bool cancelled; ///< True if the search stopped on a cancel request
+        qint64 expanded; ///< Cells taken off the frontier
+        int floorChanges; ///< Stairs and portals to other floors along the path
+        qint64 elapsedUs;
+        QVector<int> path; ///< Node ids from the start to the goal, empty if not found
+    };
+
+    LayeredMaze();
+    LayeredMaze(int nlayers, int nrows, int ncolumns);
+    void resize(int nlayers, int nrows, int ncolumns); ///< Reallocates as open floors without stairs or portals
+
+    int getLayers() const;
+    int getRows() const;
+    int getColumns() const;
+    int getLayerSize() const; ///< Cells of one floor
+    int getCellCount() const; ///< Cells of all floors
+    qint64 getMemoryUsage() const; ///< Bytes of the planes and the portals, five bits per cell and a few per portal
+
+    int idOf(int layer, int row, int column) const { return (layer * rows + row) * columns + column; }
+    int layerOf(int id) const { return id / (rows * columns); }
+
+    bool isWall(int id) const;
+    void setWall(int id, bool wall);
+    void setLayerWalls(int layer, const QBitArray &walls); ///< Sets the walls of a floor from one bit per 2D node id
+    QBitArray getLayerWalls(int layer) const; ///< Gets one bit per 2D node id of a floor, set for walls
+    void randomize(quint32 seed); ///< Makes about a third of the cells of every floor walls, keeping the first and the last cell open
+
+    bool hasStairUp(int id) const;
+    bool hasStairDown(int id) const;
+    void setStair(int id, bool stair); ///< Adds or removes the stairs from a cell to the cell above
+    int portalOf(int id) const; ///< The other end of the portal of a cell, -1 for none
+    void setPortal(int from, int to); ///< Joins two cells, replacing portals they had before
+    void removePortal(int id); ///< Removes the portal of a cell and of its other end
+    void clearConnections(); ///< Removes all stairs and portals
+    void placeConnections(int stairsPerLayer, int portalCount, quint32 seed); ///< Replaces the stairs and portals with random ones between open cells
+    int getStairCount() const;
+    int getPortalCount() const;
+
+    Result search(int start, int goal, Algorithm algorithm, SearchControl *control = 0) const; ///< Finds a shortest path over all floors
+
+    static int runComparison(int nlayers, int size, int stairsPerLayer, int portalCount, quint32 seed, QTextStream &out); ///< Times both searches on random floors against a 2D BFS with as many cells
+
+private:
+    static inline bool testBit(const QVector<quint64> &plane, int index)
+    {
+        return (plane.at(index >> 6) >> (index & 63)) & 1;
+    }
+    static inline void assignBit(QVector<quint64> &plane, int index, bool value)
+    {
+        if(value){
+            plane[index >> 6] |= (quint64(1) << (index & 63));
+        }
+        else{
+            plane[index >> 6] &= ~(quint64(1) << (index & 63));
+        }
+    }
+    static int opposite(int direction) { return direction == Through ? Through : direction ^ 1; }
+
+    int layers;
+    int rows;
+    int columns;
+    int stride; ///< Slots per padded row
+    int layerSlots; ///< Slots per padded floor
+    int storageSize;
+    int offsets[Through]; ///< Storage offset of the neighbour in every direction but through a portal
+    int stairCount;
+
+    QVector<quint64> wallPlane;
+    QVector<quint64> stairUpPlane; ///< Set where stairs lead to the cell above
+    QVector<quint64> stairDownPlane; ///< Set where stairs lead to the cell below
+    QVector<quint64> portalPlane; ///< Set where a portal starts, the other end is in portals
+    QVector<quint64> linkPlane; ///< Set where any stairs or a portal start, so the searches test one bit for all three
+    QHash<int,int> portals; ///< Storage index of both ends to the other end
+
+    int indexOfId(int id) const; ///< Storage index of a node id
+    int idOfIndex(int index) const; ///< Node id of a storage index
+    void coordinatesOf(int index, int &layer, int &row, int &column) const; ///< Floor, row and column of a storage index
+    int neighbourOf(int index, int direction) const; ///< Storage index of the neighbour in a direction
+    void updateLink(int index); ///< Recomputes the link bit of a slot
+    bool searchBreadthFirst(int startIndex, int goalIndex, QVector<quint64> &visited, QVector<quint64> &parents, SearchControl *control, Result &result) const;
+    bool searchAStar(int startIndex, int goalIndex, QVector<quint64> &visited, QVector<quint64> &parents, SearchControl *control, Result &result) const;
+};
+
+#endif // LAYEREDMAZE_H
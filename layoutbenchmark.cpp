@@ -0,0 +1,294 @@
+#include "layoutbenchmark.h"
+#include "mazegrid.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointF>
+#include <QVector>
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#endif
+
+namespace LayoutBenchmark {
+
+/**
+ * @brief Stand-in for MazeNode with the same fields and allocation pattern, without the
+ * graphics items which need a running GUI
+ */
+struct HashNode
+{
+    int rectSize;
+    int id;
+    void *rectangle;
+    QPointF *position;
+    void *description;
+    HashNode *previousNode;
+    bool nodeIsWall;
+    bool nodeIsEntrance;
+    bool nodeIsExit;
+    bool visited;
+};
+
+/// Size of the block allocated in place of the graphics items of each node
+static const int graphicsItemBytes = 128;
+
+/**
+ * @brief Counts hardware cache misses of this process through perf_event_open.
+ * Not available on other systems or if the kernel doesn't allow it.
+ */
+class CacheMissCounter
+{
+public:
+    CacheMissCounter() : fd(-1)
+    {
+#ifdef Q_OS_LINUX
+        perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        fd = int(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMissCounter()
+    {
+#ifdef Q_OS_LINUX
+        if(fd >= 0){
+            close(fd);
+        }
+#endif
+    }
+    bool isAvailable() const { return fd >= 0; }
+    void start()
+    {
+#ifdef Q_OS_LINUX
+        if(fd >= 0){
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    /// Stops counting and returns the misses since start(), -1 if not available
+    qint64 stop()
+    {
+#ifdef Q_OS_LINUX
+        if(fd >= 0){
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if(read(fd, &count, sizeof(count)) == sizeof(count)){
+                return count;
+            }
+        }
+#endif
+        return -1;
+    }
+
+private:
+    int fd;
+};
+
+/// Measurements of one layout
+struct Measurement
+{
+    Measurement() : milliseconds(0), cacheMisses(-1), expanded(0), pathLength(0), bytes(0) {}
+    double milliseconds; ///< Best time over all repetitions
+    qint64 cacheMisses; ///< Cache misses of the best repetition, -1 if not counted
+    int expanded;
+    int pathLength;
+    qint64 bytes; ///< Memory holding the maze and search state
+};
+
+/**
+ * @brief Breadth first search over the node hash, the way SearchStepper walks it
+ */
+static int searchNodeHash(QHash<int,HashNode*> &nodeHash, int size, int entrance, int exit, int &expanded)
+{
+    foreach(HashNode *node, nodeHash){
+        node->visited = false;
+        node->previousNode = 0;
+    }
+
+    QVector<HashNode*> queue;
+    HashNode *start = nodeHash.value(entrance);
+    start->visited = true;
+    queue.append(start);
+
+    int head = 0;
+    HashNode *exitNode = 0;
+    while(head < queue.size()){
+        HashNode *current = queue.at(head++);
+        if(current->id == exit){
+            exitNode = current;
+            break;
+        }
+        int id = current->id;
+        int neighbourIds[4] = { -1, -1, -1, -1 };
+        if(id + size < size * size){
+            neighbourIds[0] = id + size;
+        }
+        if(id >= size){
+            neighbourIds[1] = id - size;
+        }
+        if((id + 1) % size != 0){
+            neighbourIds[2] = id + 1;
+        }
+        if(id % size != 0){
+            neighbourIds[3] = id - 1;
+        }
+        for(int direction = 0; direction < 4; direction++){
+            if(neighbourIds[direction] < 0){
+                continue;
+            }
+            HashNode *next = nodeHash.value(neighbourIds[direction]);
+            if(!next->nodeIsWall && !next->visited){
+                next->visited = true;
+                next->previousNode = current;
+                queue.append(next);
+            }
+        }
+    }
+
+    expanded = head;
+    int length = 0;
+    for(HashNode *node = exitNode; node != 0; node = node->previousNode){
+        length++;
+    }
+    return length;
+}
+
+/**
+ * @brief Times the node hash layout
+ */
+static Measurement measureNodeHash(const MazeGrid &maze, int size, int repetitions, CacheMissCounter &counter)
+{
+    QHash<int,HashNode*> nodeHash;
+    QVector<char*> graphicsItems;
+    for(int id = 0; id < size * size; id++){
+        HashNode *node = new HashNode;
+        node->rectSize = 0;
+        node->id = id;
+        graphicsItems.append(new char[graphicsItemBytes]);
+        node->rectangle = graphicsItems.last();
+        node->position = new QPointF(id % size, id / size);
+        node->description = 0;
+        node->previousNode = 0;
+        node->nodeIsWall = maze.isWall(maze.indexOfId(id));
+        node->nodeIsEntrance = id == 0;
+        node->nodeIsExit = id == size * size - 1;
+        node->visited = false;
+        nodeHash.insert(id, node);
+    }
+
+    Measurement measurement;
+    measurement.bytes = qint64(size) * size * (sizeof(HashNode) + sizeof(QPointF) + 2 * sizeof(void*));
+    for(int repetition = 0; repetition < repetitions; repetition++){
+        QElapsedTimer timer;
+        timer.start();
+        counter.start();
+        measurement.pathLength = searchNodeHash(nodeHash, size, 0, size * size - 1, measurement.expanded);
+        qint64 misses = counter.stop();
+        double milliseconds = timer.nsecsElapsed() / 1e6;
+        if(repetition == 0 || milliseconds < measurement.milliseconds){
+            measurement.milliseconds = milliseconds;
+            measurement.cacheMisses = misses;
+        }
+    }
+
+    foreach(HashNode *node, nodeHash){
+        delete node->position;
+        delete node;
+    }
+    foreach(char *item, graphicsItems){
+        delete[] item;
+    }
+    return measurement;
+}
+
+/**
+ * @brief Times the grid planes in one ordering
+ */
+static Measurement measureGrid(const QBitArray &walls, int size, MazeGrid::Ordering ordering, int repetitions, CacheMissCounter &counter)
+{
+    MazeGrid grid(size, size, ordering);
+    grid.setWalls(walls);
+
+    Measurement measurement;
+    measurement.bytes = grid.getMemoryUsage();
+    QVector<int> path;
+    for(int repetition = 0; repetition < repetitions; repetition++){
+        QElapsedTimer timer;
+        timer.start();
+        counter.start();
+        grid.findPath(0, size * size - 1, path, &measurement.expanded);
+        qint64 misses = counter.stop();
+        double milliseconds = timer.nsecsElapsed() / 1e6;
+        if(repetition == 0 || milliseconds < measurement.milliseconds){
+            measurement.milliseconds = milliseconds;
+            measurement.cacheMisses = misses;
+        }
+    }
+    measurement.pathLength = path.size();
+    return measurement;
+}
+
+/**
+ * @brief Prints one row of the result table
+ */
+static void report(QTextStream &out, const QString &name, const Measurement &measurement)
+{
+    out << name.leftJustified(12)
+        << QString::number(measurement.milliseconds, 'f', 2).rightJustified(12)
+        << (measurement.cacheMisses >= 0 ? QString::number(measurement.cacheMisses) : QString("n/a")).rightJustified(14)
+        << QString::number(measurement.expanded).rightJustified(12)
+        << QString::number(measurement.pathLength).rightJustified(10)
+        << QString::number(measurement.bytes / 1024).rightJustified(12) << "\n";
+}
+
+/**
+ * @brief Runs the breadth first search on all layouts and prints a table
+ * @param size The number of rows and columns of the random maze
+ * @param repetitions How often each search is repeated, the best run is reported
+ * @param out Where the table goes
+ * @return 0 if all layouts found the same path length, 1 otherwise
+ */
+int run(int size, int repetitions, QTextStream &out)
+{
+    size = qMax(size, 2);
+    repetitions = qMax(repetitions, 1);
+    MazeGrid maze(size, size);
+    maze.randomize(0x9e3779b9u);
+    QBitArray walls = maze.getWalls();
+    CacheMissCounter counter;
+
+    out << "Layout benchmark, " << size << "x" << size << " random maze, best of " << repetitions << "\n";
+    if(!counter.isAvailable()){
+        out << "Cache miss counter not available, reporting time only\n";
+    }
+    out << QString("Layout").leftJustified(12) << QString("ms").rightJustified(12)
+        << QString("cache misses").rightJustified(14) << QString("expanded").rightJustified(12)
+        << QString("path").rightJustified(10) << QString("KiB").rightJustified(12) << "\n";
+
+    Measurement hash = measureNodeHash(maze, size, repetitions, counter);
+    report(out, "Node hash", hash);
+
+    const char *names[] = { "Row-major", "Tiled", "Morton" };
+    bool consistent = true;
+    for(int ordering = MazeGrid::RowMajor; ordering <= MazeGrid::Morton; ordering++){
+        Measurement grid = measureGrid(walls, size, MazeGrid::Ordering(ordering), repetitions, counter);
+        report(out, names[ordering], grid);
+        consistent = consistent && grid.pathLength == hash.pathLength;
+    }
+    out.flush();
+
+    return consistent ? 0 : 1;
+}
+
+}
@@ -0,0 +1,17 @@
+#ifndef LAYOUTBENCHMARK_H
+#define LAYOUTBENCHMARK_H
+
+#include <QTextStream>
+
+/**
+ * @brief Compares a breadth first search over the per-node heap objects the UI uses with the
+ * same search over the MazeGrid planes in each ordering. Reports time and, where the kernel
+ * allows it, hardware cache misses. Started with --benchmark-layout on the command line.
+ */
+namespace LayoutBenchmark {
+
+int run(int size, int repetitions, QTextStream &out); ///< Runs all layouts on a random size x size maze, returns a process exit code
+
+}
+
+#endif // LAYOUTBENCHMARK_H
@@ -0,0 +1,203 @@
+#include "logview.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+/// Space between the border and the text in pixels
+static const int textMargin = 3;
+
+/**
+ * @brief Creates an empty log
+ * @param capacity The most lines held, older lines are dropped
+ * @param parent The parent for reference purposes
+ */
+LogView::LogView(int capacity, QWidget *parent) :
+    QAbstractScrollArea(parent)
+{
+    lines.resize(qMax(1, capacity));
+    first = 0;
+    count = 0;
+    widestLine = 0;
+
+    viewport()->setBackgroundRole(QPalette::Base);
+    viewport()->setAutoFillBackground(true);
+    setFocusPolicy(Qt::StrongFocus);
+    verticalScrollBar()->setSingleStep(1);
+}
+
+/**
+ * @brief Gets the number of lines currently kept
+ * @return The number of lines
+ */
+int LogView::getLineCount() const
+{
+    return count;
+}
+
+/**
+ * @brief Gets the most lines kept before the oldest are dropped
+ * @return The capacity in lines
+ */
+int LogView::getCapacity() const
+{
+    return lines.size();
+}
+
+/**
+ * @brief Gets a line
+ * @param line The line number, 0 is the oldest line held
+ * @return The line, empty if there's no such line
+ */
+QString LogView::lineAt(int line) const
+{
+    if(line < 0 || line >= count){
+        return QString();
+    }
+    return lines.at((first + line) % lines.size());
+}
+
+/**
+ * @brief Gets the whole log as text, for copying
+ * @return All held lines joined by line breaks
+ */
+QString LogView::toPlainText() const
+{
+    QStringList all;
+    all.reserve(count);
+    for(int ii = 0; ii < count; ii++){
+        all.append(lineAt(ii));
+    }
+    return all.join("\n");
+}
+
+/**
+ * @brief Appends text to the log
+ * @param text The text, split into lines at its line breaks
+ */
+void LogView::append(const QString &text)
+{
+    appendLines(text.split('\n'));
+}
+
+/**
+ * @brief Appends many lines to the log, the view is updated once
+ * @param newLines The lines to append
+ */
+void LogView::appendLines(const QStringList &newLines)
+{
+    bool follow = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+    foreach(const QString &line, newLines){
+        store(line);
+    }
+    updateScrollBars(follow);
+    viewport()->update();
+}
+
+/**
+ * @brief Drops all lines
+ */
+void LogView::clear()
+{
+    for(int ii = 0; ii < lines.size(); ii++){
+        lines[ii].clear();
+    }
+    first = 0;
+    count = 0;
+    widestLine = 0;
+    updateScrollBars(true);
+    viewport()->update();
+}
+
+/**
+ * @brief Puts a line into the ring buffer, over the oldest one once it's full
+ * @param line The line
+ */
+void LogView::store(const QString &line)
+{
+    if(count < lines.size()){
+        lines[(first + count) % lines.size()] = line;
+        count++;
+    }
+    else{
+        lines[first] = line;
+        first = (first + 1) % lines.size();
+    }
+}
+
+/**
+ * @brief Fits the scroll bars to the number of lines and the size of the view
+ * @param follow True to scroll to the newest line
+ */
+void LogView::updateScrollBars(bool follow)
+{
+    int lineHeight = qMax(1, fontMetrics().lineSpacing());
+    int visibleLines = qMax(1, (viewport()->height() - 2 * textMargin) / lineHeight);
+
+    verticalScrollBar()->setPageStep(visibleLines);
+    verticalScrollBar()->setRange(0, qMax(0, count - visibleLines));
+    if(follow){
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    }
+
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, widestLine + 2 * textMargin - viewport()->width()));
+}
+
+/**
+ * @brief Paints the lines in view, nothing else is laid out
+ * @param event The paint event
+ */
+void LogView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(viewport());
+    painter.setPen(palette().color(QPalette::Text));
+
+    QFontMetrics metrics = fontMetrics();
+    int lineHeight = qMax(1, metrics.lineSpacing());
+    int top = verticalScrollBar()->value();
+    int visibleLines = viewport()->height() / lineHeight + 1;
+    int x = textMargin - horizontalScrollBar()->value();
+    int widest = widestLine;
+
+    for(int ii = 0; ii < visibleLines && top + ii < count; ii++){
+        QString line = lineAt(top + ii);
+        painter.drawText(x, textMargin + ii * lineHeight + metrics.ascent(), line);
+        widest = qMax(widest, metrics.width(line));
+    }
+
+    // The horizontal range grows with the widest line seen, measuring every line would cost
+    // as much as laying them all out
+    if(widest > widestLine){
+        widestLine = widest;
+        updateScrollBars(false);
+    }
+}
+
+/**
+ * @brief Updates the scroll ranges to the new viewport size, staying at the bottom if the
+ * view was following the newest lines
+ * @param event The resize event
+ */
+void LogView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars(verticalScrollBar()->value() == verticalScrollBar()->maximum());
+}
+
+/**
+ * @brief Copies the whole log on the copy shortcut
+ * @param event The key event, passed on if it isn't the copy shortcut
+ */
+void LogView::keyPressEvent(QKeyEvent *event)
+{
+    if(event->matches(QKeySequence::Copy)){
+        QApplication::clipboard()->setText(toPlainText());
+    }
+    else{
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
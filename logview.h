@@ -0,0 +1,44 @@
+#ifndef LOGVIEW_H
+#define LOGVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief A read-only log pane that keeps its lines in a ring buffer of bounded size and only
+ * paints the lines in view. Appending a line doesn't lay out any text, so writing thousands
+ * of lines costs about as much as storing them. Once the buffer is full the oldest lines are
+ * dropped. The view follows new lines while it's scrolled to the bottom.
+ */
+class LogView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit LogView(int capacity = 100000, QWidget *parent = 0);
+    int getLineCount() const; ///< Lines currently held
+    int getCapacity() const;
+    QString lineAt(int line) const; ///< Gets a held line, 0 is the oldest
+    QString toPlainText() const; ///< All held lines joined by line breaks
+
+public slots:
+    void append(const QString &text); ///< Appends text, one line per line break in it
+    void appendLines(const QStringList &lines); ///< Appends many lines with one update
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void keyPressEvent(QKeyEvent *event);
+
+private:
+    QVector<QString> lines; ///< The ring buffer
+    int first; ///< Slot of the oldest line
+    int count; ///< Number of lines held
+    int widestLine; ///< Widest line painted so far in pixels, the horizontal scroll range
+
+    void store(const QString &line);
+    void updateScrollBars(bool follow);
+};
+
+#endif // LOGVIEW_H
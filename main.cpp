@@ -16,10 +16,117 @@
  * If you find this software useful or are using it I'd be happy about an email.
  */
 #include "mainwindow.h"
+#include "layoutbenchmark.h"
+#include "batchsolver.h"
+#include "mazeservice.h"
+#include "mazeclient.h"
+#include "mazeimage.h"
+#include "shardedsearch.h"
+#include "mazefuzzer.h"
+#include "mazeanalytics.h"
+#include "framerenderer.h"
+#include "layeredmaze.h"
+#include "solvecache.h"
+#include "timelinetrace.h"
 #include <QApplication>
+#include <QTextStream>
+
+/**
+ * @brief Reads a numeric command line argument
+ * @param argc The number of arguments
+ * @param argv The arguments
+ * @param index The position of the argument
+ * @param defaultValue The value if the argument is missing
+ * @return The value of the argument
+ */
+static int numericArgument(int argc, char *argv[], int index, int defaultValue)
+{
+    return argc > index ? QString(argv[index]).toInt() : defaultValue;
+}
 
 int main(int argc, char *argv[])
 {
+    // Whatever follows --timeline <file> runs as usual and leaves its timeline in the file
+    QString timelineFile;
+    if(argc > 2 && QString(argv[1]) == "--timeline"){
+        timelineFile = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+#ifdef MAZESOLVER_TIMELINE
+    TimelineTrace::ExportOnExit timelineExport(timelineFile);
+#else
+    if(!timelineFile.isEmpty()){
+        QTextStream(stderr) << "Timeline tracing has been compiled out, rebuild with qmake CONFIG+=timeline\n";
+    }
+#endif
+
+    // Command line modes run without a window
+    if(argc > 1 && QString(argv[1]).startsWith("--")){
+        QCoreApplication core(argc, argv);
+        QTextStream out(stdout);
+        QString mode = argv[1];
+
+        if(mode == "--benchmark-layout"){
+            return LayoutBenchmark::run(numericArgument(argc, argv, 2, 1024), numericArgument(argc, argv, 3, 3), out);
+        }
+        else if(mode == "--benchmark-batch"){
+            return BatchSolver::runBenchmark(numericArgument(argc, argv, 2, 512), numericArgument(argc, argv, 3, 2000), out);
+        }
+        else if(mode == "--serve"){
+            MazeService service;
+            QString name = argc > 2 ? QString(argv[2]) : QString("mazesolver");
+            if(!service.listen(name)){
+                out << "Could not listen on " << name << ": " << service.errorString() << "\n";
+                return 1;
+            }
+            out << "Listening on " << service.getServerName() << "\n";
+            out.flush();
+            return core.exec();
+        }
+        else if(mode == "--client"){
+            QString name = argc > 2 ? QString(argv[2]) : QString("mazesolver");
+            return MazeClient::runHarness(name, numericArgument(argc, argv, 3, 256), numericArgument(argc, argv, 4, 10000),
+                                          numericArgument(argc, argv, 5, 64), out);
+        }
+        else if(mode == "--import-image" && argc > 2){
+            return MazeImage::convert(argv[2], numericArgument(argc, argv, 3, 128), argc > 4 ? QString(argv[4]) : QString(), out);
+        }
+        else if(mode == "--solve-sharded"){
+            return ShardedSearch::runComparison(numericArgument(argc, argv, 2, 1024), numericArgument(argc, argv, 3, 4),
+                                                numericArgument(argc, argv, 4, -1), out);
+        }
+        else if(mode == "--shard-worker" && argc > 3){
+            return ShardedSearch::runWorker(argv[2], numericArgument(argc, argv, 3, 0));
+        }
+        else if(mode == "--fuzz"){
+            return MazeFuzzer::run(numericArgument(argc, argv, 2, 10000), quint32(numericArgument(argc, argv, 3, 1)), out);
+        }
+        else if(mode == "--analyze"){
+            return MazeAnalytics::runReport(argc > 2 ? QString(argv[2]) : QString("1024"), quint32(numericArgument(argc, argv, 3, 1)), out);
+        }
+        else if(mode == "--render-frames" && argc > 3){
+            FrameRenderer::Settings settings;
+            settings.width = numericArgument(argc, argv, 4, settings.width);
+            settings.height = numericArgument(argc, argv, 5, settings.height);
+            settings.stride = numericArgument(argc, argv, 6, settings.stride);
+            settings.format = argc > 7 && QString(argv[7]) == "raw" ? FrameRenderer::RawRgb : FrameRenderer::Png;
+            return FrameRenderer::runRender(argv[2], argv[3], settings, out);
+        }
+        else if(mode == "--solve-floors"){
+            return LayeredMaze::runComparison(numericArgument(argc, argv, 2, 8), numericArgument(argc, argv, 3, 1000),
+                                              numericArgument(argc, argv, 4, 200), numericArgument(argc, argv, 5, 4),
+                                              quint32(numericArgument(argc, argv, 6, 1)), out);
+        }
+        else if(mode == "--cache-benchmark"){
+            return SolveCache::runBenchmark(numericArgument(argc, argv, 2, 1024), numericArgument(argc, argv, 3, 10000), out);
+        }
+
+        out << "Unknown option " << mode << "\n";
+        return 2;
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
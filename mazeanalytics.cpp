@@ -0,0 +1,509 @@
+#include "mazeanalytics.h"
+#include "mazefile.h"
+#include "mazeimage.h"
+#include "searchtrace.h"
+#include "timelinetrace.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QtAlgorithms>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+namespace MazeAnalytics {
+
+/// Rows of a tile
+static const int tileRows = 256;
+/// Words of 64 cells across a tile
+static const int tileWords = 16;
+
+/**
+ * @brief The open cells of a maze, 64 per word. Every row starts on a new word and ends with at
+ * least one clear bit, and there's a clear row above and below the maze, so the neighbours of a
+ * cell are plain offsets from its index and never outside of the planes.
+ */
+struct PackedMaze
+{
+    int rows;
+    int columns;
+    int wordsPerRow;
+    int stride; ///< Bits per row, the offset to the cell below
+    QVector<quint64> open;
+
+    inline int indexOf(int id) const { return (id / columns + 1) * stride + id % columns; }
+    inline int idOf(int index) const { return (index / stride - 1) * columns + index % stride; }
+    inline quint64 word(int row, int word) const { return open.at((row + 1) * wordsPerRow + word); }
+    inline bool isOpen(int index) const { return (open.at(index >> 6) >> (index & 63)) & 1; }
+};
+
+/// The part of the maze one task works on, and what it found there
+struct Tile
+{
+    Tile() : firstRow(0), lastRow(0), firstWord(0), lastWord(0), corridors(0), chainCells(0), longest(0), histogram(histogramBuckets, 0)
+    {
+        for(int degree = 0; degree < 5; degree++){
+            degreeCount[degree] = 0;
+        }
+    }
+    int firstRow;
+    int lastRow; ///< One past the last row
+    int firstWord;
+    int lastWord; ///< One past the last word
+    qint64 degreeCount[5];
+    qint64 corridors; ///< Corridors whose lower end lies in the tile
+    qint64 chainCells; ///< Cells of those corridors
+    int longest;
+    QVector<qint64> histogram;
+};
+
+/// What a breadth first sweep from one cell found
+struct Sweep
+{
+    Sweep() : reached(0), eccentricity(-1), farthest(-1), targetDistance(-1) {}
+    qint64 reached;
+    int eccentricity;
+    int farthest; ///< Node id of a cell at the eccentricity
+    int targetDistance;
+};
+
+/**
+ * @brief Gets the open neighbours of a word of cells in the four directions
+ */
+static inline void neighbourWords(const PackedMaze *maze, int row, int word, quint64 &north, quint64 &south, quint64 &east, quint64 &west)
+{
+    quint64 here = maze->word(row, word);
+    north = maze->word(row - 1, word);
+    south = maze->word(row + 1, word);
+    east = (here >> 1) | (maze->word(row, word + 1) << 63);
+    west = (here << 1) | (maze->word(row, word - 1) >> 63);
+}
+
+/**
+ * @brief Counts the open neighbours of 64 cells at once. Adds the four direction words bit by
+ * bit and returns the sum as three bit planes, it is at most four.
+ */
+static inline void degreeWords(quint64 north, quint64 south, quint64 east, quint64 west, quint64 &ones, quint64 &twos, quint64 &fours)
+{
+    quint64 sum1 = north ^ south;
+    quint64 carry1 = north & south;
+    quint64 sum2 = east ^ west;
+    quint64 carry2 = east & west;
+    quint64 carry3 = sum1 & sum2; // Never set together with carry1 or carry2
+    ones = sum1 ^ sum2;
+    twos = carry1 ^ carry2 ^ carry3;
+    fours = carry1 & carry2;
+}
+
+/**
+ * @brief Counts the cells of a tile by their number of open neighbours and marks its corridor
+ * cells, the ones with exactly two, handed out by QtConcurrent
+ */
+struct TileCensus
+{
+    TileCensus(const PackedMaze *packedMaze, QVector<quint64> *corridorPlane) : maze(packedMaze), corridor(corridorPlane) {}
+
+    void operator()(Tile &tile) const
+    {
+        for(int row = tile.firstRow; row < tile.lastRow; row++){
+            for(int word = tile.firstWord; word < tile.lastWord; word++){
+                quint64 here = maze->word(row, word);
+                quint64 north, south, east, west, ones, twos, fours;
+                neighbourWords(maze, row, word, north, south, east, west);
+                degreeWords(north, south, east, west, ones, twos, fours);
+
+                quint64 two = here & ~ones & twos;
+                tile.degreeCount[0] += qPopulationCount(here & ~ones & ~twos & ~fours);
+                tile.degreeCount[1] += qPopulationCount(here & ones & ~twos);
+                tile.degreeCount[2] += qPopulationCount(two);
+                tile.degreeCount[3] += qPopulationCount(here & ones & twos);
+                tile.degreeCount[4] += qPopulationCount(here & fours);
+                (*corridor)[(row + 1) * maze->wordsPerRow + word] = two;
+            }
+        }
+    }
+
+    const PackedMaze *maze;
+    QVector<quint64> *corridor;
+};
+
+/**
+ * @brief Follows the corridors that start in a tile and records their lengths, handed out by
+ * QtConcurrent. A corridor starts at a corridor cell next to a dead end or junction and is
+ * walked to its other end; it's counted by the end with the lower node id, so each one once.
+ */
+struct TileCorridors
+{
+    TileCorridors(const PackedMaze *packedMaze, const QVector<quint64> *corridorPlane) : maze(packedMaze), corridor(corridorPlane) {}
+
+    inline bool isCorridor(int index) const
+    {
+        return (corridor->at(index >> 6) >> (index & 63)) & 1;
+    }
+
+    inline quint64 corridorWord(int row, int word) const
+    {
+        return corridor->at((row + 1) * maze->wordsPerRow + word);
+    }
+
+    void operator()(Tile &tile) const
+    {
+        const int steps[4] = { maze->stride, -maze->stride, 1, -1 };
+
+        for(int row = tile.firstRow; row < tile.lastRow; row++){
+            for(int word = tile.firstWord; word < tile.lastWord; word++){
+                // Corridor cells with an open neighbour that isn't part of a corridor
+                quint64 here = corridorWord(row, word);
+                quint64 north, south, east, west;
+                neighbourWords(maze, row, word, north, south, east, west);
+                quint64 corridorEast = (here >> 1) | (corridorWord(row, word + 1) << 63);
+                quint64 corridorWest = (here << 1) | (corridorWord(row, word - 1) >> 63);
+                quint64 starts = here & ((north & ~corridorWord(row - 1, word)) | (south & ~corridorWord(row + 1, word))
+                                         | (east & ~corridorEast) | (west & ~corridorWest));
+
+                while(starts != 0){
+                    int start = (row + 1) * maze->stride + word * 64 + qCountTrailingZeroBits(starts);
+                    starts &= starts - 1;
+
+                    // Step onto the neighbouring corridor cell, if there is one
+                    int previous = start;
+                    int current = start;
+                    int length = 1;
+                    for(int dir = 0; dir < 4; dir++){
+                        if(isCorridor(start + steps[dir])){
+                            current = start + steps[dir];
+                            length++;
+                            break;
+                        }
+                    }
+
+                    // Walk on until the next cell ends the corridor
+                    while(current != start){
+                        int next = current;
+                        for(int dir = 0; dir < 4; dir++){
+                            int candidate = current + steps[dir];
+                            if(candidate != previous && maze->isOpen(candidate)){
+                                next = candidate;
+                                break;
+                            }
+                        }
+                        if(!isCorridor(next)){
+                            break;
+                        }
+                        previous = current;
+                        current = next;
+                        length++;
+                    }
+
+                    if(start > current){
+                        continue; // Counted from the other end
+                    }
+                    int bucket = 0;
+                    while(bucket + 1 < histogramBuckets && (length >> (bucket + 1)) != 0){
+                        bucket++;
+                    }
+                    tile.histogram[bucket]++;
+                    tile.corridors++;
+                    tile.chainCells += length;
+                    tile.longest = qMax(tile.longest, length);
+                }
+            }
+        }
+    }
+
+    const PackedMaze *maze;
+    const QVector<quint64> *corridor;
+};
+
+/// The search state of a word of cells, kept together so a step touches one cache line
+struct SweepWord
+{
+    quint64 visited;
+    quint64 level; ///< Cells of the current level
+    quint64 next; ///< Cells of the next level
+};
+
+/**
+ * @brief Adds the cells of a word that are open and not yet visited to the next level
+ */
+static inline void reachWord(const PackedMaze *maze, int word, quint64 bits, SweepWord *state, QVector<int> &nextWords)
+{
+    if(bits == 0){
+        return;
+    }
+    SweepWord &target = state[word];
+    bits &= maze->open.at(word) & ~target.visited;
+    if(bits == 0){
+        return;
+    }
+    if(target.next == 0){
+        nextWords.append(word);
+    }
+    target.next |= bits;
+    target.visited |= bits;
+}
+
+/**
+ * @brief Runs a breadth first search level by level on whole words: a level is the list of
+ * words it touches and their bits, and each word expands to its own and its four neighbouring
+ * words with a few shifts and masks
+ * @param maze The maze
+ * @param source Node id to start from
+ * @param target Node id whose distance is wanted, -1 for none
+ * @return The cells reached, the eccentricity of the source and a cell that far away
+ */
+static Sweep sweep(const PackedMaze *maze, int source, int target)
+{
+    TIMELINE_SCOPE("MazeAnalytics::sweep", "solver");
+    Sweep result;
+    if(source < 0 || !maze->isOpen(maze->indexOf(source))){
+        return result;
+    }
+
+    SweepWord clear = { 0, 0, 0 };
+    QVector<SweepWord> words(maze->open.size(), clear);
+    SweepWord *state = words.data();
+    QVector<int> levelWords;
+    QVector<int> nextWords;
+    int sourceIndex = maze->indexOf(source);
+    int targetIndex = target >= 0 ? maze->indexOf(target) : -1;
+    state[sourceIndex >> 6].next = state[sourceIndex >> 6].visited = quint64(1) << (sourceIndex & 63);
+    nextWords.append(sourceIndex >> 6);
+
+    int distance = 0;
+    while(!nextWords.isEmpty()){
+        // The next level becomes the current one
+        levelWords.swap(nextWords);
+        nextWords.clear();
+        for(int ii = 0; ii < levelWords.size(); ii++){
+            SweepWord &word = state[levelWords.at(ii)];
+            word.level = word.next;
+            word.next = 0;
+        }
+
+        int first = levelWords.first();
+        result.eccentricity = distance;
+        result.farthest = maze->idOf(first * 64 + qCountTrailingZeroBits(state[first].level));
+        if(targetIndex >= 0 && (state[targetIndex >> 6].level >> (targetIndex & 63)) & 1){
+            result.targetDistance = distance;
+        }
+
+        for(int ii = 0; ii < levelWords.size(); ii++){
+            int word = levelWords.at(ii);
+            quint64 bits = state[word].level;
+            state[word].level = 0;
+            result.reached += qPopulationCount(bits);
+            reachWord(maze, word, (bits << 1) | (bits >> 1), state, nextWords);
+            reachWord(maze, word + 1, bits >> 63, state, nextWords);
+            reachWord(maze, word - 1, bits << 63, state, nextWords);
+            reachWord(maze, word + maze->wordsPerRow, bits, state, nextWords);
+            reachWord(maze, word - maze->wordsPerRow, bits, state, nextWords);
+        }
+        distance++;
+    }
+    return result;
+}
+
+/**
+ * @brief Gets the average corridor length. Cells on rings without a junction aren't part of
+ * any corridor and are left out.
+ * @return The average number of cells per corridor, 0 without corridors
+ */
+double Report::meanCorridor() const
+{
+    qint64 cells = degreeCount[2] - loopCells;
+    return corridors > 0 ? double(cells) / corridors : 0.0;
+}
+
+/**
+ * @brief Computes the figures of a maze. The sweeps from the entrance and the exit run on
+ * threads of their own while the tiles are counted, then the second sweep of the diameter runs.
+ * @param grid The maze
+ * @param entranceId Node id of the entrance
+ * @param exitId Node id of the exit
+ * @return The figures
+ */
+Report analyze(const MazeGrid &grid, int entranceId, int exitId)
+{
+    TIMELINE_SCOPE("MazeAnalytics::analyze", "solver");
+    QElapsedTimer clock;
+    clock.start();
+
+    Report report;
+    report.rows = grid.getRows();
+    report.columns = grid.getColumns();
+    if(grid.getCellCount() == 0){
+        return report;
+    }
+
+    // Pack the open cells, a row at a time, below a clear row
+    PackedMaze maze;
+    maze.rows = report.rows;
+    maze.columns = report.columns;
+    maze.wordsPerRow = maze.columns / 64 + 1;
+    maze.stride = maze.wordsPerRow * 64;
+    maze.open.fill(0, (maze.rows + 2) * maze.wordsPerRow);
+    for(int row = 0; row < maze.rows; row++){
+        quint64 *bits = maze.open.data() + (row + 1) * maze.wordsPerRow;
+        grid.getWallRow(row, bits);
+        for(int word = 0; word < maze.wordsPerRow; word++){
+            int count = qBound(0, maze.columns - word * 64, 64);
+            bits[word] = ~bits[word] & (count == 64 ? ~quint64(0) : (quint64(1) << count) - 1);
+        }
+    }
+
+    QFuture<Sweep> entranceSweep = QtConcurrent::run(sweep, &maze, entranceId, exitId);
+    QFuture<Sweep> exitSweep = QtConcurrent::run(sweep, &maze, exitId, -1);
+
+    QVector<Tile> tiles;
+    for(int row = 0; row < maze.rows; row += tileRows){
+        for(int word = 0; word < maze.wordsPerRow; word += tileWords){
+            Tile tile;
+            tile.firstRow = row;
+            tile.lastRow = qMin(row + tileRows, maze.rows);
+            tile.firstWord = word;
+            tile.lastWord = qMin(word + tileWords, maze.wordsPerRow);
+            tiles.append(tile);
+        }
+    }
+    QVector<quint64> corridor(maze.open.size(), 0);
+    QtConcurrent::blockingMap(tiles, TileCensus(&maze, &corridor));
+    QtConcurrent::blockingMap(tiles, TileCorridors(&maze, &corridor));
+
+    qint64 chainCells = 0;
+    foreach(const Tile &tile, tiles){
+        for(int degree = 0; degree < 5; degree++){
+            report.degreeCount[degree] += tile.degreeCount[degree];
+        }
+        for(int bucket = 0; bucket < histogramBuckets; bucket++){
+            report.corridorHistogram[bucket] += tile.histogram.at(bucket);
+        }
+        report.corridors += tile.corridors;
+        chainCells += tile.chainCells;
+        report.longestCorridor = qMax(report.longestCorridor, tile.longest);
+    }
+    for(int degree = 0; degree < 5; degree++){
+        report.openCells += report.degreeCount[degree];
+    }
+    report.loopCells = report.degreeCount[2] - chainCells;
+    report.tiles = tiles.size();
+
+    Sweep fromEntrance = entranceSweep.result();
+    report.reachable = fromEntrance.reached;
+    report.entranceEccentricity = fromEntrance.eccentricity;
+    report.entranceExitDistance = fromEntrance.targetDistance;
+    if(fromEntrance.farthest >= 0){
+        // The cell farthest from the entrance is one end of a longest path in a tree
+        Sweep fromFarthest = sweep(&maze, fromEntrance.farthest, -1);
+        report.diameter = fromFarthest.eccentricity;
+        report.diameterStart = fromEntrance.farthest;
+        report.diameterEnd = fromFarthest.farthest;
+    }
+    report.exitEccentricity = exitSweep.result().eccentricity;
+    report.elapsedMs = clock.elapsed();
+    return report;
+}
+
+/**
+ * @brief Gets the row and column of a node id as text
+ */
+static QString cellName(const Report &report, int id)
+{
+    return "(" + QString::number(id / report.columns) + ", " + QString::number(id % report.columns) + ")";
+}
+
+/**
+ * @brief Writes the figures as a few lines of text
+ * @param report The figures
+ * @return The lines, for the log or the command line
+ */
+QStringList describe(const Report &report)
+{
+    QStringList lines;
+    qint64 cells = qint64(report.rows) * report.columns;
+    lines.append("Maze of " + QString::number(report.rows) + "x" + QString::number(report.columns) + ": "
+                 + QString::number(report.openCells) + " of " + QString::number(cells) + " cells open, "
+                 + QString::number(report.reachable) + " reachable from the entrance");
+    lines.append("Branching: " + QString::number(report.degreeCount[1]) + " dead ends, "
+                 + QString::number(report.degreeCount[2]) + " corridor cells, "
+                 + QString::number(report.degreeCount[3]) + " 3-way and "
+                 + QString::number(report.degreeCount[4]) + " 4-way junctions, "
+                 + QString::number(report.degreeCount[0]) + " isolated cells");
+    lines.append("Corridors: " + QString::number(report.corridors) + ", "
+                 + QString::number(report.meanCorridor(), 'f', 2) + " cells on average, the longest "
+                 + QString::number(report.longestCorridor) + ", "
+                 + QString::number(report.loopCells) + " cells on closed loops");
+
+    QStringList buckets;
+    for(int bucket = 0; bucket < histogramBuckets; bucket++){
+        if(report.corridorHistogram.at(bucket) == 0){
+            continue;
+        }
+        int low = 1 << bucket;
+        int high = (low << 1) - 1;
+        buckets.append((low == high ? QString::number(low) : QString::number(low) + "-" + QString::number(high))
+                       + ": " + QString::number(report.corridorHistogram.at(bucket)));
+    }
+    if(!buckets.isEmpty()){
+        lines.append("Corridor lengths: " + buckets.join(", "));
+    }
+
+    lines.append("Eccentricity of the entrance " + (report.entranceEccentricity >= 0 ? QString::number(report.entranceEccentricity) : QString("-"))
+                 + ", of the exit " + (report.exitEccentricity >= 0 ? QString::number(report.exitEccentricity) : QString("-"))
+                 + (report.entranceExitDistance >= 0 ? ", " + QString::number(report.entranceExitDistance) + " steps between them"
+                                                     : QString(", the exit can't be reached")));
+    if(report.diameter >= 0){
+        lines.append("Diameter at least " + QString::number(report.diameter) + " steps (double sweep), from "
+                     + cellName(report, report.diameterStart) + " to " + cellName(report, report.diameterEnd));
+    }
+    lines.append("Analyzed in " + QString::number(report.elapsedMs) + " ms on " + QString::number(report.tiles) + " tiles");
+    return lines;
+}
+
+/**
+ * @brief Analyzes a maze from the command line, from the top left to the bottom right corner
+ * @param maze The side of a random maze, or a maze or image file to load
+ * @param seed The seed of the random maze
+ * @param out Receives the figures
+ * @return 0 on success, 1 if the file can't be loaded
+ */
+int runReport(const QString &maze, quint32 seed, QTextStream &out)
+{
+    MazeGrid grid;
+    bool isSize = false;
+    int side = maze.toInt(&isSize);
+    QElapsedTimer clock;
+    clock.start();
+    if(isSize){
+        grid.resize(side, side);
+        grid.randomize(seed);
+        out << "Created a random " << side << "x" << side << " maze with seed " << seed << " in " << clock.elapsed() << " ms\n";
+    }
+    else if(QFileInfo(maze).suffix() == "maze"){
+        int rows;
+        int columns;
+        QBitArray walls;
+        SearchTrace trace;
+        if(!MazeFile::load(maze, rows, columns, walls, trace)){
+            out << "Could not load a maze from " << maze << "\n";
+            return 1;
+        }
+        grid.resize(rows, columns);
+        grid.setWalls(walls);
+    }
+    else{
+        MazeImage::Markers markers;
+        QString error;
+        if(!MazeImage::load(maze, 128, grid, markers, error)){
+            out << error << "\n";
+            return 1;
+        }
+    }
+
+    Report report = analyze(grid, 0, grid.getCellCount() - 1);
+    foreach(const QString &line, describe(report)){
+        out << line << "\n";
+    }
+    return 0;
+}
+
+}
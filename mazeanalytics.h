@@ -0,0 +1,63 @@
+#ifndef MAZEANALYTICS_H
+#define MAZEANALYTICS_H
+
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include "mazegrid.h"
+
+/**
+ * @brief Structural figures of a maze for choosing a solver: how much of it can be reached,
+ * how it branches, how long its corridors are and how far apart its cells can be.
+ *
+ * The walls are packed into 64 cells per word and row. The degree census takes a word of cells
+ * at a time with bit-sliced counting, and it and the corridor walks run in parallel over
+ * tiles of the maze. The breadth first sweeps from the entrance and the exit run alongside
+ * them; the diameter is a double sweep from the cell farthest from the entrance, which is
+ * exact for mazes without loops and a lower bound otherwise.
+ */
+namespace MazeAnalytics {
+
+/// Corridor length buckets, bucket b holds lengths from 2^b to 2^(b+1) - 1
+static const int histogramBuckets = 32;
+
+/// The figures of one maze
+struct Report
+{
+    Report() : rows(0), columns(0), openCells(0), reachable(0), corridors(0), loopCells(0), longestCorridor(0),
+        entranceEccentricity(-1), exitEccentricity(-1), entranceExitDistance(-1), diameter(-1), diameterStart(-1),
+        diameterEnd(-1), tiles(0), elapsedMs(0), corridorHistogram(histogramBuckets, 0)
+    {
+        for(int degree = 0; degree < 5; degree++){
+            degreeCount[degree] = 0;
+        }
+    }
+    int rows;
+    int columns;
+    qint64 openCells;
+    qint64 reachable; ///< Open cells reachable from the entrance, the entrance included
+    qint64 degreeCount[5]; ///< Open cells by number of open neighbours: isolated, dead ends, corridor, 3- and 4-way junctions
+    qint64 corridors; ///< Runs of corridor cells that end in dead ends or junctions
+    qint64 loopCells; ///< Corridor cells on closed rings without any junction
+    int longestCorridor; ///< Cells of the longest corridor
+    int entranceEccentricity; ///< Steps from the entrance to the farthest cell it reaches, -1 if it's a wall
+    int exitEccentricity; ///< Steps from the exit to the farthest cell it reaches, -1 if it's a wall
+    int entranceExitDistance; ///< Steps of a shortest path, -1 if there is none
+    int diameter; ///< Double sweep estimate of the longest shortest path in the entrance's region
+    int diameterStart; ///< Node ids of the ends of that path
+    int diameterEnd;
+    int tiles; ///< Tiles the maze was split into
+    qint64 elapsedMs;
+    QVector<qint64> corridorHistogram; ///< Corridors by length, see histogramBuckets
+
+    double meanCorridor() const; ///< Average corridor length in cells
+};
+
+Report analyze(const MazeGrid &grid, int entranceId, int exitId); ///< Computes all figures, in parallel
+QStringList describe(const Report &report); ///< Gets the figures as lines for the log
+int runReport(const QString &maze, quint32 seed, QTextStream &out); ///< Analyzes a random maze of the given size or a maze or image file
+
+}
+
+#endif // MAZEANALYTICS_H
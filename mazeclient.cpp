@@ -0,0 +1,245 @@
+#include "mazeclient.h"
+#include "mazeservice.h"
+#include "latencyhistogram.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QStringList>
+#include <QThread>
+
+namespace MazeClient {
+
+/// How long to wait for a reply before giving up
+static const int replyTimeoutMs = 30000;
+
+/**
+ * @brief Connects to the service. If nobody listens on the name, a service is started
+ * from this executable and the connection is retried while it comes up.
+ * @return True once connected
+ */
+static bool connectToService(QLocalSocket &socket, const QString &serverName, QProcess &service, QTextStream &out)
+{
+    socket.connectToServer(serverName);
+    if(socket.waitForConnected(1000)){
+        return true;
+    }
+
+    out << "No service on " << serverName << ", starting one\n";
+    out.flush();
+    service.setProcessChannelMode(QProcess::ForwardedChannels);
+    service.start(QCoreApplication::applicationFilePath(), QStringList() << "--serve" << serverName);
+    if(!service.waitForStarted()){
+        return false;
+    }
+    for(int attempt = 0; attempt < 50; attempt++){
+        QThread::msleep(100);
+        socket.connectToServer(serverName);
+        if(socket.waitForConnected(1000)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the next reply
+ * @return False on a timeout or a broken connection
+ */
+static bool readReply(QLocalSocket &socket, QByteArray &buffer, QJsonObject &reply)
+{
+    forever{
+        int taken = MazeService::takeFrame(buffer, reply);
+        if(taken > 0){
+            return true;
+        }
+        if(taken < 0 || !socket.waitForReadyRead(replyTimeoutMs)){
+            return false;
+        }
+        buffer.append(socket.readAll());
+    }
+}
+
+/**
+ * @brief Prints one row of the latency table
+ */
+static void printRow(QTextStream &out, const QString &name, const LatencyHistogram &histogram)
+{
+    out << name.leftJustified(12)
+        << QString::number(histogram.getCount()).rightJustified(10)
+        << QString::number(histogram.getMean(), 'f', 0).rightJustified(10)
+        << QString::number(histogram.percentile(0.5)).rightJustified(10)
+        << QString::number(histogram.percentile(0.9)).rightJustified(10)
+        << QString::number(histogram.percentile(0.99)).rightJustified(10)
+        << QString::number(histogram.getMaximum()).rightJustified(10) << "\n";
+}
+
+/**
+ * @brief Prints the header of the latency table
+ */
+static void printHeader(QTextStream &out)
+{
+    out << QString("Operation").leftJustified(12) << QString("count").rightJustified(10)
+        << QString("mean us").rightJustified(10) << QString("p50 us").rightJustified(10)
+        << QString("p90 us").rightJustified(10) << QString("p99 us").rightJustified(10)
+        << QString("max us").rightJustified(10) << "\n";
+}
+
+/**
+ * @brief Creates a random maze on the service and runs a mixed workload against it
+ * @param serverName The name of the service socket
+ * @param size The number of rows and columns of the maze
+ * @param requests The number of requests after the create
+ * @param pipeline How many requests are kept in flight
+ * @param out Where the report goes
+ * @return 0 if every request got a successful reply, 1 otherwise
+ */
+int runHarness(const QString &serverName, int size, int requests, int pipeline, QTextStream &out)
+{
+    size = qMax(size, 2);
+    requests = qMax(requests, 0);
+    pipeline = qMax(pipeline, 1);
+
+    QLocalSocket socket;
+    QProcess service;
+    if(!connectToService(socket, serverName, service, out)){
+        out << "Could not connect to " << serverName << "\n";
+        return 1;
+    }
+
+    QByteArray buffer;
+    QJsonObject reply;
+    QElapsedTimer clock;
+    clock.start();
+
+    QJsonObject create;
+    create.insert("id", 0);
+    create.insert("op", QString("create"));
+    create.insert("maze", QString("harness"));
+    create.insert("rows", size);
+    create.insert("columns", size);
+    create.insert("random", 12345);
+    socket.write(MazeService::encodeFrame(create));
+    if(!readReply(socket, buffer, reply) || !reply.value("ok").toBool()){
+        out << "Could not create the maze: " << reply.value("error").toString() << "\n";
+        return 1;
+    }
+
+    // Mostly queries without paths, a solve every 20 and an edit every 50 requests
+    QHash<int,qint64> sentAt;
+    QHash<int,QString> operationOf;
+    QHash<QString,LatencyHistogram> latencies;
+    quint32 state = 0x2545f491u;
+    int sent = 0;
+    int received = 0;
+    int failed = 0;
+    qint64 batchSizeTotal = 0;
+    int batchSizeCount = 0;
+    int cells = size * size;
+
+    while(received < requests){
+        while(sent < requests && sent - received < pipeline){
+            int id = sent + 1;
+            QJsonObject request;
+            request.insert("id", id);
+            request.insert("maze", QString("harness"));
+
+            int ids[2];
+            for(int ii = 0; ii < 2; ii++){
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                ids[ii] = int(state % quint32(cells));
+            }
+
+            QString operation;
+            if(id % 50 == 0){
+                operation = "edit";
+                QJsonArray toggled;
+                toggled.append(ids[0]);
+                request.insert(id % 100 == 0 ? "open" : "walls", toggled);
+            }
+            else if(id % 20 == 0){
+                operation = "solve";
+                request.insert("start", ids[0]);
+                request.insert("goal", ids[1]);
+                request.insert("algorithm", QString("dfs"));
+                request.insert("connectivity", QString("8"));
+                request.insert("withPath", false);
+            }
+            else{
+                operation = "query";
+                request.insert("start", ids[0]);
+                request.insert("goal", ids[1]);
+                request.insert("withPath", false);
+            }
+            request.insert("op", operation);
+
+            sentAt.insert(id, clock.nsecsElapsed());
+            operationOf.insert(id, operation);
+            socket.write(MazeService::encodeFrame(request));
+            sent++;
+        }
+        socket.flush();
+
+        if(!readReply(socket, buffer, reply)){
+            out << "Lost the connection after " << received << " replies\n";
+            return 1;
+        }
+        int id = reply.value("id").toInt();
+        if(!sentAt.contains(id)){
+            continue;
+        }
+        received++;
+        latencies[operationOf.take(id)].add((clock.nsecsElapsed() - sentAt.take(id)) / 1000);
+        if(!reply.value("ok").toBool()){
+            failed++;
+        }
+        if(reply.contains("batchSize")){
+            batchSizeTotal += reply.value("batchSize").toInt();
+            batchSizeCount++;
+        }
+    }
+    double seconds = qMax(clock.nsecsElapsed() / 1e9, 1e-6);
+
+    out << "Sent " << requests << " requests on a " << size << "x" << size << " maze with "
+        << pipeline << " in flight: " << QString::number(requests / seconds, 'f', 0) << " requests/s, "
+        << failed << " failed\n";
+    if(batchSizeCount > 0){
+        out << "Queries shared their batch with " << QString::number(double(batchSizeTotal) / batchSizeCount, 'f', 1)
+            << " queries on average\n";
+    }
+    out << "\nRound trip latency seen by the client\n";
+    printHeader(out);
+    QHash<QString,LatencyHistogram>::const_iterator ii;
+    for(ii = latencies.constBegin(); ii != latencies.constEnd(); ++ii){
+        printRow(out, ii.key(), ii.value());
+    }
+
+    QJsonObject statsRequest;
+    statsRequest.insert("id", -1);
+    statsRequest.insert("op", QString("stats"));
+    socket.write(MazeService::encodeFrame(statsRequest));
+    if(readReply(socket, buffer, reply)){
+        out << "\nService stats\n" << QString::fromUtf8(QJsonDocument(reply).toJson(QJsonDocument::Indented));
+    }
+
+    // A service started by the harness goes down with it
+    if(service.state() != QProcess::NotRunning){
+        QJsonObject shutdown;
+        shutdown.insert("id", -2);
+        shutdown.insert("op", QString("shutdown"));
+        socket.write(MazeService::encodeFrame(shutdown));
+        socket.flush();
+        readReply(socket, buffer, reply);
+        service.waitForFinished(5000);
+    }
+    out.flush();
+    return failed == 0 ? 0 : 1;
+}
+
+}
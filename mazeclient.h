@@ -0,0 +1,18 @@
+#ifndef MAZECLIENT_H
+#define MAZECLIENT_H
+
+#include <QTextStream>
+
+/**
+ * @brief A load generating client for MazeService. It creates a random maze on the service,
+ * keeps a number of requests in flight (mostly queries, some solves and edits) and prints the
+ * round trip latencies next to the histograms the service reports.
+ * Started with --client on the command line.
+ */
+namespace MazeClient {
+
+int runHarness(const QString &serverName, int size, int requests, int pipeline, QTextStream &out); ///< Runs the workload, returns a process exit code
+
+}
+
+#endif // MAZECLIENT_H
@@ -0,0 +1,314 @@
+#include "mazeeditor.h"
+
+#include <QBitArray>
+
+/**
+ * @brief Creates an editor for the nodes of an arena
+ * @param nodeArena The nodes, ids are row-major
+ */
+MazeEditor::MazeEditor(MazeNodeArena *nodeArena)
+{
+    arena = nodeArena;
+    rows = 0;
+    columns = 0;
+    position = 0;
+    editing = false;
+    lastChangeCount = 0;
+}
+
+/**
+ * @brief Sets the size of the maze. The journal refers to node ids, so it's dropped.
+ * @param mazeRows Number of rows
+ * @param mazeColumns Number of columns
+ */
+void MazeEditor::reset(int mazeRows, int mazeColumns)
+{
+    rows = mazeRows;
+    columns = mazeColumns;
+    journal.clear();
+    position = 0;
+    current = Edit();
+    editing = false;
+    dirty = QRect();
+    lastChangeCount = 0;
+}
+
+/**
+ * @brief Starts an edit. Everything painted until endEdit is one step in the journal.
+ * @param wall True to paint walls, false to clear them
+ */
+void MazeEditor::beginEdit(bool wall)
+{
+    current = Edit();
+    current.wall = wall;
+    editing = true;
+}
+
+/**
+ * @brief Paints a part of a row and records the cells that changed
+ * @param row The row, ignored outside of the maze
+ * @param left The first column
+ * @param right The last column
+ */
+void MazeEditor::paintSpan(int row, int left, int right)
+{
+    left = qMax(left, 0);
+    right = qMin(right, columns - 1);
+    if(!editing || row < 0 || row >= rows || left > right){
+        return;
+    }
+    if(arena->assignWalls(row * columns + left, right - left + 1, current.wall, &current.runs) > 0){
+        QRect span(left, row, right - left + 1, 1);
+        current.bounds = current.bounds.united(span);
+        dirty = dirty.united(span);
+    }
+}
+
+/**
+ * @brief Paints a square brush
+ * @param row The row of the centre
+ * @param column The column of the centre
+ * @param radius Cells from the centre to the edge, 0 for a single cell
+ */
+void MazeEditor::paintBrush(int row, int column, int radius)
+{
+    paintRectangle(row - radius, column - radius, row + radius, column + radius);
+}
+
+/**
+ * @brief Paints the brush at every cell of a Bresenham line, so a fast drag leaves no gaps
+ * @param fromRow The row the line starts in
+ * @param fromColumn The column the line starts in
+ * @param toRow The row the line ends in
+ * @param toColumn The column the line ends in
+ * @param radius Cells from the centre of the brush to its edge
+ */
+void MazeEditor::paintLine(int fromRow, int fromColumn, int toRow, int toColumn, int radius)
+{
+    int rowDistance = qAbs(toRow - fromRow);
+    int columnDistance = qAbs(toColumn - fromColumn);
+    int rowStep = fromRow < toRow ? 1 : -1;
+    int columnStep = fromColumn < toColumn ? 1 : -1;
+    int error = columnDistance - rowDistance;
+    int row = fromRow;
+    int column = fromColumn;
+
+    while(true){
+        paintBrush(row, column, radius);
+        if(row == toRow && column == toColumn){
+            break;
+        }
+        int doubled = 2 * error;
+        if(doubled > -rowDistance){
+            error -= rowDistance;
+            column += columnStep;
+        }
+        if(doubled < columnDistance){
+            error += columnDistance;
+            row += rowStep;
+        }
+    }
+}
+
+/**
+ * @brief Paints a rectangle one row span at a time
+ * @param top The first row
+ * @param left The first column
+ * @param bottom The last row
+ * @param right The last column
+ */
+void MazeEditor::paintRectangle(int top, int left, int bottom, int right)
+{
+    for(int row = qMax(top, 0); row <= qMin(bottom, rows - 1); row++){
+        paintSpan(row, left, right);
+    }
+}
+
+/**
+ * @brief Paints the 4-connected region around a cell whose cells are the opposite of what the
+ * edit paints, a span of a row at a time (scanline fill). Does nothing on a cell that already
+ * has the value.
+ * @param row The row of the cell
+ * @param column The column of the cell
+ */
+void MazeEditor::floodFill(int row, int column)
+{
+    if(!editing || row < 0 || row >= rows || column < 0 || column >= columns){
+        return;
+    }
+    bool region = !current.wall;
+    QBitArray seen(rows * columns);
+    QVector<int> pending;
+    pending.append(row * columns + column);
+
+    while(!pending.isEmpty()){
+        int id = pending.last();
+        pending.removeLast();
+        if(seen.testBit(id) || arena->at(id)->isWall() != region){
+            continue;
+        }
+
+        // Widen to the whole span of the region in this row
+        int spanRow = id / columns;
+        int rowStart = spanRow * columns;
+        int left = id - rowStart;
+        int right = left;
+        while(left > 0 && !seen.testBit(rowStart + left - 1) && arena->at(rowStart + left - 1)->isWall() == region){
+            left--;
+        }
+        while(right < columns - 1 && !seen.testBit(rowStart + right + 1) && arena->at(rowStart + right + 1)->isWall() == region){
+            right++;
+        }
+        seen.fill(true, rowStart + left, rowStart + right + 1);
+
+        // Queue the first cell of every run of the region next to the span
+        for(int neighbourRow = spanRow - 1; neighbourRow <= spanRow + 1; neighbourRow += 2){
+            if(neighbourRow < 0 || neighbourRow >= rows){
+                continue;
+            }
+            bool inRun = false;
+            for(int cc = left; cc <= right; cc++){
+                int neighbour = neighbourRow * columns + cc;
+                bool open = !seen.testBit(neighbour) && arena->at(neighbour)->isWall() == region;
+                if(open && !inRun){
+                    pending.append(neighbour);
+                }
+                inRun = open;
+            }
+        }
+
+        // Painted last, the entrance and exit keep their value and are only kept apart by seen
+        paintSpan(spanRow, left, right);
+    }
+}
+
+/**
+ * @brief Finishes the edit and adds it to the journal, dropping the undone edits and the oldest
+ * ones beyond the depth of the journal
+ * @return False if the edit changed nothing, it's not recorded then
+ */
+bool MazeEditor::endEdit()
+{
+    if(!editing){
+        return false;
+    }
+    editing = false;
+    lastChangeCount = 0;
+    for(int ii = 1; ii < current.runs.size(); ii += 2){
+        lastChangeCount += current.runs.at(ii);
+    }
+    if(current.runs.isEmpty()){
+        return false;
+    }
+
+    journal.resize(position);
+    journal.append(current);
+    if(journal.size() > journalDepth){
+        journal.remove(0);
+    }
+    position = journal.size();
+    current = Edit();
+    return true;
+}
+
+/**
+ * @brief Checks if an edit has begun and not ended yet
+ * @return True while editing
+ */
+bool MazeEditor::isEditing() const
+{
+    return editing;
+}
+
+/**
+ * @brief Sets the cells of a journal edit to a value
+ * @param edit The edit
+ * @param wall True for walls
+ */
+void MazeEditor::replay(const Edit &edit, bool wall)
+{
+    lastChangeCount = 0;
+    for(int ii = 0; ii + 1 < edit.runs.size(); ii += 2){
+        lastChangeCount += arena->assignWalls(edit.runs.at(ii), edit.runs.at(ii + 1), wall);
+    }
+    dirty = dirty.united(edit.bounds);
+}
+
+/**
+ * @brief Reverts the last applied edit
+ * @return False if there's nothing to undo
+ */
+bool MazeEditor::undo()
+{
+    if(!canUndo()){
+        return false;
+    }
+    position--;
+    replay(journal.at(position), !journal.at(position).wall);
+    return true;
+}
+
+/**
+ * @brief Applies the last undone edit again
+ * @return False if there's nothing to redo
+ */
+bool MazeEditor::redo()
+{
+    if(!canRedo()){
+        return false;
+    }
+    replay(journal.at(position), journal.at(position).wall);
+    position++;
+    return true;
+}
+
+/**
+ * @brief Checks if there is an applied edit to revert, never in the middle of an edit
+ * @return True if undo() would do something
+ */
+bool MazeEditor::canUndo() const
+{
+    return !editing && position > 0;
+}
+
+/**
+ * @brief Checks if there is an undone edit to apply again, never in the middle of an edit
+ * @return True if redo() would do something
+ */
+bool MazeEditor::canRedo() const
+{
+    return !editing && position < journal.size();
+}
+
+/**
+ * @brief Gets the memory held by the journal
+ * @return Bytes of the edits and their runs
+ */
+qint64 MazeEditor::getJournalBytes() const
+{
+    qint64 bytes = 0;
+    foreach(const Edit &edit, journal){
+        bytes += sizeof(Edit) + qint64(edit.runs.capacity()) * sizeof(int);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Gets and forgets the cells changed since the last call, for one repaint
+ * @return The bounding rectangle in columns (x) and rows (y), null if nothing changed
+ */
+QRect MazeEditor::takeDirty()
+{
+    QRect changed = dirty;
+    dirty = QRect();
+    return changed;
+}
+
+/**
+ * @brief Gets the number of cells the last edit, undo or redo actually changed
+ * @return The number of changed cells
+ */
+int MazeEditor::getLastChangeCount() const
+{
+    return lastChangeCount;
+}
@@ -0,0 +1,78 @@
+#ifndef MAZEEDITOR_H
+#define MAZEEDITOR_H
+
+#include <QRect>
+#include <QVector>
+
+#include "mazenodearena.h"
+
+/**
+ * @brief Paints walls with brushes, lines, rectangles and flood fills and keeps an undo journal.
+ *
+ * Every tool breaks its shape into row spans and sets the walls of a span in one pass over the
+ * node block, without a repaint per node. The cells changed since the last takeDirty() form a
+ * single rectangle for the view to repaint. An edit lasts from beginEdit() to endEdit(), so a
+ * whole drag is one step in the journal.
+ *
+ * Since an edit sets all its cells to the same value, only the cells that changed are kept,
+ * as runs of consecutive ids. Undoing flips them back and redoing flips them again, so a
+ * rectangle fill costs two ints per row in the journal however wide it is.
+ */
+class MazeEditor
+{
+public:
+    /// The editing tools, in the order of the tool selector
+    enum Tool {
+        Toggle = 0, ///< Flips the clicked cell
+        Brush, ///< Paints a square brush along the drag
+        Line, ///< Paints a straight line from the press to the release
+        RectangleFill, ///< Fills the rectangle from the press to the release
+        FloodFill ///< Fills the region of cells like the clicked one
+    };
+
+    explicit MazeEditor(MazeNodeArena *nodeArena);
+    void reset(int mazeRows, int mazeColumns); ///< Sets the size of the maze and drops the journal
+
+    void beginEdit(bool wall); ///< Starts an edit that sets walls (true) or clears them (false)
+    void paintBrush(int row, int column, int radius); ///< Paints a square of 2 * radius + 1 cells around a cell
+    void paintLine(int fromRow, int fromColumn, int toRow, int toColumn, int radius); ///< Paints the brush along a line
+    void paintRectangle(int top, int left, int bottom, int right); ///< Paints a rectangle, bounds inclusive
+    void floodFill(int row, int column); ///< Paints the region of cells connected to a cell that the edit would change
+    bool endEdit(); ///< Adds the edit to the journal, false if it changed nothing
+    bool isEditing() const;
+
+    bool undo(); ///< Reverts the last edit
+    bool redo(); ///< Applies the last undone edit again
+    bool canUndo() const;
+    bool canRedo() const;
+    qint64 getJournalBytes() const; ///< Memory held by the journal
+
+    QRect takeDirty(); ///< The cells changed since the last call, in rows and columns, null if none
+    int getLastChangeCount() const; ///< Cells changed by the last edit, undo or redo
+
+private:
+    /// One edit in the journal
+    struct Edit
+    {
+        bool wall; ///< The value the edit set
+        QVector<int> runs; ///< The changed ids as pairs of first id and length
+        QRect bounds; ///< The changed cells in rows and columns
+    };
+
+    static const int journalDepth = 256; ///< Edits kept for undo
+
+    MazeNodeArena *arena;
+    int rows;
+    int columns;
+    QVector<Edit> journal;
+    int position; ///< Edits before this one are applied, the ones after it have been undone
+    Edit current;
+    bool editing;
+    QRect dirty;
+    int lastChangeCount;
+
+    void paintSpan(int row, int left, int right); ///< Paints a part of a row, clipped to the maze
+    void replay(const Edit &edit, bool wall); ///< Sets the cells of a journal edit
+};
+
+#endif // MAZEEDITOR_H
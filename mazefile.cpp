@@ -0,0 +1,82 @@
+#include "mazefile.h"
+
+#include <QFile>
+#include <QDataStream>
+
+/**
+ * @brief Writes a maze and the trace of its last search to a file
+ * @param fileName The file to write to
+ * @param rows Number of rows in the maze
+ * @param columns Number of columns in the maze
+ * @param walls One bit per node id, set for walls
+ * @param trace The trace of the last search, may be empty
+ * @return True on success
+ */
+bool MazeFile::save(const QString &fileName, int rows, int columns, const QBitArray &walls, const SearchTrace &trace)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << magic << version << qint32(rows) << qint32(columns) << walls;
+    out << bool(!trace.isEmpty());
+    if(!trace.isEmpty()){
+        out << trace;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief Reads a maze and the trace of its last search from a file
+ * @param fileName The file to read from
+ * @param rows Receives the number of rows
+ * @param columns Receives the number of columns
+ * @param walls Receives one bit per node id, set for walls
+ * @param trace Receives the trace, reset to empty if the file has none
+ * @return True on success
+ */
+bool MazeFile::load(const QString &fileName, int &rows, int &columns, QBitArray &walls, SearchTrace &trace)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 fileMagic;
+    qint32 fileVersion;
+    qint32 fileRows;
+    qint32 fileColumns;
+    in >> fileMagic >> fileVersion;
+    if(fileMagic != magic || fileVersion > version){
+        return false;
+    }
+
+    // The size is checked before anything of that size is allocated
+    in >> fileRows >> fileColumns;
+    if(in.status() != QDataStream::Ok || fileRows <= 0 || fileColumns <= 0 || qint64(fileRows) * fileColumns > maxCells){
+        return false;
+    }
+    int cells = fileRows * fileColumns;
+    in >> walls;
+    if(walls.size() != cells){
+        return false;
+    }
+
+    bool hasTrace = false;
+    in >> hasTrace;
+    trace.reset(cells);
+    if(hasTrace && !trace.read(in, cells)){
+        trace.reset(cells);
+        return false;
+    }
+
+    rows = fileRows;
+    columns = fileColumns;
+    return in.status() == QDataStream::Ok;
+}
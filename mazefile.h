@@ -0,0 +1,25 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include <QString>
+#include <QBitArray>
+
+#include "searchtrace.h"
+
+/**
+ * @brief Reads and writes mazes, together with the trace of the last search, to disk
+ */
+class MazeFile
+{
+public:
+    static bool save(const QString &fileName, int rows, int columns, const QBitArray &walls, const SearchTrace &trace); ///< Writes a maze and its trace
+    static bool load(const QString &fileName, int &rows, int &columns, QBitArray &walls, SearchTrace &trace); ///< Reads a maze and its trace
+
+    static const qint64 maxCells = qint64(1) << 30; ///< Largest maze a file may hold
+
+private:
+    static const quint32 magic = 0x4d5a4531; ///< "MZE1"
+    static const qint32 version = 1;
+};
+
+#endif // MAZEFILE_H
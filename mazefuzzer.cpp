@@ -0,0 +1,590 @@
+#include "mazefuzzer.h"
+#include "mazegrid.h"
+#include "mazekernels.h"
+#include "mazenodearena.h"
+#include "searchstepper.h"
+#include "boundedsearch.h"
+#include "anytimesearch.h"
+#include "landmarktable.h"
+#include "rectanglesearch.h"
+#include "batchsolver.h"
+#include "shardedsearch.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace MazeFuzzer {
+
+/// Memory the bounded searches may use, enough to never run out on the fuzzed mazes
+static const qint64 boundedBudgetBytes = 64 * 1024 * 1024;
+
+/// A maze with a start and a goal, all node ids row-major
+struct Case
+{
+    Case() : rows(0), columns(0), start(0), goal(0) {}
+    int rows;
+    int columns;
+    QBitArray walls;
+    int start;
+    int goal;
+
+    int cells() const { return rows * columns; }
+    bool isCornerToCorner() const { return start == 0 && goal == cells() - 1 && cells() > 1; }
+};
+
+/// What a solver found
+struct Answer
+{
+    Answer() : found(false), shortest(false) {}
+    bool found;
+    bool shortest; ///< True if the path has to be a shortest one
+    QVector<int> path;
+};
+
+/// The solvers under test
+enum SolverKind {
+    GridSolver, ///< MazeGrid::findPath in one of the orderings
+    KernelSolver, ///< A specialized kernel
+    StepperSolver, ///< The stepwise DFS or BFS of the GUI on real nodes
+    BoundedSolver, ///< IDA* or frontier BFS
+    AnytimeSolver, ///< ARA*, with or without landmarks
+    RectangleSolver, ///< A* across empty rectangles
+    BatchSolverKind, ///< One query of the batch solver
+    ShardedSolver ///< The BFS over worker processes
+};
+
+/// One solver configuration
+struct Solver
+{
+    QString name;
+    SolverKind kind;
+    int variant; ///< Ordering, algorithm, stepper mode, method or landmark flag
+    MazeKernels::Connectivity connectivity;
+    MazeKernels::Storage storage;
+    int every; ///< Runs on every n-th case only, for the slow ones
+};
+
+static inline quint32 nextRandom(quint32 &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * @brief Makes the maze of a case seed. Most mazes are small so many of them run per second,
+ * every eighth one is larger. Half of them go from corner to corner like the GUI does.
+ * @param seed The case seed
+ * @return The maze, with the start and the goal open
+ */
+static Case generate(quint32 seed)
+{
+    quint32 state = seed * 2654435761u ^ 0x9e3779b9u;
+    if(state == 0){
+        state = 1;
+    }
+    for(int warmUp = 0; warmUp < 4; warmUp++){
+        nextRandom(state);
+    }
+
+    Case maze;
+    int limit = nextRandom(state) % 8 == 0 ? 64 : 16;
+    maze.rows = 1 + int(nextRandom(state) % limit);
+    maze.columns = 1 + int(nextRandom(state) % limit);
+    int density = int(nextRandom(state) % 61);
+    maze.walls = QBitArray(maze.cells());
+    for(int id = 0; id < maze.cells(); id++){
+        if(int(nextRandom(state) % 100) < density){
+            maze.walls.setBit(id);
+        }
+    }
+    if(nextRandom(state) & 1){
+        maze.start = 0;
+        maze.goal = maze.cells() - 1;
+    }
+    else{
+        maze.start = int(nextRandom(state) % maze.cells());
+        maze.goal = int(nextRandom(state) % maze.cells());
+    }
+    maze.walls.clearBit(maze.start);
+    maze.walls.clearBit(maze.goal);
+    return maze;
+}
+
+/**
+ * @brief The length of a shortest path with a plain breadth first search
+ * @return The number of steps, -1 if the goal can't be reached
+ */
+template<class Neighbourhood>
+static int referenceDistance(const Case &maze)
+{
+    QVector<int> distance(maze.cells(), -1);
+    QVector<int> queue;
+    distance[maze.start] = 0;
+    queue.append(maze.start);
+    for(int head = 0; head < queue.size(); head++){
+        int id = queue.at(head);
+        if(id == maze.goal){
+            return distance.at(id);
+        }
+        int row = id / maze.columns;
+        int column = id % maze.columns;
+        for(int dir = 0; dir < Neighbourhood::Count; dir++){
+            int nextRow = row + Neighbourhood::rowOffset(dir, row & 1);
+            int nextColumn = column + Neighbourhood::columnOffset(dir, row & 1);
+            if(nextRow < 0 || nextRow >= maze.rows || nextColumn < 0 || nextColumn >= maze.columns){
+                continue;
+            }
+            int next = nextRow * maze.columns + nextColumn;
+            if(!maze.walls.testBit(next) && distance.at(next) < 0){
+                distance[next] = distance.at(id) + 1;
+                queue.append(next);
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Checks whether one step of a path goes to a neighbour
+ */
+template<class Neighbourhood>
+static bool isStep(const Case &maze, int from, int to)
+{
+    int row = from / maze.columns;
+    int column = from % maze.columns;
+    for(int dir = 0; dir < Neighbourhood::Count; dir++){
+        int nextRow = row + Neighbourhood::rowOffset(dir, row & 1);
+        int nextColumn = column + Neighbourhood::columnOffset(dir, row & 1);
+        if(nextRow >= 0 && nextRow < maze.rows && nextColumn >= 0 && nextColumn < maze.columns
+                && nextRow * maze.columns + nextColumn == to){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Gets the row and column of a cell as text
+ */
+static QString cellName(const Case &maze, int id)
+{
+    return "(" + QString::number(id / maze.columns) + ", " + QString::number(id % maze.columns) + ")";
+}
+
+/**
+ * @brief Compares an answer with the reference search
+ * @return What's wrong with it, empty if nothing
+ */
+template<class Neighbourhood>
+static QString checkAnswer(const Case &maze, const Answer &answer)
+{
+    int distance = referenceDistance<Neighbourhood>(maze);
+    if(answer.found != (distance >= 0)){
+        return answer.found ? QString("found a path where there is none")
+                            : "found no path, the shortest has " + QString::number(distance) + " steps";
+    }
+    if(!answer.found){
+        return QString();
+    }
+    if(answer.path.isEmpty() || answer.path.first() != maze.start || answer.path.last() != maze.goal){
+        return "the path doesn't lead from the start to the goal";
+    }
+    for(int ii = 0; ii < answer.path.size(); ii++){
+        int id = answer.path.at(ii);
+        if(id < 0 || id >= maze.cells()){
+            return "the path leaves the maze";
+        }
+        if(maze.walls.testBit(id)){
+            return "the path crosses the wall at " + cellName(maze, id);
+        }
+        if(ii > 0 && !isStep<Neighbourhood>(maze, answer.path.at(ii - 1), id)){
+            return "the path jumps from " + cellName(maze, answer.path.at(ii - 1)) + " to " + cellName(maze, id);
+        }
+    }
+    if(answer.shortest && answer.path.size() - 1 != distance){
+        return "the path has " + QString::number(answer.path.size() - 1) + " steps, the shortest has " + QString::number(distance);
+    }
+    return QString();
+}
+
+/**
+ * @brief Builds the grid the grid based solvers search
+ */
+static MazeGrid gridOf(const Case &maze, MazeGrid::Ordering ordering = MazeGrid::RowMajor)
+{
+    MazeGrid grid(maze.rows, maze.columns, ordering);
+    grid.setWalls(maze.walls);
+    return grid;
+}
+
+/**
+ * @brief Runs the stepwise search of the GUI on real nodes, the way MSolver does
+ */
+static Answer runStepper(const Case &maze, SearchStepper::Mode mode, quint32 seed)
+{
+    static MazeNodeArena arena;
+    arena.reserve(maze.rows, maze.columns);
+    QHash<int,MazeNode*> nodeHash;
+    nodeHash.reserve(maze.cells());
+    for(int id = 0; id < maze.cells(); id++){
+        nodeHash.insert(id, arena.create(id % maze.columns, id / maze.columns, 1));
+    }
+    arena.assignAllWalls(maze.walls);
+    nodeHash.value(maze.start)->setEntrance(true);
+    nodeHash.value(maze.goal)->setExit(true);
+
+    SearchStepper stepper;
+    stepper.setSeed(seed);
+    stepper.start(mode, &nodeHash, maze.rows, maze.columns, arena.getOpenDirections());
+    stepper.run();
+
+    Answer answer;
+    answer.shortest = mode == SearchStepper::BreadthFirst;
+    MazeNode *node = stepper.getExitNode();
+    answer.found = node != 0;
+    while(node != 0 && answer.path.size() <= maze.cells()){
+        answer.path.append(node->getId());
+        node = node->getId() == maze.start ? 0 : node->getPreviousNode();
+    }
+    std::reverse(answer.path.begin(), answer.path.end());
+    return answer;
+}
+
+/**
+ * @brief Checks whether a solver can run on a maze at all
+ */
+static bool applies(const Solver &solver, const Case &maze)
+{
+    // The stepper always goes from the entrance in the top left to the exit in the bottom right
+    return solver.kind != StepperSolver || maze.isCornerToCorner();
+}
+
+/**
+ * @brief Runs a solver on a maze and checks its answer
+ * @param solver The solver
+ * @param maze The maze
+ * @param seed Seeds the random choices of the solver
+ * @return What's wrong with the answer, empty if nothing
+ */
+static QString runSolver(const Solver &solver, const Case &maze, quint32 seed)
+{
+    Answer answer;
+    switch(solver.kind){
+    case GridSolver:{
+        MazeGrid grid = gridOf(maze, MazeGrid::Ordering(solver.variant));
+        answer.found = grid.findPath(maze.start, maze.goal, answer.path);
+        answer.shortest = true;
+        break;
+    }
+    case KernelSolver:{
+        MazeKernels::KernelInput input;
+        input.rows = maze.rows;
+        input.columns = maze.columns;
+        input.entrance = maze.start;
+        input.exit = maze.goal;
+        input.walls = maze.walls;
+        MazeKernels::KernelResult result = MazeKernels::run(input, MazeKernels::Algorithm(solver.variant), solver.connectivity, solver.storage);
+        answer.found = result.found;
+        answer.path = result.path;
+        answer.shortest = solver.variant == MazeKernels::BreadthFirst;
+        if(solver.connectivity == MazeKernels::EightConnected){
+            return checkAnswer<MazeKernels::EightNeighbourhood>(maze, answer);
+        }
+        if(solver.connectivity == MazeKernels::HexConnected){
+            return checkAnswer<MazeKernels::HexNeighbourhood>(maze, answer);
+        }
+        break;
+    }
+    case StepperSolver:
+        answer = runStepper(maze, SearchStepper::Mode(solver.variant), seed);
+        break;
+    case BoundedSolver:{
+        BoundedSearch::Result result = BoundedSearch::run(gridOf(maze), maze.start, maze.goal, BoundedSearch::Method(solver.variant),
+                                                          boundedBudgetBytes, 0);
+        if(result.budgetExceeded){
+            return "ran out of its memory budget";
+        }
+        answer.found = result.found;
+        answer.path = result.path;
+        answer.shortest = true;
+        break;
+    }
+    case AnytimeSolver:{
+        AnytimeSearch search;
+        AnytimeSearch::Request request;
+        request.grid = gridOf(maze);
+        request.start = maze.start;
+        request.goal = maze.goal;
+        request.deadlineUs = 10000000;
+        LandmarkTable landmarks;
+        if(solver.variant != 0 && landmarks.build(request.grid, 2)){
+            request.landmarks = &landmarks;
+        }
+        request.clock.start();
+        AnytimeSearch::Result result = search.run(request, 0);
+        answer.found = result.found;
+        answer.path = result.path;
+        answer.shortest = result.optimal;
+        break;
+    }
+    case RectangleSolver:{
+        RectangleSearch::Result result = RectangleSearch::run(gridOf(maze), maze.start, maze.goal, 0);
+        answer.found = result.found;
+        answer.path = result.path;
+        answer.shortest = true;
+        break;
+    }
+    case BatchSolverKind:{
+        PathAnswer result = BatchSolver::answer(gridOf(maze), PathQuery(maze.start, maze.goal));
+        answer.found = result.found;
+        answer.path = result.path;
+        answer.shortest = true;
+        break;
+    }
+    case ShardedSolver:{
+        ShardedSearch::Result result = ShardedSearch::run(gridOf(maze), maze.start, maze.goal, solver.variant, 0);
+        if(result.failed){
+            return "failed: " + result.error;
+        }
+        answer.found = result.found;
+        answer.path = result.path;
+        answer.shortest = true;
+        break;
+    }
+    }
+    return checkAnswer<MazeKernels::FourNeighbourhood>(maze, answer);
+}
+
+/**
+ * @brief Lists every solver configuration
+ */
+static QVector<Solver> allSolvers()
+{
+    QVector<Solver> solvers;
+    Solver solver;
+    solver.connectivity = MazeKernels::FourConnected;
+    solver.storage = MazeKernels::PaddedGridStorage;
+    solver.every = 1;
+
+    static const char *orderings[] = { "row-major", "tiled", "Morton" };
+    solver.kind = GridSolver;
+    for(int ordering = MazeGrid::RowMajor; ordering <= MazeGrid::Morton; ordering++){
+        solver.name = QString("MazeGrid BFS, ") + orderings[ordering];
+        solver.variant = ordering;
+        solvers.append(solver);
+    }
+
+    static const char *algorithms[] = { "BFS", "DFS" };
+    static const char *connectivities[] = { "4", "8", "hex" };
+    static const char *storages[] = { "bit plane", "byte grid", "padded grid" };
+    solver.kind = KernelSolver;
+    for(int algorithm = 0; algorithm < MazeKernels::AlgorithmCount; algorithm++){
+        for(int connectivity = 0; connectivity < MazeKernels::ConnectivityCount; connectivity++){
+            for(int storage = 0; storage < MazeKernels::StorageCount; storage++){
+                solver.name = QString("Kernel ") + algorithms[algorithm] + ", " + connectivities[connectivity] + " neighbours, " + storages[storage];
+                solver.variant = algorithm;
+                solver.connectivity = MazeKernels::Connectivity(connectivity);
+                solver.storage = MazeKernels::Storage(storage);
+                solvers.append(solver);
+            }
+        }
+    }
+    solver.connectivity = MazeKernels::FourConnected;
+
+    solver.kind = StepperSolver;
+    solver.name = "Stepper DFS";
+    solver.variant = SearchStepper::DepthFirst;
+    solvers.append(solver);
+    solver.name = "Stepper BFS";
+    solver.variant = SearchStepper::BreadthFirst;
+    solvers.append(solver);
+
+    solver.kind = BoundedSolver;
+    solver.name = "IDA*";
+    solver.variant = BoundedSearch::IterativeDeepeningAStar;
+    solver.every = 8; // Revisits cells a lot on open mazes
+    solvers.append(solver);
+    solver.every = 1;
+    solver.name = "Frontier BFS";
+    solver.variant = BoundedSearch::FrontierBreadthFirst;
+    solvers.append(solver);
+
+    solver.kind = AnytimeSolver;
+    solver.name = "Anytime A*";
+    solver.variant = 0;
+    solvers.append(solver);
+    solver.name = "Anytime A* with landmarks";
+    solver.variant = 1;
+    solver.every = 16; // Building the landmarks starts threads
+    solvers.append(solver);
+    solver.every = 1;
+
+    solver.kind = RectangleSolver;
+    solver.name = "Rectangle A*";
+    solver.variant = 0;
+    solvers.append(solver);
+
+    solver.kind = BatchSolverKind;
+    solver.name = "Batch query";
+    solvers.append(solver);
+
+    solver.kind = ShardedSolver;
+    solver.name = "Sharded BFS, 3 workers";
+    solver.variant = 3;
+    solver.every = 1024; // Starts processes
+    solvers.append(solver);
+    return solvers;
+}
+
+/**
+ * @brief Cuts one row or column off a border of the maze
+ * @param maze The maze
+ * @param side 0 to 3 for the top, bottom, left and right border
+ * @param smaller Receives the smaller maze
+ * @return False if the border holds the start or the goal, or there's nothing left to cut
+ */
+static bool crop(const Case &maze, int side, Case &smaller)
+{
+    int top = side == 0 ? 1 : 0;
+    int bottom = maze.rows - (side == 1 ? 1 : 0);
+    int left = side == 2 ? 1 : 0;
+    int right = maze.columns - (side == 3 ? 1 : 0);
+    if(bottom - top < 1 || right - left < 1){
+        return false;
+    }
+    int cells[2] = { maze.start, maze.goal };
+    for(int ii = 0; ii < 2; ii++){
+        int row = cells[ii] / maze.columns;
+        int column = cells[ii] % maze.columns;
+        if(row < top || row >= bottom || column < left || column >= right){
+            return false;
+        }
+    }
+
+    smaller = Case();
+    smaller.rows = bottom - top;
+    smaller.columns = right - left;
+    smaller.walls = QBitArray(smaller.cells());
+    for(int row = top; row < bottom; row++){
+        for(int column = left; column < right; column++){
+            if(maze.walls.testBit(row * maze.columns + column)){
+                smaller.walls.setBit((row - top) * smaller.columns + column - left);
+            }
+        }
+    }
+    smaller.start = (maze.start / maze.columns - top) * smaller.columns + maze.start % maze.columns - left;
+    smaller.goal = (maze.goal / maze.columns - top) * smaller.columns + maze.goal % maze.columns - left;
+    return true;
+}
+
+/**
+ * @brief Shrinks a maze a solver fails on, cropping borders and opening walls for as long as
+ * the solver keeps failing
+ * @return The smallest failing maze found
+ */
+static Case minimize(Case maze, const Solver &solver, quint32 seed)
+{
+    bool shrunk = true;
+    while(shrunk){
+        shrunk = false;
+        for(int side = 0; side < 4; side++){
+            Case smaller;
+            while(crop(maze, side, smaller) && applies(solver, smaller) && !runSolver(solver, smaller, seed).isEmpty()){
+                maze = smaller;
+                shrunk = true;
+            }
+        }
+        for(int id = 0; id < maze.cells(); id++){
+            if(!maze.walls.testBit(id)){
+                continue;
+            }
+            Case opened = maze;
+            opened.walls.clearBit(id);
+            if(!runSolver(solver, opened, seed).isEmpty()){
+                maze = opened;
+                shrunk = true;
+            }
+        }
+    }
+    return maze;
+}
+
+/**
+ * @brief Prints a maze, S and G for the start and the goal, # for walls
+ */
+static void printMaze(const Case &maze, QTextStream &out)
+{
+    for(int row = 0; row < maze.rows; row++){
+        out << "    ";
+        for(int column = 0; column < maze.columns; column++){
+            int id = row * maze.columns + column;
+            out << (id == maze.start ? 'S' : id == maze.goal ? 'G' : maze.walls.testBit(id) ? '#' : '.');
+        }
+        out << "\n";
+    }
+}
+
+/**
+ * @brief Runs every solver on the cases seed, seed + 1, ... and prints the first failure of
+ * each solver shrunk to a small maze, then the runs, failures and time per run of each solver
+ * @param cases The number of mazes
+ * @param seed The seed of the first maze
+ * @param out Receives the report
+ * @return 0 if all solvers passed, 1 otherwise
+ */
+int run(int cases, quint32 seed, QTextStream &out)
+{
+    QVector<Solver> solvers = allSolvers();
+    QVector<int> runs(solvers.size(), 0);
+    QVector<int> failures(solvers.size(), 0);
+    QVector<qint64> elapsedNs(solvers.size(), 0);
+    QElapsedTimer clock;
+    clock.start();
+
+    for(int index = 0; index < cases; index++){
+        quint32 caseSeed = seed + quint32(index);
+        Case maze = generate(caseSeed);
+        for(int ss = 0; ss < solvers.size(); ss++){
+            const Solver &solver = solvers.at(ss);
+            if(caseSeed % quint32(solver.every) != 0 || !applies(solver, maze)){
+                continue;
+            }
+            qint64 before = clock.nsecsElapsed();
+            QString error = runSolver(solver, maze, caseSeed);
+            elapsedNs[ss] += clock.nsecsElapsed() - before;
+            runs[ss]++;
+            if(error.isEmpty()){
+                continue;
+            }
+
+            failures[ss]++;
+            if(failures.at(ss) == 1){
+                out << solver.name << " fails on the " << maze.rows << "x" << maze.columns << " maze of seed " << caseSeed
+                    << ": " << error << "\n";
+                Case small = minimize(maze, solver, caseSeed);
+                out << "  Shrunk to " << small.rows << "x" << small.columns << ": " << runSolver(solver, small, caseSeed) << "\n";
+                printMaze(small, out);
+                out << "  Run again with --fuzz 1 " << caseSeed << "\n";
+                out.flush();
+            }
+        }
+    }
+
+    qint64 totalMs = qMax(clock.elapsed(), qint64(1));
+    int failed = 0;
+    out << "\n" << cases << " mazes in " << totalMs << " ms, " << qint64(cases) * 1000 / totalMs << " per second\n";
+    for(int ss = 0; ss < solvers.size(); ss++){
+        out << "  " << solvers.at(ss).name << ": " << runs.at(ss) << " runs, " << failures.at(ss) << " failed, "
+            << (runs.at(ss) > 0 ? elapsedNs.at(ss) / runs.at(ss) / 1000.0 : 0.0) << " us per run\n";
+        failed += failures.at(ss);
+    }
+    out << (failed == 0 ? "All solvers passed\n" : "Some solvers FAILED\n");
+    return failed == 0 ? 0 : 1;
+}
+
+}
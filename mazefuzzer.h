@@ -0,0 +1,21 @@
+#ifndef MAZEFUZZER_H
+#define MAZEFUZZER_H
+
+#include <QTextStream>
+
+/**
+ * @brief Differential fuzzing of all solvers against a plain reference BFS. Every case is a
+ * random maze whose size, wall density, start and goal follow from the case seed alone, so a
+ * failure is reproduced by running that one seed again. Each solver's path has to start and
+ * end in the right cells and step between open neighbours; the breadth first and A* searches
+ * also have to match the shortest distance. A failing maze is shrunk by cropping its borders
+ * and opening walls as long as the solver still fails, and printed as a small grid.
+ * Started with --fuzz on the command line.
+ */
+namespace MazeFuzzer {
+
+int run(int cases, quint32 seed, QTextStream &out); ///< Runs cases seed, seed + 1, ..., returns 0 if all solvers passed
+
+}
+
+#endif // MAZEFUZZER_H
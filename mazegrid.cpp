@@ -0,0 +1,495 @@
+#include "mazegrid.h"
+
+/// Bits of a Morton index that hold the column and the row
+static const quint32 mortonColumnMask = 0x55555555u;
+static const quint32 mortonRowMask = 0xaaaaaaaau;
+
+/**
+ * @brief Spreads the lower 16 bits of a value to the even bits
+ */
+static inline quint32 spreadBits(quint32 value)
+{
+    value &= 0x0000ffff;
+    value = (value | (value << 8)) & 0x00ff00ff;
+    value = (value | (value << 4)) & 0x0f0f0f0f;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+/**
+ * @brief Collects the even bits of a value into the lower 16 bits
+ */
+static inline quint32 compactBits(quint32 value)
+{
+    value &= 0x55555555;
+    value = (value | (value >> 1)) & 0x33333333;
+    value = (value | (value >> 2)) & 0x0f0f0f0f;
+    value = (value | (value >> 4)) & 0x00ff00ff;
+    value = (value | (value >> 8)) & 0x0000ffff;
+    return value;
+}
+
+/**
+ * @brief Creates an empty grid
+ */
+MazeGrid::MazeGrid()
+{
+    resize(0, 0, RowMajor);
+}
+
+/**
+ * @brief Creates an open maze of the given size
+ * @param nrows The number of rows
+ * @param ncolumns The number of columns
+ * @param cellOrdering The memory layout of the cells
+ */
+MazeGrid::MazeGrid(int nrows, int ncolumns, Ordering cellOrdering)
+{
+    resize(nrows, ncolumns, cellOrdering);
+}
+
+/**
+ * @brief Reallocates the planes for a new size or ordering. All cells end up open and unvisited,
+ * all slots outside of the maze are walls.
+ * @param nrows The number of rows
+ * @param ncolumns The number of columns
+ * @param cellOrdering The memory layout of the cells
+ */
+void MazeGrid::resize(int nrows, int ncolumns, Ordering cellOrdering)
+{
+    rows = nrows;
+    columns = ncolumns;
+    ordering = cellOrdering;
+    stride = columns + 2;
+    tilesPerRow = (columns + 2 + 7) / 8;
+    mortonSide = 1;
+
+    switch(ordering){
+    case RowMajor:
+        storageSize = (rows + 2) * stride;
+        break;
+    case Tiled:
+        storageSize = ((rows + 2 + 7) / 8) * tilesPerRow * 64;
+        break;
+    case Morton:
+        // One spare row and column of walls, reached by wrapping around from the first ones
+        while(mortonSide < qMax(rows, columns) + 1){
+            mortonSide <<= 1;
+        }
+        storageSize = mortonSide * mortonSide;
+        break;
+    }
+
+    int words = (storageSize + 63) / 64;
+    wallPlane.fill(~quint64(0), words);
+    visitedPlane.fill(0, words);
+    exitPlane.fill(0, words);
+    parentPlane.fill(0, (storageSize + 31) / 32);
+
+    for(int row = 0; row < rows; row++){
+        for(int column = 0; column < columns; column++){
+            setWall(indexOf(row, column), false);
+        }
+    }
+}
+
+/**
+ * @brief Gets the number of rows
+ * @return The number of rows
+ */
+int MazeGrid::getRows() const
+{
+    return rows;
+}
+
+/**
+ * @brief Gets the number of columns
+ * @return The number of columns
+ */
+int MazeGrid::getColumns() const
+{
+    return columns;
+}
+
+/**
+ * @brief Gets the memory layout of the cells
+ * @return The ordering
+ */
+MazeGrid::Ordering MazeGrid::getOrdering() const
+{
+    return ordering;
+}
+
+/**
+ * @brief Gets the number of cells of the maze
+ * @return Rows times columns
+ */
+int MazeGrid::getCellCount() const
+{
+    return rows * columns;
+}
+
+/**
+ * @brief Gets the number of slots, including the sentinel walls and padding
+ * @return The number of slots
+ */
+int MazeGrid::getStorageSize() const
+{
+    return storageSize;
+}
+
+/**
+ * @brief Gets the memory used by the planes
+ * @return The size in bytes
+ */
+qint64 MazeGrid::getMemoryUsage() const
+{
+    return qint64(wallPlane.size() + visitedPlane.size() + exitPlane.size() + parentPlane.size()) * sizeof(quint64);
+}
+
+/**
+ * @brief Gets the storage index of a cell
+ * @param row The row of the cell
+ * @param column The column of the cell
+ * @return The storage index
+ */
+int MazeGrid::indexOf(int row, int column) const
+{
+    switch(ordering){
+    case Tiled:
+    {
+        int paddedRow = row + 1;
+        int paddedColumn = column + 1;
+        return (((paddedRow >> 3) * tilesPerRow + (paddedColumn >> 3)) << 6) + ((paddedRow & 7) << 3) + (paddedColumn & 7);
+    }
+    case Morton:
+        return int(spreadBits(quint32(column)) | (spreadBits(quint32(row)) << 1));
+    default:
+        return (row + 1) * stride + column + 1;
+    }
+}
+
+/**
+ * @brief Gets the storage index of a node id
+ * @param id The row-major node id
+ * @return The storage index
+ */
+int MazeGrid::indexOfId(int id) const
+{
+    return indexOf(id / columns, id % columns);
+}
+
+/**
+ * @brief Gets the padded row and column of a storage index. Row-major and tiled layouts
+ * are padded by one, the Morton layout is not.
+ * @param index The storage index
+ * @param row Receives the padded row
+ * @param column Receives the padded column
+ */
+void MazeGrid::rowColumnOf(int index, int &row, int &column) const
+{
+    switch(ordering){
+    case Tiled:
+    {
+        int tile = index >> 6;
+        row = ((tile / tilesPerRow) << 3) + ((index >> 3) & 7);
+        column = ((tile % tilesPerRow) << 3) + (index & 7);
+        break;
+    }
+    case Morton:
+        row = int(compactBits(quint32(index) >> 1));
+        column = int(compactBits(quint32(index)));
+        break;
+    default:
+        row = index / stride;
+        column = index % stride;
+        break;
+    }
+}
+
+/**
+ * @brief Gets the node id of a storage index
+ * @param index A storage index inside the maze
+ * @return The row-major node id
+ */
+int MazeGrid::idOf(int index) const
+{
+    int row;
+    int column;
+    rowColumnOf(index, row, column);
+    if(ordering != Morton){
+        row--;
+        column--;
+    }
+    return row * columns + column;
+}
+
+/**
+ * @brief Gets the storage index of a neighbour. Neighbours of maze cells are always valid
+ * slots, outside of the maze they are walls.
+ * @param index The storage index of a maze cell
+ * @param direction The direction to move in
+ * @return The storage index of the neighbour
+ */
+int MazeGrid::neighbour(int index, int direction) const
+{
+    switch(ordering){
+    case Tiled:
+        // Moves inside a tile are plain offsets, moves across a tile edge jump to the next tile
+        switch(direction){
+        case South:
+            return ((index >> 3) & 7) != 7 ? index + 8 : index - 56 + (tilesPerRow << 6);
+        case North:
+            return ((index >> 3) & 7) != 0 ? index - 8 : index + 56 - (tilesPerRow << 6);
+        case East:
+            return (index & 7) != 7 ? index + 1 : index - 7 + 64;
+        default:
+            return (index & 7) != 0 ? index - 1 : index + 7 - 64;
+        }
+    case Morton:
+    {
+        // Add or subtract one on the interleaved bits by filling the gaps so the carry passes
+        // through them. Stepping off the first row or column wraps to the last one, which is all walls.
+        quint32 value = quint32(index);
+        quint32 result;
+        switch(direction){
+        case South:
+            result = (((value | mortonColumnMask) + 1) & mortonRowMask) | (value & mortonColumnMask);
+            break;
+        case North:
+            result = (((value & mortonRowMask) - 1) & mortonRowMask) | (value & mortonColumnMask);
+            break;
+        case East:
+            result = (((value | mortonRowMask) + 1) & mortonColumnMask) | (value & mortonRowMask);
+            break;
+        default:
+            result = (((value & mortonColumnMask) - 1) & mortonColumnMask) | (value & mortonRowMask);
+            break;
+        }
+        return int(result & quint32(storageSize - 1));
+    }
+    default:
+        switch(direction){
+        case South:
+            return index + stride;
+        case North:
+            return index - stride;
+        case East:
+            return index + 1;
+        default:
+            return index - 1;
+        }
+    }
+}
+
+/**
+ * @brief Sets or clears the wall bit of a cell
+ * @param index The storage index
+ * @param wall True for a wall
+ */
+void MazeGrid::setWall(int index, bool wall)
+{
+    assignBit(wallPlane, index, wall);
+}
+
+/**
+ * @brief Sets the direction from a cell back to the cell it was reached from
+ * @param index The storage index
+ * @param direction The direction to the parent
+ */
+void MazeGrid::setParentDirection(int index, int direction)
+{
+    quint64 &word = parentPlane[index >> 5];
+    int shift = (index & 31) * 2;
+    word = (word & ~(quint64(3) << shift)) | (quint64(direction & 3) << shift);
+}
+
+/**
+ * @brief Sets all walls of the maze
+ * @param walls One bit per row-major node id, set for walls
+ */
+void MazeGrid::setWalls(const QBitArray &walls)
+{
+    for(int row = 0; row < rows; row++){
+        for(int column = 0; column < columns; column++){
+            setWall(indexOf(row, column), walls.testBit(row * columns + column));
+        }
+    }
+}
+
+/**
+ * @brief Sets the walls of one row from packed bits. Row-major grids take the bits a word at
+ * a time, shifted to where the row starts in the wall plane.
+ * @param row The row
+ * @param bits Column c in bit c % 64 of word c / 64, bits past the last column are ignored
+ */
+void MazeGrid::setWallRow(int row, const quint64 *bits)
+{
+    if(ordering != RowMajor){
+        for(int column = 0; column < columns; column++){
+            setWall(indexOf(row, column), (bits[column >> 6] >> (column & 63)) & 1);
+        }
+        return;
+    }
+
+    int start = indexOf(row, 0);
+    for(int word = 0; word * 64 < columns; word++){
+        int count = qMin(64, columns - word * 64);
+        quint64 mask = count == 64 ? ~quint64(0) : (quint64(1) << count) - 1;
+        quint64 value = bits[word] & mask;
+        int position = start + word * 64;
+        int shift = position & 63;
+        quint64 &low = wallPlane[position >> 6];
+        low = (low & ~(mask << shift)) | (value << shift);
+        if(shift != 0 && shift + count > 64){
+            quint64 &high = wallPlane[(position >> 6) + 1];
+            high = (high & ~(mask >> (64 - shift))) | (value >> (64 - shift));
+        }
+    }
+}
+
+/**
+ * @brief Gets the walls of one row as packed bits. Row-major grids give them a word at a time,
+ * shifted from where the row starts in the wall plane.
+ * @param row The row
+ * @param bits Receives column c in bit c % 64 of word c / 64, bits past the last column are clear
+ */
+void MazeGrid::getWallRow(int row, quint64 *bits) const
+{
+    int words = (columns + 63) / 64;
+    if(ordering != RowMajor){
+        for(int word = 0; word < words; word++){
+            bits[word] = 0;
+        }
+        for(int column = 0; column < columns; column++){
+            if(isWall(indexOf(row, column))){
+                bits[column >> 6] |= quint64(1) << (column & 63);
+            }
+        }
+        return;
+    }
+
+    int start = indexOf(row, 0);
+    for(int word = 0; word < words; word++){
+        int count = qMin(64, columns - word * 64);
+        quint64 mask = count == 64 ? ~quint64(0) : (quint64(1) << count) - 1;
+        int position = start + word * 64;
+        int shift = position & 63;
+        quint64 value = wallPlane.at(position >> 6) >> shift;
+        if(shift != 0 && shift + count > 64){
+            value |= wallPlane.at((position >> 6) + 1) << (64 - shift);
+        }
+        bits[word] = value & mask;
+    }
+}
+
+/**
+ * @brief Gets all walls of the maze
+ * @return One bit per row-major node id, set for walls
+ */
+QBitArray MazeGrid::getWalls() const
+{
+    QBitArray walls(rows * columns);
+    for(int row = 0; row < rows; row++){
+        for(int column = 0; column < columns; column++){
+            if(isWall(indexOf(row, column))){
+                walls.setBit(row * columns + column);
+            }
+        }
+    }
+    return walls;
+}
+
+/**
+ * @brief Clears the visited and parent planes for a new search
+ */
+void MazeGrid::clearSearchState()
+{
+    visitedPlane.fill(0);
+    parentPlane.fill(0);
+}
+
+/**
+ * @brief Fills the maze with walls like MazeUi::createRandomMaze, but from a seed so the
+ * same maze can be created again. The first and the last cell stay open.
+ * @param seed The seed of the random sequence, not 0
+ */
+void MazeGrid::randomize(quint32 seed)
+{
+    quint32 state = seed ? seed : 0x9e3779b9u;
+    for(int row = 0; row < rows; row++){
+        for(int column = 0; column < columns; column++){
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            setWall(indexOf(row, column), state % 3 >= 2);
+        }
+    }
+    if(rows > 0 && columns > 0){
+        setWall(indexOf(0, 0), false);
+        setWall(indexOf(rows - 1, columns - 1), false);
+    }
+}
+
+/**
+ * @brief Runs a breadth first search using only the planes for the search state.
+ * The queue holds storage indexes, the path is followed back through the parent plane.
+ * @param entranceId The node id to start from
+ * @param exitId The node id to find
+ * @param path Receives the node ids from the entrance to the exit
+ * @param expanded Receives the number of expanded cells, if not 0
+ * @return True if the exit was reached
+ */
+bool MazeGrid::findPath(int entranceId, int exitId, QVector<int> &path, int *expanded)
+{
+    path.clear();
+    clearSearchState();
+    exitPlane.fill(0);
+
+    int entrance = indexOfId(entranceId);
+    int exit = indexOfId(exitId);
+    setExit(exit, true);
+
+    QVector<int> queue;
+    queue.reserve(qMin(getCellCount(), 1 << 16));
+    queue.append(entrance);
+    setVisited(entrance, true);
+
+    int head = 0;
+    bool found = false;
+    while(head < queue.size()){
+        int current = queue.at(head++);
+        if(isExit(current)){
+            found = true;
+            break;
+        }
+        for(int direction = 0; direction < 4; direction++){
+            int next = neighbour(current, direction);
+            if(!isWall(next) && !isVisited(next)){
+                setVisited(next, true);
+                setParentDirection(next, opposite(direction));
+                queue.append(next);
+            }
+        }
+    }
+
+    if(expanded){
+        *expanded = head;
+    }
+    if(!found){
+        return false;
+    }
+
+    QVector<int> reversed;
+    for(int current = exit; current != entrance; current = neighbour(current, parentDirection(current))){
+        reversed.append(idOf(current));
+    }
+    reversed.append(entranceId);
+
+    path.resize(reversed.size());
+    for(int ii = 0; ii < reversed.size(); ii++){
+        path[ii] = reversed.at(reversed.size() - 1 - ii);
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef MAZEGRID_H
+#define MAZEGRID_H
+
+#include <QVector>
+#include <QBitArray>
+
+/**
+ * @brief A dense maze store in structure-of-arrays form. Walls, visited and exit flags are
+ * separate bit planes and the direction back to the parent is a two bit plane, so a search
+ * touches a few bytes per cell instead of a heap object per cell.
+ *
+ * Cells are addressed by a storage index whose layout depends on the ordering. Row-major and
+ * tiled layouts keep a border of walls around the maze and the Morton layout keeps at least one
+ * row and column of walls at the end, so neighbour() never has to check bounds. Node ids are
+ * row-major (row * columns + column) like everywhere else in the application.
+ */
+class MazeGrid
+{
+public:
+    /// How cells are laid out in memory
+    enum Ordering {
+        RowMajor = 0, ///< Rows one after another
+        Tiled, ///< 8x8 tiles, one 64 bit word of each bit plane per tile
+        Morton ///< Z-order curve, rows and columns interleaved bit by bit
+    };
+
+    /// Neighbour directions, in the same order as MSolver and the kernels
+    enum Direction {
+        South = 0,
+        North = 1,
+        East = 2,
+        West = 3
+    };
+
+    MazeGrid();
+    MazeGrid(int nrows, int ncolumns, Ordering cellOrdering = RowMajor);
+    void resize(int nrows, int ncolumns, Ordering cellOrdering = RowMajor); ///< Reallocates as an open maze
+
+    int getRows() const;
+    int getColumns() const;
+    Ordering getOrdering() const;
+    int getCellCount() const; ///< Number of cells of the maze
+    int getStorageSize() const; ///< Number of slots including the sentinel walls
+    qint64 getMemoryUsage() const; ///< Bytes used by all planes
+
+    int indexOf(int row, int column) const; ///< Storage index of a cell
+    int indexOfId(int id) const; ///< Storage index of a row-major node id
+    int idOf(int index) const; ///< Row-major node id of a storage index
+    int neighbour(int index, int direction) const; ///< Storage index of the neighbour, a wall outside of the maze
+    static int opposite(int direction) { return direction ^ 1; }
+
+    bool isWall(int index) const { return testBit(wallPlane, index); }
+    bool isVisited(int index) const { return testBit(visitedPlane, index); }
+    bool isExit(int index) const { return testBit(exitPlane, index); }
+    int parentDirection(int index) const { return int((parentPlane.at(index >> 5) >> ((index & 31) * 2)) & 3); }
+    void setWall(int index, bool wall);
+    void setVisited(int index, bool visited) { assignBit(visitedPlane, index, visited); }
+    void setExit(int index, bool exit) { assignBit(exitPlane, index, exit); }
+    void setParentDirection(int index, int direction);
+
+    void setWalls(const QBitArray &walls); ///< Sets all walls from one bit per node id
+    void setWallRow(int row, const quint64 *bits); ///< Sets the walls of one row from packed bits, column c in bit c % 64 of word c / 64
+    QBitArray getWalls() const; ///< Gets one bit per node id, set for walls
+    void getWallRow(int row, quint64 *bits) const; ///< Gets the walls of one row as packed bits, the layout of setWallRow
+    void clearSearchState(); ///< Clears the visited and parent planes
+    void randomize(quint32 seed); ///< Makes about a third of the cells walls, keeping the corners open
+
+    bool findPath(int entranceId, int exitId, QVector<int> &path, int *expanded = 0); ///< Breadth first search on the planes
+
+private:
+    static inline bool testBit(const QVector<quint64> &plane, int index)
+    {
+        return (plane.at(index >> 6) >> (index & 63)) & 1;
+    }
+    static inline void assignBit(QVector<quint64> &plane, int index, bool value)
+    {
+        if(value){
+            plane[index >> 6] |= (quint64(1) << (index & 63));
+        }
+        else{
+            plane[index >> 6] &= ~(quint64(1) << (index & 63));
+        }
+    }
+
+    int rows;
+    int columns;
+    Ordering ordering;
+    int storageSize;
+    int stride; ///< Row-major: slots per padded row
+    int tilesPerRow; ///< Tiled: tiles per padded row
+    int mortonSide; ///< Morton: side length of the power of two square
+
+    QVector<quint64> wallPlane;
+    QVector<quint64> visitedPlane;
+    QVector<quint64> exitPlane;
+    QVector<quint64> parentPlane; ///< Two bits per cell, 32 cells per word
+
+    void rowColumnOf(int index, int &row, int &column) const; ///< Padded row and column of a storage index
+};
+
+#endif // MAZEGRID_H
@@ -0,0 +1,439 @@
+#include "mazeimage.h"
+#include "mazefile.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QtConcurrentMap>
+
+/// A chunk of raster rows on its way from the file to the grid
+struct RasterChunk
+{
+    QByteArray input; ///< The raster bytes as read
+    QVector<quint64> packed; ///< Wall bits, wordsPerRow words per row
+    QVector<int> rows; ///< Row numbers within the chunk, the sequence handed to QtConcurrent
+    int firstRow;
+};
+
+/// The layout of a binary PBM or PGM raster and how its values map to walls
+struct RasterFormat
+{
+    bool bitmap; ///< PBM, otherwise PGM
+    int width;
+    int bytesPerRow;
+    int wordsPerRow;
+    int bytesPerSample; ///< PGM: 1 up to a maximum value of 255, 2 above
+    QByteArray wallOfByte; ///< PGM with one byte samples: non-zero for values below the threshold
+    qint64 thresholdTimesMaximum; ///< PGM with two byte samples: value * 255 below this is a wall
+};
+
+/**
+ * @brief Reverses the bits of a byte, PBM keeps the leftmost pixel in the highest bit
+ */
+static inline quint8 reverseBits(quint8 byte)
+{
+    byte = quint8((byte & 0xf0) >> 4 | (byte & 0x0f) << 4);
+    byte = quint8((byte & 0xcc) >> 2 | (byte & 0x33) << 2);
+    return quint8((byte & 0xaa) >> 1 | (byte & 0x55) << 1);
+}
+
+/**
+ * @brief Converts the rows of a raster chunk to wall bits, handed out by QtConcurrent
+ */
+struct RasterRowConverter
+{
+    RasterRowConverter(const RasterFormat *rasterFormat, RasterChunk *rasterChunk) : format(rasterFormat), chunk(rasterChunk) {}
+
+    void operator()(int &row) const
+    {
+        const uchar *in = reinterpret_cast<const uchar*>(chunk->input.constData()) + qint64(row) * format->bytesPerRow;
+        quint64 *out = chunk->packed.data() + qint64(row) * format->wordsPerRow;
+
+        if(format->bitmap){
+            // Set bits are black, eight pixels per byte
+            for(int word = 0; word < format->wordsPerRow; word++){
+                quint64 bits = 0;
+                int firstByte = word * 8;
+                int lastByte = qMin(firstByte + 8, format->bytesPerRow);
+                for(int byte = firstByte; byte < lastByte; byte++){
+                    bits |= quint64(reverseBits(in[byte])) << ((byte - firstByte) * 8);
+                }
+                out[word] = bits;
+            }
+            return;
+        }
+
+        const char *wallOfByte = format->wallOfByte.constData();
+        for(int word = 0; word < format->wordsPerRow; word++){
+            quint64 bits = 0;
+            int firstColumn = word * 64;
+            int lastColumn = qMin(firstColumn + 64, format->width);
+            for(int column = firstColumn; column < lastColumn; column++){
+                bool wall;
+                if(format->bytesPerSample == 1){
+                    wall = wallOfByte[in[column]] != 0;
+                }
+                else{
+                    int value = (in[column * 2] << 8) | in[column * 2 + 1];
+                    wall = qint64(value) * 255 < format->thresholdTimesMaximum;
+                }
+                bits |= quint64(wall) << (column - firstColumn);
+            }
+            out[word] = bits;
+        }
+    }
+
+    const RasterFormat *format;
+    RasterChunk *chunk;
+};
+
+/**
+ * @brief Checks for the whitespace of a Netpbm header
+ */
+static inline bool isHeaderSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+/**
+ * @brief Reads the next character of a Netpbm file that isn't whitespace or part of a comment
+ * @return False at the end of the file
+ */
+static bool skipSpaceAndComments(QFile &file, char &c)
+{
+    do{
+        if(!file.getChar(&c)){
+            return false;
+        }
+        if(c == '#'){
+            while(c != '\n' && c != '\r'){
+                if(!file.getChar(&c)){
+                    return false;
+                }
+            }
+        }
+    } while(isHeaderSpace(c));
+    return true;
+}
+
+/**
+ * @brief Reads a decimal number of a Netpbm header or plain raster. The whitespace character
+ * after it is consumed, which for the last header value is the one before a binary raster.
+ * @return False if there's no number
+ */
+static bool readNumber(QFile &file, int &value)
+{
+    char c;
+    if(!skipSpaceAndComments(file, c) || c < '0' || c > '9'){
+        return false;
+    }
+    qint64 number = 0;
+    while(c >= '0' && c <= '9'){
+        number = number * 10 + (c - '0');
+        if(number > 0x7fffffff){
+            return false;
+        }
+        if(!file.getChar(&c)){
+            break; // A number may end the file
+        }
+    }
+    value = int(number);
+    return true;
+}
+
+/**
+ * @brief Checks that a maze of the given size fits the int storage indexes of a MazeGrid
+ */
+static bool checkSize(int width, int height, QString &error)
+{
+    if(width <= 0 || height <= 0 || (qint64(width) + 2) * (qint64(height) + 2) > 0x7fffffff){
+        error = "The image size " + QString::number(width) + "x" + QString::number(height) + " isn't supported";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Streams a binary PBM or PGM raster into the grid. Reading the next chunk overlaps
+ * with converting the previous one on the thread pool.
+ */
+static bool loadBinaryRaster(QFile &file, RasterFormat &format, int height, int chunkBytes, MazeGrid &grid, QString &error)
+{
+    int chunkRows = qMax(1, chunkBytes / format.bytesPerRow);
+    RasterChunk chunks[2];
+    QFuture<void> converting;
+    int pending = -1;
+    int next = 0;
+
+    for(int firstRow = 0; firstRow < height; firstRow += chunkRows){
+        RasterChunk &chunk = chunks[next];
+        int rowCount = qMin(chunkRows, height - firstRow);
+        qint64 size = qint64(rowCount) * format.bytesPerRow;
+        chunk.input.resize(int(size));
+        bool complete = file.read(chunk.input.data(), size) == size;
+
+        // The chunk before has been converting meanwhile, its words go into the grid now
+        if(pending >= 0){
+            converting.waitForFinished();
+            const RasterChunk &done = chunks[pending];
+            for(int row = 0; row < done.rows.size(); row++){
+                grid.setWallRow(done.firstRow + row, done.packed.constData() + qint64(row) * format.wordsPerRow);
+            }
+            pending = -1;
+        }
+        if(!complete){
+            error = "The image ends early";
+            return false;
+        }
+
+        chunk.firstRow = firstRow;
+        chunk.packed.resize(rowCount * format.wordsPerRow);
+        chunk.rows.resize(rowCount);
+        for(int row = 0; row < rowCount; row++){
+            chunk.rows[row] = row;
+        }
+        converting = QtConcurrent::map(chunk.rows, RasterRowConverter(&format, &chunk));
+        pending = next;
+        next ^= 1;
+    }
+
+    if(pending >= 0){
+        converting.waitForFinished();
+        const RasterChunk &done = chunks[pending];
+        for(int row = 0; row < done.rows.size(); row++){
+            grid.setWallRow(done.firstRow + row, done.packed.constData() + qint64(row) * format.wordsPerRow);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a plain PBM (P1) or PGM (P2) raster as it's read
+ */
+static bool loadPlainRaster(QFile &file, bool bitmap, int width, int height, int maximum, int threshold, MazeGrid &grid, QString &error)
+{
+    QVector<quint64> row((width + 63) / 64);
+    for(int y = 0; y < height; y++){
+        row.fill(0);
+        for(int x = 0; x < width; x++){
+            bool wall;
+            if(bitmap){
+                // Plain PBM pixels don't need whitespace between them
+                char c;
+                if(!skipSpaceAndComments(file, c) || (c != '0' && c != '1')){
+                    error = "The image ends early";
+                    return false;
+                }
+                wall = c == '1';
+            }
+            else{
+                int value;
+                if(!readNumber(file, value)){
+                    error = "The image ends early";
+                    return false;
+                }
+                wall = qint64(value) * 255 < qint64(threshold) * maximum;
+            }
+            row[x >> 6] |= quint64(wall) << (x & 63);
+        }
+        grid.setWallRow(y, row.constData());
+    }
+    return true;
+}
+
+/**
+ * @brief Converts the rows of a decoded image to wall bits and finds the markers, handed
+ * out by QtConcurrent
+ */
+struct ImageRowConverter
+{
+    ImageRowConverter(const QImage *decoded, int grey, int words, QVector<quint64> *wallBits, QVector<int> *entrances, QVector<int> *exits) :
+        image(decoded), threshold(grey), wordsPerRow(words), packed(wallBits), entranceColumns(entrances), exitColumns(exits) {}
+
+    void operator()(int &row) const
+    {
+        const QRgb *pixels = reinterpret_cast<const QRgb*>(image->constScanLine(row));
+        quint64 *out = packed->data() + qint64(row) * wordsPerRow;
+        int width = image->width();
+        int entrance = -1;
+        int exit = -1;
+
+        for(int word = 0; word < wordsPerRow; word++){
+            quint64 bits = 0;
+            int firstColumn = word * 64;
+            int lastColumn = qMin(firstColumn + 64, width);
+            for(int column = firstColumn; column < lastColumn; column++){
+                QRgb pixel = pixels[column];
+                int red = qRed(pixel);
+                int green = qGreen(pixel);
+                int blue = qBlue(pixel);
+                if(red >= 192 && green >= 192 && blue < 64){
+                    entrance = entrance < 0 ? column : entrance; // Yellow
+                    continue;
+                }
+                if(red < 64 && green < 64 && blue >= 192){
+                    exit = exit < 0 ? column : exit; // Blue
+                    continue;
+                }
+                bool wall = qAlpha(pixel) >= 128 && qGray(pixel) < threshold;
+                bits |= quint64(wall) << (column - firstColumn);
+            }
+            out[word] = bits;
+        }
+        (*entranceColumns)[row] = entrance;
+        (*exitColumns)[row] = exit;
+    }
+
+    const QImage *image;
+    int threshold;
+    int wordsPerRow;
+    QVector<quint64> *packed;
+    QVector<int> *entranceColumns;
+    QVector<int> *exitColumns;
+};
+
+/**
+ * @brief Decodes an image with QImage and converts its rows in parallel
+ */
+static bool loadDecodedImage(const QString &fileName, int threshold, MazeGrid &grid, MazeImage::Markers &markers, QString &error)
+{
+    QImage image(fileName);
+    if(image.isNull()){
+        error = "Could not decode " + fileName;
+        return false;
+    }
+    if(!checkSize(image.width(), image.height(), error)){
+        return false;
+    }
+    if(image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32){
+        image = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    int width = image.width();
+    int height = image.height();
+    int wordsPerRow = (width + 63) / 64;
+    QVector<quint64> packed(height * wordsPerRow);
+    QVector<int> entranceColumns(height);
+    QVector<int> exitColumns(height);
+    QVector<int> rows(height);
+    for(int row = 0; row < height; row++){
+        rows[row] = row;
+    }
+    QtConcurrent::blockingMap(rows, ImageRowConverter(&image, threshold, wordsPerRow, &packed, &entranceColumns, &exitColumns));
+
+    grid.resize(height, width);
+    for(int row = 0; row < height; row++){
+        grid.setWallRow(row, packed.constData() + qint64(row) * wordsPerRow);
+        if(markers.entrance < 0 && entranceColumns.at(row) >= 0){
+            markers.entrance = row * width + entranceColumns.at(row);
+        }
+        if(markers.exit < 0 && exitColumns.at(row) >= 0){
+            markers.exit = row * width + exitColumns.at(row);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the walls of a maze from an image. Pixels darker than the threshold are walls.
+ * @param fileName The image, a PBM, PGM or anything QImage reads
+ * @param threshold Grey level from 0 to 255, darker pixels are walls. PBM files don't use it.
+ * @param grid Receives the maze, resized to the image
+ * @param markers Receives the entrance and exit marked in a colour image
+ * @param error Receives the reason if the import fails
+ * @return True on success
+ */
+bool MazeImage::load(const QString &fileName, int threshold, MazeGrid &grid, Markers &markers, QString &error)
+{
+    markers = Markers();
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        error = "Could not open " + fileName;
+        return false;
+    }
+
+    // Netpbm files are told apart by their magic number, everything else goes to QImage
+    char magic[2];
+    if(file.read(magic, 2) != 2 || magic[0] != 'P' || magic[1] < '1' || magic[1] > '5' || magic[1] == '3'){
+        file.close();
+        return loadDecodedImage(fileName, threshold, grid, markers, error);
+    }
+
+    bool bitmap = magic[1] == '1' || magic[1] == '4';
+    int width;
+    int height;
+    int maximum = 1;
+    if(!readNumber(file, width) || !readNumber(file, height) || (!bitmap && !readNumber(file, maximum))
+            || maximum <= 0 || maximum > 65535){
+        error = "The header of " + fileName + " is broken";
+        return false;
+    }
+    if(!checkSize(width, height, error)){
+        return false;
+    }
+
+    grid.resize(height, width);
+    if(magic[1] == '1' || magic[1] == '2'){
+        return loadPlainRaster(file, bitmap, width, height, maximum, threshold, grid, error);
+    }
+
+    RasterFormat format;
+    format.bitmap = bitmap;
+    format.width = width;
+    format.wordsPerRow = (width + 63) / 64;
+    format.bytesPerSample = maximum < 256 ? 1 : 2;
+    format.bytesPerRow = bitmap ? (width + 7) / 8 : width * format.bytesPerSample;
+    format.thresholdTimesMaximum = qint64(threshold) * maximum;
+    format.wallOfByte = QByteArray(256, 0);
+    for(int value = 0; value < 256; value++){
+        format.wallOfByte[value] = char(qint64(value) * 255 < format.thresholdTimesMaximum);
+    }
+    return loadBinaryRaster(file, format, height, chunkBytes, grid, error);
+}
+
+/**
+ * @brief Imports an image from the command line, optionally saving it as a maze file
+ * @param fileName The image
+ * @param threshold Grey level from 0 to 255, darker pixels are walls
+ * @param mazeFileName Where to save the maze, nothing is saved if empty
+ * @param out Where the report goes
+ * @return 0 on success, 1 otherwise
+ */
+int MazeImage::convert(const QString &fileName, int threshold, const QString &mazeFileName, QTextStream &out)
+{
+    MazeGrid grid;
+    Markers markers;
+    QString error;
+    QElapsedTimer clock;
+    clock.start();
+    if(!load(fileName, threshold, grid, markers, error)){
+        out << error << "\n";
+        return 1;
+    }
+    double seconds = qMax(clock.nsecsElapsed() / 1e9, 1e-9);
+    qint64 fileSize = QFile(fileName).size();
+
+    out << "Imported " << grid.getColumns() << "x" << grid.getRows() << " pixels in "
+        << QString::number(seconds * 1000, 'f', 1) << " ms: "
+        << QString::number(grid.getCellCount() / seconds / 1e6, 'f', 1) << " Mpixel/s, "
+        << QString::number(fileSize / seconds / 1048576, 'f', 1) << " MiB/s\n";
+    QBitArray walls = grid.getWalls();
+    out << walls.count(true) << " walls";
+    if(markers.entrance >= 0){
+        out << ", entrance at " << markers.entrance;
+    }
+    if(markers.exit >= 0){
+        out << ", exit at " << markers.exit;
+    }
+    out << "\n";
+
+    if(!mazeFileName.isEmpty()){
+        SearchTrace noTrace;
+        if(!MazeFile::save(mazeFileName, grid.getRows(), grid.getColumns(), walls, noTrace)){
+            out << "Could not save the maze to " << mazeFileName << "\n";
+            return 1;
+        }
+        out << "Saved the maze to " << mazeFileName << "\n";
+    }
+    return 0;
+}
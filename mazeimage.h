@@ -0,0 +1,40 @@
+#ifndef MAZEIMAGE_H
+#define MAZEIMAGE_H
+
+#include <QString>
+#include <QTextStream>
+
+#include "mazegrid.h"
+
+/**
+ * @brief Imports mazes from images: dark pixels become walls, light pixels open cells.
+ *
+ * Binary PBM (P4) and PGM (P5) files are streamed in chunks of rows. While one chunk is read
+ * from disk, the rows of the previous one are converted in parallel into packed wall words,
+ * which are then copied into the wall plane of the grid a word at a time, so the import keeps
+ * up with the disk. The plain text variants (P1, P2) are parsed as they are read. Everything
+ * else, PNG in particular, is decoded by QImage first and converted row by row in parallel.
+ *
+ * Colour images can mark the entrance with a yellow and the exit with a blue pixel, the colours
+ * the maze view paints them in. The first marker of each colour in row-major order counts and
+ * its cell is open.
+ */
+class MazeImage
+{
+public:
+    /// Marker positions as node ids, -1 if the image has no such marker
+    struct Markers
+    {
+        Markers() : entrance(-1), exit(-1) {}
+        int entrance;
+        int exit;
+    };
+
+    static bool load(const QString &fileName, int threshold, MazeGrid &grid, Markers &markers, QString &error); ///< Reads the walls and markers of an image
+    static int convert(const QString &fileName, int threshold, const QString &mazeFileName, QTextStream &out); ///< Imports an image and reports the throughput, returns a process exit code
+
+private:
+    static const int chunkBytes = 4 << 20; ///< Raster bytes read at once while streaming
+};
+
+#endif // MAZEIMAGE_H
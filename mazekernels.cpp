@@ -0,0 +1,48 @@
+#include "mazekernels.h"
+#include "timelinetrace.h"
+
+namespace MazeKernels {
+
+/**
+ * @brief The dispatch table holding one instantiation per algorithm, neighbourhood and storage
+ */
+static const KernelFunction kernelTable[AlgorithmCount][ConnectivityCount][StorageCount] = {
+    {
+        { &breadthFirst<FourNeighbourhood, BitplaneGrid>, &breadthFirst<FourNeighbourhood, ByteGrid>, &breadthFirst<FourNeighbourhood, PaddedGrid> },
+        { &breadthFirst<EightNeighbourhood, BitplaneGrid>, &breadthFirst<EightNeighbourhood, ByteGrid>, &breadthFirst<EightNeighbourhood, PaddedGrid> },
+        { &breadthFirst<HexNeighbourhood, BitplaneGrid>, &breadthFirst<HexNeighbourhood, ByteGrid>, &breadthFirst<HexNeighbourhood, PaddedGrid> }
+    },
+    {
+        { &depthFirst<FourNeighbourhood, BitplaneGrid>, &depthFirst<FourNeighbourhood, ByteGrid>, &depthFirst<FourNeighbourhood, PaddedGrid> },
+        { &depthFirst<EightNeighbourhood, BitplaneGrid>, &depthFirst<EightNeighbourhood, ByteGrid>, &depthFirst<EightNeighbourhood, PaddedGrid> },
+        { &depthFirst<HexNeighbourhood, BitplaneGrid>, &depthFirst<HexNeighbourhood, ByteGrid>, &depthFirst<HexNeighbourhood, PaddedGrid> }
+    }
+};
+
+/**
+ * @brief Looks up the kernel instantiation for the given combination
+ * @param algorithm The search algorithm
+ * @param connectivity The neighbourhood policy
+ * @param storage The cell storage policy
+ * @return The kernel function
+ */
+KernelFunction kernelFor(Algorithm algorithm, Connectivity connectivity, Storage storage)
+{
+    return kernelTable[algorithm][connectivity][storage];
+}
+
+/**
+ * @brief Runs the kernel for the given combination on a maze snapshot
+ * @param input The maze snapshot
+ * @param algorithm The search algorithm
+ * @param connectivity The neighbourhood policy
+ * @param storage The cell storage policy
+ * @return The result of the search
+ */
+KernelResult run(const KernelInput &input, Algorithm algorithm, Connectivity connectivity, Storage storage)
+{
+    TIMELINE_SCOPE("MazeKernels::run", "solver");
+    return kernelFor(algorithm, connectivity, storage)(input);
+}
+
+} // namespace MazeKernels
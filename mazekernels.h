@@ -0,0 +1,381 @@
+#ifndef MAZEKERNELS_H
+#define MAZEKERNELS_H
+
+#include <QVector>
+#include <QBitArray>
+
+#include "searchcontrol.h"
+
+/**
+ * @brief Compile-time specialized search kernels. Every kernel is a template over a
+ * neighbourhood policy and a cell storage policy, so the neighbour loop of each
+ * combination is inlined and unrolled. A small dispatch table picks the instantiation at runtime.
+ */
+namespace MazeKernels {
+
+/// The search algorithms a kernel can run
+enum Algorithm {
+    BreadthFirst = 0,
+    DepthFirst,
+    AlgorithmCount
+};
+
+/// The neighbourhood policies a kernel can be specialized for
+enum Connectivity {
+    FourConnected = 0,
+    EightConnected,
+    HexConnected,
+    ConnectivityCount
+};
+
+/// The cell storage policies a kernel can be specialized for
+enum Storage {
+    BitplaneStorage = 0,
+    ByteGridStorage,
+    PaddedGridStorage,
+    StorageCount
+};
+
+/**
+ * @brief A plain snapshot of the maze which the kernels search through. Node ids are row-major.
+ */
+struct KernelInput
+{
+    KernelInput() : rows(0), columns(0), entrance(0), exit(0), control(0) {}
+    int rows;
+    int columns;
+    int entrance; ///< Node id of the entrance
+    int exit; ///< Node id of the exit
+    QBitArray walls; ///< One bit per node id, set if the node is a wall
+    SearchControl *control; ///< Optional, polled for cancellation and fed with progress
+};
+
+/**
+ * @brief The outcome of a kernel run
+ */
+struct KernelResult
+{
+    KernelResult() : found(false), cancelled(false), expanded(0) {}
+    bool found; ///< True if the exit has been reached
+    bool cancelled; ///< True if the search stopped on a cancel request
+    int expanded; ///< Number of nodes taken off the frontier
+    QVector<int> path; ///< Node ids from the entrance to the exit, empty if not found
+};
+
+/// Signature shared by all kernel instantiations
+typedef KernelResult (*KernelFunction)(const KernelInput &input);
+
+KernelFunction kernelFor(Algorithm algorithm, Connectivity connectivity, Storage storage); ///< Looks up the instantiation in the dispatch table
+KernelResult run(const KernelInput &input, Algorithm algorithm, Connectivity connectivity, Storage storage); ///< Runs the matching kernel
+
+/**
+ * @brief Calls f(0) ... f(N-1) with compile-time constant arguments, so the neighbour loop is unrolled
+ */
+template<int N>
+struct Unroll
+{
+    template<typename F>
+    static inline void apply(F &f)
+    {
+        Unroll<N-1>::apply(f);
+        f(N-1);
+    }
+};
+
+template<>
+struct Unroll<0>
+{
+    template<typename F>
+    static inline void apply(F &) {}
+};
+
+// ---------------------------------------------------------------------------
+// Neighbourhood policies. The offsets are given as rows and columns and may depend
+// on the parity of the row (hex grids use odd rows shifted to the right).
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief South, north, east and west, in the same order as MSolver
+ */
+struct FourNeighbourhood
+{
+    enum { Count = 4, ParityDependent = 0 };
+    static inline int rowOffset(int dir, int) { static const int dr[4] = { 1, -1, 0, 0 }; return dr[dir]; }
+    static inline int columnOffset(int dir, int) { static const int dc[4] = { 0, 0, 1, -1 }; return dc[dir]; }
+};
+
+/**
+ * @brief The four direct neighbours plus the four diagonals
+ */
+struct EightNeighbourhood
+{
+    enum { Count = 8, ParityDependent = 0 };
+    static inline int rowOffset(int dir, int) { static const int dr[8] = { 1, -1, 0, 0, 1, 1, -1, -1 }; return dr[dir]; }
+    static inline int columnOffset(int dir, int) { static const int dc[8] = { 0, 0, 1, -1, 1, -1, 1, -1 }; return dc[dir]; }
+};
+
+/**
+ * @brief Six neighbours of a hex grid in "odd-r" layout, where every odd row is shifted half a cell to the right
+ */
+struct HexNeighbourhood
+{
+    enum { Count = 6, ParityDependent = 1 };
+    static inline int rowOffset(int dir, int) { static const int dr[6] = { 0, 0, -1, -1, 1, 1 }; return dr[dir]; }
+    static inline int columnOffset(int dir, int parity)
+    {
+        static const int dc[2][6] = { { 1, -1, -1, 0, -1, 0 },
+                                      { 1, -1, 0, 1, 0, 1 } };
+        return dc[parity][dir];
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Storage policies. All of them are row-major with a fixed stride, so a neighbour
+// is always at index + rowOffset * stride + columnOffset.
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief One bit per cell, packed into 32 bit words
+ */
+class BitplaneGrid
+{
+public:
+    enum { Padded = 0 };
+    explicit BitplaneGrid(const KernelInput &input) : columns(input.columns), cells(input.rows * input.columns)
+    {
+        words.fill(0, (cells + 31) / 32);
+        for(int ii = 0; ii < cells; ii++){
+            if(input.walls.testBit(ii)){
+                words[ii >> 5] |= (1u << (ii & 31));
+            }
+        }
+    }
+    inline int stride() const { return columns; }
+    inline int size() const { return cells; }
+    inline int indexOf(int nodeId) const { return nodeId; }
+    inline int nodeIdOf(int index) const { return index; }
+    inline int parityOf(int index) const { return (index / columns) & 1; }
+    inline bool isOpen(int index) const { return !((words.at(index >> 5) >> (index & 31)) & 1u); }
+private:
+    int columns;
+    int cells;
+    QVector<quint32> words;
+};
+
+/**
+ * @brief One byte per cell, non-zero for walls
+ */
+class ByteGrid
+{
+public:
+    enum { Padded = 0 };
+    explicit ByteGrid(const KernelInput &input) : columns(input.columns), cells(input.rows * input.columns)
+    {
+        bytes.resize(cells);
+        for(int ii = 0; ii < cells; ii++){
+            bytes[ii] = input.walls.testBit(ii) ? 1 : 0;
+        }
+    }
+    inline int stride() const { return columns; }
+    inline int size() const { return cells; }
+    inline int indexOf(int nodeId) const { return nodeId; }
+    inline int nodeIdOf(int index) const { return index; }
+    inline int parityOf(int index) const { return (index / columns) & 1; }
+    inline bool isOpen(int index) const { return bytes.at(index) == 0; }
+private:
+    int columns;
+    int cells;
+    QVector<quint8> bytes;
+};
+
+/**
+ * @brief One byte per cell with a one cell border of walls around the maze.
+ * The sentinels make every neighbour index valid, so no bounds checks are needed.
+ */
+class PaddedGrid
+{
+public:
+    enum { Padded = 1 };
+    explicit PaddedGrid(const KernelInput &input) : columns(input.columns), paddedColumns(input.columns + 2)
+    {
+        int paddedRows = input.rows + 2;
+        bytes.fill(1, paddedRows * paddedColumns);
+        for(int row = 0; row < input.rows; row++){
+            for(int col = 0; col < input.columns; col++){
+                bytes[(row + 1) * paddedColumns + col + 1] = input.walls.testBit(row * columns + col) ? 1 : 0;
+            }
+        }
+    }
+    inline int stride() const { return paddedColumns; }
+    inline int size() const { return bytes.size(); }
+    inline int indexOf(int nodeId) const { return (nodeId / columns + 1) * paddedColumns + nodeId % columns + 1; }
+    inline int nodeIdOf(int index) const { return (index / paddedColumns - 1) * columns + index % paddedColumns - 1; }
+    inline bool isOpen(int index) const { return bytes.at(index) == 0; }
+    /// Row parity of an index, the border row is row -1 so the parity flips
+    inline int parityOf(int index) const { return ((index / paddedColumns) + 1) & 1; }
+private:
+    int columns;
+    int paddedColumns;
+    QVector<quint8> bytes;
+};
+
+/**
+ * @brief Pushes all open, unseen neighbours of one cell. Instantiated per neighbourhood and storage,
+ * the bounds checks disappear for padded storage and the row computation for non-hex neighbourhoods.
+ */
+template<class Neighbourhood, class Grid, class Frontier>
+struct Expander
+{
+    Expander(const Grid &grid, int rows, QVector<int> &parent, Frontier &frontier, int goal)
+        : grid(grid), rows(rows), parent(parent), frontier(frontier), goal(goal),
+          current(0), row(0), column(0), parity(0), goalReached(false) {}
+
+    const Grid &grid;
+    int rows;
+    QVector<int> &parent;
+    Frontier &frontier;
+    int goal;
+    int current;
+    int row;
+    int column;
+    int parity;
+    bool goalReached;
+
+    /// Sets the cell whose neighbours are expanded next
+    inline void setCurrent(int index)
+    {
+        current = index;
+        if(!Grid::Padded){
+            row = index / grid.stride();
+            column = index - row * grid.stride();
+            parity = row & 1;
+        }
+        else if(Neighbourhood::ParityDependent){
+            parity = grid.parityOf(index);
+        }
+    }
+
+    inline void operator()(int dir)
+    {
+        if(goalReached){
+            return;
+        }
+        int dr = Neighbourhood::rowOffset(dir, parity);
+        int dc = Neighbourhood::columnOffset(dir, parity);
+        if(!Grid::Padded){
+            int nextRow = row + dr;
+            int nextColumn = column + dc;
+            if(nextRow < 0 || nextRow >= rows || nextColumn < 0 || nextColumn >= grid.stride()){
+                return;
+            }
+        }
+        int next = current + dr * grid.stride() + dc;
+        if(!grid.isOpen(next) || parent.at(next) != -1){
+            return;
+        }
+        parent[next] = current;
+        frontier.append(next);
+        if(next == goal){
+            goalReached = true;
+        }
+    }
+};
+
+/**
+ * @brief Walks the parent links back from the goal and returns node ids from start to goal
+ */
+template<class Grid>
+QVector<int> reconstructPath(const Grid &grid, const QVector<int> &parent, int start, int goal)
+{
+    QVector<int> reversed;
+    int index = goal;
+    while(index != start){
+        reversed.append(grid.nodeIdOf(index));
+        index = parent.at(index);
+    }
+    reversed.append(grid.nodeIdOf(start));
+
+    QVector<int> path(reversed.size());
+    for(int ii = 0; ii < reversed.size(); ii++){
+        path[ii] = reversed.at(reversed.size() - 1 - ii);
+    }
+    return path;
+}
+
+/**
+ * @brief Breadth first search, returns a shortest path in number of steps
+ */
+template<class Neighbourhood, class Grid>
+KernelResult breadthFirst(const KernelInput &input)
+{
+    KernelResult result;
+    Grid grid(input);
+    int start = grid.indexOf(input.entrance);
+    int goal = grid.indexOf(input.exit);
+
+    QVector<int> parent(grid.size(), -1);
+    QVector<int> queue;
+    queue.reserve(grid.size() / 4 + 1);
+    Expander<Neighbourhood, Grid, QVector<int> > expand(grid, input.rows, parent, queue, goal);
+
+    parent[start] = start;
+    queue.append(start);
+    int head = 0;
+    while(head < queue.size() && !expand.goalReached && start != goal){
+        if(input.control && (result.expanded & (SearchControl::PollInterval - 1)) == 0
+                && input.control->poll(result.expanded, queue.size() - head)){
+            result.cancelled = true;
+            return result;
+        }
+        expand.setCurrent(queue.at(head++));
+        result.expanded++;
+        Unroll<Neighbourhood::Count>::apply(expand);
+    }
+
+    if(expand.goalReached || start == goal){
+        result.found = true;
+        result.path = reconstructPath(grid, parent, start, goal);
+    }
+    return result;
+}
+
+/**
+ * @brief Depth first search with a fixed neighbour order, returns any path
+ */
+template<class Neighbourhood, class Grid>
+KernelResult depthFirst(const KernelInput &input)
+{
+    KernelResult result;
+    Grid grid(input);
+    int start = grid.indexOf(input.entrance);
+    int goal = grid.indexOf(input.exit);
+
+    QVector<int> parent(grid.size(), -1);
+    QVector<int> stack;
+    Expander<Neighbourhood, Grid, QVector<int> > expand(grid, input.rows, parent, stack, goal);
+
+    parent[start] = start;
+    stack.append(start);
+    while(!stack.isEmpty() && !expand.goalReached && start != goal){
+        if(input.control && (result.expanded & (SearchControl::PollInterval - 1)) == 0
+                && input.control->poll(result.expanded, stack.size())){
+            result.cancelled = true;
+            return result;
+        }
+        int current = stack.last();
+        stack.removeLast();
+        expand.setCurrent(current);
+        result.expanded++;
+        Unroll<Neighbourhood::Count>::apply(expand);
+    }
+
+    if(expand.goalReached || start == goal){
+        result.found = true;
+        result.path = reconstructPath(grid, parent, start, goal);
+    }
+    return result;
+}
+
+} // namespace MazeKernels
+
+#endif // MAZEKERNELS_H
@@ -1,36 +1,66 @@
 #include "mazenode.h"
+#include "timelinetrace.h"
+
+/**
+ * @brief Creates the drawn rectangle of a node
+ * @param owner The node the rectangle belongs to
+ * @param x the x value of the rectangle
+ * @param y the y value of the rectangle
+ * @param rectSize the size of the rectangle
+ */
+MazeNodeItem::MazeNodeItem(MazeNode *owner, int x, int y, int rectSize) : QGraphicsRectItem(x,y,rectSize,rectSize)
+{
+    node = owner;
+}
+/**
+ * @brief Paints the rectangle in the current color of the node
+ * @param painter The painter of the scene
+ * @param option Unused, the item has no selected or focused look
+ * @param widget Unused
+ */
+void MazeNodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    TIMELINE_SCOPE("MazeNodeItem::paint", "paint");
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    painter->setPen(pen());
+    painter->setBrush(QBrush(node->getColor()));
+    painter->drawRect(rect());
+}
+
 /**
  * @brief Creates a Mazenode.
  * @param newId the ID of the new node
  * @param x the x value of the new node
  * @param y the y value of the new node
  * @param rectSize the size of the rectangle
+ * @param mazeGeneration the generation counters shared by all nodes of the maze
+ * @param mazeOpenDirections the open directions of all nodes of the maze, patched when the wall changes
  */
-MazeNode::MazeNode(int newId, int x, int y, int rectSize)
+MazeNode::MazeNode(int newId, int x, int y, int rectSize, const MazeGeneration *mazeGeneration, OpenDirectionTable *mazeOpenDirections) :
+    rectangle(this,x,y,rectSize),
+    position(x,y)
 {
-    // Create the rectangle item
-    createRectangle(x,y,rectSize);
-
-    // Set some default values
-    nodeIsWall = false;
-    visited = false;
+    // Set some default values, stamps of 0 are never current
+    generation = mazeGeneration;
+    openDirections = mazeOpenDirections;
+    wallStamp = 0;
+    visitedStamp = 0;
+    previousStamp = 0;
+    paintStamp = 0;
+    paintState = Plain;
     nodeIsEntrance= false;
     nodeIsExit = false;
-    position = new QPointF(x,y);
     id = newId;
+    this->rectSize = rectSize;
     previousNode = 0;
-
-    // Sets description of the rectangle
-    description = new QGraphicsTextItem("",rectangle);
-    description->setPos(position->x(),position->y());
-
+    description = 0;
 }
 /**
  * @brief Destructor
  */
 MazeNode::~MazeNode()
 {
-    delete position;
 }
 /**
  * @brief Returns the visible rectangle of the node
@@ -38,7 +68,7 @@ MazeNode::~MazeNode()
  */
 QGraphicsRectItem *MazeNode::getRectangle()
 {
-    return rectangle;
+    return &rectangle;
 }
 /**
  * @brief Gets the position of the drawn rectangle
@@ -46,7 +76,7 @@ QGraphicsRectItem *MazeNode::getRectangle()
  */
 QPointF *MazeNode::getPosition()
 {
-    return position;
+    return &position;
 }
 /**
  * @brief Returns the ID of the node
@@ -61,15 +91,49 @@ int MazeNode::getId(){
  */
 MazeNode *MazeNode::getPreviousNode()
 {
+    if(previousStamp != generation->search){
+        return 0;
+    }
     return previousNode;
 }
+/**
+ * @brief Works out the color of the node from its state. Search state painted in the current
+ * generation wins over the base color of walls, the entrance and the exit.
+ * @return QColor The color to paint the node in
+ */
+QColor MazeNode::getColor()
+{
+    if(paintStamp == generation->search){
+        switch(paintState){
+        case Active:
+            return Qt::yellow;
+        case Visited:
+            return Qt::red;
+        case Path:
+            return Qt::green;
+        default:
+            break;
+        }
+    }
+
+    if(isWall()){
+        return Qt::black;
+    }
+    else if(nodeIsEntrance){
+        return Qt::yellow;
+    }
+    else if(nodeIsExit){
+        return Qt::blue;
+    }
+    return Qt::white;
+}
 /**
  * @brief Checks if the node is a wall
  * @return bool True/False
  */
 bool MazeNode::isWall()
 {
-    return nodeIsWall;
+    return wallStamp == generation->walls;
 }
 
 /**
@@ -94,7 +158,7 @@ bool MazeNode::isExit()
  */
 bool MazeNode::hasBeenVisited()
 {
-    return visited;
+    return visitedStamp == generation->search;
 }
 /**
  * @brief Sets the node to active, meaning it changes color to yellow
@@ -103,10 +167,10 @@ bool MazeNode::hasBeenVisited()
 void MazeNode::setActive(bool active)
 {
     if(active){
-        rectangle->setBrush(QBrush(Qt::yellow));
+        setPaintState(Active);
     }
     else{
-        rectangle->setBrush(QBrush(Qt::white));
+        setPaintState(Plain);
     }
 }
 /**
@@ -114,6 +178,10 @@ void MazeNode::setActive(bool active)
  */
 void MazeNode::setDescripionToId()
 {
+    if(description == 0){
+        description = new QGraphicsTextItem("",&rectangle);
+        description->setPos(position.x(),position.y());
+    }
     description->setPlainText(QString::number(id));
 }
 /**
@@ -122,9 +190,7 @@ void MazeNode::setDescripionToId()
 void MazeNode::setEntrance(bool isEntrance)
 {
     nodeIsEntrance = isEntrance;
-    if(isEntrance){
-        rectangle->setBrush(QBrush(Qt::yellow));
-    }
+    rectangle.update();
 }
 
 /**
@@ -135,11 +201,7 @@ void MazeNode::setEntrance(bool isEntrance)
 void MazeNode::setExit(bool isExit)
 {
     nodeIsExit = isExit;
-
-    if(isExit){
-        rectangle->setBrush(QBrush(Qt::blue));
-    }
-
+    rectangle.update();
 }
 /**
  * @brief Sets the current node as visited to keep track
@@ -148,13 +210,13 @@ void MazeNode::setExit(bool isExit)
 
 void MazeNode::setVisited(bool value)
 {
-    visited = value;
-
     if(value){
-        rectangle->setBrush(QBrush(Qt::red));
+        visitedStamp = generation->search;
+        setPaintState(Visited);
     }
     else{
-        rectangle->setBrush(QBrush(Qt::white));
+        visitedStamp = 0;
+        setPaintState(Plain);
     }
 }
 /**
@@ -166,8 +228,9 @@ void MazeNode::setWall()
         return;
     }
 
-    nodeIsWall = true;
-    rectangle->setBrush(QBrush(Qt::black));
+    wallStamp = generation->walls;
+    openDirections->setWall(id, true);
+    rectangle.update();
 }
 
 /**
@@ -177,6 +240,7 @@ void MazeNode::setWall()
 void MazeNode::setPreviousNode(MazeNode *node)
 {
     previousNode = node;
+    previousStamp = generation->search;
 }
 
 /**
@@ -184,27 +248,71 @@ void MazeNode::setPreviousNode(MazeNode *node)
  */
 void MazeNode::tracePath()
 {
-    rectangle->setBrush(QBrush(Qt::green));
-
+    setPaintState(Path);
 }
+/**
+ * @brief Paints the node for a replayed search frame. Only the color changes, the node itself
+ * keeps its state.
+ * @param state 0 for untouched, 1 for active, 2 for visited and 3 for path (see SearchTrace::Event)
+ */
+void MazeNode::showTraceState(int state)
+{
+    setPaintState(PaintState(state & 3));
+}
+
 /**
  * @brief Sets the node to be a walkable node and paints it white
  */
 void MazeNode::unsetWall()
 {
-    nodeIsWall = false;
-    rectangle->setBrush(QBrush(Qt::white));
+    wallStamp = 0;
+    openDirections->setWall(id, false);
+    rectangle.update();
+}
 
+/**
+ * @brief Forgets visited, previous node and painted state of all generations
+ */
+void MazeNode::clearSearchStamps()
+{
+    visitedStamp = 0;
+    previousStamp = 0;
+    paintStamp = 0;
+}
+
+/**
+ * @brief Sets or clears the wall without scheduling a repaint, for edits that repaint the
+ * whole area they changed at once. The entrance and the exit never become walls. The open
+ * directions aren't patched either, the arena updates them for the whole edit.
+ * @param wall True for a wall
+ * @return True if the node changed
+ */
+bool MazeNode::assignWall(bool wall)
+{
+    if(wall == isWall() || (wall && (nodeIsEntrance || nodeIsExit))){
+        return false;
+    }
+    wallStamp = wall ? generation->walls : 0;
+    return true;
+}
+
+/**
+ * @brief Forgets the wall of all generations
+ */
+void MazeNode::clearWallStamp()
+{
+    wallStamp = 0;
 }
 
 /**
- * @brief Creates the rectangle that's getting drawn for the node
- * @param x the point on the x axis where it should be drawn
- * @param y the point on the y axis where it should be drawn
- * @param rectSize the size of the rectangle side
+ * @brief Stamps the state the node is painted in with the current generation
+ * @param state The state to paint
  */
-void MazeNode::createRectangle(int x, int y, int rectSize)
+void MazeNode::setPaintState(PaintState state)
 {
-    rectangle = new QGraphicsRectItem(x,y,rectSize,rectSize);
+    TIMELINE_SCOPE("MazeNode::setPaintState", "scene");
+    paintState = state;
+    paintStamp = generation->search;
+    rectangle.update();
 }
 
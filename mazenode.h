@@ -5,10 +5,41 @@
 #include <QRect>
 #include <QGraphicsRectItem>
 #include <QGraphicsTextItem>
+#include <QPainter>
 #include <QPen>
 #include <QBrush>
 #include <QDebug>
 
+#include "opendirectiontable.h"
+
+class MazeNode;
+
+/**
+ * @brief The generation counters all nodes of a maze compare their stamps with.
+ * State stamped with an older generation counts as cleared, so bumping a counter resets
+ * that state on every node at once.
+ */
+struct MazeGeneration
+{
+    MazeGeneration() : search(1), walls(1) {}
+    quint32 search; ///< Stamps visited, active, path and the previous node
+    quint32 walls; ///< Stamps the walls
+};
+
+/**
+ * @brief The drawn rectangle of a node. It takes its color from the node when it's painted,
+ * so node state can change without touching the brush.
+ */
+class MazeNodeItem : public QGraphicsRectItem
+{
+public:
+    MazeNodeItem(MazeNode *owner, int x, int y, int rectSize);
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
+private:
+    MazeNode *node;
+};
+
 /**
  * @brief This class holds all data necessary for a mazenode, including position, the graphical item
  * and helper functionality
@@ -17,12 +48,13 @@ class MazeNode
 {
 
 public:
-    explicit MazeNode(int newId, int x, int y, int rectSize);
+    explicit MazeNode(int newId, int x, int y, int rectSize, const MazeGeneration *mazeGeneration, OpenDirectionTable *mazeOpenDirections);
     ~MazeNode();
     QGraphicsRectItem *getRectangle();
     QPointF *getPosition(); ///< Returns the position of the rectangle of the node
     int getId(); ///< Returns the unique ID of the node
     MazeNode *getPreviousNode(); ///< Returns the previously visited node
+    QColor getColor(); ///< Returns the color the node is painted in
     bool isWall();
     bool isEntrance();
     bool isExit();
@@ -35,23 +67,34 @@ public:
     void setWall();
     void setPreviousNode(MazeNode *node);
     void tracePath(); ///< Highlights the node
+    void showTraceState(int state); ///< Paints a replayed state without changing the node
     void unsetWall();
+    bool assignWall(bool wall); ///< Sets or clears the wall without a repaint or a patch of the open directions, true if it changed
+    void clearSearchStamps(); ///< Drops all search state, used when the generation counter wraps
+    void clearWallStamp(); ///< Drops the wall, used when the generation counter wraps
 
 private:
+    /// What the node is painted as on top of its base color, same values as SearchTrace::Event
+    enum PaintState { Plain = 0, Active = 1, Visited = 2, Path = 3 };
+
     int rectSize; // The size of the rectangle in the UI
     int id; // The unique ID of the rectangle
-    QGraphicsRectItem *rectangle; // The rectangle item
-    QPointF *position; // The position of the rectangle
-    QGraphicsTextItem *description;
+    MazeNodeItem rectangle; // The rectangle item
+    QPointF position; // The position of the rectangle
+    QGraphicsTextItem *description; // Created when the description is first shown
     MazeNode *previousNode; // A pointer for the search algorithms to find the previous node
+    const MazeGeneration *generation; // The counters the stamps are compared with
+    OpenDirectionTable *openDirections; // Patched when the wall is set or cleared
 
-    bool nodeIsWall;
     bool nodeIsEntrance;
     bool nodeIsExit;
-    bool visited;
-    void createRectangle(int x,int y,int rectSize); ///< Creates a rectangle item
+    quint32 wallStamp; // The node is a wall if this is the current wall generation
+    quint32 visitedStamp;
+    quint32 previousStamp;
+    quint32 paintStamp;
+    PaintState paintState;
 
-    
+    void setPaintState(PaintState state); ///< Stamps a paint state and schedules a repaint
 };
 
 #endif // MAZENODE_H
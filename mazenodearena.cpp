@@ -0,0 +1,197 @@
+#include "mazenodearena.h"
+
+#include <new>
+
+/**
+ * @brief Creates an empty arena
+ */
+MazeNodeArena::MazeNodeArena()
+{
+    nodes = 0;
+    count = 0;
+    capacity = 0;
+}
+
+/**
+ * @brief Destroys all nodes and frees the memory. Destroying a node takes its rectangle
+ * off the scene.
+ */
+MazeNodeArena::~MazeNodeArena()
+{
+    clear();
+    ::operator delete(nodes);
+}
+
+/**
+ * @brief Destroys all nodes and makes sure there's room for a grid of the given size.
+ * Grids that fit into the current block reuse it, bigger ones get one new block.
+ * The nodes are about to be created in row-major order.
+ * @param rows The number of rows of the grid
+ * @param columns The number of columns of the grid
+ */
+void MazeNodeArena::reserve(int rows, int columns)
+{
+    clear();
+    openDirections.reset(rows, columns);
+    int nodeCount = rows * columns;
+    if(nodeCount <= capacity){
+        return;
+    }
+
+    ::operator delete(nodes);
+    nodes = static_cast<MazeNode*>(::operator new(sizeof(MazeNode) * size_t(nodeCount)));
+    capacity = nodeCount;
+}
+
+/**
+ * @brief Constructs the next node in the arena
+ * @param x the x value of the new node
+ * @param y the y value of the new node
+ * @param rectSize the size of the rectangle
+ * @return The new node, or 0 if the arena is full
+ */
+MazeNode *MazeNodeArena::create(int x, int y, int rectSize)
+{
+    if(count >= capacity){
+        return 0;
+    }
+    MazeNode *node = new (nodes + count) MazeNode(count,x,y,rectSize,&generation,&openDirections);
+    count++;
+    return node;
+}
+
+/**
+ * @brief Destroys all nodes but keeps the memory for the next grid
+ */
+void MazeNodeArena::clear()
+{
+    for(int ii = count - 1; ii >= 0; ii--){
+        nodes[ii].~MazeNode();
+    }
+    count = 0;
+}
+
+/**
+ * @brief Gets a node by its id
+ * @param id The id of the node
+ * @return The node, or 0 if there is none with that id
+ */
+MazeNode *MazeNodeArena::at(int id) const
+{
+    if(id < 0 || id >= count){
+        return 0;
+    }
+    return nodes + id;
+}
+
+/**
+ * @brief Gets the number of nodes
+ * @return The number of nodes
+ */
+int MazeNodeArena::size() const
+{
+    return count;
+}
+
+/**
+ * @brief Gets the number of nodes the current block can hold
+ * @return The capacity
+ */
+int MazeNodeArena::getCapacity() const
+{
+    return capacity;
+}
+
+/**
+ * @brief Starts a new search generation. Every node stamped with an older one reads as
+ * unvisited, with no previous node and in its base color. Only when the counter wraps
+ * around are the stamps cleared one by one.
+ */
+void MazeNodeArena::newSearchGeneration()
+{
+    generation.search++;
+    if(generation.search == 0){
+        for(int ii = 0; ii < count; ii++){
+            nodes[ii].clearSearchStamps();
+        }
+        generation.search = 1;
+    }
+}
+
+/**
+ * @brief Starts a new wall generation, which turns every node into walkable space
+ */
+void MazeNodeArena::newWallGeneration()
+{
+    generation.walls++;
+    if(generation.walls == 0){
+        for(int ii = 0; ii < count; ii++){
+            nodes[ii].clearWallStamp();
+        }
+        generation.walls = 1;
+    }
+    openDirections.clearWalls();
+}
+
+/**
+ * @brief Sets or clears the walls of consecutive ids in one pass over the block, without
+ * scheduling a repaint per node. The caller repaints the area once.
+ * @param firstId The first id of the range
+ * @param nodeCount The number of ids in the range
+ * @param wall True for walls
+ * @param changedRuns If not 0, the ids that changed are appended as pairs of first id and
+ * length, merged with the last pair if they continue it
+ * @return The number of nodes that changed
+ */
+int MazeNodeArena::assignWalls(int firstId, int nodeCount, bool wall, QVector<int> *changedRuns)
+{
+    int first = qMax(firstId, 0);
+    int last = qMin(firstId + nodeCount, count);
+    int changed = 0;
+    for(int ii = first; ii < last; ii++){
+        if(!nodes[ii].assignWall(wall)){
+            continue;
+        }
+        openDirections.setWall(ii, wall);
+        changed++;
+        if(changedRuns == 0){
+            continue;
+        }
+        int runs = changedRuns->size();
+        if(runs >= 2 && changedRuns->at(runs - 2) + changedRuns->at(runs - 1) == ii){
+            (*changedRuns)[runs - 1]++;
+        }
+        else{
+            changedRuns->append(ii);
+            changedRuns->append(1);
+        }
+    }
+    return changed;
+}
+
+/**
+ * @brief Sets the walls of every node in one pass over the block, without scheduling a
+ * repaint per node, and rebuilds the open directions from them at once. The entrance and
+ * the exit stay open.
+ * @param walls One bit per node id, set for walls
+ */
+void MazeNodeArena::assignAllWalls(const QBitArray &walls)
+{
+    QBitArray assigned(count);
+    for(int ii = 0; ii < count && ii < walls.size(); ii++){
+        nodes[ii].assignWall(walls.testBit(ii));
+        if(nodes[ii].isWall()){
+            assigned.setBit(ii);
+        }
+    }
+    openDirections.setWalls(assigned);
+}
+
+/**
+ * @brief Gets the open directions of every node, which follow the walls
+ * @return The table, owned by the arena
+ */
+const OpenDirectionTable *MazeNodeArena::getOpenDirections() const
+{
+    return &openDirections;
+}
@@ -0,0 +1,45 @@
+#ifndef MAZENODEARENA_H
+#define MAZENODEARENA_H
+
+#include <QVector>
+
+#include "mazenode.h"
+#include "opendirectiontable.h"
+
+/**
+ * @brief Holds all nodes of the maze in one block of memory. The block is only reallocated
+ * when a grid needs more nodes than it can hold, otherwise a new grid is built in place.
+ * The arena also owns the generation counters of its nodes, so resetting the search state
+ * or the walls of the whole maze is a single increment, and the table of open directions,
+ * which the nodes patch when their wall is set or cleared.
+ */
+class MazeNodeArena
+{
+public:
+    MazeNodeArena();
+    ~MazeNodeArena();
+    void reserve(int rows, int columns); ///< Destroys all nodes and makes room for a grid of the given size
+    MazeNode *create(int x, int y, int rectSize); ///< Builds the next node, its id is its index
+    void clear(); ///< Destroys all nodes, keeping the memory
+    MazeNode *at(int id) const;
+    int size() const;
+    int getCapacity() const;
+
+    void newSearchGeneration(); ///< Clears visited, active, path and previous nodes of every node
+    void newWallGeneration(); ///< Clears the walls of every node
+    int assignWalls(int firstId, int nodeCount, bool wall, QVector<int> *changedRuns = 0); ///< Sets or clears the walls of a range of ids without repainting
+    void assignAllWalls(const QBitArray &walls); ///< Sets the walls of every node without repainting, the table is rebuilt in one pass
+    const OpenDirectionTable *getOpenDirections() const;
+
+private:
+    MazeNode *nodes; ///< Raw storage for capacity nodes, the first count are constructed
+    int count;
+    int capacity;
+    MazeGeneration generation;
+    OpenDirectionTable openDirections; ///< Follows the walls of the nodes
+
+    MazeNodeArena(const MazeNodeArena &);
+    MazeNodeArena &operator=(const MazeNodeArena &);
+};
+
+#endif // MAZENODEARENA_H
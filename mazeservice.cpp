@@ -0,0 +1,654 @@
+#include "mazeservice.h"
+#include "batchsolver.h"
+#include "mazefile.h"
+#include "mazeimage.h"
+#include "mazekernels.h"
+#include "searchtrace.h"
+
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QtConcurrentRun>
+
+/**
+ * @brief Creates a service that isn't listening yet
+ * @param parent The parent object
+ */
+MazeService::MazeService(QObject *parent) :
+    QObject(parent)
+{
+    server = new QLocalServer(this);
+    dispatchScheduled = false;
+    batchCount = 0;
+    batchedQueries = 0;
+    clock.start();
+
+    connect(server,SIGNAL(newConnection()),this,SLOT(acceptConnection()));
+}
+
+/**
+ * @brief Waits for running batches and solves, then frees the mazes
+ */
+MazeService::~MazeService()
+{
+    foreach(QObject *watcher, batches.keys()){
+        static_cast<QFutureWatcher<PathAnswer>*>(watcher)->waitForFinished();
+    }
+    foreach(QObject *watcher, solves.keys()){
+        static_cast<QFutureWatcher<MazeKernels::KernelResult>*>(watcher)->waitForFinished();
+    }
+    qDeleteAll(mazes);
+}
+
+/**
+ * @brief Starts listening. A stale socket left by a crashed service is removed first.
+ * @param name The name of the socket
+ * @return False if the socket can't be created
+ */
+bool MazeService::listen(const QString &name)
+{
+    QLocalServer::removeServer(name);
+    return server->listen(name);
+}
+
+/**
+ * @brief Gets the full name of the socket clients connect to
+ * @return The path of the socket, or the name of the pipe on Windows
+ */
+QString MazeService::getServerName() const
+{
+    return server->fullServerName();
+}
+
+/**
+ * @brief Describes why listening failed
+ * @return The error message
+ */
+QString MazeService::errorString() const
+{
+    return server->errorString();
+}
+
+/**
+ * @brief Encodes a message as compact JSON prefixed with its length
+ * @param message The message
+ * @return The frame to write to the socket
+ */
+QByteArray MazeService::encodeFrame(const QJsonObject &message)
+{
+    QByteArray json = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    quint32 length = quint32(json.size());
+    QByteArray frame;
+    frame.append(char((length >> 24) & 0xff));
+    frame.append(char((length >> 16) & 0xff));
+    frame.append(char((length >> 8) & 0xff));
+    frame.append(char(length & 0xff));
+    frame.append(json);
+    return frame;
+}
+
+/**
+ * @brief Takes the next complete message off the front of a buffer
+ * @param buffer The bytes read so far, the frame is removed from it
+ * @param message Receives the message
+ * @return 1 if a message has been taken, 0 if the frame isn't complete yet, -1 if the frame
+ * is too large or not a JSON object
+ */
+int MazeService::takeFrame(QByteArray &buffer, QJsonObject &message)
+{
+    if(buffer.size() < 4){
+        return 0;
+    }
+    quint32 length = (quint32(quint8(buffer.at(0))) << 24) | (quint32(quint8(buffer.at(1))) << 16)
+            | (quint32(quint8(buffer.at(2))) << 8) | quint32(quint8(buffer.at(3)));
+    if(length > quint32(MaximumFrameSize)){
+        return -1;
+    }
+    if(quint32(buffer.size()) < 4 + length){
+        return 0;
+    }
+
+    QJsonDocument document = QJsonDocument::fromJson(buffer.mid(4, int(length)));
+    buffer.remove(0, 4 + int(length));
+    if(!document.isObject()){
+        return -1;
+    }
+    message = document.object();
+    return 1;
+}
+
+/**
+ * @brief Packs walls into base64, one bit per node id, lowest bit first
+ * @param walls The walls
+ * @return The base64 text
+ */
+QString MazeService::encodeWalls(const QBitArray &walls)
+{
+    QByteArray packed((walls.size() + 7) / 8, 0);
+    for(int ii = 0; ii < walls.size(); ii++){
+        if(walls.testBit(ii)){
+            packed[ii >> 3] = char(packed.at(ii >> 3) | (1 << (ii & 7)));
+        }
+    }
+    return QString::fromLatin1(packed.toBase64());
+}
+
+/**
+ * @brief Unpacks walls packed by encodeWalls()
+ * @param encoded The base64 text
+ * @param cells The number of cells of the maze
+ * @return The walls, empty if the text is too short
+ */
+QBitArray MazeService::decodeWalls(const QString &encoded, int cells)
+{
+    QByteArray packed = QByteArray::fromBase64(encoded.toLatin1());
+    if(packed.size() < (cells + 7) / 8){
+        return QBitArray();
+    }
+    QBitArray walls(cells);
+    for(int ii = 0; ii < cells; ii++){
+        if(packed.at(ii >> 3) & (1 << (ii & 7))){
+            walls.setBit(ii);
+        }
+    }
+    return walls;
+}
+
+/**
+ * @brief Accepts all waiting connections
+ */
+void MazeService::acceptConnection()
+{
+    while(QLocalSocket *socket = server->nextPendingConnection()){
+        buffers.insert(socket, QByteArray());
+        connect(socket,SIGNAL(readyRead()),this,SLOT(readRequests()));
+        connect(socket,SIGNAL(disconnected()),this,SLOT(dropConnection()));
+    }
+}
+
+/**
+ * @brief Reads all complete requests of a connection. Dispatching waits until the event loop
+ * is idle again, so everything that arrived in the meantime can be batched.
+ */
+void MazeService::readRequests()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if(socket == 0 || !buffers.contains(socket)){
+        return;
+    }
+
+    QByteArray &buffer = buffers[socket];
+    buffer.append(socket->readAll());
+
+    QJsonObject message;
+    int taken;
+    while((taken = takeFrame(buffer, message)) > 0){
+        Request request;
+        request.socket = socket;
+        request.message = message;
+        request.operation = message.value("op").toString();
+        request.receivedNs = clock.nsecsElapsed();
+        handle(request);
+    }
+
+    if(taken < 0){
+        Request request;
+        request.socket = socket;
+        request.receivedNs = clock.nsecsElapsed();
+        replyError(request, "Malformed frame");
+        buffers.remove(socket);
+        socket->disconnectFromServer();
+    }
+}
+
+/**
+ * @brief Forgets a closed connection. Replies to its running requests are dropped.
+ */
+void MazeService::dropConnection()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    buffers.remove(socket);
+    if(socket != 0){
+        socket->deleteLater();
+    }
+}
+
+/**
+ * @brief Answers service requests right away and queues maze requests with their maze
+ * @param request The request
+ */
+void MazeService::handle(const Request &request)
+{
+    if(request.operation == "stats"){
+        QJsonObject response = collectStats();
+        reply(request, response);
+        return;
+    }
+    if(request.operation == "shutdown"){
+        reply(request, QJsonObject());
+        if(request.socket){
+            request.socket->flush();
+        }
+        QTimer::singleShot(0, QCoreApplication::instance(), SLOT(quit()));
+        return;
+    }
+
+    QString operation = request.operation;
+    if(operation != "create" && operation != "edit" && operation != "query"
+            && operation != "solve" && operation != "drop"){
+        replyError(request, "Unknown operation " + operation);
+        return;
+    }
+
+    QString mazeId = request.message.value("maze").toString();
+    MazeEntry *entry = mazes.value(mazeId);
+    if(entry == 0){
+        if(operation != "create"){
+            replyError(request, "Unknown maze " + mazeId);
+            return;
+        }
+        entry = new MazeEntry;
+        mazes.insert(mazeId, entry);
+    }
+
+    entry->waiting.append(request);
+    pendingMazes.insert(mazeId);
+    scheduleDispatch();
+}
+
+/**
+ * @brief Runs dispatchPending() once the event loop is idle
+ */
+void MazeService::scheduleDispatch()
+{
+    if(!dispatchScheduled){
+        dispatchScheduled = true;
+        QTimer::singleShot(0, this, SLOT(dispatchPending()));
+    }
+}
+
+/**
+ * @brief Starts whatever the mazes with waiting requests can run now
+ */
+void MazeService::dispatchPending()
+{
+    dispatchScheduled = false;
+    QSet<QString> ready = pendingMazes;
+    pendingMazes.clear();
+    foreach(const QString &mazeId, ready){
+        runQueue(mazeId);
+    }
+}
+
+/**
+ * @brief Works through the requests of a maze in order. All queries and solves at the front
+ * start at once, queries as one batch. A create, edit or drop waits until nothing reads the
+ * maze any more.
+ * @param mazeId The id of the maze
+ */
+void MazeService::runQueue(const QString &mazeId)
+{
+    MazeEntry *entry = mazes.value(mazeId);
+    if(entry == 0){
+        return;
+    }
+
+    while(!entry->waiting.isEmpty()){
+        QString operation = entry->waiting.first().operation;
+        if(operation == "query" || operation == "solve"){
+            QList<Request> queries;
+            while(!entry->waiting.isEmpty() && (entry->waiting.first().operation == "query"
+                                                || entry->waiting.first().operation == "solve")){
+                Request request = entry->waiting.takeFirst();
+                if(request.operation == "solve"){
+                    startSolve(mazeId, entry, request);
+                }
+                else{
+                    queries.append(request);
+                }
+            }
+            if(!queries.isEmpty()){
+                startQueryBatch(mazeId, entry, queries);
+            }
+            continue;
+        }
+
+        if(entry->running > 0){
+            return; // Finishing readers call runQueue() again
+        }
+
+        Request request = entry->waiting.takeFirst();
+        if(operation == "create"){
+            if(!createMaze(entry, request) && entry->grid.getCellCount() == 0 && entry->waiting.isEmpty()){
+                mazes.remove(mazeId);
+                delete entry;
+                return;
+            }
+        }
+        else if(operation == "edit"){
+            editMaze(entry, request);
+        }
+        else{
+            reply(request, QJsonObject());
+            foreach(const Request &orphan, entry->waiting){
+                replyError(orphan, "Unknown maze " + mazeId);
+            }
+            mazes.remove(mazeId);
+            delete entry;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Builds or replaces a maze
+ * @param entry The maze
+ * @param request The create request
+ * @return False if the request is invalid, the maze is unchanged then
+ */
+bool MazeService::createMaze(MazeEntry *entry, const Request &request)
+{
+    const QJsonObject &message = request.message;
+    int rows = message.value("rows").toInt();
+    int columns = message.value("columns").toInt();
+    QBitArray walls;
+    MazeImage::Markers markers;
+
+    if(message.contains("file")){
+        SearchTrace unusedTrace;
+        if(!MazeFile::load(message.value("file").toString(), rows, columns, walls, unusedTrace)){
+            replyError(request, "Could not load " + message.value("file").toString());
+            return false;
+        }
+    }
+    else if(message.contains("image")){
+        MazeGrid imported;
+        QString error;
+        if(!MazeImage::load(message.value("image").toString(), message.value("threshold").toInt(128), imported, markers, error)){
+            replyError(request, error);
+            return false;
+        }
+        rows = imported.getRows();
+        columns = imported.getColumns();
+        walls = imported.getWalls();
+    }
+
+    // Loaded mazes are held to the same size as requested ones
+    if(rows <= 0 || columns <= 0 || qint64(rows) * columns > MazeFile::maxCells){
+        replyError(request, "Invalid maze size");
+        return false;
+    }
+
+    bool loaded = message.contains("file") || message.contains("image");
+    if(!loaded && message.contains("walls")){
+        walls = decodeWalls(message.value("walls").toString(), rows * columns);
+        if(walls.isEmpty()){
+            replyError(request, "Walls don't match the maze size");
+            return false;
+        }
+    }
+    else if(!loaded){
+        MazeGrid random(rows, columns);
+        random.randomize(quint32(message.value("random").toDouble(1)));
+        walls = random.getWalls();
+    }
+
+    entry->grid.resize(rows, columns);
+    entry->grid.setWalls(walls);
+    entry->walls = walls;
+
+    QJsonObject response;
+    response.insert("rows", rows);
+    response.insert("columns", columns);
+    response.insert("walls", walls.count(true));
+    if(markers.entrance >= 0){
+        response.insert("entrance", markers.entrance);
+    }
+    if(markers.exit >= 0){
+        response.insert("exit", markers.exit);
+    }
+    reply(request, response);
+    return true;
+}
+
+/**
+ * @brief Sets and clears walls of a maze
+ * @param entry The maze
+ * @param request The edit request
+ */
+void MazeService::editMaze(MazeEntry *entry, const Request &request)
+{
+    int cells = entry->grid.getCellCount();
+    int changed = 0;
+    const char *keys[] = { "walls", "open" };
+    for(int key = 0; key < 2; key++){
+        bool wall = key == 0;
+        foreach(const QJsonValue &value, request.message.value(keys[key]).toArray()){
+            int id = value.toInt(-1);
+            if(id < 0 || id >= cells){
+                continue;
+            }
+            entry->grid.setWall(entry->grid.indexOfId(id), wall);
+            entry->walls.setBit(id, wall);
+            changed++;
+        }
+    }
+
+    QJsonObject response;
+    response.insert("changed", changed);
+    reply(request, response);
+}
+
+/**
+ * @brief Puts the queries of several requests into one batch for the thread pool
+ * @param mazeId The id of the maze
+ * @param entry The maze
+ * @param requests The query requests
+ */
+void MazeService::startQueryBatch(const QString &mazeId, MazeEntry *entry, const QList<Request> &requests)
+{
+    QueryBatch batch;
+    batch.mazeId = mazeId;
+    QVector<PathQuery> queries;
+    foreach(const Request &request, requests){
+        batch.requests.append(request);
+        batch.offsets.append(queries.size());
+        if(request.message.contains("queries")){
+            foreach(const QJsonValue &pair, request.message.value("queries").toArray()){
+                QJsonArray ids = pair.toArray();
+                queries.append(PathQuery(ids.at(0).toInt(-1), ids.at(1).toInt(-1)));
+            }
+        }
+        else{
+            queries.append(PathQuery(request.message.value("start").toInt(-1), request.message.value("goal").toInt(-1)));
+        }
+    }
+    batch.size = queries.size();
+    batch.offsets.append(queries.size());
+
+    QFutureWatcher<PathAnswer> *watcher = new QFutureWatcher<PathAnswer>(this);
+    connect(watcher,SIGNAL(finished()),this,SLOT(finishQueryBatch()));
+    batches.insert(watcher, batch);
+    entry->running++;
+    batchCount++;
+    batchedQueries += queries.size();
+
+    BatchSolver solver(&entry->grid);
+    watcher->setFuture(solver.start(queries));
+}
+
+/**
+ * @brief Hands the answers of a finished batch back to its requests
+ */
+void MazeService::finishQueryBatch()
+{
+    QFutureWatcher<PathAnswer> *watcher = static_cast<QFutureWatcher<PathAnswer>*>(sender());
+    QueryBatch batch = batches.take(watcher);
+    QFuture<PathAnswer> future = watcher->future();
+
+    for(int ii = 0; ii < batch.requests.size(); ii++){
+        const Request &request = batch.requests.at(ii);
+        bool withPath = request.message.value("withPath").toBool(true);
+        QJsonArray results;
+        for(int query = batch.offsets.at(ii); query < batch.offsets.at(ii + 1); query++){
+            PathAnswer answer = future.resultAt(query);
+            QJsonObject result;
+            result.insert("found", answer.found);
+            result.insert("expanded", answer.expanded);
+            result.insert("length", answer.path.size());
+            if(withPath){
+                QJsonArray path;
+                foreach(int id, answer.path){
+                    path.append(id);
+                }
+                result.insert("path", path);
+            }
+            results.append(result);
+        }
+
+        QJsonObject response;
+        response.insert("results", results);
+        response.insert("batchSize", batch.size);
+        reply(request, response);
+    }
+
+    watcher->deleteLater();
+    MazeEntry *entry = mazes.value(batch.mazeId);
+    if(entry != 0){
+        entry->running--;
+        runQueue(batch.mazeId);
+    }
+}
+
+/**
+ * @brief Runs a search kernel for a solve request on the thread pool
+ * @param mazeId The id of the maze
+ * @param entry The maze
+ * @param request The solve request
+ */
+void MazeService::startSolve(const QString &mazeId, MazeEntry *entry, const Request &request)
+{
+    MazeKernels::KernelInput input;
+    input.rows = entry->grid.getRows();
+    input.columns = entry->grid.getColumns();
+    input.entrance = request.message.value("start").toInt(-1);
+    input.exit = request.message.value("goal").toInt(-1);
+    input.walls = entry->walls;
+
+    int cells = input.rows * input.columns;
+    if(input.entrance < 0 || input.entrance >= cells || input.exit < 0 || input.exit >= cells){
+        replyError(request, "Start or goal outside of the maze");
+        return;
+    }
+
+    QString algorithmName = request.message.value("algorithm").toString();
+    QString connectivityName = request.message.value("connectivity").toString();
+    MazeKernels::Algorithm algorithm = algorithmName == "dfs" ? MazeKernels::DepthFirst : MazeKernels::BreadthFirst;
+    MazeKernels::Connectivity connectivity = MazeKernels::FourConnected;
+    if(connectivityName == "8"){
+        connectivity = MazeKernels::EightConnected;
+    }
+    else if(connectivityName == "hex"){
+        connectivity = MazeKernels::HexConnected;
+    }
+
+    SolveTask task;
+    task.mazeId = mazeId;
+    task.request = request;
+
+    QFutureWatcher<MazeKernels::KernelResult> *watcher = new QFutureWatcher<MazeKernels::KernelResult>(this);
+    connect(watcher,SIGNAL(finished()),this,SLOT(finishSolve()));
+    solves.insert(watcher, task);
+    entry->running++;
+    watcher->setFuture(QtConcurrent::run(MazeKernels::run, input, algorithm, connectivity, MazeKernels::PaddedGridStorage));
+}
+
+/**
+ * @brief Replies to a finished solve
+ */
+void MazeService::finishSolve()
+{
+    QFutureWatcher<MazeKernels::KernelResult> *watcher = static_cast<QFutureWatcher<MazeKernels::KernelResult>*>(sender());
+    SolveTask task = solves.take(watcher);
+    MazeKernels::KernelResult result = watcher->result();
+
+    QJsonObject response;
+    response.insert("found", result.found);
+    response.insert("expanded", result.expanded);
+    response.insert("length", result.path.size());
+    if(task.request.message.value("withPath").toBool(true)){
+        QJsonArray path;
+        foreach(int id, result.path){
+            path.append(id);
+        }
+        response.insert("path", path);
+    }
+    reply(task.request, response);
+
+    watcher->deleteLater();
+    MazeEntry *entry = mazes.value(task.mazeId);
+    if(entry != 0){
+        entry->running--;
+        runQueue(task.mazeId);
+    }
+}
+
+/**
+ * @brief Sends a successful reply and counts its latency
+ * @param request The request
+ * @param response The fields of the reply, id and ok are added
+ */
+void MazeService::reply(const Request &request, QJsonObject response)
+{
+    qint64 microseconds = (clock.nsecsElapsed() - request.receivedNs) / 1000;
+    latencies[request.operation.isEmpty() ? QString("invalid") : request.operation].add(microseconds);
+
+    if(!response.contains("ok")){
+        response.insert("ok", true);
+    }
+    response.insert("id", request.message.value("id"));
+    response.insert("serverUs", double(microseconds));
+    if(request.socket){
+        request.socket->write(encodeFrame(response));
+    }
+}
+
+/**
+ * @brief Sends an error reply
+ * @param request The request
+ * @param error What went wrong
+ */
+void MazeService::replyError(const Request &request, const QString &error)
+{
+    QJsonObject response;
+    response.insert("ok", false);
+    response.insert("error", error);
+    reply(request, response);
+}
+
+/**
+ * @brief Collects the latency histograms and counters
+ * @return The fields of a stats reply
+ */
+QJsonObject MazeService::collectStats() const
+{
+    QJsonObject histograms;
+    LatencyHistogram all;
+    QHash<QString,LatencyHistogram>::const_iterator ii;
+    for(ii = latencies.constBegin(); ii != latencies.constEnd(); ++ii){
+        histograms.insert(ii.key(), ii.value().toJson());
+        all.merge(ii.value());
+    }
+    histograms.insert("all", all.toJson());
+
+    QJsonObject stats;
+    stats.insert("mazes", mazes.size());
+    stats.insert("connections", buffers.size());
+    stats.insert("batches", double(batchCount));
+    stats.insert("batchedQueries", double(batchedQueries));
+    stats.insert("averageBatchSize", batchCount > 0 ? double(batchedQueries) / batchCount : 0.0);
+    stats.insert("latency", histograms);
+    return stats;
+}
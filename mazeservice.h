@@ -0,0 +1,124 @@
+#ifndef MAZESERVICE_H
+#define MAZESERVICE_H
+
+#include <QObject>
+#include <QBitArray>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QSet>
+
+#include "mazegrid.h"
+#include "latencyhistogram.h"
+
+/**
+ * @brief Runs the solver as a local service. Clients connect to a local socket and send
+ * requests as JSON objects, each one prefixed by its length as a 32 bit big endian number.
+ * Mazes stay loaded by id between requests.
+ *
+ * Requests for one maze run in the order they arrive. Consecutive queries and solves read the
+ * maze, so they run together: all queries waiting for a maze go to the thread pool as one
+ * BatchSolver batch, solves run the search kernels the instant searches of the UI use.
+ * Edits and drops wait until nothing reads the maze any more.
+ *
+ * Every reply carries the id of its request and "ok". Operations:
+ * - create: maze, rows, columns and one of walls (base64, one bit per node id), random (seed), file
+ *   or image (with an optional threshold, replies with the entrance and exit it marks)
+ * - edit: maze, walls (node ids to turn into walls), open (node ids to clear)
+ * - query: maze, start and goal or queries ([[start, goal], ...]), withPath (default true)
+ * - solve: maze, start, goal, algorithm (bfs, dfs), connectivity (4, 8, hex), withPath
+ * - drop: maze
+ * - stats: latency histograms per operation and the batching counters
+ * - shutdown: stops the service after replying
+ */
+class MazeService : public QObject
+{
+    Q_OBJECT
+public:
+    enum { MaximumFrameSize = 64 * 1024 * 1024 }; ///< Larger frames close the connection
+
+    explicit MazeService(QObject *parent = 0);
+    ~MazeService();
+    bool listen(const QString &name); ///< Starts listening on the local socket with the given name
+    QString getServerName() const; ///< Full path or pipe name of the socket
+    QString errorString() const;
+
+    static QByteArray encodeFrame(const QJsonObject &message); ///< Prefixes the JSON of a message with its length
+    static int takeFrame(QByteArray &buffer, QJsonObject &message); ///< Takes the next message off a buffer, 1 if taken, 0 if incomplete, -1 if malformed
+    static QString encodeWalls(const QBitArray &walls); ///< Packs walls into base64 for create requests
+    static QBitArray decodeWalls(const QString &encoded, int cells); ///< Unpacks walls of create requests
+
+private slots:
+    void acceptConnection();
+    void readRequests();
+    void dropConnection();
+    void dispatchPending();
+    void finishQueryBatch();
+    void finishSolve();
+
+private:
+    /// A request waiting for its reply
+    struct Request
+    {
+        QPointer<QLocalSocket> socket;
+        QJsonObject message;
+        QString operation;
+        qint64 receivedNs; ///< Service clock when the request has been read
+    };
+
+    /// A loaded maze and the requests waiting for it
+    struct MazeEntry
+    {
+        MazeEntry() : running(0) {}
+        MazeGrid grid; ///< Read by query batches
+        QBitArray walls; ///< Read by solves
+        QList<Request> waiting;
+        int running; ///< Batches and solves reading the maze right now
+    };
+
+    /// Query requests answered by one BatchSolver run
+    struct QueryBatch
+    {
+        QString mazeId;
+        QList<Request> requests;
+        QVector<int> offsets; ///< First query of each request in the batch
+        int size;
+    };
+
+    /// A solve request running a kernel
+    struct SolveTask
+    {
+        QString mazeId;
+        Request request;
+    };
+
+    QLocalServer *server;
+    QHash<QLocalSocket*,QByteArray> buffers; ///< Bytes read but not yet parsed, by connection
+    QHash<QString,MazeEntry*> mazes;
+    QSet<QString> pendingMazes; ///< Mazes with waiting requests
+    QHash<QObject*,QueryBatch> batches; ///< Running batches by their watcher
+    QHash<QObject*,SolveTask> solves; ///< Running solves by their watcher
+    QHash<QString,LatencyHistogram> latencies; ///< By operation
+    QElapsedTimer clock;
+    bool dispatchScheduled;
+    qint64 batchCount;
+    qint64 batchedQueries;
+
+    void handle(const Request &request);
+    void scheduleDispatch();
+    void runQueue(const QString &mazeId);
+    void startQueryBatch(const QString &mazeId, MazeEntry *entry, const QList<Request> &requests);
+    void startSolve(const QString &mazeId, MazeEntry *entry, const Request &request);
+    bool createMaze(MazeEntry *entry, const Request &request);
+    void editMaze(MazeEntry *entry, const Request &request);
+    void reply(const Request &request, QJsonObject response);
+    void replyError(const Request &request, const QString &error);
+    QJsonObject collectStats() const;
+};
+
+#endif // MAZESERVICE_H
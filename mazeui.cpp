@@ -1,4 +1,17 @@
 #include "mazeui.h"
+#include "mazefile.h"
+#include "mazeimage.h"
+#include "timelinetrace.h"
+
+#include <QFileDialog>
+#include <QFile>
+#include <QApplication>
+#include <QClipboard>
+#include <QMimeData>
+#include <QThread>
+#include <QtConcurrentRun>
+#include <QStandardPaths>
+#include <QDir>
 /**
  * @brief Creates a new maze solver ui with solving capabilities on a given tab
  * @param QWidget the widget on which to create the UI
@@ -21,6 +34,9 @@ MazeUi::MazeUi(QWidget *parent) : QGraphicsView(parent)
     // Create the data structures that hold pointers to all the nodes
     listOfRectangles = new QHash<QGraphicsItem *,MazeNode *>(); // one by the graphics items
     listOfIds = new QHash<int,MazeNode*>(); // one by the ID
+    nodes = new MazeNodeArena(); // and the nodes themselves in one block
+    editor = new MazeEditor(nodes);
+    trace = new SearchTrace();
 
     setupUI();
     setDefaultSelections();
@@ -31,8 +47,17 @@ MazeUi::MazeUi(QWidget *parent) : QGraphicsView(parent)
  * @brief Destructor
  */
 MazeUi::~MazeUi(){
+    delete editor;
+    delete nodes; // Takes the rectangles off the scene before it goes
     delete listOfRectangles;
     delete listOfIds;
+    delete trace;
+    batchWatcher->waitForFinished();
+    analyticsWatcher->waitForFinished();
+    delete batchGrid;
+    delete landmarks;
+    delete floors;
+    delete solveCache;
 }
 /**
  * @brief Creates an array for the different sizes of the arrays
@@ -108,8 +133,60 @@ void MazeUi::addItemsToMazeGroupBox(QGroupBox *mazeGroupBox){
     searchSelection = new QComboBox();
     searchSelection->addItem("DFS");
     searchSelection->addItem("BFS");
+    searchSelection->addItem("DFS (instant)");
+    searchSelection->addItem("BFS (instant)");
+    searchSelection->addItem("IDA*");
+    searchSelection->addItem("Frontier BFS");
+    searchSelection->addItem("Anytime A*");
+    searchSelection->addItem("Rectangle A*");
+    searchSelection->addItem("Sharded BFS");
     controlLayout->addRow(searchDescription,searchSelection);
 
+    // Options for the instant searches, which run specialized kernels
+    neighbourhoodSelection = new QComboBox();
+    neighbourhoodSelection->addItem("4-connected");
+    neighbourhoodSelection->addItem("8-connected");
+    neighbourhoodSelection->addItem("Hex");
+    controlLayout->addRow(new QLabel("Neighbourhood"),neighbourhoodSelection);
+
+    storageSelection = new QComboBox();
+    storageSelection->addItem("Bit plane");
+    storageSelection->addItem("Byte grid");
+    storageSelection->addItem("Padded grid");
+    storageSelection->setCurrentIndex(MazeKernels::PaddedGridStorage);
+    controlLayout->addRow(new QLabel("Cell storage"),storageSelection);
+
+    // Memory the IDA* and frontier searches may use
+    memoryBudgetSelector = new QSpinBox();
+    memoryBudgetSelector->setMinimum(1);
+    memoryBudgetSelector->setMaximum(4194304);
+    memoryBudgetSelector->setValue(1024);
+    memoryBudgetSelector->setSuffix(" KiB");
+    controlLayout->addRow(new QLabel("Memory budget"),memoryBudgetSelector);
+
+    // Time the anytime search may take to refine its path
+    deadlineSelector = new QSpinBox();
+    deadlineSelector->setMinimum(1);
+    deadlineSelector->setMaximum(60000000);
+    deadlineSelector->setValue(10000);
+    deadlineSelector->setSuffix(" us");
+    controlLayout->addRow(new QLabel("Deadline"),deadlineSelector);
+
+    // Worker processes of the sharded search, one per band of rows
+    shardCountSelector = new QSpinBox();
+    shardCountSelector->setMinimum(1);
+    shardCountSelector->setMaximum(64);
+    shardCountSelector->setValue(qMax(2, QThread::idealThreadCount()));
+    controlLayout->addRow(new QLabel("Worker processes"),shardCountSelector);
+
+    // Results of searches that ran before on the same maze, kept across sessions
+    reuseResultsBox = new QCheckBox("Reuse cached results");
+    reuseResultsBox->setChecked(true);
+    controlLayout->addRow(reuseResultsBox);
+    solveCache = new SolveCache();
+    solveCache->setDirectory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("solves"));
+    storeResult = false;
+
     // Get the possible sizes of the maze from the created array
     QLabel *gridSizeDescription = new QLabel("Select Grid size");
     gridSizeSelection = new QComboBox();
@@ -133,16 +210,69 @@ void MazeUi::addItemsToMazeGroupBox(QGroupBox *mazeGroupBox){
     startSearchButton = new QPushButton("Start Search");
     controlLayout->addRow(startSearchButton);
 
+    stepSearchButton = new QPushButton("Step");
+    controlLayout->addRow(stepSearchButton);
+    stepSearchButton->setVisible(false);
+
     stopSearchButton = new QPushButton("Stop Search");
     controlLayout->addRow(stopSearchButton);
     stopSearchButton->setVisible(false);
 
+    saveMazeButton = new QPushButton("Save Maze");
+    controlLayout->addRow(saveMazeButton);
+
+    loadMazeButton = new QPushButton("Load Maze");
+    controlLayout->addRow(loadMazeButton);
+
+    importImageButton = new QPushButton("Import Image");
+    controlLayout->addRow(importImageButton);
+
+    imageThresholdSelector = new QSpinBox();
+    imageThresholdSelector->setMinimum(1);
+    imageThresholdSelector->setMaximum(255);
+    imageThresholdSelector->setValue(128);
+    controlLayout->addRow(new QLabel("Image threshold"),imageThresholdSelector);
+
+    // Checkpoints of the DFS and BFS searches
+    checkpointIntervalSelector = new QSpinBox();
+    checkpointIntervalSelector->setMinimum(0);
+    checkpointIntervalSelector->setMaximum(86400);
+    checkpointIntervalSelector->setValue(0);
+    checkpointIntervalSelector->setSuffix(" s");
+    checkpointIntervalSelector->setSpecialValueText("Off");
+    controlLayout->addRow(new QLabel("Checkpoint every"),checkpointIntervalSelector);
+    checkpointFileName = "search.checkpoint";
+
+    saveCheckpointButton = new QPushButton("Save Checkpoint");
+    saveCheckpointButton->setEnabled(false); // Enabled while searching
+    controlLayout->addRow(saveCheckpointButton);
+
+    resumeCheckpointButton = new QPushButton("Resume Checkpoint");
+    controlLayout->addRow(resumeCheckpointButton);
+
+    // All solvers at once, each on a thread of its own
+    raceButton = new QPushButton("Race All Solvers");
+    controlLayout->addRow(raceButton);
+    raceWindow = 0;
+
+    progressBar = new QProgressBar();
+    progressBar->setRange(0,1000);
+    progressBar->setValue(0);
+    controlLayout->addRow(progressBar);
+
     // Connect the buttons to slots
     connect(changeGridSize,SIGNAL(clicked()),this,SLOT(setNewGridSize()));
     connect(startSearchButton,SIGNAL(clicked()),this,SLOT(startSearch()));
+    connect(stepSearchButton,SIGNAL(clicked()),this,SLOT(stepSearch()));
     connect(stopSearchButton,SIGNAL(clicked()),this,SLOT(stopSearch()));
     connect(resetMazeButton,SIGNAL(clicked()),this,SLOT(resetMaze()));
     connect(clearMazeButton,SIGNAL(clicked()),this,SLOT(clearMaze()));
+    connect(saveMazeButton,SIGNAL(clicked()),this,SLOT(saveMaze()));
+    connect(loadMazeButton,SIGNAL(clicked()),this,SLOT(loadMaze()));
+    connect(importImageButton,SIGNAL(clicked()),this,SLOT(importImage()));
+    connect(saveCheckpointButton,SIGNAL(clicked()),this,SLOT(saveCheckpoint()));
+    connect(resumeCheckpointButton,SIGNAL(clicked()),this,SLOT(resumeCheckpoint()));
+    connect(raceButton,SIGNAL(clicked()),this,SLOT(startRace()));
 
 }
 /**
@@ -158,6 +288,29 @@ void MazeUi::addItemsToToolsGroupBox(QGroupBox *toolsGroupBox)
     QPushButton *createRandomMazeButton = new QPushButton("Create Random Maze");
     controlLayout->addRow(createRandomMazeButton);
 
+    // Editing the walls with the mouse
+    editToolSelection = new QComboBox(this);
+    editToolSelection->addItem("Toggle");
+    editToolSelection->addItem("Brush");
+    editToolSelection->addItem("Line");
+    editToolSelection->addItem("Rectangle");
+    editToolSelection->addItem("Flood fill");
+    controlLayout->addRow("Edit tool",editToolSelection);
+
+    brushRadiusSelector = new QSpinBox(this);
+    brushRadiusSelector->setMinimum(0);
+    brushRadiusSelector->setMaximum(1000);
+    brushRadiusSelector->setValue(0);
+    controlLayout->addRow("Brush radius",brushRadiusSelector);
+
+    undoButton = new QPushButton("Undo");
+    undoButton->setEnabled(false);
+    controlLayout->addRow(undoButton);
+
+    redoButton = new QPushButton("Redo");
+    redoButton->setEnabled(false);
+    controlLayout->addRow(redoButton);
+
     // Setting the tick intervals
     tickIntervalSelector = new QSpinBox(this);
     tickIntervalSelector->setMinimum(1);
@@ -165,7 +318,131 @@ void MazeUi::addItemsToToolsGroupBox(QGroupBox *toolsGroupBox)
     tickIntervalSelector->setValue(10);
     controlLayout->addRow("Tick Interval",tickIntervalSelector);
 
+    // How the DFS and BFS searches are driven
+    runModeSelection = new QComboBox(this);
+    runModeSelection->addItem("Animated");
+    runModeSelection->addItem("Single step");
+    runModeSelection->addItem("Full speed");
+    controlLayout->addRow("Run mode",runModeSelection);
+
+    expansionsPerTickSelector = new QSpinBox(this);
+    expansionsPerTickSelector->setMinimum(1);
+    expansionsPerTickSelector->setMaximum(100000);
+    expansionsPerTickSelector->setValue(1);
+    controlLayout->addRow("Steps per tick",expansionsPerTickSelector);
+
+    // Replay of the recorded search
+    replaySlider = new QSlider(Qt::Horizontal,this);
+    replaySlider->setRange(0,0);
+    controlLayout->addRow("Replay",replaySlider);
+
+    replaySpeedSelector = new QSpinBox(this);
+    replaySpeedSelector->setMinimum(1);
+    replaySpeedSelector->setMaximum(1000000);
+    replaySpeedSelector->setValue(10);
+    controlLayout->addRow("Replay steps per tick",replaySpeedSelector);
+
+    replayButton = new QPushButton("Play Replay");
+    controlLayout->addRow(replayButton);
+
+    replayTimer = new QTimer(this);
+
+    // Many path queries at once on the current maze
+    batchQuerySelector = new QSpinBox(this);
+    batchQuerySelector->setMinimum(1);
+    batchQuerySelector->setMaximum(1000000);
+    batchQuerySelector->setValue(1000);
+    controlLayout->addRow("Batch queries",batchQuerySelector);
+
+    batchQueryButton = new QPushButton("Run Batch Queries");
+    controlLayout->addRow(batchQueryButton);
+
+    batchGrid = new MazeGrid();
+    batchWatcher = new QFutureWatcher<PathAnswer>(this);
+
+    // Landmark distances for the estimate of the anytime search
+    landmarkCountSelector = new QSpinBox(this);
+    landmarkCountSelector->setMinimum(1);
+    landmarkCountSelector->setMaximum(64);
+    landmarkCountSelector->setValue(8);
+    controlLayout->addRow("Landmarks",landmarkCountSelector);
+
+    buildLandmarksButton = new QPushButton("Build Landmarks");
+    controlLayout->addRow(buildLandmarksButton);
+
+    landmarks = new LandmarkTable();
+
+    // Dead ends, corridors, eccentricities and diameter of the current maze
+    analyzeButton = new QPushButton("Analyze Maze");
+    controlLayout->addRow(analyzeButton);
+    analyticsWatcher = new QFutureWatcher<MazeAnalytics::Report>(this);
+
+    QPushButton *clearCacheButton = new QPushButton("Clear Result Cache");
+    controlLayout->addRow(clearCacheButton);
+
+    // Floors stacked on top of each other, the maze view shows one of them
+    floorCountSelector = new QSpinBox(this);
+    floorCountSelector->setMinimum(1);
+    floorCountSelector->setMaximum(16);
+    floorCountSelector->setValue(1);
+    controlLayout->addRow("Floors",floorCountSelector);
+
+    floorSelector = new QSpinBox(this);
+    floorSelector->setMinimum(0);
+    floorSelector->setMaximum(0);
+    controlLayout->addRow("Shown floor",floorSelector);
+
+    stairCountSelector = new QSpinBox(this);
+    stairCountSelector->setMinimum(0);
+    stairCountSelector->setMaximum(10000);
+    stairCountSelector->setValue(20);
+    controlLayout->addRow("Stairs per floor",stairCountSelector);
+
+    portalCountSelector = new QSpinBox(this);
+    portalCountSelector->setMinimum(0);
+    portalCountSelector->setMaximum(10000);
+    portalCountSelector->setValue(2);
+    controlLayout->addRow("Portals",portalCountSelector);
+
+    placeConnectionsButton = new QPushButton("Place Stairs and Portals");
+    controlLayout->addRow(placeConnectionsButton);
+
+    floorSearchSelection = new QComboBox(this);
+    floorSearchSelection->addItem("BFS");
+    floorSearchSelection->addItem("A*");
+    controlLayout->addRow("Floor search",floorSearchSelection);
+
+    solveFloorsButton = new QPushButton("Solve Floors");
+    controlLayout->addRow(solveFloorsButton);
+
+    floors = new LayeredMaze();
+    shownFloor = 0;
+
+    connect(buildLandmarksButton,SIGNAL(clicked()),this,SLOT(buildLandmarks()));
+    connect(analyzeButton,SIGNAL(clicked()),this,SLOT(analyzeMaze()));
+    connect(analyticsWatcher,SIGNAL(finished()),this,SLOT(finishAnalysis()));
+    connect(clearCacheButton,SIGNAL(clicked()),this,SLOT(clearResultCache()));
+    connect(floorCountSelector,SIGNAL(valueChanged(int)),this,SLOT(setFloorCount(int)));
+    connect(floorSelector,SIGNAL(valueChanged(int)),this,SLOT(showFloor(int)));
+    connect(placeConnectionsButton,SIGNAL(clicked()),this,SLOT(placeFloorConnections()));
+    connect(solveFloorsButton,SIGNAL(clicked()),this,SLOT(solveFloors()));
+
+#ifdef MAZESOLVER_TIMELINE
+    // Where the time of the solver, the event handlers and painting went
+    QPushButton *exportTimelineButton = new QPushButton("Export Timeline");
+    controlLayout->addRow(exportTimelineButton);
+    connect(exportTimelineButton,SIGNAL(clicked()),this,SLOT(exportTimeline()));
+#endif
+
+    connect(batchQueryButton,SIGNAL(clicked()),this,SLOT(runBatchQueries()));
+    connect(batchWatcher,SIGNAL(finished()),this,SLOT(finishBatchQueries()));
+    connect(replaySlider,SIGNAL(valueChanged(int)),this,SLOT(showReplayFrame(int)));
+    connect(replayButton,SIGNAL(clicked()),this,SLOT(toggleReplay()));
+    connect(replayTimer,SIGNAL(timeout()),this,SLOT(replayTick()));
+
     connect(createRandomMazeButton,SIGNAL(clicked()),this,SLOT(createRandomMaze()));
+    connect(undoButton,SIGNAL(clicked()),this,SLOT(undoEdit()));
+    connect(redoButton,SIGNAL(clicked()),this,SLOT(redoEdit()));
 
 }
 /**
@@ -177,8 +454,18 @@ void MazeUi::addItemsToLogGroupBox(QGroupBox *logGroupBox)
     QGridLayout *controlLayout = new QGridLayout();
     logGroupBox->setLayout(controlLayout);
 
-    log = new QTextBrowser();
-    controlLayout->addWidget(log);
+    log = new LogView();
+    controlLayout->addWidget(log,0,0,1,2);
+
+    // The last path as run-length encoded moves
+    QPushButton *exportPathButton = new QPushButton("Export Path");
+    controlLayout->addWidget(exportPathButton,1,0);
+
+    QPushButton *copyPathButton = new QPushButton("Copy Path");
+    controlLayout->addWidget(copyPathButton,1,1);
+
+    connect(exportPathButton,SIGNAL(clicked()),this,SLOT(exportPath()));
+    connect(copyPathButton,SIGNAL(clicked()),this,SLOT(copyPath()));
 
 }
 /**
@@ -192,26 +479,15 @@ void MazeUi::setEntranceAndExit()
 }
 
 /**
- * @brief Resets the maze but leaves the walls intact
+ * @brief Resets the maze but leaves the walls intact. Moving on to a new search generation
+ * clears the search state of all nodes at once, the nodes repaint from their state.
  */
 void MazeUi::resetMaze()
 {
-    foreach(MazeNode *item, *listOfRectangles){
-        if(!item->isWall()){
-            item->unsetWall();
-            item->setEntrance(false);
-            item->setVisited(false);
-            item->setExit(false);
-            item->setActive(false);
-
-            if(rectSize > nodeDescriptionThreshold){
-                item->setDescripionToId();
-            }
-        }
-    }
-
-    // Reset entrance and exit
-    setEntranceAndExit();
+    TIMELINE_SCOPE("MazeUi::resetMaze", "scene");
+    nodes->newSearchGeneration();
+    scene->update();
+    replayStates.clear(); // Whatever the replay painted is gone as well
 
     startSearchButton->setEnabled(true);
     log->clear();
@@ -235,17 +511,34 @@ void MazeUi::switchUiState()
     changeGridSize->setEnabled(!changeGridSize->isEnabled());
     gridSizeSelection->setEnabled(!gridSizeSelection->isEnabled());
     searchSelection->setEnabled(!searchSelection->isEnabled());
+    neighbourhoodSelection->setEnabled(!neighbourhoodSelection->isEnabled());
+    storageSelection->setEnabled(!storageSelection->isEnabled());
+    memoryBudgetSelector->setEnabled(!memoryBudgetSelector->isEnabled());
+    deadlineSelector->setEnabled(!deadlineSelector->isEnabled());
+    shardCountSelector->setEnabled(!shardCountSelector->isEnabled());
     clearMazeButton->setEnabled(!clearMazeButton->isEnabled());
+    runModeSelection->setEnabled(!runModeSelection->isEnabled());
+    replaySlider->setEnabled(!replaySlider->isEnabled());
+    replayButton->setEnabled(!replayButton->isEnabled());
+    saveMazeButton->setEnabled(!saveMazeButton->isEnabled());
+    loadMazeButton->setEnabled(!loadMazeButton->isEnabled());
+    importImageButton->setEnabled(!importImageButton->isEnabled());
+    buildLandmarksButton->setEnabled(!buildLandmarksButton->isEnabled());
+    saveCheckpointButton->setEnabled(!saveCheckpointButton->isEnabled());
+    resumeCheckpointButton->setEnabled(!resumeCheckpointButton->isEnabled());
+    raceButton->setEnabled(!raceButton->isEnabled());
+    floorCountSelector->setEnabled(!floorCountSelector->isEnabled());
+    floorSelector->setEnabled(!floorSelector->isEnabled());
+    placeConnectionsButton->setEnabled(!placeConnectionsButton->isEnabled());
+    solveFloorsButton->setEnabled(!solveFloorsButton->isEnabled());
 }
 /**
- * @brief Writes the found path to the log
+ * @brief Writes the found path to the log as runs of moves
  * @param path The path that is to be output to the log
  */
-void MazeUi::fillLogWithPath(QStack<int> *path)
+void MazeUi::fillLogWithPath(const EncodedPath &path)
 {
-    while(!path->isEmpty()){
-        log->append(QString::number(path->pop()));
-    }
+    log->appendLines(path.toTextLines(16));
 }
 /**
  * @brief Sets up the maze solver object
@@ -256,6 +549,9 @@ void MazeUi::initializeMazeSolver()
     int rows = sceneHeight / rectSize;
     solver = new MSolver(listOfIds,rows,columns,tickIntervalSelector->value());
     connect(solver,SIGNAL(displayExit(MazeNode*)),this,SLOT(displayResult(MazeNode*)));
+    connect(solver,SIGNAL(improvedPath(MazeNode*,double,qint64)),this,SLOT(displayImprovedPath(MazeNode*,double,qint64)));
+    connect(solver,SIGNAL(progress(int,int,double)),this,SLOT(updateProgress(int,int,double)));
+    connect(solver,SIGNAL(checkpointSaved(QString,bool,qint64)),this,SLOT(showCheckpointSaved(QString,bool,qint64)));
 
 }
 /**
@@ -283,11 +579,16 @@ void MazeUi::addItemsToScene(){
     int jj = 0;
     int idCounter = 0;
 
+    // All nodes go into one block, which is only reallocated if the grid outgrows it
+    nodes->reserve(rows, columns);
+    listOfRectangles->reserve(rows * columns);
+    listOfIds->reserve(rows * columns);
+
     // Each row and each column
     while(ii < rows){
         while(jj < columns){
             // Gets a new node
-            node = new MazeNode(idCounter,jj*rectSize,ii * rectSize,rectSize);
+            node = nodes->create(jj*rectSize,ii * rectSize,rectSize);
             scene->addItem(node->getRectangle());
 
             // Insert the nodes into the hashtables as well later access
@@ -306,59 +607,202 @@ void MazeUi::addItemsToScene(){
     }
 
     setEntranceAndExit();
+    editor->reset(rows,columns);
+
+    // Every floor has the size of the view, the walls of the others are lost
+    floors->resize(floorCountSelector->value(),rows,columns);
+    shownFloor = floorSelector->value();
+    floorPath.clear();
 }
 
 /**
- * @brief Blanks the entire maze to walkable space
+ * @brief Blanks the entire maze to walkable space. New wall and search generations clear
+ * all nodes at once.
  */
 void MazeUi::clearMaze()
 {
-    foreach(MazeNode *item, *listOfRectangles){
-        item->unsetWall();
-        item->setEntrance(false);
-        item->setVisited(false);
-        item->setExit(false);
-        item->setActive(false);
-
-        if(rectSize > nodeDescriptionThreshold){
-            item->setDescripionToId();
-        }
-    }
-    setEntranceAndExit();
+    nodes->newWallGeneration();
+    nodes->newSearchGeneration();
+    scene->update();
+    // The journal holds changes, which don't undo a cleared maze
+    editor->reset(sceneHeight / rectSize,sceneWidth / rectSize);
+    repaintEdits();
+    replayStates.clear();
     startSearchButton->setEnabled(true);
     log->clear();
 
 }
 
 /**
- * @brief This function handles mouse press events handed down from the mainwindow
+ * @brief Starts an edit with the selected tool. Whether it paints walls or open space follows
+ * from the clicked cell, like a toggle.
  * @param me the mousepressevent
  */
 void MazeUi::mousePressEvent(QMouseEvent *me){
-    QGraphicsItem *current = itemAt(me->pos());
-
-    // Null check
-    if(!current){
+    TIMELINE_SCOPE("MazeUi::mousePressEvent", "ui");
+    int row;
+    int column;
+    // No editing while a search runs on the nodes
+    if(me->button() != Qt::LeftButton || !clearMazeButton->isEnabled() || !cellAt(me->pos(),row,column)){
         return;
     }
 
-    MazeNode *selectedMazeNode = listOfRectangles->value(current);
+    int columns = sceneWidth / rectSize;
+    editor->beginEdit(!listOfIds->value(row * columns + column)->isWall());
+    editStartRow = row;
+    editStartColumn = column;
+    editLastRow = row;
+    editLastColumn = column;
+
+    switch(editToolSelection->currentIndex()){
+    case MazeEditor::Toggle:
+        editor->paintBrush(row,column,0);
+        editor->endEdit();
+        break;
+    case MazeEditor::Brush:
+        editor->paintBrush(row,column,brushRadiusSelector->value());
+        break;
+    case MazeEditor::FloodFill:
+        editor->floodFill(row,column);
+        editor->endEdit();
+        break;
+    default:
+        break; // Lines and rectangles are painted on release
+    }
+    repaintEdits();
+}
 
-    if(selectedMazeNode == 0){
+/**
+ * @brief Paints the brush along the drag, from where it was last painted
+ * @param me the mousemoveevent
+ */
+void MazeUi::mouseMoveEvent(QMouseEvent *me)
+{
+    TIMELINE_SCOPE("MazeUi::mouseMoveEvent", "ui");
+    int row;
+    int column;
+    if(!editor->isEditing() || editToolSelection->currentIndex() != MazeEditor::Brush || !cellAt(me->pos(),row,column)){
+        return;
+    }
+    if(row == editLastRow && column == editLastColumn){
         return;
     }
+    editor->paintLine(editLastRow,editLastColumn,row,column,brushRadiusSelector->value());
+    editLastRow = row;
+    editLastColumn = column;
+    repaintEdits();
+}
 
-    // Sets or unsets the wall at the clicked node
-    if(me->button() == Qt::LeftButton){
-        if(selectedMazeNode->isWall()){
-            selectedMazeNode->unsetWall();
-        }
-        else{
-            selectedMazeNode->setWall();
-        }
+/**
+ * @brief Paints lines and rectangles up to the cell the mouse is released on and finishes the edit
+ * @param me the mousereleaseevent
+ */
+void MazeUi::mouseReleaseEvent(QMouseEvent *me)
+{
+    TIMELINE_SCOPE("MazeUi::mouseReleaseEvent", "ui");
+    if(!editor->isEditing()){
+        return;
+    }
+    int row;
+    int column;
+    if(!cellAt(me->pos(),row,column)){
+        row = editLastRow;
+        column = editLastColumn;
+    }
+
+    if(editToolSelection->currentIndex() == MazeEditor::Line){
+        editor->paintLine(editStartRow,editStartColumn,row,column,brushRadiusSelector->value());
+    }
+    else if(editToolSelection->currentIndex() == MazeEditor::RectangleFill){
+        editor->paintRectangle(qMin(editStartRow,row),qMin(editStartColumn,column),qMax(editStartRow,row),qMax(editStartColumn,column));
+    }
+    editor->endEdit();
+    repaintEdits();
+}
+
+/**
+ * @brief Handles the undo and redo shortcuts
+ * @param ke the keypressevent
+ */
+void MazeUi::keyPressEvent(QKeyEvent *ke)
+{
+    TIMELINE_SCOPE("MazeUi::keyPressEvent", "ui");
+    if(ke->matches(QKeySequence::Undo)){
+        undoEdit();
     }
+    else if(ke->matches(QKeySequence::Redo)){
+        redoEdit();
+    }
+    else{
+        QGraphicsView::keyPressEvent(ke);
+    }
+}
 
+/**
+ * @brief Gets the cell under a point of the view
+ * @param position The point in view coordinates
+ * @param row Set to the row of the cell
+ * @param column Set to the column of the cell
+ * @return False if the point is outside of the maze
+ */
+bool MazeUi::cellAt(const QPoint &position, int &row, int &column)
+{
+    QPointF scenePosition = mapToScene(position);
+    if(scenePosition.x() < 0 || scenePosition.y() < 0){
+        return false;
+    }
+    row = int(scenePosition.y()) / rectSize;
+    column = int(scenePosition.x()) / rectSize;
+    return row < sceneHeight / rectSize && column < sceneWidth / rectSize;
+}
 
+/**
+ * @brief Paints the visible part of the scene
+ * @param event The paint event of the viewport
+ */
+void MazeUi::paintEvent(QPaintEvent *event)
+{
+    TIMELINE_SCOPE("MazeUi::paintEvent", "paint");
+    QGraphicsView::paintEvent(event);
+}
+
+/**
+ * @brief Repaints the cells the editor changed with a single update of the scene, however many
+ * there are, and enables undo and redo as far as the journal allows
+ */
+void MazeUi::repaintEdits()
+{
+    TIMELINE_SCOPE("MazeUi::repaintEdits", "scene");
+    QRect changed = editor->takeDirty();
+    if(!changed.isNull()){
+        scene->update(QRectF(changed.x() * rectSize,changed.y() * rectSize,changed.width() * rectSize,changed.height() * rectSize));
+    }
+    undoButton->setEnabled(editor->canUndo());
+    redoButton->setEnabled(editor->canRedo());
+}
+
+/**
+ * @brief Reverts the last edit
+ */
+void MazeUi::undoEdit()
+{
+    if(!clearMazeButton->isEnabled() || !editor->undo()){
+        return;
+    }
+    log->append("Undid an edit of " + QString::number(editor->getLastChangeCount()) + " cells");
+    repaintEdits();
+}
+
+/**
+ * @brief Applies the last undone edit again
+ */
+void MazeUi::redoEdit()
+{
+    if(!clearMazeButton->isEnabled() || !editor->redo()){
+        return;
+    }
+    log->append("Redid an edit of " + QString::number(editor->getLastChangeCount()) + " cells");
+    repaintEdits();
 }
 
 
@@ -372,33 +816,60 @@ void MazeUi::setNewGridSize()
         return;
     }
     rectSize = rectSizeList[1][gridSizeSelection->currentIndex()];
-    scene->clear();
-
-    foreach(MazeNode *item, *listOfRectangles){
-        delete item;
-    }
 
+    // The nodes take their rectangles off the scene, the arena keeps the memory
+    nodes->clear();
     listOfRectangles->clear();
     listOfIds->clear();
     addItemsToScene();
     startSearchButton->setEnabled(true);
+
+    // The recording belongs to the old grid
+    trace->reset(listOfIds->size());
+    resetReplay();
 }
 
 /**
- * @brief Starts the search algorithm
+ * @brief Switches the UI to searching and hands the solver the maze, the run mode, the trace
+ * and the checkpoint settings
  */
-void MazeUi::startSearch()
+void MazeUi::prepareSearch()
 {
-    log->append("Starting search " + searchSelection->currentText());
-
     switchUiState();
     startSearchButton->setVisible(false);
     stopSearchButton->setVisible(true);
+    progressBar->setValue(0);
+    progressBar->setFormat("%p%");
 
     int columns = sceneWidth / rectSize;
     int rows = sceneHeight / rectSize;
 
     solver->setParameters(listOfIds,rows,columns,tickIntervalSelector->value());
+    solver->setRunMode(MSolver::RunMode(runModeSelection->currentIndex()),expansionsPerTickSelector->value());
+    solver->setCheckpointing(checkpointFileName,checkpointIntervalSelector->value() * 1000);
+
+    // Record the search for replays
+    replayTimer->stop();
+    trace->reset(rows * columns);
+    solver->setTrace(trace);
+    solver->setOpenDirections(nodes->getOpenDirections());
+    stepSearchButton->setVisible(runModeSelection->currentIndex() == MSolver::SingleStep);
+}
+
+/**
+ * @brief Starts the search algorithm
+ */
+void MazeUi::startSearch()
+{
+    log->append("Starting search " + searchSelection->currentText());
+
+    // A maze solved before with the same search is answered right away, unless it's to be stepped through
+    storeResult = setSearchKey();
+    if(storeResult && reuseResultsBox->isChecked() && runModeSelection->currentIndex() != MSolver::SingleStep
+            && showCachedResult()){
+        return;
+    }
+    prepareSearch();
 
     if(searchSelection->currentText() == "DFS"){
         solver->startDFS();
@@ -406,22 +877,98 @@ void MazeUi::startSearch()
     else if(searchSelection->currentText() == "BFS"){
         solver->startBFS();
     }
+    else if(searchSelection->currentText() == "DFS (instant)"){
+        solver->startKernelSearch(MazeKernels::DepthFirst,
+                                  MazeKernels::Connectivity(neighbourhoodSelection->currentIndex()),
+                                  MazeKernels::Storage(storageSelection->currentIndex()));
+    }
+    else if(searchSelection->currentText() == "BFS (instant)"){
+        solver->startKernelSearch(MazeKernels::BreadthFirst,
+                                  MazeKernels::Connectivity(neighbourhoodSelection->currentIndex()),
+                                  MazeKernels::Storage(storageSelection->currentIndex()));
+    }
+    else if(searchSelection->currentText() == "IDA*"){
+        solver->startBoundedSearch(BoundedSearch::IterativeDeepeningAStar,qint64(memoryBudgetSelector->value()) * 1024);
+    }
+    else if(searchSelection->currentText() == "Frontier BFS"){
+        solver->startBoundedSearch(BoundedSearch::FrontierBreadthFirst,qint64(memoryBudgetSelector->value()) * 1024);
+    }
+    else if(searchSelection->currentText() == "Anytime A*"){
+        // Landmarks of an older version of the maze would overestimate
+        const LandmarkTable *table = 0;
+        if(!landmarks->isEmpty()){
+            if(landmarks->matches(sceneHeight / rectSize,sceneWidth / rectSize,collectWalls())){
+                table = landmarks;
+                log->append("Using " + QString::number(landmarks->getLandmarkCount()) + " landmarks");
+            }
+            else{
+                log->append("The landmarks don't match the maze anymore, build them again to use them");
+            }
+        }
+        solver->startAnytimeSearch(deadlineSelector->value(),table);
+    }
+    else if(searchSelection->currentText() == "Rectangle A*"){
+        solver->startRectangleSearch();
+    }
+    else if(searchSelection->currentText() == "Sharded BFS"){
+        solver->startShardedSearch(shardCountSelector->value());
+    }
     else{
         log->append("This algorithm hasn't been implemented yet");
+        storeResult = false;
         switchUiState();
     }
 }
 
+/**
+ * @brief Expands one node of a single step search
+ */
+void MazeUi::stepSearch()
+{
+    solver->step();
+}
+
 /**
  * @brief Stops the search
  */
 void MazeUi::stopSearch()
 {
     stopSearchButton->setVisible(false);
+    stepSearchButton->setVisible(false);
     startSearchButton->setVisible(true);
+    storeResult = false; // A stopped search hasn't found out whether there is a path
     solver->triggerStopSearch();
 }
 
+/**
+ * @brief Shows the progress of the running search
+ * @param expanded The number of nodes expanded so far
+ * @param frontierSize The number of nodes waiting on the frontier
+ * @param fraction The estimated fraction of the reachable maze that has been searched
+ */
+void MazeUi::updateProgress(int expanded, int frontierSize, double fraction)
+{
+    TIMELINE_SCOPE("MazeUi::updateProgress", "ui");
+    progressBar->setValue(int(fraction * 1000));
+    progressBar->setFormat(QString("%p% (%1 expanded, %2 queued)").arg(expanded).arg(frontierSize));
+}
+
+/**
+ * @brief Logs a better path found by the anytime search while it keeps refining
+ * @param lastNode The exit, linked back to the entrance
+ * @param bound The path is at most this many times longer than the shortest one
+ * @param elapsedUs Microseconds since the search was started
+ */
+void MazeUi::displayImprovedPath(MazeNode *lastNode, double bound, qint64 elapsedUs)
+{
+    int lengthOfPath = 0;
+    for(MazeNode *node = lastNode; node != 0; node = node->getPreviousNode()){
+        lengthOfPath++;
+    }
+    log->append("Path of length " + QString::number(lengthOfPath) + " within " + QString::number(bound,'f',3)
+                + " of the shortest after " + QString::number(elapsedUs) + " us");
+}
+
 /**
  * @brief Traces back a path from the exit (if it exists)
  * @param lastNode the last node that has been visited (the exit)
@@ -430,9 +977,12 @@ void MazeUi::stopSearch()
  */
 int MazeUi::tracePath(MazeNode* lastNode,QStack<int> *nodeStack)
 {
+    TIMELINE_SCOPE("MazeUi::tracePath", "scene");
+    // A broken checkpoint may link the nodes in a cycle, no path is longer than the maze
     int counter = 0;
-    while(lastNode != 0){
+    while(lastNode != 0 && counter < listOfIds->size()){
         lastNode->tracePath();
+        trace->record(lastNode->getId(), SearchTrace::Path);
         nodeStack->push(lastNode->getId());
         lastNode = lastNode->getPreviousNode();
         counter++;
@@ -448,14 +998,15 @@ int MazeUi::tracePath(MazeNode* lastNode,QStack<int> *nodeStack)
 void MazeUi::createRandomMaze()
 {
     clearMaze();
-    foreach(MazeNode *item, *listOfRectangles){
-        if(!item->isEntrance() || !item->isExit() ){
-            int isWallDecider = qrand() % 3; // Pseudorandom remainder decides if it's a wall or not
-            if(isWallDecider >= 2){
-                item->setWall();
-            }
-        }
+    QBitArray walls(listOfIds->size());
+    for(int id = 0; id < walls.size(); id++){
+        int isWallDecider = qrand() % 3; // Pseudorandom remainder decides if it's a wall or not
+        walls.setBit(id, isWallDecider >= 2);
     }
+
+    // The arena keeps the entrance and the exit open
+    nodes->assignAllWalls(walls);
+    scene->update();
     log->append("Created random maze");
 }
 
@@ -465,24 +1016,849 @@ void MazeUi::createRandomMaze()
  */
 void MazeUi::displayResult(MazeNode *lastNode)
 {
+    TIMELINE_SCOPE("MazeUi::displayResult", "ui");
     // First trace the path, then fill the log window
     if(lastNode != 0){
         QStack<int> *path = new QStack<int>;
         int lengthOfPath = tracePath(lastNode,path);
-        fillLogWithPath(path);
+        QVector<int> ids;
+        ids.reserve(path->size());
+        while(!path->isEmpty()){
+            ids.append(path->pop());
+        }
+        EncodedPath::fromIds(ids,sceneWidth / rectSize,lastPath);
+        fillLogWithPath(lastPath);
         log->append("Length of the path: " + QString::number(lengthOfPath));
         log->append("Seconds elapsed: " + QString::number(solver->getTimeElapsed() / 1000.0,'f',3));
+        if(solver->getNodesExpanded() > 0){
+            log->append("Nodes expanded: " + QString::number(solver->getNodesExpanded()));
+        }
         delete path;
     }
     else{
+        lastPath = EncodedPath();
         log->append("No path to the exit found");
     }
 
+    // The bounded searches also report how much of their budget they used
+    if(searchSelection->currentText() == "IDA*" || searchSelection->currentText() == "Frontier BFS"){
+        BoundedSearch::Result bounded = solver->getBoundedResult();
+        if(bounded.budgetExceeded){
+            log->append("The search needs more than the memory budget");
+        }
+        log->append("Peak memory: " + QString::number(bounded.peakBytes / 1024.0,'f',1) + " of "
+                    + QString::number(bounded.budgetBytes / 1024) + " KiB");
+        log->append((searchSelection->currentText() == "IDA*" ? "Iterations: " : "Subproblems: ")
+                    + QString::number(bounded.iterations));
+    }
+    else if(searchSelection->currentText() == "Anytime A*"){
+        AnytimeSearch::Result anytime = solver->getAnytimeResult();
+        if(anytime.found){
+            log->append(anytime.optimal ? QString("The path is a shortest one")
+                                        : "The path is at most " + QString::number(anytime.bound,'f',3) + " times the shortest");
+        }
+        if(anytime.deadlineReached){
+            log->append("The deadline of " + QString::number(deadlineSelector->value()) + " us stopped the search after "
+                        + QString::number(anytime.elapsedUs) + " us");
+        }
+        log->append("Improvements: " + QString::number(anytime.solutions));
+    }
+    else if(searchSelection->currentText() == "Rectangle A*"){
+        RectangleSearch::Result rectangle = solver->getRectangleResult();
+        log->append("Empty rectangles: " + QString::number(rectangle.rectangles) + ", the largest has "
+                    + QString::number(rectangle.largestRectangle) + " cells");
+        log->append("Found the rectangles in " + QString::number(rectangle.buildUs / 1000.0,'f',3) + " ms");
+    }
+    else if(searchSelection->currentText() == "Sharded BFS"){
+        ShardedSearch::Result sharded = solver->getShardedResult();
+        if(sharded.failed){
+            log->append("The sharded search failed: " + sharded.error);
+            storeResult = false;
+        }
+        log->append("Levels: " + QString::number(sharded.levels) + " over " + QString::number(sharded.bands) + " worker processes");
+        if(sharded.restarts > 0){
+            log->append("Restarted workers: " + QString::number(sharded.restarts));
+        }
+    }
+
+    if(storeResult){
+        SolveCache::Result result;
+        result.found = lastNode != 0;
+        result.path = result.found ? lastPath.toBinary() : QByteArray();
+        result.expanded = solver->getNodesExpanded();
+        result.solveUs = solver->getTimeElapsed() * 1000;
+        solveCache->insert(searchKey,result);
+        storeResult = false;
+    }
+
     // Switch the UI to disable searching until the maze is reset
     switchUiState();
     startSearchButton->setEnabled(false);
     startSearchButton->setVisible(true);
     stopSearchButton->setVisible(false);
+    stepSearchButton->setVisible(false);
+
+    log->append("Recorded " + QString::number(trace->getEventCount()) + " events in "
+                + QString::number(trace->getByteSize()) + " bytes");
+    resetReplay();
+}
+
+/**
+ * @brief Forgets what the replay has painted and sets the timeline to the end of the trace
+ */
+void MazeUi::resetReplay()
+{
+    replayTimer->stop();
+    replayButton->setText("Play Replay");
+    replayStates.clear();
+    replaySlider->blockSignals(true);
+    replaySlider->setRange(0,trace->getEventCount());
+    replaySlider->setValue(trace->getEventCount());
+    replaySlider->blockSignals(false);
+}
+
+/**
+ * @brief Paints the recorded search as it was after the given number of events. Moving forward
+ * decodes from the current position, anything else seeks from the closest keyframe.
+ * Only cells whose state differs from what is painted get a new brush.
+ * @param frame The number of events to show
+ */
+void MazeUi::showReplayFrame(int frame)
+{
+    TIMELINE_SCOPE("MazeUi::showReplayFrame", "scene");
+    if(trace->getCellCount() != listOfIds->size()){
+        return;
+    }
+
+    QByteArray states;
+    if(replayStates.size() == trace->getCellCount() && frame >= replayCursor.frame){
+        states = replayStates;
+        trace->advance(replayCursor,states,frame);
+    }
+    else{
+        replayCursor = trace->seek(frame,states);
+    }
+
+    // Nothing is painted yet after a search, so every cell differs
+    bool repaintAll = replayStates.size() != states.size();
+    for(int ii = 0; ii < states.size(); ii++){
+        if(repaintAll || states.at(ii) != replayStates.at(ii)){
+            listOfIds->value(ii)->showTraceState(states.at(ii));
+        }
+    }
+    replayStates = states;
+}
+
+/**
+ * @brief Starts or pauses the replay. A finished replay starts over from the beginning.
+ */
+void MazeUi::toggleReplay()
+{
+    if(replayTimer->isActive()){
+        replayTimer->stop();
+        replayButton->setText("Play Replay");
+        return;
+    }
+
+    if(replaySlider->value() >= replaySlider->maximum()){
+        replaySlider->setValue(0);
+    }
+    replayTimer->start(tickIntervalSelector->value());
+    replayButton->setText("Pause Replay");
+}
+
+/**
+ * @brief Moves the replay forward by the selected number of events
+ */
+void MazeUi::replayTick()
+{
+    replaySlider->setValue(replaySlider->value() + replaySpeedSelector->value());
+    if(replaySlider->value() >= replaySlider->maximum()){
+        replayTimer->stop();
+        replayButton->setText("Play Replay");
+    }
+}
+
+/**
+ * @brief Collects the walls of the current maze
+ * @return One bit per node id, set for walls
+ */
+QBitArray MazeUi::collectWalls()
+{
+    QBitArray walls(listOfIds->size());
+    foreach(MazeNode *node, *listOfIds){
+        if(node->isWall()){
+            walls.setBit(node->getId());
+        }
+    }
+    return walls;
+}
+
+/**
+ * @brief Saves the maze and the recording of the last search to a file
+ */
+void MazeUi::saveMaze()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,"Save Maze","","Mazes (*.maze)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    int columns = sceneWidth / rectSize;
+    int rows = sceneHeight / rectSize;
+    QBitArray walls = collectWalls();
+    if(MazeFile::save(fileName,rows,columns,walls,*trace)){
+        log->append("Saved maze to " + fileName);
+        if(landmarks->matches(rows,columns,walls)){
+            QString tableName = LandmarkTable::tableFileName(fileName);
+            log->append(landmarks->save(tableName) ? "Saved the landmarks to " + tableName
+                                                   : "Could not save the landmarks to " + tableName);
+        }
+    }
+    else{
+        log->append("Could not save the maze to " + fileName);
+    }
+}
+
+/**
+ * @brief Writes the last path to a file, as text or in the binary form for *.mpath files
+ */
+void MazeUi::exportPath()
+{
+    if(lastPath.isEmpty()){
+        log->append("There is no path to export");
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this,"Export Path","","Path text (*.txt);;Binary path (*.mpath)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    QFile file(fileName);
+    bool binary = fileName.endsWith(".mpath");
+    QByteArray data = binary ? lastPath.toBinary() : lastPath.toText().toLatin1();
+    if(file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size()){
+        log->append("Exported " + QString::number(lastPath.getRuns().size()) + " runs to " + fileName);
+    }
+    else{
+        log->append("Could not export the path to " + fileName);
+    }
+}
+
+/**
+ * @brief Puts the last path on the clipboard, as text and in the binary form
+ */
+void MazeUi::copyPath()
+{
+    if(lastPath.isEmpty()){
+        log->append("There is no path to copy");
+        return;
+    }
+    QMimeData *mimeData = new QMimeData();
+    mimeData->setText(lastPath.toText());
+    mimeData->setData(EncodedPath::mimeType,lastPath.toBinary());
+    QApplication::clipboard()->setMimeData(mimeData);
+    log->append("Copied " + QString::number(lastPath.getRuns().size()) + " runs to the clipboard");
+}
+
+#ifdef MAZESOLVER_TIMELINE
+/**
+ * @brief Writes the timeline events recorded so far as a Chrome trace and starts a new timeline
+ */
+void MazeUi::exportTimeline()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,"Export Timeline","timeline.json","Chrome trace (*.json)");
+    if(fileName.isEmpty()){
+        return;
+    }
+    int events = TimelineTrace::exportJson(fileName);
+    if(events < 0){
+        log->append("Could not export the timeline to " + fileName);
+        return;
+    }
+    TimelineTrace::clear();
+    log->append("Exported " + QString::number(events) + " timeline events to " + fileName
+                + ", open it in chrome://tracing or Perfetto");
+}
+#endif
+
+/**
+ * @brief Loads a maze and the recording of its last search from a file. The grid size
+ * switches to the one of the file.
+ */
+void MazeUi::loadMaze()
+{
+    // The anytime racer may be reading the landmarks
+    if(raceWindow != 0 && raceWindow->isRacing()){
+        log->append("Wait for the race to finish before changing the landmarks");
+        return;
+    }
+    QString fileName = QFileDialog::getOpenFileName(this,"Load Maze","","Mazes (*.maze)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    int rows;
+    int columns;
+    QBitArray walls;
+    SearchTrace loadedTrace;
+    if(!MazeFile::load(fileName,rows,columns,walls,loadedTrace)){
+        log->append("Could not load a maze from " + fileName);
+        return;
+    }
+
+    if(!showWalls(rows,columns,walls)){
+        return;
+    }
+
+    *trace = loadedTrace;
+    resetReplay();
+    log->append("Loaded maze from " + fileName);
+    if(!trace->isEmpty()){
+        log->append("The maze has a recorded search of " + QString::number(trace->getEventCount()) + " events");
+    }
+
+    // Landmarks saved next to the maze are mapped, not read
+    if(landmarks->load(LandmarkTable::tableFileName(fileName))){
+        if(landmarks->matches(rows,columns,walls)){
+            log->append("Mapped " + QString::number(landmarks->getLandmarkCount()) + " landmarks ("
+                        + QString::number(landmarks->getByteSize() / 1024) + " KiB)");
+        }
+        else{
+            landmarks->clear();
+            log->append("The saved landmarks belong to another maze");
+        }
+    }
+    else{
+        landmarks->clear();
+    }
+}
+
+/**
+ * @brief Writes the state of the running DFS or BFS to a file. Timed checkpoints go to the
+ * same file from then on.
+ */
+void MazeUi::saveCheckpoint()
+{
+    if(searchSelection->currentText() != "DFS" && searchSelection->currentText() != "BFS"){
+        log->append("Only DFS and BFS searches can be checkpointed");
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this,"Save Checkpoint",checkpointFileName,"Checkpoints (*.checkpoint)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    checkpointFileName = fileName;
+    solver->setCheckpointing(checkpointFileName,checkpointIntervalSelector->value() * 1000);
+    if(!solver->saveCheckpoint(fileName)){
+        log->append("The search has ended or is still writing its last checkpoint");
+    }
+}
+
+/**
+ * @brief Loads a checkpoint, switches to its maze and carries on with its search
+ */
+void MazeUi::resumeCheckpoint()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,"Resume Checkpoint",checkpointFileName,"Checkpoints (*.checkpoint)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    SearchCheckpoint checkpoint;
+    if(!checkpoint.load(fileName)){
+        log->append("Could not load a checkpoint from " + fileName);
+        return;
+    }
+    // Switches to the grid size of the checkpoint, which is what resuming needs
+    if(!showWalls(checkpoint.rows,checkpoint.columns,checkpoint.walls)){
+        return;
+    }
+
+    checkpointFileName = fileName;
+    searchSelection->setCurrentIndex(searchSelection->findText(checkpoint.mode == SearchStepper::DepthFirst ? "DFS" : "BFS"));
+    storeResult = setSearchKey();
+    log->append("Resuming search " + searchSelection->currentText() + " after " + QString::number(checkpoint.expandedCount)
+                + " expansions with " + QString::number(checkpoint.getFrontierSize()) + " nodes queued");
+    prepareSearch();
+    if(!solver->resumeSearch(checkpoint)){
+        log->append("The checkpoint doesn't fit the maze");
+        storeResult = false;
+        switchUiState();
+        startSearchButton->setVisible(true);
+        stopSearchButton->setVisible(false);
+        stepSearchButton->setVisible(false);
+    }
 }
 
+/**
+ * @brief Logs a checkpoint written by the solver
+ * @param fileName The file it was written to
+ * @param saved False if writing failed
+ * @param captureUs Microseconds taking the state took, without the copies of the planes the
+ * next step makes
+ */
+void MazeUi::showCheckpointSaved(QString fileName, bool saved, qint64 captureUs)
+{
+    if(saved){
+        // The planes are copied by the next step that writes to them, which isn't counted here
+        log->append("Saved a checkpoint to " + fileName + ", taking the state took " + QString::number(captureUs)
+                    + " us, the next step also copies the planes it writes to");
+    }
+    else{
+        log->append("Could not save a checkpoint to " + fileName);
+    }
+}
+
+/**
+ * @brief Switches to the grid size of a maze and sets its walls
+ * @param rows Number of rows in the maze
+ * @param columns Number of columns in the maze
+ * @param walls One bit per node id, set for walls
+ * @return False if none of the grid sizes fits the maze
+ */
+bool MazeUi::showWalls(int rows, int columns, const QBitArray &walls)
+{
+    int sizeIndex = -1;
+    for(int ii = 0; ii < gridSizeSelection->count(); ii++){
+        if(sceneWidth / rectSizeList[1][ii] == columns && sceneHeight / rectSizeList[1][ii] == rows){
+            sizeIndex = ii;
+        }
+    }
+    if(sizeIndex < 0){
+        log->append("The maze has a grid size of " + QString::number(columns) + "x"
+                    + QString::number(rows) + " which isn't available");
+        return false;
+    }
+
+    gridSizeSelection->setCurrentIndex(sizeIndex);
+    setNewGridSize();
+    clearMaze();
+    nodes->assignAllWalls(walls);
+    scene->update();
+    return true;
+}
+
+/**
+ * @brief Imports the walls of a maze from an image with the selected threshold
+ */
+void MazeUi::importImage()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,"Import Image","","Images (*.png *.pbm *.pgm *.ppm *.bmp)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    MazeGrid grid;
+    MazeImage::Markers markers;
+    QString error;
+    QElapsedTimer clock;
+    clock.start();
+    if(!MazeImage::load(fileName,imageThresholdSelector->value(),grid,markers,error)){
+        log->append(error);
+        return;
+    }
+    qint64 importMs = clock.elapsed();
+    if(!showWalls(grid.getRows(),grid.getColumns(),grid.getWalls())){
+        return;
+    }
+
+    trace->reset(grid.getCellCount());
+    resetReplay();
+    log->append("Imported " + fileName + " in " + QString::number(importMs) + " ms");
+
+    // The view keeps its entrance and exit in the corners
+    if(markers.entrance >= 0 && markers.entrance != 0){
+        log->append("The image marks the entrance at " + QString::number(markers.entrance) + ", the search starts at 0");
+    }
+    if(markers.exit >= 0 && markers.exit != grid.getCellCount() - 1){
+        log->append("The image marks the exit at " + QString::number(markers.exit) + ", the search ends at "
+                    + QString::number(grid.getCellCount() - 1));
+    }
+}
+
+/**
+ * @brief Picks landmarks on the current maze and measures their distances to all cells
+ */
+void MazeUi::buildLandmarks()
+{
+    // The anytime racer may be reading the landmarks
+    if(raceWindow != 0 && raceWindow->isRacing()){
+        log->append("Wait for the race to finish before changing the landmarks");
+        return;
+    }
+    int columns = sceneWidth / rectSize;
+    int rows = sceneHeight / rectSize;
+    MazeGrid grid(rows,columns);
+    grid.setWalls(collectWalls());
+
+    QElapsedTimer clock;
+    clock.start();
+    if(landmarks->build(grid,landmarkCountSelector->value())){
+        log->append("Built " + QString::number(landmarks->getLandmarkCount()) + " landmarks ("
+                    + QString::number(landmarks->getByteSize() / 1024) + " KiB) in "
+                    + QString::number(clock.elapsed()) + " ms");
+    }
+    else{
+        log->append("There are no open cells for landmarks");
+    }
+}
+
+/**
+ * @brief Answers the selected number of path queries between random open cells of the
+ * current maze on all cores
+ */
+void MazeUi::runBatchQueries()
+{
+    int columns = sceneWidth / rectSize;
+    int rows = sceneHeight / rectSize;
+    batchGrid->resize(rows,columns);
+    batchGrid->setWalls(collectWalls());
+
+    QVector<int> openCells;
+    for(int ii = 0; ii < rows * columns; ii++){
+        if(!batchGrid->isWall(batchGrid->indexOfId(ii))){
+            openCells.append(ii);
+        }
+    }
+    if(openCells.isEmpty()){
+        log->append("There are no open cells to query");
+        return;
+    }
 
+    QVector<PathQuery> queries;
+    for(int ii = 0; ii < batchQuerySelector->value(); ii++){
+        queries.append(PathQuery(openCells.at(qrand() % openCells.size()),openCells.at(qrand() % openCells.size())));
+    }
+
+    log->append("Answering " + QString::number(queries.size()) + " path queries");
+    batchQueryButton->setEnabled(false);
+    batchClock.start();
+    BatchSolver batchSolver(batchGrid);
+    batchWatcher->setFuture(batchSolver.start(queries));
+}
+
+/**
+ * @brief Writes the throughput of the finished batch to the log
+ */
+void MazeUi::finishBatchQueries()
+{
+    double seconds = qMax(batchClock.nsecsElapsed() / 1e9, 1e-6);
+    int answered = batchWatcher->future().resultCount();
+    int found = 0;
+    qint64 totalLength = 0;
+    for(int ii = 0; ii < answered; ii++){
+        PathAnswer answer = batchWatcher->resultAt(ii);
+        if(answer.found){
+            found++;
+            totalLength += answer.path.size();
+        }
+    }
+
+    log->append("Answered " + QString::number(answered) + " queries in "
+                + QString::number(seconds,'f',3) + " seconds ("
+                + QString::number(answered / seconds,'f',0) + " per second)");
+    log->append(QString::number(found) + " queries have a path"
+                + (found > 0 ? ", " + QString::number(double(totalLength) / found,'f',1) + " nodes long on average" : QString()));
+    batchQueryButton->setEnabled(true);
+}
+
+/**
+ * @brief Races all solvers on a copy of the current maze with the options selected for them,
+ * from the entrance to the exit, and logs their places once all are done
+ */
+void MazeUi::startRace()
+{
+    if(raceWindow == 0){
+        raceWindow = new RaceWindow(this);
+        connect(raceWindow,SIGNAL(raceFinished(QStringList)),log,SLOT(appendLines(QStringList)));
+    }
+    if(raceWindow->isRacing()){
+        raceWindow->raise();
+        return;
+    }
+
+    int columns = sceneWidth / rectSize;
+    int rows = sceneHeight / rectSize;
+    MazeGrid grid(rows,columns);
+    grid.setWalls(collectWalls());
+
+    SolverRace::Settings settings;
+    settings.storage = MazeKernels::Storage(storageSelection->currentIndex());
+    settings.budgetBytes = qint64(memoryBudgetSelector->value()) * 1024;
+    settings.deadlineUs = deadlineSelector->value();
+    settings.bands = shardCountSelector->value();
+    settings.landmarks = !landmarks->isEmpty() && landmarks->matches(rows,columns,grid.getWalls()) ? landmarks : 0;
+
+    log->append("Racing all solvers on the " + QString::number(rows) + "x" + QString::number(columns) + " maze");
+    raceWindow->startRace(grid,0,rows * columns - 1,settings);
+    raceWindow->show();
+    raceWindow->raise();
+}
+
+/**
+ * @brief Computes the figures of a copy of the current maze on a worker thread, from the
+ * entrance to the exit
+ */
+void MazeUi::analyzeMaze()
+{
+    int columns = sceneWidth / rectSize;
+    int rows = sceneHeight / rectSize;
+    MazeGrid grid(rows,columns);
+    grid.setWalls(collectWalls());
+
+    analyzeButton->setEnabled(false);
+    analyticsWatcher->setFuture(QtConcurrent::run(MazeAnalytics::analyze,grid,0,rows * columns - 1));
+}
+
+/**
+ * @brief Writes the figures of the finished analysis to the log
+ */
+void MazeUi::finishAnalysis()
+{
+    log->appendLines(MazeAnalytics::describe(analyticsWatcher->result()));
+    analyzeButton->setEnabled(true);
+}
+
+/**
+ * @brief Changes the number of floors. The walls of the floors that remain are kept, the stairs
+ * and portals are removed. If the shown floor goes, the top floor is shown instead.
+ * @param count The new number of floors
+ */
+void MazeUi::setFloorCount(int count)
+{
+    floors->setLayerWalls(shownFloor,collectWalls());
+    QVector<QBitArray> kept;
+    for(int layer = 0; layer < qMin(count,floors->getLayers()); layer++){
+        kept.append(floors->getLayerWalls(layer));
+    }
+    floors->resize(count,floors->getRows(),floors->getColumns());
+    for(int layer = 0; layer < kept.size(); layer++){
+        floors->setLayerWalls(layer,kept.at(layer));
+    }
+    floorPath.clear();
+
+    // Shows the top floor through showFloor if the shown one is gone
+    floorSelector->setMaximum(count - 1);
+    nodes->newSearchGeneration();
+    paintFloor();
+}
+
+/**
+ * @brief Puts a floor into the maze view. The walls on screen go back to the floor they
+ * belong to first, so edits are kept. The undo journal and the recorded search belong to the
+ * floor that was shown and are dropped.
+ * @param floor The floor to show
+ */
+void MazeUi::showFloor(int floor)
+{
+    if(floor == shownFloor || floor < 0 || floor >= floors->getLayers()){
+        return;
+    }
+    floors->setLayerWalls(shownFloor,collectWalls());
+    shownFloor = floor;
+
+    nodes->newWallGeneration();
+    nodes->newSearchGeneration();
+    nodes->assignAllWalls(floors->getLayerWalls(floor));
+    editor->reset(sceneHeight / rectSize,sceneWidth / rectSize);
+    repaintEdits();
+    trace->reset(listOfIds->size());
+    resetReplay();
+    paintFloor();
+}
+
+/**
+ * @brief Marks the cells with stairs or a portal as active and the cells of the last path over
+ * the floors as path, on the shown floor only
+ */
+void MazeUi::paintFloor()
+{
+    int first = shownFloor * floors->getLayerSize();
+    for(int id = 0; id < floors->getLayerSize(); id++){
+        int cell = first + id;
+        if(floors->hasStairUp(cell) || floors->hasStairDown(cell) || floors->portalOf(cell) >= 0){
+            listOfIds->value(id)->showTraceState(1);
+        }
+    }
+    foreach(int cell, floorPath){
+        if(floors->layerOf(cell) == shownFloor){
+            listOfIds->value(cell - first)->showTraceState(3);
+        }
+    }
+    scene->update();
+}
+
+/**
+ * @brief Replaces the stairs and portals with the selected numbers of random ones between open
+ * cells, on the walls of all floors as they are now
+ */
+void MazeUi::placeFloorConnections()
+{
+    floors->setLayerWalls(shownFloor,collectWalls());
+    floors->placeConnections(stairCountSelector->value(),portalCountSelector->value(),quint32(qrand()));
+    floorPath.clear();
+    nodes->newSearchGeneration();
+    paintFloor();
+    log->append("Placed " + QString::number(floors->getStairCount()) + " stairs and "
+                + QString::number(floors->getPortalCount()) + " portals over "
+                + QString::number(floors->getLayers()) + " floors");
+}
+
+/**
+ * @brief Searches all floors with the selected search, from the entrance on the bottom floor to
+ * the exit on the top floor, and shows the path on the shown floor. The floors of the view
+ * sizes are small enough to be searched right away.
+ */
+void MazeUi::solveFloors()
+{
+    floors->setLayerWalls(shownFloor,collectWalls());
+    LayeredMaze::Result result = floors->search(0,floors->getCellCount() - 1,
+                                                LayeredMaze::Algorithm(floorSearchSelection->currentIndex()));
+    floorPath = result.path;
+    nodes->newSearchGeneration();
+    paintFloor();
+
+    QString summary = "Searched " + QString::number(floors->getLayers()) + " floors with "
+                      + floorSearchSelection->currentText() + ": ";
+    if(!result.found){
+        log->append(summary + "no path, " + QString::number(result.expanded) + " cells expanded");
+        return;
+    }
+    log->append(summary + "path of " + QString::number(result.path.size()) + " cells over "
+                + QString::number(result.floorChanges) + " floor changes, "
+                + QString::number(result.expanded) + " cells expanded in "
+                + QString::number(result.elapsedUs) + " us");
+    QStringList perFloor;
+    QVector<int> cellsPerFloor(floors->getLayers(),0);
+    foreach(int cell, result.path){
+        cellsPerFloor[floors->layerOf(cell)]++;
+    }
+    for(int layer = 0; layer < cellsPerFloor.size(); layer++){
+        perFloor.append("Floor " + QString::number(layer) + ": " + QString::number(cellsPerFloor.at(layer)) + " cells");
+    }
+    log->appendLines(perFloor);
+}
+
+/**
+ * @brief Sets the cache key of the selected search on the maze on screen. The options that
+ * change the path of a search are part of the key.
+ * @return False for the anytime search, whose path depends on the deadline and the machine
+ */
+bool MazeUi::setSearchKey()
+{
+    QString algorithm = searchSelection->currentText();
+    if(algorithm == "Anytime A*"){
+        return false;
+    }
+    if(algorithm.endsWith("(instant)")){
+        algorithm += ", " + neighbourhoodSelection->currentText() + ", " + storageSelection->currentText();
+    }
+    else if(algorithm == "IDA*" || algorithm == "Frontier BFS"){
+        algorithm += ", " + QString::number(memoryBudgetSelector->value()) + " KiB";
+    }
+    else if(algorithm == "Sharded BFS"){
+        algorithm += ", " + QString::number(shardCountSelector->value()) + " workers";
+    }
+
+    // The table keeps the hash up to date on every wall change
+    searchKey.wallHash = nodes->getOpenDirections()->getWallHash();
+    searchKey.rows = sceneHeight / rectSize;
+    searchKey.columns = sceneWidth / rectSize;
+    searchKey.entrance = 0;
+    searchKey.exit = listOfIds->size() - 1;
+    searchKey.algorithm = algorithm;
+    return true;
+}
+
+/**
+ * @brief Checks that a cached path leads from the entrance of the search key to its exit
+ * through neighbouring cells of the current grid
+ * @param path The decoded path
+ * @param ids Receives the node ids of the path
+ * @return False if the path doesn't fit the grid
+ */
+bool MazeUi::isValidCachedPath(const EncodedPath &path, QVector<int> &ids) const
+{
+    int columns = searchKey.columns;
+    int cells = listOfIds->size();
+    if(path.isEmpty() || path.getColumns() != columns || path.getCellCount() > cells){
+        return false;
+    }
+    ids = path.toIds();
+    if(ids.first() != searchKey.entrance || ids.last() != searchKey.exit){
+        return false;
+    }
+    for(int ii = 0; ii < ids.size(); ii++){
+        int id = ids.at(ii);
+        if(id < 0 || id >= cells){
+            return false;
+        }
+        if(ii > 0){
+            // A step of one column has to stay in the row, it would wrap around the edge otherwise
+            int previous = ids.at(ii - 1);
+            bool vertical = qAbs(id - previous) == columns;
+            bool horizontal = qAbs(id - previous) == 1 && id / columns == previous / columns;
+            if(!vertical && !horizontal){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Paints and logs the cached result of the search key as a finished search would, and
+ * records the path for the replay. A result whose path doesn't fit the maze is dropped from the
+ * cache so the search runs again.
+ * @return False if the cache has no usable result for the key
+ */
+bool MazeUi::showCachedResult()
+{
+    QElapsedTimer clock;
+    clock.start();
+    SolveCache::Result result;
+    EncodedPath path;
+    QVector<int> ids;
+    if(!solveCache->lookup(searchKey,result)){
+        return false;
+    }
+    if(result.found && (!EncodedPath::fromBinary(result.path,path) || !isValidCachedPath(path,ids))){
+        solveCache->remove(searchKey);
+        log->append("Dropped a cached result that doesn't fit the maze");
+        return false;
+    }
+    qint64 lookupUs = clock.nsecsElapsed() / 1000;
+
+    trace->reset(listOfIds->size());
+    lastPath = path;
+    if(result.found){
+        foreach(int id, ids){
+            listOfIds->value(id)->tracePath();
+            trace->record(id, SearchTrace::Path);
+        }
+        fillLogWithPath(lastPath);
+        log->append("Length of the path: " + QString::number(ids.size()));
+    }
+    else{
+        log->append("No path to the exit found");
+    }
+    log->append("Answered from the result cache in " + QString::number(lookupUs) + " us, the search took "
+                + QString::number(result.solveUs / 1e6,'f',3) + " s and expanded " + QString::number(result.expanded) + " nodes");
+
+    storeResult = false;
+    startSearchButton->setEnabled(false);
+    resetReplay();
+    return true;
+}
+
+/**
+ * @brief Forgets the results of all earlier searches, in memory and in the cache directory
+ */
+void MazeUi::clearResultCache()
+{
+    int results = qMax(solveCache->getDiskEntries(),solveCache->getMemoryEntries());
+    solveCache->clear();
+    log->append("Removed " + QString::number(results) + " cached results");
+}
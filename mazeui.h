@@ -15,11 +15,26 @@
 #include <QPushButton>
 #include <QElapsedTimer>
 #include <QGroupBox>
-#include <QTextBrowser>
 #include <QSpinBox>
+#include <QProgressBar>
+#include <QSlider>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QCheckBox>
 
 #include "mazenode.h"
+#include "mazenodearena.h"
 #include "msolver.h"
+#include "batchsolver.h"
+#include "searchtrace.h"
+#include "encodedpath.h"
+#include "logview.h"
+#include "landmarktable.h"
+#include "mazeeditor.h"
+#include "racewindow.h"
+#include "mazeanalytics.h"
+#include "layeredmaze.h"
+#include "solvecache.h"
 
 /**
  * @brief This class sets up the user interface for the maze
@@ -31,12 +46,18 @@ public:
     explicit MazeUi(QWidget* parent = 0);
 public slots:
     void mousePressEvent(QMouseEvent *me);
+    void mouseMoveEvent(QMouseEvent *me);
+    void mouseReleaseEvent(QMouseEvent *me);
+    void keyPressEvent(QKeyEvent *ke);
+
+protected:
+    void paintEvent(QPaintEvent *event); ///< Paints the scene, a span of its own on the timeline
 
 
 private:
     // UI related objects
     QWidget* currentTab; ///< Currently selected tab
-    QTextBrowser *log; ///< Log display
+    LogView *log; ///< Log display
     QGridLayout *mazeTabLayout; ///< Layout that holds maze, log and  buttons
     QGraphicsScene *scene; ///< The graphics scene which is being painted on
 
@@ -46,12 +67,73 @@ private:
     QPushButton *startSearchButton;
     QPushButton *clearMazeButton;
     QPushButton *stopSearchButton;
+    QPushButton *stepSearchButton; ///< Expands one node in single step mode
+    QPushButton *saveMazeButton;
+    QPushButton *loadMazeButton;
+    QPushButton *importImageButton;
+    QSpinBox *imageThresholdSelector; ///< Grey level below which imported pixels are walls
+    QPushButton *saveCheckpointButton; ///< Writes the state of the running DFS or BFS
+    QPushButton *resumeCheckpointButton;
+    QSpinBox *checkpointIntervalSelector; ///< Seconds between checkpoints of a DFS or BFS, 0 for none
+    QString checkpointFileName; ///< Where the timed checkpoints go, the last file saved to
+    QPushButton *replayButton; ///< Plays or pauses the replay of the last search
+    QPushButton *undoButton;
+    QPushButton *redoButton;
+    QPushButton *raceButton; ///< Races all solvers on the current maze
+    RaceWindow *raceWindow; ///< Shows the race, created on the first one
 
+    QProgressBar *progressBar; ///< Shows the progress of the running search
     QComboBox *gridSizeSelection; ///< Selector for the grid size
     QSpinBox *tickIntervalSelector;
+    QComboBox *runModeSelection; ///< Selector for animated, single step or full speed searches
+    QSpinBox *expansionsPerTickSelector;
+    QSlider *replaySlider; ///< Timeline of the recorded search, one position per event
+    QSpinBox *replaySpeedSelector; ///< Events per replay tick
+    QTimer *replayTimer;
+    SearchTrace *trace; ///< The recording of the last search
+    SearchTrace::Cursor replayCursor; ///< Position of the replay in the trace
+    QByteArray replayStates; ///< The cell states currently painted by the replay
+    QSpinBox *batchQuerySelector; ///< Number of random queries in a batch
+    QPushButton *batchQueryButton;
+    MazeGrid *batchGrid; ///< Copy of the maze the batch queries read from
+    QFutureWatcher<PathAnswer> *batchWatcher;
+    QSpinBox *landmarkCountSelector; ///< Number of landmarks to build
+    QPushButton *buildLandmarksButton;
+    LandmarkTable *landmarks; ///< Landmark distances of the maze, built or mapped from a file
+    QPushButton *analyzeButton;
+    QFutureWatcher<MazeAnalytics::Report> *analyticsWatcher; ///< Watches the analysis on the worker thread
+    QSpinBox *floorCountSelector; ///< Floors of the multi-floor maze
+    QSpinBox *floorSelector; ///< The floor shown and edited in the maze view
+    QSpinBox *stairCountSelector; ///< Stairs from every floor to the next
+    QSpinBox *portalCountSelector; ///< Portals in the whole multi-floor maze
+    QPushButton *placeConnectionsButton;
+    QComboBox *floorSearchSelection; ///< Selector for the search over all floors, in the order of LayeredMaze::Algorithm
+    QPushButton *solveFloorsButton;
+    LayeredMaze *floors; ///< The walls of all floors, the shown one is taken from the view when needed
+    int shownFloor; ///< The floor currently in the maze view
+    QVector<int> floorPath; ///< Layered node ids of the last path over the floors
+    QElapsedTimer batchClock;
     QHash<QGraphicsItem*,MazeNode*> *listOfRectangles; ///< A hashlist that lets us look up the nodes by their drawn rectangle
     QHash<int,MazeNode*> *listOfIds; ///< A hashlist that lets us look up the nodes by ID
+    MazeNodeArena *nodes; ///< The memory all nodes live in
+    MazeEditor *editor; ///< Applies the editing tools to the nodes and keeps the undo journal
+    QComboBox *editToolSelection; ///< Selector for the editing tool, in the order of MazeEditor::Tool
+    QSpinBox *brushRadiusSelector; ///< Cells from the centre of the brush to its edge
+    int editStartRow; ///< Cell the current edit was started on
+    int editStartColumn;
+    int editLastRow; ///< Cell the brush was last painted on
+    int editLastColumn;
     QComboBox *searchSelection; ///< Selector for the type of search algorithm
+    QSpinBox *memoryBudgetSelector; ///< Memory the bounded searches may use, in KiB
+    EncodedPath lastPath; ///< The path of the last search
+    QSpinBox *deadlineSelector; ///< Time the anytime search may take, in microseconds
+    QSpinBox *shardCountSelector; ///< Worker processes of the sharded search
+    QCheckBox *reuseResultsBox; ///< Answers searches that ran before on the same maze from the cache
+    SolveCache *solveCache; ///< Results of earlier searches, in memory and in the user's cache directory
+    SolveCache::Key searchKey; ///< The maze and the search that is running
+    bool storeResult; ///< True if the result of the running search goes into the cache
+    QComboBox *neighbourhoodSelection; ///< Selector for the neighbourhood used by the instant searches
+    QComboBox *storageSelection; ///< Selector for the cell storage used by the instant searches
     MSolver *solver;
     int nodeDescriptionThreshold; ///< The threshold under which a mazenode should not display the description anymore
     int sceneHeight;
@@ -67,22 +149,62 @@ private:
     void addItemsToScene(); ///< Builds the empty maze
     void createGridSizeArray(); ///< Creates an array of the different possible grid sizes
     void drawMaze(); ///< draws the empty maze
-    void fillLogWithPath(QStack<int>* path); ///< Writes the found path to the log
+    void fillLogWithPath(const EncodedPath &path); ///< Writes the found path to the log
     void initializeMazeSolver();
+    void resetReplay(); ///< Forgets what the replay painted and updates the timeline
+    QBitArray collectWalls(); ///< Gets one bit per node id, set for walls
+    bool cellAt(const QPoint &position, int &row, int &column); ///< Gets the cell under a point of the view
+    void repaintEdits(); ///< Repaints the cells the editor changed in one update
+    bool showWalls(int rows, int columns, const QBitArray &walls); ///< Switches to the grid size of a maze and sets its walls
     void setDefaultSelections();
     void setEntranceAndExit();
     void setupUI();
     void switchUiState(); ///< Switches UI elements on an off while searching
+    void prepareSearch(); ///< Sets up the UI, the solver and the trace for a search
+    void paintFloor(); ///< Marks the stairs, portals and path cells of the shown floor
+    bool setSearchKey(); ///< Sets the cache key of the selected search on the current maze, false if its results can't be reused
+    bool showCachedResult(); ///< Shows the cached result of the search key like a finished search, false if there is none or it is unusable
+    bool isValidCachedPath(const EncodedPath &path, QVector<int> &ids) const; ///< Checks that a cached path leads from the entrance to the exit of the grid
     int tracePath(MazeNode* lastNode,QStack<int>* nodeStack); ///< Displays a found path visually
 
 private slots:
     void clearMaze();
     void createRandomMaze();
     void displayResult(MazeNode *lastNode);
+    void displayImprovedPath(MazeNode *lastNode, double bound, qint64 elapsedUs);
     void resetMaze();
     void setNewGridSize();
     void startSearch();
+    void stepSearch();
     void stopSearch();
+    void updateProgress(int expanded, int frontierSize, double fraction);
+    void saveMaze();
+    void loadMaze();
+    void exportPath(); ///< Writes the last path to a file
+    void copyPath(); ///< Puts the last path on the clipboard
+    void buildLandmarks(); ///< Builds the landmark table of the current maze
+    void importImage(); ///< Imports the walls of a maze from an image
+    void undoEdit();
+    void saveCheckpoint(); ///< Writes the state of the running DFS or BFS to a file
+    void resumeCheckpoint(); ///< Loads a checkpoint and carries on with its search
+    void showCheckpointSaved(QString fileName, bool saved, qint64 captureUs);
+    void redoEdit();
+    void toggleReplay();
+    void replayTick();
+    void showReplayFrame(int frame); ///< Paints the state of the recorded search after the given number of events
+    void runBatchQueries(); ///< Answers random path queries on the current maze in parallel
+    void finishBatchQueries();
+    void startRace(); ///< Runs all solvers at once on the current maze
+    void analyzeMaze(); ///< Computes the structural figures of the current maze in the background
+    void finishAnalysis();
+    void setFloorCount(int count); ///< Adds or removes floors, keeping the walls of the remaining ones
+    void showFloor(int floor); ///< Keeps the walls of the shown floor and puts another one in the view
+    void placeFloorConnections(); ///< Places random stairs and portals between open cells of the floors
+    void solveFloors(); ///< Searches from the entrance of the bottom floor to the exit of the top floor
+    void clearResultCache(); ///< Forgets the results of all earlier searches
+#ifdef MAZESOLVER_TIMELINE
+    void exportTimeline(); ///< Writes the recorded timeline events to a file
+#endif
 
 };
 
@@ -1,6 +1,8 @@
 #include "msolver.h"
+#include "timelinetrace.h"
 
 #include <QElapsedTimer>
+#include <QtConcurrentRun>
 
 /**
  * @brief Constructor for the maze solver
@@ -17,17 +19,44 @@ MSolver::MSolver(QHash<int, MazeNode *> *listOfIds, int nrows, int ncolumns,int
     rows = nrows;
     columns = ncolumns;
     nodeHash = listOfIds;
+    openDirections = 0;
     tickInterval = tick;
-    interruptSearch = false;
+    nodesExpanded = 0;
+    openNodes = 0;
+    runMode = Animated;
+    expansionsPerTick = 1;
+    stepper.setControl(&control);
+    checkpointIntervalMs = 0;
+    checkpointCaptureUs = 0;
 
     // Initialize timers
-    tickerDFS = new QTimer(this);
-    tickerBFS = new QTimer(this);
+    ticker = new QTimer(this);
+    progressTicker = new QTimer(this);
+    checkpointTicker = new QTimer(this);
     stopwatch = new QElapsedTimer();
+    progressClock = new QElapsedTimer();
     timeElapsed = 0;
 
-    connect(tickerDFS, SIGNAL(timeout()), this, SLOT(takeFromStack()));
-    connect(tickerBFS, SIGNAL(timeout()), this, SLOT(takeFromQueue()));
+    // The kernel searches run on a worker thread
+    kernelWatcher = new QFutureWatcher<MazeKernels::KernelResult>(this);
+    boundedWatcher = new QFutureWatcher<BoundedSearch::Result>(this);
+    anytime = new AnytimeSearch(this);
+    anytimeWatcher = new QFutureWatcher<AnytimeSearch::Result>(this);
+    rectangleWatcher = new QFutureWatcher<RectangleSearch::Result>(this);
+    shardedWatcher = new QFutureWatcher<ShardedSearch::Result>(this);
+    checkpointWatcher = new QFutureWatcher<bool>(this);
+    qRegisterMetaType<QVector<int> >("QVector<int>");
+
+    connect(ticker, SIGNAL(timeout()), this, SLOT(tick()));
+    connect(progressTicker, SIGNAL(timeout()), this, SLOT(reportKernelProgress()));
+    connect(kernelWatcher, SIGNAL(finished()), this, SLOT(finishKernelSearch()));
+    connect(boundedWatcher, SIGNAL(finished()), this, SLOT(finishBoundedSearch()));
+    connect(anytime, SIGNAL(improved(QVector<int>,double,qint64)), this, SLOT(showImprovedPath(QVector<int>,double,qint64)));
+    connect(anytimeWatcher, SIGNAL(finished()), this, SLOT(finishAnytimeSearch()));
+    connect(rectangleWatcher, SIGNAL(finished()), this, SLOT(finishRectangleSearch()));
+    connect(shardedWatcher, SIGNAL(finished()), this, SLOT(finishShardedSearch()));
+    connect(checkpointTicker, SIGNAL(timeout()), this, SLOT(autoCheckpoint()));
+    connect(checkpointWatcher, SIGNAL(finished()), this, SLOT(finishCheckpoint()));
 
 }
 /**
@@ -39,6 +68,15 @@ qint64 MSolver::getTimeElapsed()
     return timeElapsed;
 }
 
+/**
+ * @brief Gets the number of nodes expanded by the last search
+ * @return The number of expanded nodes
+ */
+int MSolver::getNodesExpanded()
+{
+    return nodesExpanded;
+}
+
 /**
  * @brief This function sets some rudimentary parameters. Can be set in the constructor as well
  * @param listOfIds A hashlist with all the nodes that we need to search through
@@ -55,250 +93,550 @@ void MSolver::setParameters(QHash<int, MazeNode *> *listOfIds, int nrows, int nc
 }
 
 /**
- * @brief Starts the DFS algorithm on the list of nodes.
+ * @brief Sets how the stepwise searches are driven
+ * @param mode Animated, single step or full speed
+ * @param expansions The number of expansions per timer tick in animated mode
  */
-void MSolver::startDFS(){
-    // Initialize the stack and start the timer
-    stack = new QStack<MazeNode*>();
-    stopwatch->restart();
+void MSolver::setRunMode(RunMode mode, int expansions)
+{
+    runMode = mode;
+    expansionsPerTick = qMax(1, expansions);
+}
+
+/**
+ * @brief Sets the trace which the stepwise searches record into
+ * @param trace The trace, or 0 for none
+ */
+void MSolver::setTrace(SearchTrace *trace)
+{
+    stepper.setTrace(trace);
+}
 
-    MazeNode *start = nodeHash->value(0);
-    stack->push(start);
+/**
+ * @brief Sets the open directions of the nodes, so a stepwise search doesn't build them first
+ * @param table The table of the arena holding the nodes, or 0 for none
+ */
+void MSolver::setOpenDirections(const OpenDirectionTable *table)
+{
+    openDirections = table;
+}
 
-    tickerDFS->blockSignals(false);
-    tickerDFS->start(tickInterval); // On each tick, take one node off the stack and search
+/**
+ * @brief Starts the DFS algorithm on the list of nodes.
+ */
+void MSolver::startDFS(){
+    startStepper(SearchStepper::DepthFirst);
 }
 /**
  * @brief Starts the BFS algorithm on the list of nodes.
  */
 void MSolver::startBFS(){
-    // Initialize the queue and start the timer
-    queue = new QQueue<MazeNode*>();
-    stopwatch->restart();
-
-    MazeNode *start = nodeHash->value(0);
-    queue->enqueue(start);
-
-    tickerBFS->blockSignals(false);
-    tickerBFS->start(tickInterval);  // On each tick, take one node off the queue and search
+    startStepper(SearchStepper::BreadthFirst);
 }
+
 /**
- * @brief Stops the search, triggered from the UI
+ * @brief Counts the nodes which aren't walls, used to estimate the search progress
  */
-void MSolver::triggerStopSearch(){
-    timeElapsed = stopwatch->elapsed();
-    stopwatch->invalidate();
-    interruptSearch = true;
+void MSolver::countOpenNodes()
+{
+    openNodes = 0;
+    foreach(MazeNode *node, *nodeHash){
+        if(!node->isWall()){
+            openNodes++;
+        }
+    }
 }
 
 /**
- * @brief Stops the search, triggered from the algorithm
- * @param exitNode The exitnode
+ * @brief Emits the progress signal
+ * @param expanded The number of nodes expanded so far
+ * @param frontierSize The number of nodes on the frontier
  */
-void MSolver::stopSearch(MazeNode *exitNode)
+void MSolver::emitProgress(int expanded, int frontierSize)
 {
+    double fraction = openNodes > 0 ? qMin(1.0, double(expanded) / openNodes) : 0.0;
+    emit progress(expanded, frontierSize, fraction);
+}
 
-    // Stop all the timers
-    timeElapsed = stopwatch->elapsed();
-    stopwatch->invalidate();
+/**
+ * @brief Starts the stepwise search and drives it according to the run mode
+ * @param mode DFS or BFS
+ */
+void MSolver::startStepper(SearchStepper::Mode mode)
+{
+    stopwatch->restart();
+    progressClock->restart();
+    nodesExpanded = 0;
+    control.reset();
+    countOpenNodes();
+    stepper.start(mode, nodeHash, rows, columns, openDirections);
+    runStepper();
+}
 
-    tickerDFS->blockSignals(true);
-    tickerDFS->stop();
+/**
+ * @brief Carries on with a checkpointed DFS or BFS, driven according to the run mode. The nodes
+ * have to show the walls of the checkpoint and no search state.
+ * @param checkpoint The state of the search
+ * @return False if the checkpoint doesn't fit the maze
+ */
+bool MSolver::resumeSearch(const SearchCheckpoint &checkpoint)
+{
+    stopwatch->restart();
+    progressClock->restart();
+    nodesExpanded = 0;
+    control.reset();
+    countOpenNodes();
+    if(!stepper.resume(checkpoint, nodeHash)){
+        return false;
+    }
+    runStepper();
+    return true;
+}
 
-    tickerBFS->blockSignals(true);
-    tickerBFS->stop();
+/**
+ * @brief Starts the timers which drive the stepper and write its checkpoints
+ */
+void MSolver::runStepper()
+{
+    if(!checkpointFile.isEmpty() && checkpointIntervalMs > 0){
+        checkpointTicker->start(checkpointIntervalMs);
+    }
 
-    // Clear stacks and queue
-    if(stack != 0){
-        stack->clear();
+    if(runMode == Animated){
+        ticker->start(tickInterval); // On each tick, expand a few nodes
     }
-    if(queue != 0){
-        queue->clear();
+    else if(runMode == FullSpeed){
+        ticker->start(0); // Run in time slices so the event loop stays responsive
     }
-
-    // Display the path/exit
-    emit displayExit(exitNode);
+    // In single step mode, step() is called from the UI
 }
+
 /**
- * @brief Gets the unvisited adjacent nodes of the passed in node
- * @param currentID The node ID we need the adjacent nodes for
- * @return The list of neighboring nodes that have been unvisited
+ * @brief Expands exactly one node, used for single step debugging
  */
-QList<MazeNode *> *MSolver::getAdjacentUnvisitedNodes(int currentID)
+void MSolver::step()
 {
-    QList<MazeNode*> *neighbours = new QList<MazeNode*>();
-    int totalNumberOfNodes = rows * columns;
-
-    MazeNode *adjacentNode;
-
-    // Node to the south
-    if((currentID) < (totalNumberOfNodes-columns)){
-        adjacentNode = nodeHash->value(currentID+columns);
-        if(!adjacentNode->isWall() && !adjacentNode->hasBeenVisited()){
-            neighbours->append(adjacentNode);
-        }
+    if(stepper.getState() != SearchStepper::Running){
+        return;
     }
+    stepper.step();
+    emitProgress(stepper.getExpandedCount(), stepper.getFrontierSize());
+    finishStepper();
+}
 
-    // Node to the north
-    if(currentID > columns){
-        adjacentNode = nodeHash->value(currentID-columns);
-
-        if(!adjacentNode->isWall() && !adjacentNode->hasBeenVisited()){
-            neighbours->append(adjacentNode);
-        }
+/**
+ * @brief One timer tick of the stepwise search. In full speed mode the tick runs for at most
+ * fullSpeedSliceMs, which bounds the time until a click on stop is handled.
+ */
+void MSolver::tick()
+{
+    TIMELINE_SCOPE("MSolver::tick", "solver");
+    // Check if the search has been interrupted
+    if(control.isCancelled()){
+        finishStepper();
+        return;
     }
 
-    // Node to the east
-    if(((currentID+1) % columns) != 0){ // Check if the node isn't at the very right
-        adjacentNode = nodeHash->value(currentID+1);
-        if(!adjacentNode->isWall() && (currentID+1) <= totalNumberOfNodes && !adjacentNode->hasBeenVisited()){
-            neighbours->append(adjacentNode);
+    if(runMode == FullSpeed){
+        QElapsedTimer slice;
+        slice.start();
+        while(stepper.getState() == SearchStepper::Running && !stepper.isCancelled()
+              && slice.elapsed() < fullSpeedSliceMs){
+            stepper.run(SearchControl::PollInterval);
         }
     }
-    // Node to the west
-    if(currentID != 0 && ((currentID) % columns) != 0){ // Check if the node isn't at the very left
-        adjacentNode = nodeHash->value(currentID-1);
-        if(!adjacentNode->isWall() && !adjacentNode->hasBeenVisited()){
-            neighbours->append(adjacentNode);
-        }
+    else{
+        stepper.advance(expansionsPerTick);
     }
 
-    return neighbours;
+    // Report progress a few times per second
+    if(progressClock->elapsed() >= progressIntervalMs){
+        progressClock->restart();
+        emitProgress(stepper.getExpandedCount(), stepper.getFrontierSize());
+    }
+    finishStepper();
 }
 
 /**
- * @brief One step in the DFS search algorithm
+ * @brief Stops the search if the stepper reached a final state or has been interrupted
  */
-void MSolver::takeFromStack()
+void MSolver::finishStepper()
 {
-    // Check if the search has been interrupted
-    if(interruptSearch){
-        qDebug() << "Interrupted";
-        tickerDFS->blockSignals(true);
-        tickerDFS->stop();
-        interruptSearch = false;
-        stopSearch(0); // Stop with the search, pass in 0 as the exit hasn't been found
+    SearchStepper::State state = stepper.getState();
+    if(state == SearchStepper::Running && !control.isCancelled()){
         return;
     }
 
-    int currentID;
-    MazeNode *currentNode;
-    MazeNode *nextNode;
-    QList<MazeNode*> *neighbours;
-    int validNodeCounter = 0;
-    bool exitFound = false;
-
-    // This is the DFS search algorithm. Pop a node off of the stack
-    // Get adjacent nodes and iterate over them at random and check if they're exits
-    // It not, push them onto the stack
-    if(!stack->isEmpty()){
-        currentNode = stack->pop();
-        currentNode->setActive(true);
-        currentID = currentNode->getId();
-        neighbours = getAdjacentUnvisitedNodes(currentID);
-        while(!neighbours->isEmpty()){
-            nextNode = neighbours->takeAt(rand() % neighbours->size());
-            // Ignore Node it is a wall or has been visited already
-            if(nextNode->isWall() || nextNode->hasBeenVisited()){
-                continue;
-            }
-            validNodeCounter++;
-            nextNode->setPreviousNode(currentNode);
-            stack->push(nextNode);
-            if(nextNode->isExit()){
-                exitFound = true;
-                break;
-            }
-        }
-        currentNode->setVisited(true);
+    checkpointTicker->stop();
+    nodesExpanded = stepper.getExpandedCount();
+    emitProgress(nodesExpanded, 0);
+    MazeNode *exitNode = (state == SearchStepper::ExitFound) ? stepper.getExitNode() : 0;
+    control.reset();
+    stepper.abort();
+    stopSearch(exitNode);
+}
 
-        if(exitFound){
-            stopSearch(nextNode); // Exit found
-        }
-    }
-    else{
-        stopSearch(0);// No exit found
-        return;
-    }
+/**
+ * @brief Writes a checkpoint on a worker thread
+ * @param checkpoint The state, a copy that shares the planes until the search changes them
+ * @param fileName The file to write to
+ * @return True on success
+ */
+static bool writeCheckpoint(SearchCheckpoint checkpoint, QString fileName)
+{
+    return checkpoint.save(fileName);
+}
 
-    // No Node has been updated this tick
-    if(validNodeCounter == 0){
-        validNodeCounter = 0;
-        tickerDFS->stop();
-        takeFromStack(); // rerun the
-        tickerDFS->start(tickInterval);
+/**
+ * @brief Writes the state of the running DFS or BFS. The search only stands still while
+ * the state is taken, compressing and writing it happens on a worker thread. A checkpoint
+ * that is still being written is not interrupted, the request is refused instead.
+ * @param fileName The file to write to
+ * @return False if no stepwise search runs or the last checkpoint is still being written
+ */
+bool MSolver::saveCheckpoint(const QString &fileName)
+{
+    if(stepper.getState() != SearchStepper::Running || checkpointWatcher->isRunning()){
+        return false;
     }
 
+    QElapsedTimer capture;
+    capture.start();
+    SearchCheckpoint checkpoint = stepper.checkpoint();
+    checkpointCaptureUs = capture.nsecsElapsed() / 1000;
+    writingCheckpointFile = fileName;
+    checkpointWatcher->setFuture(QtConcurrent::run(writeCheckpoint, checkpoint, fileName));
+    return true;
+}
+
+/**
+ * @brief Sets where and how often checkpoints are written while a DFS or BFS runs. Takes
+ * effect with the next search.
+ * @param fileName The file each checkpoint replaces
+ * @param intervalMs Milliseconds between two checkpoints, 0 for none
+ */
+void MSolver::setCheckpointing(const QString &fileName, int intervalMs)
+{
+    checkpointFile = fileName;
+    checkpointIntervalMs = intervalMs;
 }
+
 /**
- * @brief One step in the BFS search algorithm
+ * @brief Writes the timed checkpoint
  */
-void MSolver::takeFromQueue(){
-    // Check if the search has been interrupted
-    if(interruptSearch){
-        tickerBFS->blockSignals(true);
-        tickerBFS->stop();
-        interruptSearch = false;
-        stopSearch(0); // Stop with the search, pass in 0 as the exit hasn't been found
+void MSolver::autoCheckpoint()
+{
+    saveCheckpoint(checkpointFile);
+}
+
+/**
+ * @brief Reports a checkpoint once the worker thread has written it
+ */
+void MSolver::finishCheckpoint()
+{
+    emit checkpointSaved(writingCheckpointFile, checkpointWatcher->result(), checkpointCaptureUs);
+}
+
+/**
+ * @brief Runs a compile-time specialized kernel on a snapshot of the maze. The search runs
+ * on a worker thread without animation, afterwards the path is linked up through the nodes.
+ * @param algorithm The search algorithm
+ * @param connectivity The neighbourhood of each node
+ * @param storage How the kernel stores the cells
+ */
+void MSolver::startKernelSearch(MazeKernels::Algorithm algorithm, MazeKernels::Connectivity connectivity, MazeKernels::Storage storage)
+{
+    stopwatch->restart();
+    control.reset();
+    countOpenNodes();
+
+    // Take a snapshot of the walls
+    MazeKernels::KernelInput input;
+    input.rows = rows;
+    input.columns = columns;
+    input.entrance = 0;
+    input.exit = rows * columns - 1;
+    input.walls = snapshotWalls();
+    input.control = &control;
+
+    kernelWatcher->setFuture(QtConcurrent::run(MazeKernels::run, input, algorithm, connectivity, storage));
+    progressTicker->start(progressIntervalMs);
+}
+
+/**
+ * @brief Publishes the counters of the running kernel search
+ */
+void MSolver::reportKernelProgress()
+{
+    emitProgress(control.expanded.load(), control.frontier.load());
+}
+
+/**
+ * @brief Picks up the result of the kernel search once the worker thread is done
+ */
+void MSolver::finishKernelSearch()
+{
+    progressTicker->stop();
+    MazeKernels::KernelResult result = kernelWatcher->result();
+    nodesExpanded = result.expanded;
+    emitProgress(nodesExpanded, 0);
+    control.reset();
+
+    if(!result.found){
+        stopSearch(0); // No exit found or cancelled
         return;
     }
 
-    int currentID;
-    MazeNode *currentNode;
-    MazeNode *nextNode;
-    QList<MazeNode*> *neighbours;
-    int validNodeCounter = 0;
-    bool exitFound = false;
-
-    // This is the BFS search algorithm. Dequeue a node from the queue
-    // Get adjacent nodes and iterate over them at random and check if they're exits
-    // It not, enqueue them on the queue
-    if(!queue->isEmpty()){
-        currentNode = queue->dequeue();
-
-        if(currentNode->hasBeenVisited()){
-            return;
-        }
+    stopSearch(linkPath(result.path));
+}
 
-        currentNode->setActive(true);
-        currentID = currentNode->getId();
-        neighbours = getAdjacentUnvisitedNodes(currentID);
+/**
+ * @brief Runs IDA* or frontier search from the entrance to the exit on a worker thread.
+ * Neither keeps state per node, so the nodes are only touched for the path at the end.
+ * @param method The search to run
+ * @param budgetBytes The memory the search state may use
+ */
+void MSolver::startBoundedSearch(BoundedSearch::Method method, qint64 budgetBytes)
+{
+    stopwatch->restart();
+    control.reset();
+    countOpenNodes();
 
-        while(!neighbours->isEmpty()){
-            nextNode = neighbours->takeFirst();
+    MazeGrid grid(rows, columns);
+    grid.setWalls(snapshotWalls());
 
-            // Ignore Node it is a wall or has been visited already
-            if(nextNode->isWall() || nextNode->hasBeenVisited()){
-                continue;
-            }
-            validNodeCounter++;
-            nextNode->setPreviousNode(currentNode);
-            queue->enqueue(nextNode);
-            if(nextNode->isExit()){
-                exitFound = true;
-                break;
-            }
+    boundedWatcher->setFuture(QtConcurrent::run(BoundedSearch::run, grid, 0, rows * columns - 1, method, budgetBytes, &control));
+    progressTicker->start(progressIntervalMs);
+}
 
+/**
+ * @brief Gets the outcome of the last bounded search
+ * @return The counters and the peak memory, the path is left out
+ */
+BoundedSearch::Result MSolver::getBoundedResult()
+{
+    return boundedResult;
+}
 
-        }
+/**
+ * @brief Picks up the result of the bounded search once the worker thread is done
+ */
+void MSolver::finishBoundedSearch()
+{
+    progressTicker->stop();
+    BoundedSearch::Result result = boundedWatcher->result();
+    nodesExpanded = int(qMin(result.expanded, qint64(0x7fffffff)));
+    emitProgress(nodesExpanded, 0);
+    control.reset();
+
+    boundedResult = result;
+    boundedResult.path.clear();
+    stopSearch(result.found ? linkPath(result.path) : 0);
+}
 
-        currentNode->setVisited(true);
+/**
+ * @brief Runs ARA* from the entrance to the exit on a worker thread. The deadline counts from
+ * this call, so taking the snapshot of the walls is part of it.
+ * @param deadlineUs Microseconds until the search has to return its best path
+ * @param landmarks Landmark distances of this maze for a better estimate, may be 0. They have
+ * to stay unchanged until the search is done.
+ */
+void MSolver::startAnytimeSearch(qint64 deadlineUs, const LandmarkTable *landmarks)
+{
+    AnytimeSearch::Request request;
+    request.clock.start();
+    stopwatch->restart();
+    control.reset();
+    countOpenNodes();
+
+    request.grid.resize(rows, columns);
+    request.grid.setWalls(snapshotWalls());
+    request.start = 0;
+    request.goal = rows * columns - 1;
+    request.deadlineUs = deadlineUs;
+    request.landmarks = landmarks;
+
+    anytimeWatcher->setFuture(QtConcurrent::run(anytime, &AnytimeSearch::run, request, &control));
+    progressTicker->start(progressIntervalMs);
+}
+
+/**
+ * @brief Gets the outcome of the last anytime search
+ * @return The bound and the counters, the path is left out
+ */
+AnytimeSearch::Result MSolver::getAnytimeResult()
+{
+    return anytimeResult;
+}
+
+/**
+ * @brief Passes a better path of the anytime search on to the UI
+ * @param path Node ids from the entrance to the exit
+ * @param bound The path is at most this many times longer than the shortest one
+ * @param elapsedUs Microseconds since the search was started
+ */
+void MSolver::showImprovedPath(QVector<int> path, double bound, qint64 elapsedUs)
+{
+    emit improvedPath(linkPath(path), bound, elapsedUs);
+}
 
-        if(exitFound){
-            stopSearch(nextNode); // Exit found
+/**
+ * @brief Picks up the best path of the anytime search once the worker thread is done
+ */
+void MSolver::finishAnytimeSearch()
+{
+    progressTicker->stop();
+    AnytimeSearch::Result result = anytimeWatcher->result();
+    nodesExpanded = int(qMin(result.expanded, qint64(0x7fffffff)));
+    emitProgress(nodesExpanded, 0);
+    control.reset();
+
+    anytimeResult = result;
+    anytimeResult.path.clear();
+    stopSearch(result.found ? linkPath(result.path) : 0);
+}
+
+/**
+ * @brief Runs A* from the entrance to the exit on a worker thread, crossing the empty
+ * rectangles of the maze in single steps. The rectangles are found as part of the search.
+ */
+void MSolver::startRectangleSearch()
+{
+    stopwatch->restart();
+    control.reset();
+    countOpenNodes();
+
+    MazeGrid grid(rows, columns);
+    grid.setWalls(snapshotWalls());
+
+    rectangleWatcher->setFuture(QtConcurrent::run(RectangleSearch::run, grid, 0, rows * columns - 1, &control));
+    progressTicker->start(progressIntervalMs);
+}
+
+/**
+ * @brief Gets the outcome of the last rectangle search
+ * @return The decomposition figures and the counters, the path is left out
+ */
+RectangleSearch::Result MSolver::getRectangleResult()
+{
+    return rectangleResult;
+}
+
+/**
+ * @brief Picks up the result of the rectangle search once the worker thread is done
+ */
+void MSolver::finishRectangleSearch()
+{
+    progressTicker->stop();
+    RectangleSearch::Result result = rectangleWatcher->result();
+    nodesExpanded = int(qMin(result.expanded, qint64(0x7fffffff)));
+    emitProgress(nodesExpanded, 0);
+    control.reset();
+
+    rectangleResult = result;
+    rectangleResult.path.clear();
+    stopSearch(result.found ? linkPath(result.path) : 0);
+}
+
+/**
+ * @brief Runs a BFS from the entrance to the exit with one worker process per band of rows.
+ * The coordinator waits for the workers on a worker thread.
+ * @param bands The number of worker processes
+ */
+void MSolver::startShardedSearch(int bands)
+{
+    stopwatch->restart();
+    control.reset();
+    countOpenNodes();
+
+    MazeGrid grid(rows, columns);
+    grid.setWalls(snapshotWalls());
+
+    shardedWatcher->setFuture(QtConcurrent::run(ShardedSearch::run, grid, 0, rows * columns - 1, bands, &control, -1));
+    progressTicker->start(progressIntervalMs);
+}
+
+/**
+ * @brief Gets the outcome of the last sharded search
+ * @return The levels, workers, restarts and the error if it failed, the path is left out
+ */
+ShardedSearch::Result MSolver::getShardedResult()
+{
+    return shardedResult;
+}
+
+/**
+ * @brief Picks up the result of the sharded search once the coordinator is done
+ */
+void MSolver::finishShardedSearch()
+{
+    progressTicker->stop();
+    ShardedSearch::Result result = shardedWatcher->result();
+    nodesExpanded = int(qMin(result.expanded, qint64(0x7fffffff)));
+    emitProgress(nodesExpanded, 0);
+    control.reset();
+
+    shardedResult = result;
+    shardedResult.path.clear();
+    stopSearch(result.found ? linkPath(result.path) : 0);
+}
+
+/**
+ * @brief Takes a snapshot of the walls for the searches on the worker thread
+ * @return One bit per node id, set for walls
+ */
+QBitArray MSolver::snapshotWalls()
+{
+    QBitArray walls(rows * columns);
+    foreach(MazeNode *node, *nodeHash){
+        if(node->isWall()){
+            walls.setBit(node->getId());
         }
     }
-    else{
-        stopSearch(0);// No exit found
-        return;
-    }
+    return walls;
+}
 
-    // No Node has been updated this tick
-    if(validNodeCounter == 0){
-        validNodeCounter = 0;
-        takeFromQueue();
+/**
+ * @brief Links the nodes of a path found on a worker thread, so it can be traced back from the exit
+ * @param path Node ids from the entrance to the exit
+ * @return The exit node, 0 for an empty path
+ */
+MazeNode *MSolver::linkPath(const QVector<int> &path)
+{
+    MazeNode *previous = 0;
+    foreach(int id, path){
+        MazeNode *node = nodeHash->value(id);
+        node->setPreviousNode(previous);
+        previous = node;
     }
+    return previous;
+}
 
+/**
+ * @brief Stops the search, triggered from the UI
+ */
+void MSolver::triggerStopSearch(){
+    control.requestCancel();
 
+    // Without a running timer nobody else would notice the flag
+    if(!ticker->isActive() && stepper.getState() == SearchStepper::Running){
+        finishStepper();
+    }
 }
 
+/**
+ * @brief Stops the search, triggered from the algorithm
+ * @param exitNode The exitnode
+ */
+void MSolver::stopSearch(MazeNode *exitNode)
+{
+    TIMELINE_SCOPE("MSolver::stopSearch", "solver");
+
+    // Stop the timer
+    timeElapsed = stopwatch->elapsed();
+    stopwatch->invalidate();
+    ticker->stop();
+
+    // Display the path/exit
+    emit displayExit(exitNode);
+}
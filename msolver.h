@@ -3,13 +3,18 @@
 
 #include <QObject>
 #include <QHash>
-#include <QStack>
-#include <QQueue>
-#include <QList>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QFutureWatcher>
 
 #include "mazenode.h"
+#include "mazekernels.h"
+#include "boundedsearch.h"
+#include "anytimesearch.h"
+#include "rectanglesearch.h"
+#include "shardedsearch.h"
+#include "searchstepper.h"
+#include "searchcontrol.h"
 
 /**
  * @brief The MSolver class holds the algorithms that solve the maze
@@ -18,36 +23,101 @@ class MSolver : public QObject
 {
     Q_OBJECT
 public:
+    /// How the stepwise searches are driven
+    enum RunMode {
+        Animated, ///< A timer expands a few nodes per tick
+        SingleStep, ///< Each call to step() expands one node
+        FullSpeed ///< Runs to completion without a timer
+    };
+
     explicit MSolver(QHash<int,MazeNode*>*listOfIds, int rows,int columns, int tick,QObject *parent = 0);
     qint64 getTimeElapsed(); ///< Gets the time needed to solve the maze
     void setParameters(QHash<int,MazeNode*>*listOfIds, int rows,int columns,int tick); ///< Sets some values that are needed later for solving
+    void setRunMode(RunMode mode, int expansions); ///< Sets how the stepwise searches are driven
     void startDFS();
     void startBFS();
+    void step(); ///< Expands one node of a single step search
+    bool resumeSearch(const SearchCheckpoint &checkpoint); ///< Carries on with a checkpointed DFS or BFS
+    bool saveCheckpoint(const QString &fileName); ///< Writes the state of the running DFS or BFS in the background
+    void setCheckpointing(const QString &fileName, int intervalMs); ///< Writes checkpoints at intervals while a DFS or BFS runs, 0 for never
+    void setTrace(SearchTrace *trace); ///< Sets the trace the stepwise searches record into
+    void setOpenDirections(const OpenDirectionTable *table); ///< Sets the open directions of the nodes the stepwise searches expand with
+    void startKernelSearch(MazeKernels::Algorithm algorithm, MazeKernels::Connectivity connectivity, MazeKernels::Storage storage); ///< Runs a specialized kernel to completion
+    void startBoundedSearch(BoundedSearch::Method method, qint64 budgetBytes); ///< Runs a memory-bounded search to completion
+    BoundedSearch::Result getBoundedResult(); ///< Gets the counters and peak memory of the last bounded search
+    void startAnytimeSearch(qint64 deadlineUs, const LandmarkTable *landmarks = 0); ///< Runs ARA* until the path is optimal or the deadline passes
+    AnytimeSearch::Result getAnytimeResult(); ///< Gets the bound and counters of the last anytime search
+    void startRectangleSearch(); ///< Runs A* across empty rectangles to completion
+    RectangleSearch::Result getRectangleResult(); ///< Gets the decomposition figures and counters of the last rectangle search
+    void startShardedSearch(int bands); ///< Runs a BFS split over worker processes to completion
+    ShardedSearch::Result getShardedResult(); ///< Gets the levels, workers and restarts of the last sharded search
+    int getNodesExpanded(); ///< Gets the number of nodes the last search expanded
     void triggerStopSearch(); ///< Stops the search
 
 private:
 
+    /// Upper bound for one full speed time slice, and with it for the cancel latency
+    static const int fullSpeedSliceMs = 15;
+    /// How often progress is reported
+    static const int progressIntervalMs = 100;
+
     QHash<int,MazeNode*> *nodeHash;
-    QStack<MazeNode*> *stack;
-    QQueue<MazeNode*> *queue;
-    QTimer *tickerDFS; ///<  A timer which triggers a step in the DFS algorithm
-    QTimer *tickerBFS; ///< A timer which triggers a step in the BFS algorithm
+    const OpenDirectionTable *openDirections; ///< Kept up to date by the arena of the nodes, 0 for none
+    SearchStepper stepper; ///< The state of the DFS or BFS search
+    SearchControl control; ///< Cancel flag and counters shared with the running search
+    QTimer *ticker; ///< A timer which triggers steps in the animated search
+    QTimer *progressTicker; ///< A timer which reports the progress of a kernel search
+    QTimer *checkpointTicker; ///< A timer which writes checkpoints of the stepwise search
+    QFutureWatcher<bool> *checkpointWatcher; ///< Watches the checkpoint being written on the worker thread
+    QString checkpointFile; ///< Where the timer writes checkpoints to
+    int checkpointIntervalMs;
+    QString writingCheckpointFile; ///< The file of the checkpoint being written
+    qint64 checkpointCaptureUs; ///< Time taking the state of the checkpoint being written took, the copies of the planes by the next step aren't included
     QElapsedTimer *stopwatch;
+    QElapsedTimer *progressClock; ///< Throttles the progress reports of the stepwise search
+    QFutureWatcher<MazeKernels::KernelResult> *kernelWatcher; ///< Watches the kernel search on the worker thread
+    QFutureWatcher<BoundedSearch::Result> *boundedWatcher; ///< Watches the bounded search on the worker thread
+    BoundedSearch::Result boundedResult; ///< The last bounded search, without its path
+    AnytimeSearch *anytime; ///< Runs ARA* on the worker thread and reports better paths
+    QFutureWatcher<AnytimeSearch::Result> *anytimeWatcher; ///< Watches the anytime search on the worker thread
+    AnytimeSearch::Result anytimeResult; ///< The last anytime search, without its path
+    QFutureWatcher<RectangleSearch::Result> *rectangleWatcher; ///< Watches the rectangle search on the worker thread
+    RectangleSearch::Result rectangleResult; ///< The last rectangle search, without its path
+    QFutureWatcher<ShardedSearch::Result> *shardedWatcher; ///< Watches the coordinator of the sharded search on the worker thread
+    ShardedSearch::Result shardedResult; ///< The last sharded search, without its path
 
-
-    bool interruptSearch; ///< A flag to interrupt the search
     int rows;
     int columns;
     int tickInterval; ///< How fast should the DFS or BFS ticker run
+    RunMode runMode;
+    int expansionsPerTick; ///< Productive expansions per tick in animated mode
     qint64 timeElapsed;
+    int nodesExpanded; ///< Expansions of the last search
+    int openNodes; ///< Nodes which aren't walls, the upper bound for the expansions
+    void countOpenNodes();
+    QBitArray snapshotWalls(); ///< Gets one bit per node id, set for walls
+    MazeNode *linkPath(const QVector<int> &path); ///< Links the nodes of a path so it can be traced back from the exit
+    void emitProgress(int expanded, int frontierSize);
+    void startStepper(SearchStepper::Mode mode);
+    void runStepper(); ///< Starts the timers that drive the stepper
+    void finishStepper(); ///< Stops the search once the stepper is done or interrupted
     void stopSearch(MazeNode* stopSearch);
-    QList<MazeNode*>* getAdjacentUnvisitedNodes(int currentID); ///< Gets the adjacent nodes which have not been visited
-    void traceBack(MazeNode* lastNode); ///< traces a path back from the given node to the start (if path has been set)
 private slots:
-    void takeFromStack();
-    void takeFromQueue();
+    void tick();
+    void autoCheckpoint();
+    void finishCheckpoint();
+    void reportKernelProgress();
+    void finishKernelSearch();
+    void finishBoundedSearch();
+    void showImprovedPath(QVector<int> path, double bound, qint64 elapsedUs);
+    void finishAnytimeSearch();
+    void finishRectangleSearch();
+    void finishShardedSearch();
 signals:
     void displayExit(MazeNode *exitNode);
+    void improvedPath(MazeNode *exitNode, double bound, qint64 elapsedUs); ///< The anytime search found a better path, at most bound times the shortest
+    void progress(int expanded, int frontierSize, double fraction); ///< Periodic progress of the running search
+    void checkpointSaved(QString fileName, bool saved, qint64 captureUs); ///< A checkpoint has been written, or failed to
 
 };
 
@@ -0,0 +1,250 @@
+#include "opendirectiontable.h"
+
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include <cstring>
+
+/**
+ * @brief Spreads the lowest eight bits of a word into eight bytes, bit k into bit 0 of byte k
+ * @param bits The bits, the higher ones are ignored
+ * @return Eight bytes, each 0 or 1
+ */
+static inline quint64 spreadBits(quint64 bits)
+{
+    // A copy of the byte in every byte keeps bit k in byte k, adding 0x7f moves it to bit 7
+    // without a carry into the next byte
+    quint64 copies = ((bits & 0xff) * Q_UINT64_C(0x0101010101010101)) & Q_UINT64_C(0x8040201008040201);
+    return ((copies + Q_UINT64_C(0x7f7f7f7f7f7f7f7f)) >> 7) & Q_UINT64_C(0x0101010101010101);
+}
+
+/**
+ * @brief Creates an empty table
+ */
+OpenDirectionTable::OpenDirectionTable()
+{
+    rows = 0;
+    columns = 0;
+    wordsPerRow = 0;
+    wallHash = 0;
+    for(int direction = 0; direction < 4; direction++){
+        offsets[direction] = 0;
+    }
+}
+
+/**
+ * @brief Starts over with a maze of the given size without walls
+ * @param nrows Number of rows
+ * @param ncolumns Number of columns
+ */
+void OpenDirectionTable::reset(int nrows, int ncolumns)
+{
+    rows = qMax(nrows, 0);
+    columns = qMax(ncolumns, 0);
+    wordsPerRow = (columns + 63) / 64;
+    offsets[South] = columns;
+    offsets[North] = -columns;
+    offsets[East] = 1;
+    offsets[West] = -1;
+    masks.resize(rows * columns);
+    clearWalls();
+}
+
+/**
+ * @brief Opens every cell, only the edges of the maze close directions
+ */
+void OpenDirectionTable::clearWalls()
+{
+    wallBits.fill(0, rows * wordsPerRow);
+    wallHash = 0;
+    for(int row = 0; row < rows; row++){
+        buildRow(row);
+    }
+}
+
+/**
+ * @brief Sets all walls and rebuilds the whole table
+ * @param walls One bit per node id, set for walls
+ */
+void OpenDirectionTable::setWalls(const QBitArray &walls)
+{
+    wallBits.fill(0, rows * wordsPerRow);
+    wallHash = 0;
+    for(int row = 0; row < rows; row++){
+        quint64 *rowBits = wallBits.data() + row * wordsPerRow;
+        int first = row * columns;
+        for(int column = 0; column < columns; column++){
+            if(walls.testBit(first + column)){
+                rowBits[column >> 6] |= quint64(1) << (column & 63);
+                wallHash ^= cellKey(first + column);
+            }
+        }
+    }
+    for(int row = 0; row < rows; row++){
+        buildRow(row);
+    }
+}
+
+/**
+ * @brief Sets or clears one wall. Only the cell and its neighbours can change their masks, and
+ * the hash only changes by the key of the cell.
+ * @param id The node id of the cell
+ * @param wall True for a wall
+ */
+void OpenDirectionTable::setWall(int id, bool wall)
+{
+    int row = id / columns;
+    int column = id % columns;
+    quint64 &word = wallBits[row * wordsPerRow + (column >> 6)];
+    quint64 bit = quint64(1) << (column & 63);
+    if(((word & bit) != 0) != wall){
+        wallHash ^= cellKey(id);
+    }
+    word = wall ? word | bit : word & ~bit;
+
+    patch(id);
+    if(row + 1 < rows){
+        patch(id + columns);
+    }
+    if(row > 0){
+        patch(id - columns);
+    }
+    if(column + 1 < columns){
+        patch(id + 1);
+    }
+    if(column > 0){
+        patch(id - 1);
+    }
+}
+
+/**
+ * @brief Gets all walls
+ * @return One bit per node id, set for walls
+ */
+QBitArray OpenDirectionTable::getWalls() const
+{
+    QBitArray walls(rows * columns);
+    for(int row = 0; row < rows; row++){
+        const quint64 *rowBits = wallBits.constData() + row * wordsPerRow;
+        for(int word = 0; word < wordsPerRow; word++){
+            quint64 bits = rowBits[word];
+            while(bits != 0){
+                walls.setBit(row * columns + word * 64 + qCountTrailingZeroBits(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+    return walls;
+}
+
+/**
+ * @brief Gets the Zobrist key of a cell, computed from the id by the splitmix64 finalizer, so
+ * hashes stay the same across runs and can be stored
+ * @param id The node id of the cell
+ * @return The key
+ */
+quint64 OpenDirectionTable::cellKey(int id)
+{
+    quint64 key = quint64(id) + Q_UINT64_C(0x9e3779b97f4a7c15);
+    key = (key ^ (key >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    key = (key ^ (key >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return key ^ (key >> 31);
+}
+
+/**
+ * @brief Checks the wall bit of a cell
+ * @param id The node id
+ * @return True if the cell is a wall
+ */
+bool OpenDirectionTable::isWall(int id) const
+{
+    int column = id % columns;
+    return (wallBits.at(id / columns * wordsPerRow + (column >> 6)) >> (column & 63)) & 1;
+}
+
+/**
+ * @brief Gets the number of rows of the table
+ * @return The number of rows
+ */
+int OpenDirectionTable::getRows() const
+{
+    return rows;
+}
+
+/**
+ * @brief Gets the number of columns of the table
+ * @return The number of columns
+ */
+int OpenDirectionTable::getColumns() const
+{
+    return columns;
+}
+
+/**
+ * @brief Gets the open cells of a word of a row
+ * @param row The row, outside of the maze for none
+ * @param word The word of the row, outside of the row for none
+ * @return One bit per column, set for open cells
+ */
+quint64 OpenDirectionTable::openWord(int row, int word) const
+{
+    if(row < 0 || row >= rows || word < 0 || word >= wordsPerRow){
+        return 0;
+    }
+    int count = qMin(64, columns - word * 64);
+    quint64 inside = count == 64 ? ~quint64(0) : (quint64(1) << count) - 1;
+    return ~wallBits.at(row * wordsPerRow + word) & inside;
+}
+
+/**
+ * @brief Computes the masks of a row, 64 cells at a time. The open neighbours to the east and
+ * west are the open cells shifted by a column, with the bit carried over from the next word.
+ * @param row The row
+ */
+void OpenDirectionTable::buildRow(int row)
+{
+    char *rowMasks = masks.data() + row * columns;
+    for(int word = 0; word < wordsPerRow; word++){
+        quint64 open = openWord(row, word);
+        quint64 south = open & openWord(row + 1, word);
+        quint64 north = open & openWord(row - 1, word);
+        quint64 east = open & ((open >> 1) | (openWord(row, word + 1) << 63));
+        quint64 west = open & ((open << 1) | (openWord(row, word - 1) >> 63));
+
+        int first = word * 64;
+        int count = qMin(64, columns - first);
+        for(int shift = 0; shift < count; shift += 8){
+            quint64 eight = spreadBits(south >> shift) << South | spreadBits(north >> shift) << North
+                          | spreadBits(east >> shift) << East | spreadBits(west >> shift) << West;
+            uchar bytes[8];
+            qToLittleEndian(eight, bytes);
+            memcpy(rowMasks + first + shift, bytes, qMin(8, count - shift));
+        }
+    }
+}
+
+/**
+ * @brief Computes the mask of one cell from the walls around it
+ * @param id The node id of the cell
+ */
+void OpenDirectionTable::patch(int id)
+{
+    int row = id / columns;
+    int column = id % columns;
+    int mask = 0;
+    if(!isWall(id)){
+        if(row + 1 < rows && !isWall(id + columns)){
+            mask |= 1 << South;
+        }
+        if(row > 0 && !isWall(id - columns)){
+            mask |= 1 << North;
+        }
+        if(column + 1 < columns && !isWall(id + 1)){
+            mask |= 1 << East;
+        }
+        if(column > 0 && !isWall(id - 1)){
+            mask |= 1 << West;
+        }
+    }
+    masks[id] = char(mask);
+}
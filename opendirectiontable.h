@@ -0,0 +1,62 @@
+#ifndef OPENDIRECTIONTABLE_H
+#define OPENDIRECTIONTABLE_H
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QVector>
+
+/**
+ * @brief A 4-bit mask per cell of the directions whose neighbour is inside the maze and not a
+ * wall, so expanding a cell is a lookup and a loop over the set bits, without checking the
+ * edges of the maze or the walls of the neighbours.
+ *
+ * The walls are kept packed, 64 cells of a row per word. The whole table is built a word at a
+ * time: the open cells of a row shifted by one column and those of the rows above and below
+ * give the open neighbours of 64 cells at once, which are then spread into eight masks per
+ * step. Setting or clearing one wall patches the cell and its four neighbours.
+ *
+ * The table also keeps a Zobrist hash of the walls, the XOR of a fixed key per wall cell, so a
+ * wall change updates it with one XOR and the hash of the maze is always at hand.
+ */
+class OpenDirectionTable
+{
+public:
+    /// Directions in the order the searches expand them, direction d is bit 1 << d of a mask
+    enum Direction {
+        South = 0,
+        North = 1,
+        East = 2,
+        West = 3
+    };
+
+    OpenDirectionTable();
+    void reset(int nrows, int ncolumns); ///< Starts over with an open maze of the given size
+    void clearWalls(); ///< Opens every cell
+    void setWalls(const QBitArray &walls); ///< Sets all walls from one bit per node id and rebuilds the table
+    void setWall(int id, bool wall); ///< Sets or clears one wall and patches the masks around it
+    QBitArray getWalls() const; ///< Gets one bit per node id, set for walls
+    bool isWall(int id) const;
+    int getRows() const;
+    int getColumns() const;
+    quint64 getWallHash() const { return wallHash; } ///< Zobrist hash of the walls, 0 without walls
+
+    static quint64 cellKey(int id); ///< The Zobrist key of a cell, the same in every run
+
+    int getMask(int id) const { return uchar(masks.at(id)); } ///< The open directions of a cell
+    int getOffset(int direction) const { return offsets[direction]; } ///< Difference of the ids of a cell and its neighbour
+
+private:
+    int rows;
+    int columns;
+    int wordsPerRow;
+    int offsets[4];
+    QVector<quint64> wallBits; ///< wordsPerRow words per row, column c in bit c % 64 of word c / 64
+    QByteArray masks; ///< One mask per node id
+    quint64 wallHash;
+
+    quint64 openWord(int row, int word) const; ///< Open cells of a word of a row, none outside of the maze
+    void buildRow(int row); ///< Computes the masks of a row from the packed walls
+    void patch(int id); ///< Computes the mask of one cell
+};
+
+#endif // OPENDIRECTIONTABLE_H
@@ -0,0 +1,305 @@
+#include "racewindow.h"
+#include "timelinetrace.h"
+
+#include <QCloseEvent>
+#include <QGridLayout>
+#include <QPainter>
+#include <QStringList>
+#include <QVBoxLayout>
+
+/// Mini views per row of the window
+static const int viewsPerRow = 4;
+/// Colours of the paths: the winner's, the other shortest ones and the longer ones
+static const QRgb winnerColour = qRgb(0, 170, 0);
+static const QRgb shortestColour = qRgb(40, 110, 220);
+static const QRgb longerColour = qRgb(220, 120, 0);
+
+/**
+ * @brief Creates an empty mini view
+ * @param parent The parent for reference purposes
+ */
+RaceMiniView::RaceMiniView(QWidget *parent) :
+    QWidget(parent)
+{
+    fraction = 0;
+    setMinimumSize(160, 150);
+}
+
+/**
+ * @brief Shows a new maze
+ * @param mazeImage The walls, one pixel per cell
+ */
+void RaceMiniView::setMaze(const QImage &mazeImage)
+{
+    picture = mazeImage.copy();
+    update();
+}
+
+/**
+ * @brief Colours the cells of a path
+ * @param path Node ids of the path
+ * @param columns The width of the maze
+ * @param colour The colour of the path
+ */
+void RaceMiniView::setPath(const QVector<int> &path, int columns, QRgb colour)
+{
+    foreach(int id, path){
+        picture.setPixel(id % columns, id / columns, colour);
+    }
+    update();
+}
+
+/**
+ * @brief Sets the text above and below the maze and the bar of expanded cells
+ * @param name The racer
+ * @param counters Expansions and time, or the outcome
+ * @param expandedFraction Share of the open cells expanded
+ */
+void RaceMiniView::setStatus(const QString &name, const QString &counters, double expandedFraction)
+{
+    title = name;
+    status = counters;
+    fraction = qBound(0.0, expandedFraction, 1.0);
+    update();
+}
+
+/**
+ * @brief Paints the name, the maze scaled to fit, the bar and the counters
+ * @param event The paint event
+ */
+void RaceMiniView::paintEvent(QPaintEvent *event)
+{
+    TIMELINE_SCOPE("RaceMiniView::paintEvent", "paint");
+    Q_UNUSED(event);
+    QPainter painter(this);
+    int textHeight = fontMetrics().height();
+    painter.drawText(QRect(0, 0, width(), textHeight), Qt::AlignLeft, title);
+
+    // The maze keeps its aspect ratio
+    QRect area(0, textHeight + 2, width(), height() - 2 * textHeight - 10);
+    if(!picture.isNull() && area.height() > 0){
+        double scale = qMin(double(area.width()) / picture.width(), double(area.height()) / picture.height());
+        QRect target(area.x(), area.y(), int(picture.width() * scale), int(picture.height() * scale));
+        painter.drawImage(target, picture);
+    }
+
+    QRect bar(0, height() - textHeight - 6, width(), 4);
+    painter.fillRect(bar, Qt::lightGray);
+    painter.fillRect(QRect(bar.x(), bar.y(), int(bar.width() * fraction), bar.height()), Qt::darkGreen);
+    painter.drawText(QRect(0, height() - textHeight, width(), textHeight), Qt::AlignLeft, status);
+}
+
+/**
+ * @brief Sets up the mini views, the comparison table and the cancel button
+ * @param parent The window the race belongs to, it opens as a window of its own
+ */
+RaceWindow::RaceWindow(QWidget *parent) :
+    QWidget(parent)
+{
+    setWindowFlags(Qt::Window);
+    setWindowTitle("Solver Race");
+    openCells = 0;
+
+    QVBoxLayout *layout = new QVBoxLayout();
+    setLayout(layout);
+
+    QGridLayout *viewLayout = new QGridLayout();
+    layout->addLayout(viewLayout);
+    for(int racer = 0; racer < SolverRace::RacerCount; racer++){
+        views[racer] = new RaceMiniView(this);
+        viewLayout->addWidget(views[racer], racer / viewsPerRow, racer % viewsPerRow);
+    }
+
+    statusLabel = new QLabel(this);
+    layout->addWidget(statusLabel);
+
+    table = new QTableWidget(0, 7, this);
+    table->setHorizontalHeaderLabels(QStringList() << "Place" << "Solver" << "Result" << "Path" << "Expanded" << "Time (ms)" << "Expanded per ms");
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(table);
+
+    cancelButton = new QPushButton("Cancel Race", this);
+    cancelButton->setEnabled(false);
+    layout->addWidget(cancelButton);
+
+    race = new SolverRace(this);
+    refreshTimer = new QTimer(this);
+
+    connect(race, SIGNAL(racerFinished(int)), this, SLOT(showFinishedRacer(int)));
+    connect(race, SIGNAL(finished()), this, SLOT(finishRace()));
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+    connect(cancelButton, SIGNAL(clicked()), this, SLOT(cancelRace()));
+}
+
+/**
+ * @brief Shows the maze in every mini view and starts all racers
+ * @param grid The maze, the race works on a copy
+ * @param start Node id of the start
+ * @param goal Node id of the goal
+ * @param settings The options of the solvers
+ */
+void RaceWindow::startRace(const MazeGrid &grid, int start, int goal, const SolverRace::Settings &settings)
+{
+    int rows = grid.getRows();
+    int columns = grid.getColumns();
+    QBitArray walls = grid.getWalls();
+    mazeImage = QImage(columns, rows, QImage::Format_RGB32);
+    openCells = 0;
+    for(int id = 0; id < rows * columns; id++){
+        bool wall = walls.testBit(id);
+        mazeImage.setPixel(id % columns, id / columns, wall ? qRgb(40, 40, 40) : qRgb(255, 255, 255));
+        openCells += wall ? 0 : 1;
+    }
+    mazeImage.setPixel(start % columns, start / columns, qRgb(230, 200, 0));
+    mazeImage.setPixel(goal % columns, goal / columns, qRgb(0, 120, 230));
+
+    for(int racer = 0; racer < SolverRace::RacerCount; racer++){
+        views[racer]->setMaze(mazeImage);
+    }
+    table->setRowCount(0);
+    cancelButton->setEnabled(true);
+
+    race->start(grid, start, goal, settings);
+    for(int racer = 0; racer < SolverRace::RacerCount; racer++){
+        views[racer]->setVisible(race->isEntered(racer));
+    }
+    refresh();
+    refreshTimer->start(refreshIntervalMs);
+}
+
+/**
+ * @brief Checks if the race is still running
+ * @return True while a racer is searching
+ */
+bool RaceWindow::isRacing() const
+{
+    return race->isRunning();
+}
+
+/**
+ * @brief Gets what became of a racer
+ * @param outcome The outcome of the racer
+ * @return A few words on its result
+ */
+QString RaceWindow::describe(const SolverRace::Outcome &outcome) const
+{
+    if(!outcome.finished){
+        return "Running";
+    }
+    if(outcome.cancelled){
+        return "Cancelled";
+    }
+    if(!outcome.note.isEmpty() && !outcome.found){
+        return outcome.note;
+    }
+    if(!outcome.found){
+        return "No path";
+    }
+    if(!outcome.note.isEmpty()){
+        return outcome.note;
+    }
+    return outcome.shortest ? QString("Shortest path") : "Path";
+}
+
+/**
+ * @brief Updates the counters of all running racers at once
+ */
+void RaceWindow::refresh()
+{
+    int runningRacers = 0;
+    for(int racer = 0; racer < SolverRace::RacerCount; racer++){
+        SolverRace::Outcome outcome = race->getOutcome(racer);
+        if(!race->isEntered(racer) || outcome.finished){
+            continue;
+        }
+        runningRacers++;
+        views[racer]->setStatus(SolverRace::racerName(racer),
+                                QString::number(outcome.expanded) + " expanded, " + QString::number(outcome.elapsedUs / 1000.0, 'f', 1) + " ms",
+                                openCells > 0 ? double(outcome.expanded) / openCells : 0.0);
+    }
+    statusLabel->setText(QString::number(runningRacers) + " solvers running");
+}
+
+/**
+ * @brief Shows the final counters and the path of a racer that has returned
+ * @param racer The racer
+ */
+void RaceWindow::showFinishedRacer(int racer)
+{
+    SolverRace::Outcome outcome = race->getOutcome(racer);
+    int place = race->getPlaces().indexOf(racer) + 1;
+    if(outcome.found){
+        views[racer]->setPath(outcome.path, race->getGrid().getColumns(), place == 1 ? winnerColour : outcome.shortest ? shortestColour : longerColour);
+    }
+    views[racer]->setStatus(SolverRace::racerName(racer) + (outcome.found ? " (" + QString::number(place) + ")" : QString()),
+                            describe(outcome) + ", " + QString::number(outcome.expanded) + " expanded, "
+                            + QString::number(outcome.elapsedUs / 1000.0, 'f', 2) + " ms",
+                            openCells > 0 ? double(outcome.expanded) / openCells : 0.0);
+}
+
+/**
+ * @brief Stops the refreshes, fills in the table and hands the summary on
+ */
+void RaceWindow::finishRace()
+{
+    refreshTimer->stop();
+    cancelButton->setEnabled(false);
+    fillTable();
+
+    // The places are final only now, a later racer may have been faster than an earlier one
+    QVector<int> places = race->getPlaces();
+    QStringList summary;
+    for(int place = 0; place < places.size(); place++){
+        int racer = places.at(place);
+        showFinishedRacer(racer);
+        SolverRace::Outcome outcome = race->getOutcome(racer);
+        summary.append(QString::number(place + 1) + ". " + SolverRace::racerName(racer) + ": " + describe(outcome)
+                       + (outcome.found ? ", " + QString::number(outcome.path.size()) + " nodes" : QString()) + ", "
+                       + QString::number(outcome.expanded) + " expanded in " + QString::number(outcome.elapsedUs / 1000.0, 'f', 2) + " ms");
+    }
+    statusLabel->setText("Race finished");
+    emit raceFinished(summary);
+}
+
+/**
+ * @brief Writes one row per racer, in the order they placed
+ */
+void RaceWindow::fillTable()
+{
+    QVector<int> places = race->getPlaces();
+    table->setRowCount(places.size());
+    for(int place = 0; place < places.size(); place++){
+        int racer = places.at(place);
+        SolverRace::Outcome outcome = race->getOutcome(racer);
+        double milliseconds = outcome.elapsedUs / 1000.0;
+        table->setItem(place, 0, new QTableWidgetItem(outcome.found ? QString::number(place + 1) : QString("-")));
+        table->setItem(place, 1, new QTableWidgetItem(SolverRace::racerName(racer)));
+        table->setItem(place, 2, new QTableWidgetItem(describe(outcome)));
+        table->setItem(place, 3, new QTableWidgetItem(outcome.found ? QString::number(outcome.path.size()) : QString("-")));
+        table->setItem(place, 4, new QTableWidgetItem(QString::number(outcome.expanded)));
+        table->setItem(place, 5, new QTableWidgetItem(QString::number(milliseconds, 'f', 3)));
+        table->setItem(place, 6, new QTableWidgetItem(milliseconds > 0 ? QString::number(outcome.expanded / milliseconds, 'f', 0) : QString("-")));
+    }
+    table->resizeColumnsToContents();
+}
+
+/**
+ * @brief Stops all racers, those that haven't returned yet show up as cancelled
+ */
+void RaceWindow::cancelRace()
+{
+    cancelButton->setEnabled(false);
+    race->cancel();
+}
+
+/**
+ * @brief Cancels a running race when the window is closed
+ * @param event The close event
+ */
+void RaceWindow::closeEvent(QCloseEvent *event)
+{
+    if(race->isRunning()){
+        cancelRace();
+    }
+    event->accept();
+}
@@ -0,0 +1,76 @@
+#ifndef RACEWINDOW_H
+#define RACEWINDOW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+
+#include "solverrace.h"
+
+/**
+ * @brief A small picture of the maze for one racer, with its name, its counters and how much
+ * of the maze it has expanded, and its path once it has one
+ */
+class RaceMiniView : public QWidget
+{
+public:
+    explicit RaceMiniView(QWidget *parent = 0);
+    void setMaze(const QImage &mazeImage); ///< Sets the walls, one pixel per cell, and drops the path
+    void setPath(const QVector<int> &path, int columns, QRgb colour); ///< Draws a path into the picture
+    void setStatus(const QString &name, const QString &counters, double expandedFraction);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    QImage picture; ///< The walls and the path, scaled when painted
+    QString title;
+    QString status;
+    double fraction; ///< Share of the open cells expanded, 0 to 1
+};
+
+/**
+ * @brief Shows a race of all solvers: a mini view per racer, all refreshed by one timer so
+ * they move in step, and a table comparing them once they're done
+ */
+class RaceWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit RaceWindow(QWidget *parent = 0);
+    void startRace(const MazeGrid &grid, int start, int goal, const SolverRace::Settings &settings); ///< Shows the maze and starts all racers on it
+    bool isRacing() const;
+
+signals:
+    void raceFinished(const QStringList &summary); ///< One line per racer, first place first
+
+protected:
+    void closeEvent(QCloseEvent *event);
+
+private:
+    /// Time between two refreshes of the mini views
+    static const int refreshIntervalMs = 50;
+
+    SolverRace *race;
+    RaceMiniView *views[SolverRace::RacerCount];
+    QTableWidget *table; ///< The comparison of the finished race
+    QLabel *statusLabel;
+    QPushButton *cancelButton;
+    QTimer *refreshTimer; ///< Refreshes all mini views at once
+    QImage mazeImage; ///< The walls of the raced maze, one pixel per cell
+    int openCells; ///< Cells that aren't walls, what a complete search expands
+
+    QString describe(const SolverRace::Outcome &outcome) const; ///< Gets what became of a racer in a few words
+    void fillTable(); ///< Writes the comparison of all racers into the table
+
+private slots:
+    void refresh();
+    void showFinishedRacer(int racer);
+    void finishRace();
+    void cancelRace();
+};
+
+#endif // RACEWINDOW_H
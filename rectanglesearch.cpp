@@ -0,0 +1,292 @@
+#include "rectanglesearch.h"
+#include "timelinetrace.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+/// Cost of cells that haven't been reached
+static const int unreachedCost = 0x7fffffff;
+/// Marks open cells no rectangle covers yet while building
+static const int uncovered = -2;
+
+/// Row and column steps of the MazeGrid directions
+static const int rowStep[4] = { 1, -1, 0, 0 };
+static const int columnStep[4] = { 0, 0, 1, -1 };
+
+/// An entry of the open list, stale once the cell got a lower cost
+struct MacroEntry
+{
+    int f; ///< Cost plus the Manhattan distance to the goal
+    int g; ///< Cost when the entry was pushed
+    int id; ///< Node id
+};
+
+/// Orders the heap by the smallest f first, deeper cells first among equal ones
+static bool laterMacroEntry(const MacroEntry &a, const MacroEntry &b)
+{
+    return a.f > b.f || (a.f == b.f && a.g < b.g);
+}
+
+/**
+ * @brief Creates an empty decomposition
+ */
+RectangleSearch::RectangleSearch()
+{
+    rows = 0;
+    columns = 0;
+}
+
+/**
+ * @brief Covers the open cells with rectangles that hold no walls. Each row-major first
+ * uncovered cell starts a rectangle that grows right first and then down.
+ * @param grid The maze, only read
+ */
+void RectangleSearch::build(const MazeGrid &grid)
+{
+    rows = grid.getRows();
+    columns = grid.getColumns();
+    owner.resize(rows * columns);
+    rectangles.clear();
+
+    // Marks the open cells first, so growing the rectangles reads one array only
+    int *cells = owner.data();
+    for(int row = 0; row < rows; row++){
+        for(int column = 0; column < columns; column++){
+            cells[row * columns + column] = grid.isWall(grid.indexOf(row, column)) ? -1 : uncovered;
+        }
+    }
+
+    for(int id = 0; id < rows * columns; id++){
+        if(cells[id] != uncovered){
+            continue;
+        }
+        Rectangle rectangle;
+        rectangle.top = id / columns;
+        rectangle.left = id % columns;
+        rectangle.right = rectangle.left;
+        while(rectangle.right + 1 < columns && cells[id + rectangle.right + 1 - rectangle.left] == uncovered){
+            rectangle.right++;
+        }
+        int width = rectangle.right - rectangle.left + 1;
+        rectangle.bottom = rectangle.top;
+        while(rectangle.bottom + 1 < rows){
+            const int *below = cells + (rectangle.bottom + 1) * columns + rectangle.left;
+            int open = 0;
+            while(open < width && below[open] == uncovered){
+                open++;
+            }
+            if(open < width){
+                break;
+            }
+            rectangle.bottom++;
+        }
+
+        int number = rectangles.size();
+        for(int rr = rectangle.top; rr <= rectangle.bottom; rr++){
+            std::fill(cells + rr * columns + rectangle.left, cells + rr * columns + rectangle.right + 1, number);
+        }
+        rectangles.append(rectangle);
+    }
+}
+
+/**
+ * @brief Gets the number of open rectangles the maze was split into
+ * @return The number of rectangles
+ */
+int RectangleSearch::getRectangleCount() const
+{
+    return rectangles.size();
+}
+
+/**
+ * @brief Gets the bounds of a rectangle
+ * @param rectangle The number of the rectangle
+ * @return The rectangle
+ */
+const RectangleSearch::Rectangle &RectangleSearch::getRectangle(int rectangle) const
+{
+    return rectangles.at(rectangle);
+}
+
+/**
+ * @brief Gets the rectangle a cell belongs to
+ * @param id The node id of the cell
+ * @return The number of the rectangle, -1 for walls
+ */
+int RectangleSearch::rectangleOf(int id) const
+{
+    return owner.at(id);
+}
+
+/**
+ * @brief Runs A* over the border cells of the rectangles. A cell steps to its neighbours on
+ * the border or in other rectangles, and crosses its rectangle where the neighbour is inside.
+ * Every cell of the goal's rectangle also steps to the goal directly.
+ * @param start The node id to start from
+ * @param goal The node id to reach
+ * @param control Cancel flag and counters, may be 0
+ * @return The path and the counters, without the decomposition figures
+ */
+RectangleSearch::Result RectangleSearch::search(int start, int goal, SearchControl *control) const
+{
+    Result result;
+    int cells = rows * columns;
+    if(start < 0 || goal < 0 || start >= cells || goal >= cells || owner.at(start) < 0 || owner.at(goal) < 0){
+        return result;
+    }
+    int goalRow = goal / columns;
+    int goalColumn = goal % columns;
+    int goalRectangle = owner.at(goal);
+
+    QVector<int> g(cells, unreachedCost);
+    QVector<int> parent(cells, -1);
+    QVector<MacroEntry> open;
+    MacroEntry first = { qAbs(start / columns - goalRow) + qAbs(start % columns - goalColumn), 0, start };
+    open.append(first);
+    g[start] = 0;
+
+    while(!open.isEmpty()){
+        std::pop_heap(open.begin(), open.end(), laterMacroEntry);
+        MacroEntry entry = open.last();
+        open.removeLast();
+        if(entry.g > g.at(entry.id)){
+            continue; // Stale
+        }
+        if(entry.id == goal){
+            result.found = true;
+            break;
+        }
+
+        result.expanded++;
+        if(control != 0 && result.expanded % SearchControl::PollInterval == 0){
+            if(control->poll(int(qMin(result.expanded, qint64(0x7fffffff))), open.size())){
+                result.cancelled = true;
+                return result;
+            }
+        }
+
+        int row = entry.id / columns;
+        int column = entry.id % columns;
+        int number = owner.at(entry.id);
+        const Rectangle &rectangle = rectangles.at(number);
+
+        int targets[5];
+        int costs[5];
+        int count = 0;
+        for(int direction = 0; direction < 4; direction++){
+            int nextRow = row + rowStep[direction];
+            int nextColumn = column + columnStep[direction];
+            if(nextRow < 0 || nextRow >= rows || nextColumn < 0 || nextColumn >= columns){
+                continue;
+            }
+            int next = nextRow * columns + nextColumn;
+            if(owner.at(next) < 0){
+                continue;
+            }
+            if(owner.at(next) == number && !onBorder(nextRow, nextColumn, rectangle)){
+                // Cross to the far side in one step
+                switch(direction){
+                case MazeGrid::South:
+                    nextRow = rectangle.bottom;
+                    break;
+                case MazeGrid::North:
+                    nextRow = rectangle.top;
+                    break;
+                case MazeGrid::East:
+                    nextColumn = rectangle.right;
+                    break;
+                default:
+                    nextColumn = rectangle.left;
+                    break;
+                }
+                next = nextRow * columns + nextColumn;
+            }
+            targets[count] = next;
+            costs[count] = qAbs(nextRow - row) + qAbs(nextColumn - column);
+            count++;
+        }
+        if(number == goalRectangle){
+            targets[count] = goal;
+            costs[count] = qAbs(goalRow - row) + qAbs(goalColumn - column);
+            count++;
+        }
+
+        for(int ii = 0; ii < count; ii++){
+            int next = targets[ii];
+            int cost = entry.g + costs[ii];
+            if(cost >= g.at(next)){
+                continue;
+            }
+            g[next] = cost;
+            parent[next] = entry.id;
+            MacroEntry child = { cost + qAbs(next / columns - goalRow) + qAbs(next % columns - goalColumn), cost, next };
+            open.append(child);
+            std::push_heap(open.begin(), open.end(), laterMacroEntry);
+        }
+    }
+
+    if(result.found){
+        QVector<int> macroPath;
+        for(int id = goal; id >= 0; id = parent.at(id)){
+            macroPath.append(id);
+        }
+        std::reverse(macroPath.begin(), macroPath.end());
+        result.path.reserve(g.at(goal) + 1);
+        result.path.append(start);
+        for(int ii = 1; ii < macroPath.size(); ii++){
+            appendSegment(macroPath.at(ii - 1), macroPath.at(ii), result.path);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Rebuilds the cells of one macro step, along the row first and then the column.
+ * Both cells are in one empty rectangle or next to each other, so the cells between are open.
+ * @param from The node id the step starts at, already on the path
+ * @param to The node id the step ends at
+ * @param path The path to append to
+ */
+void RectangleSearch::appendSegment(int from, int to, QVector<int> &path) const
+{
+    int row = from / columns;
+    int column = from % columns;
+    int toRow = to / columns;
+    int toColumn = to % columns;
+    while(column != toColumn){
+        column += column < toColumn ? 1 : -1;
+        path.append(row * columns + column);
+    }
+    while(row != toRow){
+        row += row < toRow ? 1 : -1;
+        path.append(row * columns + column);
+    }
+}
+
+/**
+ * @brief Builds the rectangles of a maze and searches it once, for a worker thread
+ * @param grid The maze, only read
+ * @param start The node id to start from
+ * @param goal The node id to reach
+ * @param control Cancel flag and counters, may be 0
+ * @return The path, the counters and the decomposition figures
+ */
+RectangleSearch::Result RectangleSearch::run(const MazeGrid &grid, int start, int goal, SearchControl *control)
+{
+    TIMELINE_SCOPE("RectangleSearch::run", "solver");
+    QElapsedTimer clock;
+    clock.start();
+    RectangleSearch decomposition;
+    decomposition.build(grid);
+    qint64 buildUs = clock.nsecsElapsed() / 1000;
+
+    Result result = decomposition.search(start, goal, control);
+    result.rectangles = decomposition.getRectangleCount();
+    result.buildUs = buildUs;
+    foreach(const Rectangle &rectangle, decomposition.rectangles){
+        result.largestRectangle = qMax(result.largestRectangle,
+                                       (rectangle.bottom - rectangle.top + 1) * (rectangle.right - rectangle.left + 1));
+    }
+    return result;
+}
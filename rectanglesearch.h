@@ -0,0 +1,72 @@
+#ifndef RECTANGLESEARCH_H
+#define RECTANGLESEARCH_H
+
+#include <QVector>
+
+#include "mazegrid.h"
+#include "searchcontrol.h"
+
+/**
+ * @brief A* over empty rectangles (rectangular symmetry reduction) for mostly open mazes.
+ *
+ * build() covers the open cells with rectangles that hold no walls. Every row-major first
+ * uncovered cell starts one, which grows to the right as far as it can and then down while
+ * the whole width stays open and uncovered. Inside such a rectangle all shortest paths
+ * between two cells are equally long, so the search only stops on the cells of its border:
+ * from a border cell it steps along the border or out of the rectangle, or crosses the whole
+ * rectangle in a single macro step. The cells in between are never expanded, which on open
+ * floor cuts the expansions from the area of a region to its perimeter. A start inside a
+ * rectangle crosses to the border the same way, and any cell of the rectangle holding the
+ * goal can step to it directly.
+ *
+ * The macro steps cost as many cells as they cross and the Manhattan distance stays a
+ * consistent estimate, so the path is a shortest one. It's rebuilt cell by cell at the end.
+ */
+class RectangleSearch
+{
+public:
+    /// A rectangle of open cells, bounds inclusive
+    struct Rectangle
+    {
+        int top;
+        int left;
+        int bottom;
+        int right;
+    };
+
+    /// The outcome of a search
+    struct Result
+    {
+        Result() : found(false), cancelled(false), expanded(0), rectangles(0), largestRectangle(0), buildUs(0) {}
+        bool found; ///< True if the goal has been reached
+        bool cancelled; ///< True if the search stopped on a cancel request
+        qint64 expanded; ///< Border cells expanded
+        int rectangles; ///< Rectangles covering the open cells
+        int largestRectangle; ///< Cells of the largest rectangle
+        qint64 buildUs; ///< Microseconds spent on the decomposition
+        QVector<int> path; ///< Node ids from the start to the goal, empty if not found
+    };
+
+    RectangleSearch();
+    void build(const MazeGrid &grid); ///< Covers the open cells with empty rectangles
+    int getRectangleCount() const;
+    const Rectangle &getRectangle(int rectangle) const;
+    int rectangleOf(int id) const; ///< The rectangle holding a node id, -1 for walls
+
+    Result search(int start, int goal, SearchControl *control) const; ///< Finds a shortest path with macro steps across the rectangles
+    static Result run(const MazeGrid &grid, int start, int goal, SearchControl *control); ///< Builds the rectangles and searches once
+
+private:
+    int rows;
+    int columns;
+    QVector<int> owner; ///< Rectangle of each node id, -1 for walls
+    QVector<Rectangle> rectangles;
+
+    bool onBorder(int row, int column, const Rectangle &rectangle) const
+    {
+        return row == rectangle.top || row == rectangle.bottom || column == rectangle.left || column == rectangle.right;
+    }
+    void appendSegment(int from, int to, QVector<int> &path) const; ///< Appends the cells after from up to to, both in one rectangle or neighbours
+};
+
+#endif // RECTANGLESEARCH_H
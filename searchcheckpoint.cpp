@@ -0,0 +1,159 @@
+#include "searchcheckpoint.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+
+#include "mazegrid.h"
+
+/**
+ * @brief Checks if the checkpoint holds a search
+ * @return True if nothing has been saved or loaded
+ */
+bool SearchCheckpoint::isEmpty() const
+{
+    return rows <= 0 || columns <= 0;
+}
+
+/**
+ * @brief Gets the number of nodes still waiting to be expanded
+ * @return The frontier entries that haven't been taken off yet
+ */
+int SearchCheckpoint::getFrontierSize() const
+{
+    return frontier.size() - frontierHead;
+}
+
+/**
+ * @brief Gets the node a reached node was reached from, by the direction stored for it
+ * @param id The node id
+ * @return The node id of the parent, -1 if the direction leads off the grid or across the edge
+ * of a row
+ */
+int SearchCheckpoint::parentOf(int id) const
+{
+    int column = id % columns;
+    switch(parentDirection(id)){
+    case MazeGrid::South:
+        return id + columns;
+    case MazeGrid::North:
+        return id - columns;
+    case MazeGrid::East:
+        return column + 1 < columns ? id + 1 : -1;
+    default:
+        return column > 0 ? id - 1 : -1;
+    }
+}
+
+/**
+ * @brief Writes the checkpoint. The planes are serialized and compressed in memory, then
+ * written to a temporary file that replaces the target once it's complete.
+ * @param fileName The file to write to
+ * @return True on success
+ */
+bool SearchCheckpoint::save(const QString &fileName) const
+{
+    if(isEmpty()){
+        return false;
+    }
+
+    // Only the waiting part of the frontier is kept
+    QByteArray payload;
+    {
+        QDataStream planes(&payload, QIODevice::WriteOnly);
+        planes.setVersion(QDataStream::Qt_5_0);
+        planes << walls << visited << reached << parents << frontier.mid(frontierHead);
+        if(planes.status() != QDataStream::Ok){
+            return false;
+        }
+    }
+
+    QString partName = fileName + ".part";
+    QFile file(partName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << magic << version << qint32(mode) << qint32(rows) << qint32(columns) << qint32(expandedCount)
+        << qCompress(payload, 1);
+    file.close();
+    if(out.status() != QDataStream::Ok){
+        QFile::remove(partName);
+        return false;
+    }
+
+    QFile::remove(fileName);
+    return QFile::rename(partName, fileName);
+}
+
+/**
+ * @brief Reads a checkpoint written by save
+ * @param fileName The file to read from
+ * @return True on success, the checkpoint is left empty otherwise
+ */
+bool SearchCheckpoint::load(const QString &fileName)
+{
+    *this = SearchCheckpoint();
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 fileMagic;
+    qint32 fileVersion;
+    qint32 fileMode;
+    qint32 fileRows;
+    qint32 fileColumns;
+    qint32 fileExpanded;
+    QByteArray compressed;
+    in >> fileMagic >> fileVersion;
+    if(fileMagic != magic || fileVersion > version){
+        return false;
+    }
+    in >> fileMode >> fileRows >> fileColumns >> fileExpanded >> compressed;
+    if(in.status() != QDataStream::Ok || fileRows <= 0 || fileColumns <= 0 || qint64(fileRows) * fileColumns > (qint64(1) << 30)){
+        return false;
+    }
+
+    QByteArray payload = qUncompress(compressed);
+    QDataStream planes(payload);
+    planes.setVersion(QDataStream::Qt_5_0);
+    planes >> walls >> visited >> reached >> parents >> frontier;
+
+    int cells = fileRows * fileColumns;
+    if(planes.status() != QDataStream::Ok || walls.size() != cells || visited.size() != cells
+            || reached.size() != cells || parents.size() != (cells + 31) / 32){
+        *this = SearchCheckpoint();
+        return false;
+    }
+    foreach(int id, frontier){
+        if(id < 0 || id >= cells){
+            *this = SearchCheckpoint();
+            return false;
+        }
+    }
+
+    // Every reached cell has to lead back to the entrance through reached cells of the grid.
+    // Cycles pass this check, the path trace is bounded by the number of cells.
+    columns = fileColumns;
+    for(int id = 0; id < cells; id++){
+        if(!reached.testBit(id)){
+            continue;
+        }
+        int parentId = parentOf(id);
+        if(parentId < 0 || parentId >= cells || (parentId != 0 && !reached.testBit(parentId))){
+            *this = SearchCheckpoint();
+            return false;
+        }
+    }
+
+    mode = fileMode;
+    rows = fileRows;
+    columns = fileColumns;
+    expandedCount = fileExpanded;
+    frontierHead = 0;
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef SEARCHCHECKPOINT_H
+#define SEARCHCHECKPOINT_H
+
+#include <QBitArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The complete state of a stepwise DFS or BFS search, enough to carry on with it later
+ * and in another process: the maze, the frontier, which cells have been visited and the
+ * direction from every reached cell back to its parent.
+ *
+ * All parts are implicitly shared Qt containers. Taking a checkpoint from a running search
+ * only copies references, the search copies a plane when it next writes to it, so a checkpoint
+ * never sees a half-written state and the search never waits for the file.
+ *
+ * The file holds a small header and the planes compressed with zlib. It's written next to the
+ * target and renamed over it, so an interrupted write leaves the previous checkpoint intact.
+ */
+struct SearchCheckpoint
+{
+    SearchCheckpoint() : mode(0), rows(0), columns(0), expandedCount(0), frontierHead(0) {}
+
+    int mode; ///< SearchStepper::Mode of the search
+    int rows;
+    int columns;
+    int expandedCount; ///< Nodes expanded so far
+    QBitArray walls; ///< One bit per node id, set for walls
+    QBitArray visited; ///< One bit per node id, set once expanded
+    QBitArray reached; ///< One bit per node id, set once the node has a parent
+    QVector<quint64> parents; ///< Direction to the parent as a MazeGrid::Direction, two bits per node id, 32 per word
+    QVector<int> frontier; ///< Node ids on the stack or queue, head first
+    int frontierHead; ///< Entries of the frontier before this one have been taken off already
+
+    bool isEmpty() const;
+    int getFrontierSize() const; ///< Node ids still waiting on the frontier
+    int parentDirection(int id) const { return int((parents.at(id >> 5) >> ((id & 31) * 2)) & 3); }
+    int parentOf(int id) const; ///< Node id the direction leads to, -1 across the edge of a row
+
+    bool save(const QString &fileName) const; ///< Compresses and writes the checkpoint, meant for a worker thread
+    bool load(const QString &fileName); ///< Reads a checkpoint written by save
+
+private:
+    static const quint32 magic = 0x4d5a4331; ///< "MZC1"
+    static const qint32 version = 1;
+};
+
+#endif // SEARCHCHECKPOINT_H
@@ -0,0 +1,43 @@
+#ifndef SEARCHCONTROL_H
+#define SEARCHCONTROL_H
+
+#include <QAtomicInt>
+
+/**
+ * @brief Shared state between a running search and whoever observes it. The search polls the
+ * cancel flag and publishes its counters every PollInterval expansions, so the time between
+ * a cancel request and the search noticing it is bounded by that many expansions.
+ */
+struct SearchControl
+{
+    enum { PollInterval = 4096 }; ///< Expansions between two polls, a power of two
+
+    SearchControl() : cancel(0), expanded(0), frontier(0) {}
+
+    QAtomicInt cancel; ///< Set to non-zero to request cancellation
+    QAtomicInt expanded; ///< Nodes expanded so far
+    QAtomicInt frontier; ///< Nodes currently on the frontier
+
+    /// Clears the flag and the counters before a new search
+    void reset()
+    {
+        cancel.store(0);
+        expanded.store(0);
+        frontier.store(0);
+    }
+
+    /// Asks the search to stop at its next poll
+    void requestCancel() { cancel.store(1); }
+
+    bool isCancelled() const { return cancel.load() != 0; }
+
+    /// Publishes the counters and returns true if the search should stop
+    bool poll(int expandedCount, int frontierSize)
+    {
+        expanded.store(expandedCount);
+        frontier.store(frontierSize);
+        return cancel.load() != 0;
+    }
+};
+
+#endif // SEARCHCONTROL_H
@@ -0,0 +1,408 @@
+#include "searchstepper.h"
+#include "timelinetrace.h"
+
+#include <QtAlgorithms>
+
+/**
+ * @brief Creates an idle stepper
+ */
+SearchStepper::SearchStepper()
+{
+    mode = BreadthFirst;
+    state = Idle;
+    nodeHash = 0;
+    frontierHead = 0;
+    rows = 0;
+    columns = 0;
+    expandedCount = 0;
+    lastPushCount = 0;
+    exitNode = 0;
+    control = 0;
+    trace = 0;
+    directions = 0;
+    cancelSeen = false;
+    randomState = 0x9e3779b9u;
+}
+
+/**
+ * @brief Seeds the random choices of DFS. Successive searches carry on with the sequence, so
+ * they differ unless the seed is set again before each of them.
+ * @param seed The seed, 0 is replaced by a fixed non-zero value
+ */
+void SearchStepper::setSeed(quint32 seed)
+{
+    randomState = seed ? seed : 0x9e3779b9u;
+}
+
+/**
+ * @brief Gets the next number of the xorshift sequence of DFS
+ * @return A pseudo random number
+ */
+quint32 SearchStepper::nextRandom()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+/**
+ * @brief Sets the trace which records every node the search paints
+ * @param searchTrace The trace, or 0 for none
+ */
+void SearchStepper::setTrace(SearchTrace *searchTrace)
+{
+    trace = searchTrace;
+}
+
+/**
+ * @brief Sets the control block which is polled for cancel requests and receives the counters
+ * @param searchControl The control block, or 0 for none
+ */
+void SearchStepper::setControl(SearchControl *searchControl)
+{
+    control = searchControl;
+}
+
+/**
+ * @brief Checks whether a poll has seen a cancel request
+ * @return True if the search should stop
+ */
+bool SearchStepper::isCancelled()
+{
+    return cancelSeen;
+}
+
+/**
+ * @brief Starts a new search from the entrance (node 0)
+ * @param searchMode DFS or BFS
+ * @param listOfIds A hashlist with all the nodes that we need to search through
+ * @param nrows Number of rows in the maze
+ * @param ncolumns Number of columns in the maze
+ * @param openDirections The open directions of the nodes, kept up to date by their arena, or 0
+ * to build them from the walls of the nodes
+ */
+void SearchStepper::start(Mode searchMode, QHash<int, MazeNode *> *listOfIds, int nrows, int ncolumns, const OpenDirectionTable *openDirections)
+{
+    mode = searchMode;
+    nodeHash = listOfIds;
+    rows = nrows;
+    columns = ncolumns;
+    expandedCount = 0;
+    lastPushCount = 0;
+    exitNode = 0;
+    cancelSeen = false;
+
+    // The planes cost a pass over the walls here, so checkpoints don't need one
+    int cells = rows * columns;
+    if(openDirections != 0 && openDirections->getRows() == rows && openDirections->getColumns() == columns){
+        walls = openDirections->getWalls();
+        directions = openDirections;
+    }
+    else{
+        walls = QBitArray(cells);
+        for(int id = 0; id < cells; id++){
+            if(nodeHash->value(id)->isWall()){
+                walls.setBit(id);
+            }
+        }
+        ownDirections.reset(rows, columns);
+        ownDirections.setWalls(walls);
+        directions = &ownDirections;
+    }
+    visitedPlane = QBitArray(cells);
+    reachedPlane = QBitArray(cells);
+    parentPlane.fill(0, (cells + 31) / 32);
+
+    frontier.clear();
+    frontierHead = 0;
+    frontier.append(0);
+    state = Running;
+}
+
+/**
+ * @brief Takes the next node off the frontier, the last one for DFS and the first one for BFS
+ * @return The next node
+ */
+MazeNode *SearchStepper::takeFromFrontier()
+{
+    TIMELINE_SCOPE("SearchStepper::takeFromFrontier", "solver");
+    if(mode == DepthFirst){
+        MazeNode *node = nodeHash->value(frontier.last());
+        frontier.removeLast();
+        return node;
+    }
+
+    MazeNode *node = nodeHash->value(frontier.at(frontierHead++));
+
+    // Compact the queue once the consumed part dominates
+    if(frontierHead > 1024 && frontierHead * 2 > frontier.size()){
+        frontier.remove(0, frontierHead);
+        frontierHead = 0;
+    }
+    return node;
+}
+
+/**
+ * @brief Expands one node. Nodes that have been visited in the meantime are skipped
+ * without counting as an expansion.
+ * @return The state after the expansion
+ */
+SearchStepper::State SearchStepper::step()
+{
+    TIMELINE_SCOPE("SearchStepper::step", "solver");
+    lastPushCount = 0;
+    if(state != Running){
+        return state;
+    }
+
+    // Skip nodes which have been reached twice before they were expanded
+    MazeNode *currentNode = 0;
+    while(getFrontierSize() > 0){
+        currentNode = takeFromFrontier();
+        if(!currentNode->hasBeenVisited()){
+            break;
+        }
+        currentNode = 0;
+    }
+
+    if(currentNode == 0){
+        state = Exhausted; // No exit found
+        return state;
+    }
+
+    // Get adjacent nodes and check if they're exits. If not, put them on the frontier.
+    // DFS takes them at random, BFS in order
+    currentNode->setActive(true);
+    expandedCount++;
+    if(trace != 0){
+        trace->record(currentNode->getId(), SearchTrace::Active);
+    }
+
+    // Publish the counters and check for a cancel request every few expansions
+    if(control != 0 && (expandedCount & (SearchControl::PollInterval - 1)) == 0){
+        cancelSeen = control->poll(expandedCount, getFrontierSize());
+    }
+
+    QList<MazeNode*> neighbours;
+    getAdjacentUnvisitedNodes(currentNode->getId(), neighbours);
+    while(!neighbours.isEmpty()){
+        MazeNode *nextNode;
+        if(mode == DepthFirst){
+            nextNode = neighbours.takeAt(int(nextRandom() % quint32(neighbours.size())));
+        }
+        else{
+            nextNode = neighbours.takeFirst();
+        }
+
+        lastPushCount++;
+        nextNode->setPreviousNode(currentNode);
+        setParent(nextNode->getId(), currentNode->getId());
+        frontier.append(nextNode->getId());
+        if(nextNode->isExit()){
+            exitNode = nextNode;
+            state = ExitFound;
+            break;
+        }
+    }
+    currentNode->setVisited(true);
+    visitedPlane.setBit(currentNode->getId());
+    if(trace != 0){
+        trace->record(currentNode->getId(), SearchTrace::Visited);
+    }
+
+    return state;
+}
+
+/**
+ * @brief Expands nodes until the given number of expansions added at least one node to the
+ * frontier. Dead ends are run through without counting, so they don't cost animation ticks.
+ * @param productiveExpansions The number of expansions that have to add to the frontier
+ * @return The state after the last expansion
+ */
+SearchStepper::State SearchStepper::advance(int productiveExpansions)
+{
+    int productive = 0;
+    while(state == Running && !cancelSeen && productive < productiveExpansions){
+        step();
+        if(lastPushCount > 0){
+            productive++;
+        }
+    }
+    return state;
+}
+
+/**
+ * @brief Runs the search until the exit has been found, the frontier is empty, a cancel
+ * request has been seen or the given number of expansions has been done
+ * @param maxExpansions The maximum number of expansions, negative for no limit
+ * @return The state after the last expansion
+ */
+SearchStepper::State SearchStepper::run(int maxExpansions)
+{
+    int stopAt = expandedCount + maxExpansions;
+    while(state == Running && !cancelSeen && (maxExpansions < 0 || expandedCount < stopAt)){
+        step();
+    }
+    return state;
+}
+
+/**
+ * @brief Drops the frontier and returns to idle
+ */
+void SearchStepper::abort()
+{
+    frontier.clear();
+    frontierHead = 0;
+    state = Idle;
+}
+
+/**
+ * @brief Records the previous node of a node, as the direction from the node to it
+ * @param id The node
+ * @param parentId Its previous node, a neighbour
+ */
+void SearchStepper::setParent(int id, int parentId)
+{
+    int direction;
+    if(parentId == id + columns){
+        direction = 0; // South
+    }
+    else if(parentId == id - columns){
+        direction = 1; // North
+    }
+    else if(parentId == id + 1){
+        direction = 2; // East
+    }
+    else{
+        direction = 3; // West
+    }
+    reachedPlane.setBit(id);
+    quint64 &word = parentPlane[id >> 5];
+    int shift = (id & 31) * 2;
+    word = (word & ~(quint64(3) << shift)) | (quint64(direction) << shift);
+}
+
+/**
+ * @brief Gets the state of the running search. The checkpoint shares the planes and the
+ * frontier with the stepper, so this takes no time however big the maze is. The stepper
+ * copies a plane the next time it writes to it.
+ * @return The state, empty if no search is running
+ */
+SearchCheckpoint SearchStepper::checkpoint() const
+{
+    SearchCheckpoint saved;
+    if(state != Running){
+        return saved;
+    }
+    saved.mode = mode;
+    saved.rows = rows;
+    saved.columns = columns;
+    saved.expandedCount = expandedCount;
+    saved.walls = walls;
+    saved.visited = visitedPlane;
+    saved.reached = reachedPlane;
+    saved.parents = parentPlane;
+    saved.frontier = frontier;
+    saved.frontierHead = frontierHead;
+    return saved;
+}
+
+/**
+ * @brief Carries on with a checkpointed search. The nodes have to show the walls of the
+ * checkpoint and no search state, the visited flags and previous nodes are restored on them.
+ * @param saved The checkpoint
+ * @param listOfIds A hashlist with all the nodes that we need to search through
+ * @return False if the checkpoint doesn't fit the nodes
+ */
+bool SearchStepper::resume(const SearchCheckpoint &saved, QHash<int, MazeNode *> *listOfIds)
+{
+    int cells = saved.rows * saved.columns;
+    if(saved.isEmpty() || listOfIds->size() != cells){
+        return false;
+    }
+
+    mode = saved.mode == DepthFirst ? DepthFirst : BreadthFirst;
+    nodeHash = listOfIds;
+    rows = saved.rows;
+    columns = saved.columns;
+    expandedCount = saved.expandedCount;
+    lastPushCount = 0;
+    exitNode = 0;
+    cancelSeen = false;
+    walls = saved.walls;
+    ownDirections.reset(rows, columns);
+    ownDirections.setWalls(walls);
+    directions = &ownDirections;
+    visitedPlane = saved.visited;
+    reachedPlane = saved.reached;
+    parentPlane = saved.parents;
+    frontier = saved.frontier.mid(saved.frontierHead);
+    frontierHead = 0;
+
+    for(int id = 0; id < cells; id++){
+        MazeNode *node = nodeHash->value(id);
+        if(reachedPlane.testBit(id)){
+            node->setPreviousNode(nodeHash->value(saved.parentOf(id)));
+        }
+        if(visitedPlane.testBit(id)){
+            node->setVisited(true);
+        }
+    }
+    state = Running;
+    return true;
+}
+
+/**
+ * @brief Gets the state of the search
+ * @return The state
+ */
+SearchStepper::State SearchStepper::getState()
+{
+    return state;
+}
+
+/**
+ * @brief Gets the exit node
+ * @return The exit node or 0 if it hasn't been found
+ */
+MazeNode *SearchStepper::getExitNode()
+{
+    return exitNode;
+}
+
+/**
+ * @brief Gets the number of expanded nodes
+ * @return The number of expanded nodes
+ */
+int SearchStepper::getExpandedCount()
+{
+    return expandedCount;
+}
+
+/**
+ * @brief Gets the number of nodes on the frontier
+ * @return The size of the frontier
+ */
+int SearchStepper::getFrontierSize()
+{
+    return frontier.size() - frontierHead;
+}
+
+/**
+ * @brief Gets the unvisited adjacent nodes of the passed in node, south, north, east and west.
+ * The open directions of the node say which neighbours are inside the maze and not walls.
+ * @param currentID The node ID we need the adjacent nodes for
+ * @param neighbours The list the neighboring nodes that have been unvisited are appended to
+ */
+void SearchStepper::getAdjacentUnvisitedNodes(int currentID, QList<MazeNode *> &neighbours)
+{
+    int open = directions->getMask(currentID);
+    while(open != 0){
+        int adjacentID = currentID + directions->getOffset(qCountTrailingZeroBits(quint32(open)));
+        open &= open - 1;
+        if(!visitedPlane.testBit(adjacentID)){
+            neighbours.append(nodeHash->value(adjacentID));
+        }
+    }
+}
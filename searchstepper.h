@@ -0,0 +1,75 @@
+#ifndef SEARCHSTEPPER_H
+#define SEARCHSTEPPER_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "mazenode.h"
+#include "opendirectiontable.h"
+#include "searchcontrol.h"
+#include "searchtrace.h"
+#include "searchcheckpoint.h"
+
+/**
+ * @brief A resumable DFS/BFS search written as an explicit state machine.
+ * All search state lives in this object, so the caller decides how many expansions
+ * to run at once: one per timer tick, one per button press or all of them in a loop.
+ *
+ * Besides the flags on the nodes the stepper keeps its own compact copy of the state in bit
+ * planes, so checkpoint() can hand it out without walking the nodes.
+ */
+class SearchStepper
+{
+public:
+    enum Mode { DepthFirst, BreadthFirst };
+    enum State { Idle, Running, ExitFound, Exhausted };
+
+    SearchStepper();
+    void start(Mode searchMode, QHash<int,MazeNode*> *listOfIds, int nrows, int ncolumns, const OpenDirectionTable *openDirections = 0); ///< Resets the state and puts the entrance on the frontier
+    State step(); ///< Expands exactly one node
+    State advance(int productiveExpansions); ///< Expands nodes until the given number of them added to the frontier
+    State run(int maxExpansions = -1); ///< Runs the search to completion or for the given number of expansions
+    void setControl(SearchControl *searchControl); ///< Sets the control block polled for cancellation
+    bool isCancelled(); ///< True once a poll has seen a cancel request
+    void setTrace(SearchTrace *searchTrace); ///< Sets the trace that records every painted node, 0 for none
+    void setSeed(quint32 seed); ///< Seeds the random neighbour order of DFS
+    void abort(); ///< Drops the frontier and returns to idle
+    SearchCheckpoint checkpoint() const; ///< Gets the state of the running search, sharing the planes
+    bool resume(const SearchCheckpoint &saved, QHash<int,MazeNode*> *listOfIds); ///< Carries on with a checkpointed search on freshly reset nodes
+
+    State getState();
+    MazeNode *getExitNode(); ///< The exit node, if it has been found
+    int getExpandedCount(); ///< Number of nodes expanded so far
+    int getFrontierSize(); ///< Number of nodes waiting on the stack or queue
+
+private:
+    Mode mode;
+    State state;
+    QHash<int,MazeNode*> *nodeHash;
+    QVector<int> frontier; ///< Node ids, used as a stack for DFS and as a queue for BFS
+    int frontierHead; ///< Index of the queue head for BFS
+    int rows;
+    int columns;
+    int expandedCount;
+    int lastPushCount; ///< Number of nodes pushed by the last expansion
+    MazeNode *exitNode;
+    SearchControl *control;
+    SearchTrace *trace;
+    bool cancelSeen; ///< Set when a poll of the control block found a cancel request
+    quint32 randomState; ///< Xorshift state for the neighbour order of DFS
+    QBitArray walls; ///< The walls when the search started, one bit per node id
+    const OpenDirectionTable *directions; ///< The open neighbours of every node, the arena's or ownDirections
+    OpenDirectionTable ownDirections; ///< Built from the walls when no table was handed in
+    QBitArray visitedPlane; ///< Mirrors the visited flags of the nodes
+    QBitArray reachedPlane; ///< Set for nodes that have a previous node
+    QVector<quint64> parentPlane; ///< Direction to the previous node, two bits per node id
+
+    MazeNode *takeFromFrontier();
+    quint32 nextRandom();
+    void setParent(int id, int parentId); ///< Records the previous node of a node in the planes
+    void getAdjacentUnvisitedNodes(int currentID, QList<MazeNode*> &neighbours); ///< Gets the adjacent nodes which have not been visited
+};
+
+#endif // SEARCHSTEPPER_H
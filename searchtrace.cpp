@@ -0,0 +1,270 @@
+#include "searchtrace.h"
+
+/**
+ * @brief Creates an empty trace
+ */
+SearchTrace::SearchTrace()
+{
+    cells = 0;
+    events = 0;
+    lastCell = 0;
+    keyframeInterval = minimumKeyframeInterval;
+}
+
+/**
+ * @brief Drops all events and starts a new trace for a maze of the given size
+ * @param numberOfCells The number of cells in the maze
+ */
+void SearchTrace::reset(int numberOfCells)
+{
+    cells = numberOfCells;
+    events = 0;
+    lastCell = 0;
+    keyframeInterval = qMax(minimumKeyframeInterval, cells);
+    data.clear();
+    keyframes.clear();
+    liveStates.fill(None, cells);
+}
+
+/**
+ * @brief Appends an event to the log
+ * @param cell The id of the cell
+ * @param event What happened to the cell
+ */
+void SearchTrace::record(int cell, Event event)
+{
+    if(events % keyframeInterval == 0){
+        addKeyframe();
+    }
+
+    // Zigzag encode the delta so small steps in both directions stay small,
+    // then put the event type into the lowest two bits
+    qint32 delta = cell - lastCell;
+    quint64 value = (quint64((quint32(delta) << 1) ^ quint32(delta >> 31)) << 2) | quint64(event);
+    while(value >= 0x80){
+        data.append(char(value | 0x80));
+        value >>= 7;
+    }
+    data.append(char(value));
+
+    lastCell = cell;
+    liveStates[cell] = char(event);
+    events++;
+}
+
+/**
+ * @brief Stores the current cell states as a keyframe
+ */
+void SearchTrace::addKeyframe()
+{
+    Keyframe keyframe;
+    keyframe.cursor.frame = events;
+    keyframe.cursor.offset = data.size();
+    keyframe.cursor.lastCell = lastCell;
+    keyframe.packedStates.fill(0, (cells + 3) / 4);
+    for(int ii = 0; ii < cells; ii++){
+        keyframe.packedStates[ii >> 2] = char(keyframe.packedStates.at(ii >> 2) | (liveStates.at(ii) << ((ii & 3) * 2)));
+    }
+    keyframes.append(keyframe);
+}
+
+/**
+ * @brief Decodes one event from an encoded log and moves the cursor on. A varint takes at most
+ * five bytes, the zigzag delta and the event type.
+ * @param bytes The encoded events
+ * @param cells The number of cells, decoded cells have to be below
+ * @param cursor The position in the log
+ * @param cell Receives the id of the cell
+ * @param event Receives the event type
+ * @return False if the log ends inside the event, the varint is too long or the cell is
+ * outside of the maze
+ */
+static bool decodeEvent(const QByteArray &bytes, int cells, SearchTrace::Cursor &cursor, int &cell, SearchTrace::Event &event)
+{
+    quint64 value = 0;
+    int shift = 0;
+    quint8 byte;
+    do{
+        if(cursor.offset >= bytes.size() || shift >= 35){
+            return false;
+        }
+        byte = quint8(bytes.at(cursor.offset++));
+        value |= quint64(byte & 0x7f) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+
+    event = SearchTrace::Event(value & 3);
+    quint32 zigzag = quint32(value >> 2);
+    qint32 delta = qint32(zigzag >> 1) ^ -qint32(zigzag & 1);
+    qint64 decoded = qint64(cursor.lastCell) + delta;
+    if(decoded < 0 || decoded >= cells){
+        return false;
+    }
+    cell = int(decoded);
+
+    cursor.lastCell = cell;
+    cursor.frame++;
+    return true;
+}
+
+/**
+ * @brief Decodes the event at the cursor and moves the cursor on
+ * @param cursor The position in the log
+ * @param cell Receives the id of the cell
+ * @param event Receives the event type
+ * @return False if the cursor is at the end of the log or the event doesn't decode
+ */
+bool SearchTrace::decode(Cursor &cursor, int &cell, Event &event) const
+{
+    if(cursor.frame >= events){
+        return false;
+    }
+    return decodeEvent(data, cells, cursor, cell, event);
+}
+
+/**
+ * @brief Restores the cell states after the given number of events, starting from the
+ * closest keyframe before it
+ * @param frame The number of events to apply
+ * @param states Receives one byte per cell
+ * @return A cursor positioned at the frame, to continue with advance()
+ */
+SearchTrace::Cursor SearchTrace::seek(int frame, QByteArray &states) const
+{
+    frame = qBound(0, frame, events);
+    states.fill(None, cells);
+
+    Cursor cursor;
+    if(!keyframes.isEmpty()){
+        int index = qMin(frame / keyframeInterval, keyframes.size() - 1);
+        const Keyframe &keyframe = keyframes.at(index);
+        for(int ii = 0; ii < cells; ii++){
+            states[ii] = char((keyframe.packedStates.at(ii >> 2) >> ((ii & 3) * 2)) & 3);
+        }
+        cursor = keyframe.cursor;
+    }
+
+    advance(cursor, states, frame);
+    return cursor;
+}
+
+/**
+ * @brief Applies events to the states until the cursor reaches the frame
+ * @param cursor The position in the log, moved forward
+ * @param states One byte per cell, updated in place
+ * @param frame The frame to stop at
+ */
+void SearchTrace::advance(Cursor &cursor, QByteArray &states, int frame) const
+{
+    int cell;
+    Event event;
+    while(cursor.frame < frame && decode(cursor, cell, event)){
+        states[cell] = char(event);
+    }
+}
+
+/**
+ * @brief Replays the log to recreate the keyframes, which aren't saved to disk
+ * @return False if the log is broken, the trace is empty then
+ */
+bool SearchTrace::rebuildKeyframes()
+{
+    QByteArray encoded = data;
+    int numberOfEvents = events;
+    reset(cells);
+
+    // Re-recording restores the live states and the keyframes along the way
+    Cursor cursor;
+    int cell;
+    Event event;
+    while(cursor.frame < numberOfEvents){
+        if(!decodeEvent(encoded, cells, cursor, cell, event)){
+            reset(cells);
+            return false;
+        }
+        record(cell, event);
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the number of recorded events, which is also the number of frames
+ * @return The number of events
+ */
+int SearchTrace::getEventCount() const
+{
+    return events;
+}
+
+/**
+ * @brief Gets the number of cells of the traced maze
+ * @return The number of cells
+ */
+int SearchTrace::getCellCount() const
+{
+    return cells;
+}
+
+/**
+ * @brief Checks if anything has been recorded
+ * @return True if there are no events
+ */
+bool SearchTrace::isEmpty() const
+{
+    return events == 0;
+}
+
+/**
+ * @brief Gets the size of the encoded events
+ * @return The size in bytes
+ */
+int SearchTrace::getByteSize() const
+{
+    return data.size();
+}
+
+/**
+ * @brief Writes the trace to a stream. Keyframes are left out and rebuilt on load.
+ */
+QDataStream &operator<<(QDataStream &out, const SearchTrace &trace)
+{
+    out << qint32(trace.cells) << qint32(trace.events) << trace.data;
+    return out;
+}
+
+/**
+ * @brief Reads a trace written by operator<<. A trace of another number of cells, negative
+ * counts, fewer bytes than events and events that don't decode to cells of the maze set the
+ * stream to ReadCorruptData and leave the trace empty. The cell count is checked before the
+ * events are read, so a broken file can't make the trace allocate more than the maze.
+ * @param in The stream
+ * @param numberOfCells The number of cells of the maze the trace belongs to
+ * @return False if the trace is broken
+ */
+bool SearchTrace::read(QDataStream &in, int numberOfCells)
+{
+    qint32 fileCells;
+    qint32 fileEvents;
+    QByteArray fileData;
+    in >> fileCells >> fileEvents;
+    if(in.status() == QDataStream::Ok && fileCells == numberOfCells && fileEvents >= 0){
+        in >> fileData;
+    }
+
+    // Every event takes at least one byte
+    if(in.status() != QDataStream::Ok || fileCells != numberOfCells || fileEvents < 0 || fileData.size() < fileEvents){
+        in.setStatus(QDataStream::ReadCorruptData);
+        reset(0);
+        return false;
+    }
+
+    reset(numberOfCells);
+    data = fileData;
+    events = fileEvents;
+    if(!rebuildKeyframes()){
+        in.setStatus(QDataStream::ReadCorruptData);
+        reset(0);
+        return false;
+    }
+    return true;
+}
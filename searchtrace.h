@@ -0,0 +1,72 @@
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QDataStream>
+
+/**
+ * @brief A compact log of everything a search painted, so it can be replayed at any speed
+ * without running the solver again. Each event is the cell id as a zigzag delta to the previous
+ * event's cell plus the event type, varint encoded. Periodic keyframes hold the full cell state
+ * so any frame can be reached by decoding at most one keyframe interval.
+ */
+class SearchTrace
+{
+public:
+    /// What happened to a cell, also the state of the cell in a frame
+    enum Event {
+        None = 0,
+        Active = 1,
+        Visited = 2,
+        Path = 3
+    };
+
+    /// A position in the event log
+    struct Cursor
+    {
+        Cursor() : frame(0), offset(0), lastCell(0) {}
+        int frame; ///< Number of events applied so far
+        int offset; ///< Byte offset of the next event
+        int lastCell; ///< Cell of the previous event, base of the next delta
+    };
+
+    SearchTrace();
+    void reset(int numberOfCells); ///< Drops all events and starts a new trace
+    void record(int cell, Event event); ///< Appends an event
+    int getEventCount() const;
+    int getCellCount() const;
+    bool isEmpty() const;
+    int getByteSize() const; ///< Size of the encoded events in bytes
+
+    Cursor seek(int frame, QByteArray &states) const; ///< Restores the cell states after the given number of events
+    void advance(Cursor &cursor, QByteArray &states, int frame) const; ///< Applies events until the cursor reaches the frame
+
+    bool read(QDataStream &in, int numberOfCells); ///< Reads a trace written by operator<<, false if it isn't one of a maze of the given size
+
+    friend QDataStream &operator<<(QDataStream &out, const SearchTrace &trace);
+
+private:
+    /// Events between two keyframes, at least as many as there are cells so keyframes stay small
+    static const int minimumKeyframeInterval = 4096;
+
+    struct Keyframe
+    {
+        Cursor cursor;
+        QByteArray packedStates; ///< Two bits per cell
+    };
+
+    QByteArray data; ///< The encoded events
+    QVector<Keyframe> keyframes;
+    QByteArray liveStates; ///< One byte per cell, the state after the last recorded event
+    int cells;
+    int events;
+    int lastCell;
+    int keyframeInterval;
+
+    void addKeyframe();
+    bool decode(Cursor &cursor, int &cell, Event &event) const; ///< Decodes the event at the cursor and moves on
+    bool rebuildKeyframes(); ///< Replays the events to recreate the keyframes after loading, false if they don't decode
+};
+
+#endif // SEARCHTRACE_H
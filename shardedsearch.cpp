@@ -0,0 +1,745 @@
+#include "shardedsearch.h"
+#include "timelinetrace.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QSharedMemory>
+#include <QStringList>
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ShardedSearch {
+
+/// Times a worker may be started again within one search before it's given up
+static const int restartLimit = 8;
+/// A worker quits when the coordinator hasn't been heard of for this long
+static const int heartbeatTimeoutMs = 10000;
+/// Commands besides level * 2 (expand) and level * 2 + 1 (take in the rings)
+static const int idleCommand = -2;
+static const int quitCommand = -1;
+/// Frontier entries a band needs beyond its cells for the duplicates of repeated commands
+static const int frontierSlack = 4 * restartLimit + 16;
+
+/// Header of the segment holding the walls
+struct MazeHeader
+{
+    qint32 rows;
+    qint32 columns;
+    qint32 bands;
+    qint32 goal;
+    qint32 ringCapacity; ///< Slots of every ring, a power of two
+    QBasicAtomicInt heartbeat; ///< Counted up by the coordinator while it waits
+};
+
+/// Header of the segment of a band
+struct BandHeader
+{
+    QBasicAtomicInt command; ///< The command of the coordinator
+    QBasicAtomicInt status; ///< The last command the worker has finished
+    QBasicAtomicInt found; ///< Set once the goal is on a frontier
+    qint32 firstRow;
+    qint32 rowCount;
+    qint32 frontierCapacity;
+    qint32 count[2]; ///< Entries of the two frontiers, the one of level & 1 is expanded
+    qint64 expanded; ///< Nodes expanded by the workers of this band
+};
+
+/// A ring of columns reached from a neighbouring band. Both counters only grow.
+struct Ring
+{
+    QBasicAtomicInt head; ///< Entries written, only stored by the producer
+    QBasicAtomicInt tail; ///< Entries read, only stored by the consumer
+};
+
+/// The rings of a band, by the side the cells come from
+enum RingSide { FromAbove = 0, FromBelow = 1 };
+
+static inline int alignedSize(qint64 bytes)
+{
+    return int((bytes + 7) & ~qint64(7));
+}
+
+static inline bool testBit(const quint64 *words, int bit)
+{
+    return (words[bit >> 6] >> (bit & 63)) & 1;
+}
+
+/**
+ * @brief The parts of a band segment. The coordinator and the worker lay them out the same way.
+ */
+struct BandView
+{
+    BandHeader *header;
+    Ring *rings[2];
+    qint32 *entries[2];
+    quint64 *visited; ///< One bit per cell of the band
+    quint64 *parents; ///< Direction to the parent, two bits per cell of the band
+    qint32 *frontier[2]; ///< Node ids of the two levels
+
+    static int segmentSize(int cells, int ringCapacity, int frontierCapacity)
+    {
+        return alignedSize(sizeof(BandHeader)) + 2 * alignedSize(sizeof(Ring) + qint64(ringCapacity) * 4)
+                + alignedSize(qint64((cells + 63) / 64) * 8) + alignedSize(qint64((cells + 31) / 32) * 8)
+                + 2 * alignedSize(qint64(frontierCapacity) * 4);
+    }
+
+    void attach(void *data, int cells, int ringCapacity, int frontierCapacity)
+    {
+        char *position = static_cast<char*>(data);
+        header = reinterpret_cast<BandHeader*>(position);
+        position += alignedSize(sizeof(BandHeader));
+        for(int side = 0; side < 2; side++){
+            rings[side] = reinterpret_cast<Ring*>(position);
+            entries[side] = reinterpret_cast<qint32*>(position + sizeof(Ring));
+            position += alignedSize(sizeof(Ring) + qint64(ringCapacity) * 4);
+        }
+        visited = reinterpret_cast<quint64*>(position);
+        position += alignedSize(qint64((cells + 63) / 64) * 8);
+        parents = reinterpret_cast<quint64*>(position);
+        position += alignedSize(qint64((cells + 31) / 32) * 8);
+        for(int level = 0; level < 2; level++){
+            frontier[level] = reinterpret_cast<qint32*>(position);
+            position += alignedSize(qint64(frontierCapacity) * 4);
+        }
+    }
+};
+
+/**
+ * @brief The first row of a band, the bands differ by at most one row in height
+ */
+static inline int firstRowOf(int band, int rows, int bands)
+{
+    return int(qint64(band) * rows / bands);
+}
+
+/**
+ * @brief The band a row belongs to, the inverse of firstRowOf
+ */
+static inline int bandOf(int row, int rows, int bands)
+{
+    return int((qint64(row + 1) * bands - 1) / rows);
+}
+
+/**
+ * @brief Spins, then yields, then sleeps the longer nothing happens
+ * @param idleRounds Rounds without progress so far
+ */
+static void backOff(int idleRounds)
+{
+    if(idleRounds < 64){
+        return;
+    }
+    if(idleRounds < 4096){
+        QThread::yieldCurrentThread();
+    }
+    else{
+        QThread::usleep(200);
+    }
+}
+
+/**
+ * @brief The state of a worker process: its band and the rings of its neighbours
+ */
+struct Worker
+{
+    const MazeHeader *maze;
+    const quint64 *walls;
+    int rows;
+    int columns;
+    int bandCount;
+    int band;
+    int firstId; ///< Node id of the first cell of the band
+    int lastId; ///< Node id after the last cell of the band
+    int ringMask;
+    BandView own;
+    BandView above; ///< Valid if band > 0
+    BandView below; ///< Valid if band < bandCount - 1
+    int lastHeartbeat;
+    QElapsedTimer quiet; ///< Time since the heartbeat last changed
+};
+
+/**
+ * @brief Checks whether the coordinator is still around
+ * @return False once its heartbeat has stood still for heartbeatTimeoutMs
+ */
+static bool coordinatorAlive(Worker &worker)
+{
+    int heartbeat = worker.maze->heartbeat.loadAcquire();
+    if(heartbeat != worker.lastHeartbeat){
+        worker.lastHeartbeat = heartbeat;
+        worker.quiet.restart();
+        return true;
+    }
+    return worker.quiet.elapsed() < heartbeatTimeoutMs;
+}
+
+/**
+ * @brief Puts a cell of the band on the next frontier unless it has been reached before. The
+ * cell goes on the frontier before it's marked, so a worker dying in between only leaves a
+ * duplicate behind.
+ * @param worker The worker
+ * @param level The level being expanded
+ * @param id The node id, inside the band and not a wall
+ * @param direction Direction from the cell to its parent
+ */
+static void reach(Worker &worker, int level, int id, int direction)
+{
+    int local = id - worker.firstId;
+    if(testBit(worker.own.visited, local)){
+        return;
+    }
+    BandHeader *header = worker.own.header;
+    int next = (level & 1) ^ 1;
+    if(header->count[next] >= header->frontierCapacity){
+        return;
+    }
+    worker.own.frontier[next][header->count[next]] = id;
+    header->count[next]++;
+
+    quint64 &word = worker.own.parents[local >> 5];
+    int shift = (local & 31) * 2;
+    word = (word & ~(quint64(3) << shift)) | (quint64(direction) << shift);
+    worker.own.visited[local >> 6] |= quint64(1) << (local & 63);
+    if(id == worker.maze->goal){
+        header->found.storeRelease(1);
+    }
+}
+
+/**
+ * @brief Takes in everything the neighbouring bands have handed over so far. The tail moves on
+ * after a cell has been taken in, so a worker dying in between takes it in again.
+ * @param worker The worker
+ * @param level The level being expanded
+ */
+static void drainRings(Worker &worker, int level)
+{
+    for(int side = FromAbove; side <= FromBelow; side++){
+        Ring *ring = worker.own.rings[side];
+        const qint32 *entries = worker.own.entries[side];
+        int firstId = side == FromAbove ? worker.firstId : worker.lastId - worker.columns;
+        int tail = ring->tail.load();
+        int head = ring->head.loadAcquire();
+        while(tail != head){
+            reach(worker, level, firstId + entries[tail & worker.ringMask], side == FromAbove ? MazeGrid::North : MazeGrid::South);
+            tail++;
+            ring->tail.storeRelease(tail);
+        }
+    }
+}
+
+/**
+ * @brief Hands a cell over to the band above or below. While the ring is full the worker takes
+ * in its own rings, so two bands handing over to each other never wait on each other.
+ * @param worker The worker
+ * @param level The level being expanded
+ * @param target The band to hand over to
+ * @param side The ring of that band
+ * @param column The column of the cell in the first or last row of that band
+ * @return False if the coordinator went away while the ring was full
+ */
+static bool handOver(Worker &worker, int level, BandView &target, int side, int column)
+{
+    Ring *ring = target.rings[side];
+    int head = ring->head.load();
+    int idleRounds = 0;
+    while(head - ring->tail.loadAcquire() > worker.ringMask){
+        drainRings(worker, level);
+        if(!coordinatorAlive(worker)){
+            return false;
+        }
+        backOff(idleRounds++);
+    }
+    target.entries[side][head & worker.ringMask] = column;
+    ring->head.storeRelease(head + 1);
+    return true;
+}
+
+/**
+ * @brief Expands the frontier of the band. The neighbours are checked in the order of
+ * MSolver::getAdjacentUnvisitedNodes(): south, north, east, west. Cells of other bands are
+ * handed over to them.
+ * @param worker The worker
+ * @param level The level to expand
+ * @return False if the coordinator went away
+ */
+static bool expandLevel(Worker &worker, int level)
+{
+    BandHeader *header = worker.own.header;
+    const qint32 *frontier = worker.own.frontier[level & 1];
+    int count = header->count[level & 1];
+    int totalNumberOfNodes = worker.rows * worker.columns;
+    int columns = worker.columns;
+
+    for(int ii = 0; ii < count; ii++){
+        int currentID = frontier[ii];
+        header->expanded++;
+
+        // Node to the south
+        if(currentID < (totalNumberOfNodes-columns) && !testBit(worker.walls, currentID+columns)){
+            if(currentID+columns < worker.lastId){
+                reach(worker, level, currentID+columns, MazeGrid::North);
+            }
+            else if(!handOver(worker, level, worker.below, FromAbove, currentID % columns)){
+                return false;
+            }
+        }
+
+        // Node to the north
+        if(currentID >= columns && !testBit(worker.walls, currentID-columns)){
+            if(currentID-columns >= worker.firstId){
+                reach(worker, level, currentID-columns, MazeGrid::South);
+            }
+            else if(!handOver(worker, level, worker.above, FromBelow, currentID % columns)){
+                return false;
+            }
+        }
+
+        // Node to the east
+        if(((currentID+1) % columns) != 0 && !testBit(worker.walls, currentID+1)){
+            reach(worker, level, currentID+1, MazeGrid::West);
+        }
+
+        // Node to the west
+        if((currentID % columns) != 0 && !testBit(worker.walls, currentID-1)){
+            reach(worker, level, currentID-1, MazeGrid::East);
+        }
+
+        // Keep the rings of the neighbours moving
+        if((ii & 255) == 255){
+            drainRings(worker, level);
+        }
+    }
+    drainRings(worker, level);
+    return true;
+}
+
+/**
+ * @brief Runs as the worker of one band: attaches to the segments of the coordinator and
+ * carries out its commands until it posts quit or stops sending heartbeats
+ * @param key The key the coordinator named its segments after
+ * @param band The band to work on
+ * @return 0 after quit, 1 if the segments are missing or the coordinator went away
+ */
+int runWorker(const QString &key, int band)
+{
+    QSharedMemory mazeSegment(key + "-maze");
+    if(!mazeSegment.attach(QSharedMemory::ReadOnly)){
+        return 1;
+    }
+    Worker worker;
+    worker.maze = static_cast<const MazeHeader*>(mazeSegment.constData());
+    worker.walls = reinterpret_cast<const quint64*>(static_cast<const char*>(mazeSegment.constData()) + alignedSize(sizeof(MazeHeader)));
+    worker.rows = worker.maze->rows;
+    worker.columns = worker.maze->columns;
+    worker.bandCount = worker.maze->bands;
+    worker.band = band;
+    worker.ringMask = worker.maze->ringCapacity - 1;
+    if(band < 0 || band >= worker.bandCount){
+        return 1;
+    }
+
+    // The own band and the neighbours, whose rings this worker writes to
+    QSharedMemory segments[3];
+    BandView *views[3] = { &worker.above, &worker.own, &worker.below };
+    for(int offset = -1; offset <= 1; offset++){
+        int other = band + offset;
+        if(other < 0 || other >= worker.bandCount){
+            continue;
+        }
+        int cells = (firstRowOf(other + 1, worker.rows, worker.bandCount) - firstRowOf(other, worker.rows, worker.bandCount)) * worker.columns;
+        QSharedMemory &segment = segments[offset + 1];
+        segment.setKey(key + "-band" + QString::number(other));
+        if(!segment.attach()){
+            return 1;
+        }
+        views[offset + 1]->attach(segment.data(), cells, worker.maze->ringCapacity, cells + frontierSlack);
+    }
+    worker.firstId = worker.own.header->firstRow * worker.columns;
+    worker.lastId = worker.firstId + worker.own.header->rowCount * worker.columns;
+    worker.lastHeartbeat = worker.maze->heartbeat.loadAcquire();
+    worker.quiet.start();
+
+    BandHeader *header = worker.own.header;
+    int idleRounds = 0;
+    forever{
+        int command = header->command.loadAcquire();
+        if(command == quitCommand){
+            return 0;
+        }
+        if(command >= 0 && command != header->status.loadAcquire()){
+            if((command & 1) == 0){
+                if(!expandLevel(worker, command / 2)){
+                    return 1;
+                }
+            }
+            else{
+                drainRings(worker, command / 2);
+            }
+            header->status.storeRelease(command);
+            idleRounds = 0;
+            continue;
+        }
+
+        // The neighbours may still be expanding and handing cells over
+        if(command >= 0 && (command & 1) == 0){
+            drainRings(worker, command / 2);
+        }
+        if(!coordinatorAlive(worker)){
+            return 1;
+        }
+        backOff(idleRounds++);
+    }
+}
+
+/**
+ * @brief The segments and processes of one sharded search
+ */
+class Coordinator
+{
+public:
+    Coordinator() : maze(0) {}
+    ~Coordinator();
+    bool setUp(const MazeGrid &grid, int start, int goal, int bands, QString &error);
+    bool startWorker(int band);
+    void post(int command);
+    bool wait(int command, SearchControl *control, Result &result);
+    void traceBack(int start, int goal, QVector<int> &path);
+    void killWorker(int band);
+
+    int bandCount() const { return views.size(); }
+    BandHeader *header(int band) { return views[band].header; }
+
+private:
+    QString key;
+    QSharedMemory mazeSegment;
+    MazeHeader *maze;
+    QVector<QSharedMemory*> segments;
+    QVector<BandView> views;
+    QVector<QProcess*> workers;
+};
+
+/**
+ * @brief Tells the workers to quit, kills the ones that don't and releases the segments
+ */
+Coordinator::~Coordinator()
+{
+    post(quitCommand);
+    foreach(QProcess *worker, workers){
+        if(!worker->waitForFinished(2000)){
+            worker->kill();
+            worker->waitForFinished(1000);
+        }
+        delete worker;
+    }
+    qDeleteAll(segments);
+}
+
+/**
+ * @brief Creates the segments and puts the start on the frontier of its band
+ * @param grid The maze, its walls are copied to shared memory
+ * @param start The node id to start from
+ * @param goal The node id to find
+ * @param bands The number of bands and worker processes
+ * @param error Receives the reason on failure
+ * @return False if a segment could not be created
+ */
+bool Coordinator::setUp(const MazeGrid &grid, int start, int goal, int bands, QString &error)
+{
+    static QAtomicInt searchCount(0);
+    key = QString("mazesolver-shards-%1-%2").arg(QCoreApplication::applicationPid()).arg(searchCount.fetchAndAddRelaxed(1));
+    int rows = grid.getRows();
+    int columns = grid.getColumns();
+    int ringCapacity = 64;
+    while(ringCapacity < columns){
+        ringCapacity *= 2;
+    }
+
+    // The walls, one bit per node id
+    int cells = rows * columns;
+    mazeSegment.setKey(key + "-maze");
+    if(!mazeSegment.create(alignedSize(sizeof(MazeHeader)) + alignedSize(qint64((cells + 63) / 64) * 8))){
+        error = "Could not create the shared walls: " + mazeSegment.errorString();
+        return false;
+    }
+    memset(mazeSegment.data(), 0, mazeSegment.size());
+    maze = static_cast<MazeHeader*>(mazeSegment.data());
+    maze->rows = rows;
+    maze->columns = columns;
+    maze->bands = bands;
+    maze->goal = goal;
+    maze->ringCapacity = ringCapacity;
+    quint64 *walls = reinterpret_cast<quint64*>(static_cast<char*>(mazeSegment.data()) + alignedSize(sizeof(MazeHeader)));
+    for(int id = 0; id < cells; id++){
+        if(grid.isWall(grid.indexOfId(id))){
+            walls[id >> 6] |= quint64(1) << (id & 63);
+        }
+    }
+
+    for(int band = 0; band < bands; band++){
+        int firstRow = firstRowOf(band, rows, bands);
+        int rowCount = firstRowOf(band + 1, rows, bands) - firstRow;
+        int bandCells = rowCount * columns;
+        QSharedMemory *segment = new QSharedMemory(key + "-band" + QString::number(band));
+        segments.append(segment);
+        if(!segment->create(BandView::segmentSize(bandCells, ringCapacity, bandCells + frontierSlack))){
+            error = "Could not create the segment of band " + QString::number(band) + ": " + segment->errorString();
+            return false;
+        }
+        memset(segment->data(), 0, segment->size());
+        BandView view;
+        view.attach(segment->data(), bandCells, ringCapacity, bandCells + frontierSlack);
+        view.header->command.store(idleCommand);
+        view.header->status.store(idleCommand);
+        view.header->firstRow = firstRow;
+        view.header->rowCount = rowCount;
+        view.header->frontierCapacity = bandCells + frontierSlack;
+        views.append(view);
+    }
+
+    BandView &first = views[bandOf(start / columns, rows, bands)];
+    int local = start - first.header->firstRow * columns;
+    first.frontier[0][0] = start;
+    first.header->count[0] = 1;
+    first.visited[local >> 6] |= quint64(1) << (local & 63);
+
+    for(int band = 0; band < bands; band++){
+        QProcess *worker = new QProcess();
+        worker->setProcessChannelMode(QProcess::ForwardedChannels);
+        workers.append(worker);
+        if(!startWorker(band)){
+            error = "Could not start the worker of band " + QString::number(band) + ": " + worker->errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Starts the process of a band from this executable
+ * @param band The band
+ * @return True once it runs
+ */
+bool Coordinator::startWorker(int band)
+{
+    workers[band]->start(QCoreApplication::applicationFilePath(), QStringList() << "--shard-worker" << key << QString::number(band));
+    return workers[band]->waitForStarted();
+}
+
+/**
+ * @brief Kills the process of a band, to try the restart
+ * @param band The band
+ */
+void Coordinator::killWorker(int band)
+{
+    workers[band]->kill();
+}
+
+/**
+ * @brief Posts a command to all bands, after everything written before it
+ * @param command A level step or idleCommand or quitCommand
+ */
+void Coordinator::post(int command)
+{
+    for(int band = 0; band < views.size(); band++){
+        views[band].header->command.storeRelease(command);
+    }
+}
+
+/**
+ * @brief Waits until every band has finished a command. Workers that died on the way are
+ * started again and redo the command.
+ * @param command The command
+ * @param control Polled for cancel requests, may be 0
+ * @param result Receives the restarts, and the error if a worker can't be kept running
+ * @return False if cancelled or failed
+ */
+bool Coordinator::wait(int command, SearchControl *control, Result &result)
+{
+    int idleRounds = 0;
+    forever{
+        maze->heartbeat.fetchAndAddRelaxed(1);
+        bool done = true;
+        for(int band = 0; band < views.size(); band++){
+            if(views[band].header->status.loadAcquire() != command){
+                done = false;
+            }
+        }
+        if(done){
+            return true;
+        }
+        if(control != 0 && control->isCancelled()){
+            result.cancelled = true;
+            return false;
+        }
+
+        // Looking after the processes costs system calls, so it's done now and then
+        if((idleRounds & 255) == 255){
+            for(int band = 0; band < workers.size(); band++){
+                if(workers[band]->state() != QProcess::NotRunning && !workers[band]->waitForFinished(0)){
+                    continue;
+                }
+                if(result.restarts >= restartLimit || !startWorker(band)){
+                    result.failed = true;
+                    result.error = "The worker of band " + QString::number(band) + " keeps failing";
+                    return false;
+                }
+                result.restarts++;
+            }
+        }
+        backOff(idleRounds++);
+    }
+}
+
+/**
+ * @brief Follows the parent directions from the goal back to the start across the bands
+ * @param path Receives the node ids from the start to the goal
+ */
+void Coordinator::traceBack(int start, int goal, QVector<int> &path)
+{
+    int columns = maze->columns;
+    int id = goal;
+    path.clear();
+    path.append(id);
+    while(id != start && path.size() <= maze->rows * columns){
+        const BandView &view = views.at(bandOf(id / columns, maze->rows, maze->bands));
+        int local = id - view.header->firstRow * columns;
+        int direction = int((view.parents[local >> 5] >> ((local & 31) * 2)) & 3);
+        switch(direction){
+        case MazeGrid::South: id += columns; break;
+        case MazeGrid::North: id -= columns; break;
+        case MazeGrid::East: id += 1; break;
+        default: id -= 1; break;
+        }
+        path.append(id);
+    }
+    std::reverse(path.begin(), path.end());
+}
+
+/**
+ * @brief Searches from the start to the goal with one worker process per band of rows.
+ * Meant for a worker thread, the call returns when the search is over.
+ * @param grid The maze
+ * @param start The node id to start from
+ * @param goal The node id to find
+ * @param bands The number of worker processes, at most one per row
+ * @param control Polled for cancel requests once per level, may be 0
+ * @param killAtLevel Kills the worker of the middle band when this level starts, to try the restart
+ * @return The path and the counters
+ */
+Result run(const MazeGrid &grid, int start, int goal, int bands, SearchControl *control, int killAtLevel)
+{
+    TIMELINE_SCOPE("ShardedSearch::run", "solver");
+    Result result;
+    int rows = grid.getRows();
+    int columns = grid.getColumns();
+    result.bands = qBound(1, bands, qMax(rows, 1));
+    if(rows <= 0 || columns <= 0 || grid.isWall(grid.indexOfId(start)) || grid.isWall(grid.indexOfId(goal))){
+        return result;
+    }
+    if(start == goal){
+        result.found = true;
+        result.path.append(start);
+        return result;
+    }
+
+    Coordinator coordinator;
+    if(!coordinator.setUp(grid, start, goal, result.bands, result.error)){
+        result.failed = true;
+        return result;
+    }
+
+    BandHeader *goalBand = coordinator.header(bandOf(goal / columns, rows, result.bands));
+    for(int level = 0; ; level++){
+        int next = (level & 1) ^ 1;
+        for(int band = 0; band < result.bands; band++){
+            coordinator.header(band)->count[next] = 0;
+        }
+        coordinator.post(level * 2);
+        if(level == killAtLevel){
+            coordinator.killWorker(result.bands / 2);
+        }
+        if(!coordinator.wait(level * 2, control, result)){
+            break;
+        }
+        coordinator.post(level * 2 + 1);
+        if(!coordinator.wait(level * 2 + 1, control, result)){
+            break;
+        }
+
+        result.levels = level + 1;
+        result.expanded = 0;
+        int frontierSize = 0;
+        for(int band = 0; band < result.bands; band++){
+            result.expanded += coordinator.header(band)->expanded;
+            frontierSize += coordinator.header(band)->count[next];
+        }
+        if(control != 0 && control->poll(int(qMin(result.expanded, qint64(0x7fffffff))), frontierSize)){
+            result.cancelled = true;
+            break;
+        }
+        if(goalBand->found.loadAcquire()){
+            result.found = true;
+            coordinator.traceBack(start, goal, result.path);
+            break;
+        }
+        if(frontierSize == 0){
+            break; // No exit found
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Solves a random maze with MazeGrid::findPath in this process and with the sharded
+ * search, prints both and checks that the paths are equally long and connected. The mazes of
+ * the first seeds often have the corners cut off, so it takes the first one with a path.
+ * @param size Rows and columns of the maze
+ * @param bands The number of worker processes
+ * @param killAtLevel Kills a worker when this level starts, negative for never
+ * @param out Receives the report
+ * @return 0 if both searches agree, 1 otherwise
+ */
+int runComparison(int size, int bands, int killAtLevel, QTextStream &out)
+{
+    size = qMax(size, 2);
+    MazeGrid grid(size, size);
+    int goal = size * size - 1;
+    QVector<int> path;
+    int expanded = 0;
+    bool found = false;
+    quint32 seed = 0;
+    QElapsedTimer clock;
+    while(!found && seed < 100){
+        grid.randomize(++seed);
+        clock.start();
+        found = grid.findPath(0, goal, path, &expanded);
+    }
+    out << "Single process BFS on " << size << "x" << size << " (seed " << seed << "): " << clock.elapsed() << " ms, "
+        << expanded << " expanded, path " << path.size() << "\n";
+
+    clock.restart();
+    Result sharded = run(grid, 0, goal, bands, 0, killAtLevel);
+    if(sharded.failed){
+        out << "Sharded search failed: " << sharded.error << "\n";
+        return 1;
+    }
+    out << "Sharded BFS with " << sharded.bands << " workers: " << clock.elapsed() << " ms, " << sharded.expanded
+        << " expanded, " << sharded.levels << " levels, " << sharded.restarts << " restarts, path " << sharded.path.size() << "\n";
+
+    // The paths may differ but have to be equally long and made of open neighbours
+    bool agree = sharded.found == found && sharded.path.size() == path.size();
+    for(int ii = 1; agree && ii < sharded.path.size(); ii++){
+        int from = sharded.path.at(ii - 1);
+        int to = sharded.path.at(ii);
+        int distance = qAbs(from / size - to / size) + qAbs(from % size - to % size);
+        agree = distance == 1 && !grid.isWall(grid.indexOfId(to));
+    }
+    out << (agree ? "The searches agree\n" : "The searches DISAGREE\n");
+    return agree ? 0 : 1;
+}
+
+}
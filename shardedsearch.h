@@ -0,0 +1,53 @@
+#ifndef SHARDEDSEARCH_H
+#define SHARDEDSEARCH_H
+
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+#include "mazegrid.h"
+#include "searchcontrol.h"
+
+/**
+ * @brief A breadth first search split over worker processes, each of which owns a horizontal
+ * band of rows. Started with --shard-worker on the command line by the coordinator in run().
+ *
+ * The coordinator puts the walls into one shared memory segment and creates one segment per
+ * band holding everything the band's worker knows: the visited bits and parent directions of
+ * its cells, the frontiers of the current and the next level and two single producer, single
+ * consumer rings through which the bands above and below hand over cells they reached across
+ * the boundary. The rings need no locks, only an acquire load and a release store of their
+ * head and tail.
+ *
+ * The search runs one level at a time. The coordinator posts a command to every band and
+ * waits until each reports it as done: first the workers expand their frontier, with the same
+ * south, north, east, west order as MSolver, then they take in what's left in their rings. A
+ * worker that dies is started again on the same band and redoes the current command; cells are
+ * added to the next frontier before they are marked as visited, so a repeated command at worst
+ * puts a cell on the frontier twice. The segments belong to the coordinator, so nothing is lost
+ * with the process.
+ */
+namespace ShardedSearch {
+
+/// The outcome of a search
+struct Result
+{
+    Result() : found(false), cancelled(false), failed(false), expanded(0), levels(0), bands(0), restarts(0) {}
+    bool found; ///< True if the goal has been reached
+    bool cancelled; ///< True if the search stopped on a cancel request
+    bool failed; ///< True if the workers could not be set up or kept running
+    QString error; ///< What went wrong if failed
+    qint64 expanded; ///< Nodes expanded by all workers
+    int levels; ///< Breadth first levels searched
+    int bands; ///< Worker processes the maze was split over
+    int restarts; ///< Workers started again after they died
+    QVector<int> path; ///< Node ids from the start to the goal, empty if not found
+};
+
+Result run(const MazeGrid &grid, int start, int goal, int bands, SearchControl *control, int killAtLevel = -1); ///< Searches with one worker process per band
+int runWorker(const QString &key, int band); ///< Serves one band until the coordinator quits, returns a process exit code
+int runComparison(int size, int bands, int killAtLevel, QTextStream &out); ///< Solves a random maze sharded and in one process and compares the two
+
+}
+
+#endif // SHARDEDSEARCH_H
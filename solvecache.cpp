@@ -0,0 +1,451 @@
+#include "solvecache.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+#include "encodedpath.h"
+#include "mazegrid.h"
+#include "opendirectiontable.h"
+
+/**
+ * @brief Mixes a number into well spread bits, the splitmix64 finalizer
+ * @param value The number
+ * @return The mixed bits
+ */
+static inline quint64 mix(quint64 value)
+{
+    value = (value ^ (value >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    value = (value ^ (value >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Folds the key into one number: FNV-1a over the algorithm, then the other fields mixed
+ * in one after the other
+ * @return The digest
+ */
+quint64 SolveCache::Key::digest() const
+{
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    QByteArray name = algorithm.toUtf8();
+    for(int ii = 0; ii < name.size(); ii++){
+        hash ^= quint8(name.at(ii));
+        hash *= Q_UINT64_C(1099511628211);
+    }
+    quint64 fields[5] = { wallHash, quint64(rows), quint64(columns), quint64(entrance), quint64(exit) };
+    for(int ii = 0; ii < 5; ii++){
+        hash = mix(hash ^ fields[ii]) + Q_UINT64_C(0x9e3779b97f4a7c15);
+    }
+    return hash;
+}
+
+bool SolveCache::Key::operator==(const Key &other) const
+{
+    return wallHash == other.wallHash && rows == other.rows && columns == other.columns
+            && entrance == other.entrance && exit == other.exit && algorithm == other.algorithm;
+}
+
+/**
+ * @brief Creates a cache in memory only, setDirectory adds the store
+ * @param maxMemoryBytes Bytes the results in memory may take
+ * @param maxDiskFiles Results the store keeps
+ */
+SolveCache::SolveCache(int maxMemoryBytes, int maxDiskFiles)
+    : memory(maxMemoryBytes)
+{
+    this->maxDiskFiles = qMax(maxDiskFiles, 1);
+    lastHitInMemory = false;
+}
+
+/**
+ * @brief Opens the store in a directory. The files already there are taken over, the least
+ * recently used ones first by their modification times, and the oldest over the limit go.
+ * @param path The directory, created if missing. Empty keeps the results in memory only.
+ */
+void SolveCache::setDirectory(const QString &path)
+{
+    directory.clear();
+    diskOrder.clear();
+    if(path.isEmpty() || !QDir().mkpath(path)){
+        return;
+    }
+    directory = path;
+
+    QFileInfoList files = QDir(directory).entryInfoList(QStringList("*.solve"), QDir::Files, QDir::Time | QDir::Reversed);
+    foreach(const QFileInfo &file, files){
+        bool ok = false;
+        quint64 digest = file.completeBaseName().toULongLong(&ok, 16);
+        if(ok){
+            diskOrder.append(digest);
+        }
+    }
+    while(diskOrder.size() > maxDiskFiles){
+        QFile::remove(fileNameOf(diskOrder.takeFirst()));
+    }
+}
+
+/**
+ * @brief Gets the directory of the store
+ * @return The path, empty if results are kept in memory only
+ */
+QString SolveCache::getDirectory() const
+{
+    return directory;
+}
+
+/**
+ * @brief Looks a result up, in memory first and then in the store. A result read from the
+ * store is kept in memory from then on.
+ * @param key What the result was stored under
+ * @param result Receives the result
+ * @return True if the result was found
+ */
+bool SolveCache::lookup(const Key &key, Result &result)
+{
+    quint64 digest = key.digest();
+    Entry *cached = memory.object(digest);
+    if(cached != 0 && cached->key == key){
+        result = cached->result;
+        statistics.memoryHits++;
+        lastHitInMemory = true;
+        // The file may never have been written or have been removed already
+        if(diskOrder.contains(digest)){
+            touchFile(digest);
+        }
+        return true;
+    }
+
+    Entry entry;
+    if(!directory.isEmpty() && diskOrder.contains(digest) && readEntry(digest, entry) && entry.key == key){
+        result = entry.result;
+        statistics.diskHits++;
+        lastHitInMemory = false;
+        keepInMemory(digest, entry);
+        writeEntry(digest, entry); // Renews the modification time for the next session
+        touchFile(digest);
+        return true;
+    }
+    statistics.misses++;
+    return false;
+}
+
+/**
+ * @brief Keeps a result in memory and writes it to the store
+ * @param key What the result is stored under
+ * @param result The result
+ */
+void SolveCache::insert(const Key &key, const Result &result)
+{
+    Entry entry;
+    entry.key = key;
+    entry.result = result;
+    quint64 digest = key.digest();
+    keepInMemory(digest, entry);
+    statistics.stores++;
+    if(!directory.isEmpty() && writeEntry(digest, entry)){
+        touchFile(digest);
+    }
+}
+
+/**
+ * @brief Forgets the result of a key, in memory and in the store, after the last lookup found
+ * it but the caller couldn't use it. The lookup is counted as a miss instead of a hit.
+ * @param key What the result was stored under
+ */
+void SolveCache::remove(const Key &key)
+{
+    quint64 digest = key.digest();
+    Entry *cached = memory.object(digest);
+    if(cached != 0 && cached->key == key){
+        memory.remove(digest);
+    }
+    // A result too large for memory was only read from the store
+    if(diskOrder.removeOne(digest)){
+        QFile::remove(fileNameOf(digest));
+    }
+
+    if(lastHitInMemory){
+        statistics.memoryHits--;
+    }
+    else{
+        statistics.diskHits--;
+    }
+    statistics.misses++;
+}
+
+/**
+ * @brief Forgets all results and removes the files of the store
+ */
+void SolveCache::clear()
+{
+    memory.clear();
+    foreach(quint64 digest, diskOrder){
+        QFile::remove(fileNameOf(digest));
+    }
+    diskOrder.clear();
+    statistics = Statistics();
+}
+
+/**
+ * @brief Gets the number of results kept in memory
+ * @return The number of entries
+ */
+int SolveCache::getMemoryEntries() const
+{
+    return memory.size();
+}
+
+/**
+ * @brief Gets the memory held by the results, as counted against the limit
+ * @return Bytes
+ */
+int SolveCache::getMemoryBytes() const
+{
+    return memory.totalCost();
+}
+
+/**
+ * @brief Gets the number of result files in the store
+ * @return The number of files
+ */
+int SolveCache::getDiskEntries() const
+{
+    return diskOrder.size();
+}
+
+/**
+ * @brief Gets where the lookups since the last clear were answered
+ * @return The counts
+ */
+SolveCache::Statistics SolveCache::getStatistics() const
+{
+    return statistics;
+}
+
+/**
+ * @brief Hashes all walls of a maze at once, the same as the open direction table gets by
+ * changing them one at a time
+ * @param walls One bit per node id, set for walls
+ * @return The XOR of the keys of the wall cells
+ */
+quint64 SolveCache::hashWalls(const QBitArray &walls)
+{
+    quint64 hash = 0;
+    for(int id = 0; id < walls.size(); id++){
+        if(walls.testBit(id)){
+            hash ^= OpenDirectionTable::cellKey(id);
+        }
+    }
+    return hash;
+}
+
+/**
+ * @brief Solves a random maze with BFS, then answers the same query from memory, after a wall
+ * change and back, and from the store as a new session would, and compares the times
+ * @param size Rows and columns of the maze
+ * @param repeats Queries answered from memory
+ * @param out Receives the report
+ * @return A process exit code, 1 if a cached path differs from the one searched
+ */
+int SolveCache::runBenchmark(int size, int repeats, QTextStream &out)
+{
+    size = qMax(size, 2);
+    repeats = qMax(repeats, 1);
+
+    MazeGrid grid(size, size);
+    grid.randomize(0x9e3779b9u);
+    QBitArray walls = grid.getWalls();
+    OpenDirectionTable table;
+    table.reset(size, size);
+    table.setWalls(walls);
+
+    Key key;
+    key.wallHash = table.getWallHash();
+    key.rows = size;
+    key.columns = size;
+    key.entrance = 0;
+    key.exit = size * size - 1;
+    key.algorithm = "BFS";
+
+    QString storeDirectory = QDir(QDir::tempPath()).filePath("mazesolver-cache-benchmark");
+    SolveCache cache;
+    cache.setDirectory(storeDirectory);
+    cache.clear();
+
+    QElapsedTimer clock;
+    clock.start();
+    QVector<int> ids;
+    int expanded = 0;
+    bool found = grid.findPath(key.entrance, key.exit, ids, &expanded);
+    qint64 solveNs = clock.nsecsElapsed();
+
+    Result result;
+    result.found = found;
+    result.expanded = expanded;
+    result.solveUs = solveNs / 1000;
+    EncodedPath path;
+    if(found && EncodedPath::fromIds(ids, size, path)){
+        result.path = path.toBinary();
+    }
+    cache.insert(key, result);
+    out << "Solved " << size << "x" << size << " with BFS in " << QString::number(solveNs / 1e6, 'f', 2) << " ms, "
+        << (found ? "path of " + QString::number(ids.size()) + " cells" : QString("no path")) << ", stored in "
+        << result.path.size() << " bytes\n";
+
+    // Repeated queries, the path decoded to node ids each time
+    bool consistent = true;
+    clock.restart();
+    for(int ii = 0; ii < repeats; ii++){
+        Result cached;
+        QVector<int> decoded;
+        consistent = cache.lookup(key, cached) && consistent;
+        if(EncodedPath::fromBinary(cached.path, path)){
+            decoded = path.toIds();
+        }
+        consistent = consistent && cached.found == found && decoded == ids;
+    }
+    double memoryNs = double(clock.nsecsElapsed()) / repeats;
+    out << "Memory hit: " << QString::number(memoryNs / 1000.0, 'f', 2) << " us per query, "
+        << QString::number(solveNs / qMax(memoryNs, 1.0), 'f', 0) << " times faster than searching\n";
+
+    // A wall change and its undo, each one XOR on the hash
+    int cell = size / 2 * size + size / 2;
+    int toggles = 100000;
+    clock.restart();
+    for(int ii = 0; ii < toggles; ii++){
+        table.setWall(cell, !table.isWall(cell));
+        if(ii == 0){
+            Key changed = key;
+            changed.wallHash = table.getWallHash();
+            Result missed;
+            consistent = consistent && !cache.lookup(changed, missed);
+        }
+    }
+    double toggleNs = double(clock.nsecsElapsed()) / toggles;
+    clock.restart();
+    quint64 fullHash = hashWalls(walls);
+    qint64 fullNs = clock.nsecsElapsed();
+    consistent = consistent && table.getWallHash() == key.wallHash && fullHash == key.wallHash;
+    out << "Wall change: " << QString::number(toggleNs, 'f', 1) << " ns with the table patch, hashing all walls takes "
+        << QString::number(fullNs / 1000.0, 'f', 1) << " us; the changed maze misses, changing it back hits again\n";
+
+    // The next session, starting with an empty memory
+    SolveCache reopened;
+    reopened.setDirectory(storeDirectory);
+    Result stored;
+    clock.restart();
+    bool storedHit = reopened.lookup(key, stored);
+    qint64 diskNs = clock.nsecsElapsed();
+    consistent = consistent && storedHit && stored.path == result.path && stored.expanded == result.expanded;
+    out << "Store hit after reopening: " << QString::number(diskNs / 1000.0, 'f', 1) << " us\n";
+    reopened.clear();
+
+    if(!consistent){
+        out << "A cached result differs from the search\n";
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Keeps an entry in memory, at the cost of its size
+ * @param digest The digest of its key
+ * @param entry The entry
+ */
+void SolveCache::keepInMemory(quint64 digest, const Entry &entry)
+{
+    int cost = int(sizeof(Entry)) + entry.result.path.size() + entry.key.algorithm.size() * 2;
+    memory.insert(digest, new Entry(entry), cost);
+}
+
+/**
+ * @brief Moves a file to the most recently used end of the store, removing the least recently
+ * used files over the limit
+ * @param digest The digest of its key
+ */
+void SolveCache::touchFile(quint64 digest)
+{
+    if(directory.isEmpty()){
+        return;
+    }
+    diskOrder.removeOne(digest);
+    diskOrder.append(digest);
+    while(diskOrder.size() > maxDiskFiles){
+        QFile::remove(fileNameOf(diskOrder.takeFirst()));
+    }
+}
+
+/**
+ * @brief Gets the file a result is stored in, named after the digest in hexadecimal
+ * @param digest The digest of its key
+ * @return The path of the file
+ */
+QString SolveCache::fileNameOf(quint64 digest) const
+{
+    return QDir(directory).filePath(QString("%1.solve").arg(digest, 16, 16, QChar('0')));
+}
+
+/**
+ * @brief Reads an entry written by writeEntry
+ * @param digest The digest of its key
+ * @param entry Receives the entry
+ * @return True on success
+ */
+bool SolveCache::readEntry(quint64 digest, Entry &entry) const
+{
+    QFile file(fileNameOf(digest));
+    if(!file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 fileMagic;
+    qint32 fileVersion;
+    in >> fileMagic >> fileVersion;
+    if(fileMagic != magic || fileVersion > version){
+        return false;
+    }
+    qint32 rows;
+    qint32 columns;
+    qint32 entrance;
+    qint32 exit;
+    in >> entry.key.wallHash >> rows >> columns >> entrance >> exit >> entry.key.algorithm
+       >> entry.result.found >> entry.result.expanded >> entry.result.solveUs >> entry.result.path;
+    entry.key.rows = rows;
+    entry.key.columns = columns;
+    entry.key.entrance = entrance;
+    entry.key.exit = exit;
+    return in.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief Writes an entry to a part file first and renames it, so a crash never leaves a
+ * broken entry behind
+ * @param digest The digest of its key
+ * @param entry The entry
+ * @return True on success
+ */
+bool SolveCache::writeEntry(quint64 digest, const Entry &entry) const
+{
+    QString fileName = fileNameOf(digest);
+    QString partName = fileName + ".part";
+    QFile file(partName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << magic << version << entry.key.wallHash << qint32(entry.key.rows) << qint32(entry.key.columns)
+        << qint32(entry.key.entrance) << qint32(entry.key.exit) << entry.key.algorithm
+        << entry.result.found << entry.result.expanded << entry.result.solveUs << entry.result.path;
+    file.close();
+    if(out.status() != QDataStream::Ok){
+        QFile::remove(partName);
+        return false;
+    }
+    QFile::remove(fileName);
+    return QFile::rename(partName, fileName);
+}
@@ -0,0 +1,100 @@
+#ifndef SOLVECACHE_H
+#define SOLVECACHE_H
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+#include <QString>
+#include <QTextStream>
+
+/**
+ * @brief Remembers the results of searches by the maze they ran on, so a maze that comes back,
+ * after a reset or in a later session, is answered without searching again.
+ *
+ * A maze is told apart by the Zobrist hash of its walls, which the open direction table keeps
+ * up to date on every wall change, together with the grid size, the entrance, the exit and the
+ * algorithm with the options that change its path. Results hold the path in the binary form of
+ * EncodedPath and the figures of the search that found it. The most recently used results are
+ * kept in memory up to a number of bytes. Every result also goes into a directory, one file
+ * per key, which keeps the most recently used files up to a number of entries and is read on
+ * a miss in memory. The order of the files survives restarts through their modification times.
+ */
+class SolveCache
+{
+public:
+    /// What a result is looked up by
+    struct Key
+    {
+        Key() : wallHash(0), rows(0), columns(0), entrance(0), exit(0) {}
+        quint64 wallHash; ///< Zobrist hash of the walls, see OpenDirectionTable::getWallHash
+        int rows;
+        int columns;
+        int entrance;
+        int exit;
+        QString algorithm; ///< The search and the options that change its path
+        quint64 digest() const; ///< The key as one number, also the file name in the store
+        bool operator==(const Key &other) const;
+    };
+
+    /// A stored result
+    struct Result
+    {
+        Result() : found(false), expanded(0), solveUs(0) {}
+        bool found;
+        QByteArray path; ///< EncodedPath::toBinary of the path, empty if none was found
+        qint64 expanded; ///< Nodes the search expanded when it ran
+        qint64 solveUs; ///< Time the search took when it ran
+    };
+
+    /// Where lookups were answered
+    struct Statistics
+    {
+        Statistics() : memoryHits(0), diskHits(0), misses(0), stores(0) {}
+        qint64 memoryHits;
+        qint64 diskHits;
+        qint64 misses;
+        qint64 stores;
+    };
+
+    explicit SolveCache(int maxMemoryBytes = 16 << 20, int maxDiskFiles = 4096);
+    void setDirectory(const QString &path); ///< Opens the store in a directory, created if missing, empty for memory only
+    QString getDirectory() const;
+    bool lookup(const Key &key, Result &result); ///< Finds a result in memory, then in the store
+    void insert(const Key &key, const Result &result); ///< Keeps a result in memory and in the store
+    void remove(const Key &key); ///< Forgets a result the caller couldn't use, the lookup that found it counts as a miss
+    void clear(); ///< Forgets all results, in memory and in the store
+    int getMemoryEntries() const;
+    int getMemoryBytes() const;
+    int getDiskEntries() const;
+    Statistics getStatistics() const;
+
+    static quint64 hashWalls(const QBitArray &walls); ///< The Zobrist hash of a whole maze, as the open direction table keeps it
+    static int runBenchmark(int size, int repeats, QTextStream &out); ///< Times repeated solves through the cache against searching
+
+private:
+    /// A result with its full key, which tells digests that collide apart
+    struct Entry
+    {
+        Key key;
+        Result result;
+    };
+
+    static const quint32 magic = 0x4d5a5231; ///< "MZR1"
+    static const qint32 version = 1;
+
+    QCache<quint64,Entry> memory; ///< Cost is the size of an entry in bytes
+    QString directory;
+    int maxDiskFiles;
+    QList<quint64> diskOrder; ///< Digests of the files in the store, least recently used first
+    Statistics statistics;
+    bool lastHitInMemory; ///< Where the last successful lookup was answered
+
+    void keepInMemory(quint64 digest, const Entry &entry);
+    void touchFile(quint64 digest); ///< Moves a file to the most recently used end, removing the least recently used ones over the limit
+    QString fileNameOf(quint64 digest) const;
+    bool readEntry(quint64 digest, Entry &entry) const;
+    bool writeEntry(quint64 digest, const Entry &entry) const;
+};
+
+#endif // SOLVECACHE_H
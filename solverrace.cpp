@@ -0,0 +1,283 @@
+#include "solverrace.h"
+#include "boundedsearch.h"
+#include "rectanglesearch.h"
+#include "shardedsearch.h"
+
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+/**
+ * @brief Creates a race that hasn't started
+ * @param parent The parent for reference purposes
+ */
+SolverRace::SolverRace(QObject *parent) :
+    QObject(parent)
+{
+    startId = 0;
+    goalId = 0;
+    running = 0;
+    anytime = new AnytimeSearch();
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(RacerCount);
+    for(int racer = 0; racer < RacerCount; racer++){
+        watchers[racer] = new QFutureWatcher<Outcome>(this);
+        connect(watchers[racer], SIGNAL(finished()), this, SLOT(finishRacer()));
+    }
+}
+
+/**
+ * @brief Stops a running race before the racers lose their state
+ */
+SolverRace::~SolverRace()
+{
+    cancel();
+    delete anytime;
+}
+
+/**
+ * @brief Gets the name of a racer as the search selection of the UI has it
+ * @param racer The racer
+ * @return The name
+ */
+QString SolverRace::racerName(int racer)
+{
+    switch(racer){
+    case DepthFirst: return "DFS (instant)";
+    case BreadthFirst: return "BFS (instant)";
+    case IdaStar: return "IDA*";
+    case FrontierBreadthFirst: return "Frontier BFS";
+    case AnytimeAStar: return "Anytime A*";
+    case RectangleAStar: return "Rectangle A*";
+    case ShardedBreadthFirst: return "Sharded BFS";
+    }
+    return QString();
+}
+
+/**
+ * @brief Starts all racers at once on a copy of the maze
+ * @param maze The maze, copied
+ * @param start Node id of the start
+ * @param goal Node id of the goal
+ * @param raceSettings The options of the solvers
+ */
+void SolverRace::start(const MazeGrid &maze, int start, int goal, const Settings &raceSettings)
+{
+    cancel();
+    grid = maze;
+    startId = start;
+    goalId = goal;
+    settings = raceSettings;
+    running = 0;
+    clock.start();
+
+    for(int racer = 0; racer < RacerCount; racer++){
+        outcomes[racer] = Outcome();
+        controls[racer].reset();
+        if(!isEntered(racer)){
+            continue;
+        }
+        Job job;
+        job.racer = racer;
+        job.grid = &grid;
+        job.start = startId;
+        job.goal = goalId;
+        job.settings = settings;
+        job.control = &controls[racer];
+        job.anytime = anytime;
+        watchers[racer]->setFuture(QtConcurrent::run(pool, SolverRace::run, job));
+        running++;
+    }
+}
+
+/**
+ * @brief Asks every racer to stop at its next poll and waits until all have returned
+ */
+void SolverRace::cancel()
+{
+    for(int racer = 0; racer < RacerCount; racer++){
+        controls[racer].requestCancel();
+    }
+    for(int racer = 0; racer < RacerCount; racer++){
+        watchers[racer]->waitForFinished();
+    }
+}
+
+/**
+ * @brief Checks if any racer is still searching
+ * @return True until the last racer has finished
+ */
+bool SolverRace::isRunning() const
+{
+    return running > 0;
+}
+
+/**
+ * @brief Checks if a racer takes part in the race, the sharded search only does with at least
+ * one worker process
+ * @param racer The racer
+ * @return True if the racer runs
+ */
+bool SolverRace::isEntered(int racer) const
+{
+    return racer != ShardedBreadthFirst || settings.bands > 0;
+}
+
+/**
+ * @brief Gets the copy of the maze all racers search
+ * @return The grid
+ */
+const MazeGrid &SolverRace::getGrid() const
+{
+    return grid;
+}
+
+/**
+ * @brief Gets how a racer did, or how far it got if it's still running
+ * @param racer The racer
+ * @return The outcome, with the live expansions and time of a running racer
+ */
+SolverRace::Outcome SolverRace::getOutcome(int racer) const
+{
+    Outcome outcome = outcomes[racer];
+    if(!outcome.finished && isEntered(racer) && clock.isValid()){
+        outcome.expanded = controls[racer].expanded.load();
+        outcome.elapsedUs = clock.nsecsElapsed() / 1000;
+    }
+    return outcome;
+}
+
+/**
+ * @brief Ranks the racers: those that found a path by their time, then the others
+ * @return The racers, first place first
+ */
+QVector<int> SolverRace::getPlaces() const
+{
+    QVector<int> places;
+    for(int racer = 0; racer < RacerCount; racer++){
+        if(isEntered(racer)){
+            places.append(racer);
+        }
+    }
+    std::stable_sort(places.begin(), places.end(), [this](int left, int right){
+        const Outcome &a = outcomes[left];
+        const Outcome &b = outcomes[right];
+        if(a.found != b.found){
+            return a.found;
+        }
+        return a.finished && (!b.finished || a.elapsedUs < b.elapsedUs);
+    });
+    return places;
+}
+
+/**
+ * @brief Runs one racer to completion on the thread it was handed
+ * @param job The racer, the maze and the options
+ * @return How it did
+ */
+SolverRace::Outcome SolverRace::run(Job job)
+{
+    QElapsedTimer timer;
+    timer.start();
+    Outcome outcome;
+    outcome.shortest = true;
+
+    switch(job.racer){
+    case DepthFirst:
+    case BreadthFirst:{
+        MazeKernels::KernelInput input;
+        input.rows = job.grid->getRows();
+        input.columns = job.grid->getColumns();
+        input.entrance = job.start;
+        input.exit = job.goal;
+        input.walls = job.grid->getWalls();
+        input.control = job.control;
+        MazeKernels::KernelResult result = MazeKernels::run(input, job.racer == DepthFirst ? MazeKernels::DepthFirst : MazeKernels::BreadthFirst,
+                                                            MazeKernels::FourConnected, job.settings.storage);
+        outcome.found = result.found;
+        outcome.cancelled = result.cancelled;
+        outcome.expanded = result.expanded;
+        outcome.path = result.path;
+        outcome.shortest = job.racer == BreadthFirst;
+        break;
+    }
+    case IdaStar:
+    case FrontierBreadthFirst:{
+        BoundedSearch::Result result = BoundedSearch::run(*job.grid, job.start, job.goal,
+                                                          job.racer == IdaStar ? BoundedSearch::IterativeDeepeningAStar : BoundedSearch::FrontierBreadthFirst,
+                                                          job.settings.budgetBytes, job.control);
+        outcome.found = result.found;
+        outcome.cancelled = result.cancelled;
+        outcome.expanded = result.expanded;
+        outcome.path = result.path;
+        if(result.budgetExceeded){
+            outcome.note = "Out of memory budget";
+        }
+        break;
+    }
+    case AnytimeAStar:{
+        AnytimeSearch::Request request;
+        request.grid = *job.grid;
+        request.start = job.start;
+        request.goal = job.goal;
+        request.deadlineUs = job.settings.deadlineUs;
+        request.landmarks = job.settings.landmarks;
+        request.clock.start();
+        AnytimeSearch::Result result = job.anytime->run(request, job.control);
+        outcome.found = result.found;
+        outcome.cancelled = result.cancelled;
+        outcome.expanded = result.expanded;
+        outcome.path = result.path;
+        outcome.shortest = result.optimal;
+        if(result.found && !result.optimal){
+            outcome.note = "At most " + QString::number(result.bound, 'f', 2) + " times the shortest";
+        }
+        break;
+    }
+    case RectangleAStar:{
+        RectangleSearch::Result result = RectangleSearch::run(*job.grid, job.start, job.goal, job.control);
+        outcome.found = result.found;
+        outcome.cancelled = result.cancelled;
+        outcome.expanded = result.expanded;
+        outcome.path = result.path;
+        break;
+    }
+    case ShardedBreadthFirst:{
+        ShardedSearch::Result result = ShardedSearch::run(*job.grid, job.start, job.goal, job.settings.bands, job.control);
+        outcome.found = result.found;
+        outcome.cancelled = result.cancelled;
+        outcome.expanded = result.expanded;
+        outcome.path = result.path;
+        if(result.failed){
+            outcome.note = result.error;
+        }
+        break;
+    }
+    }
+
+    outcome.elapsedUs = timer.nsecsElapsed() / 1000;
+    outcome.finished = true;
+    return outcome;
+}
+
+/**
+ * @brief Picks up the outcome of the racer whose thread has returned
+ */
+void SolverRace::finishRacer()
+{
+    QFutureWatcher<Outcome> *watcher = static_cast<QFutureWatcher<Outcome>*>(sender());
+    int racer = 0;
+    while(racer < RacerCount && watchers[racer] != watcher){
+        racer++;
+    }
+    if(racer == RacerCount || !isEntered(racer) || outcomes[racer].finished){
+        return;
+    }
+
+    outcomes[racer] = watcher->result();
+    running--;
+    emit racerFinished(racer);
+    if(running == 0){
+        emit finished();
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef SOLVERRACE_H
+#define SOLVERRACE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QThreadPool>
+
+#include "mazegrid.h"
+#include "mazekernels.h"
+#include "anytimesearch.h"
+#include "searchcontrol.h"
+
+class LandmarkTable;
+
+/**
+ * @brief Runs every solver at the same time on one maze, each on a thread of its own. The maze
+ * is copied once when the race starts and only read after that, every solver keeps its search
+ * state to itself. Each racer publishes its expansions through a SearchControl of its own and
+ * times itself on its thread, so waiting for a thread doesn't count against it.
+ *
+ * The stepwise DFS and BFS keep their state in the nodes of the scene, which can't be shared,
+ * so they race as their kernels.
+ */
+class SolverRace : public QObject
+{
+    Q_OBJECT
+public:
+    /// The solvers in the race
+    enum Racer {
+        DepthFirst, ///< The DFS kernel
+        BreadthFirst, ///< The BFS kernel
+        IdaStar, ///< IDA* within the memory budget
+        FrontierBreadthFirst, ///< Frontier BFS within the memory budget
+        AnytimeAStar, ///< ARA* until optimal or the deadline
+        RectangleAStar, ///< A* across empty rectangles
+        ShardedBreadthFirst, ///< BFS over worker processes
+        RacerCount
+    };
+
+    /// The options of the solvers that have any
+    struct Settings
+    {
+        Settings() : storage(MazeKernels::PaddedGridStorage), budgetBytes(1024 * 1024), deadlineUs(10000), bands(2), landmarks(0) {}
+        MazeKernels::Storage storage; ///< Cell storage of the kernels
+        qint64 budgetBytes; ///< Memory IDA* and frontier BFS may use
+        qint64 deadlineUs; ///< Time the anytime search may take
+        int bands; ///< Worker processes of the sharded search, 0 leaves it out
+        const LandmarkTable *landmarks; ///< Landmarks of the maze for the anytime search, may be 0
+    };
+
+    /// How a racer did
+    struct Outcome
+    {
+        Outcome() : finished(false), found(false), shortest(false), cancelled(false), expanded(0), elapsedUs(0) {}
+        bool finished; ///< The racer has returned
+        bool found; ///< It found a path
+        bool shortest; ///< The path is known to be a shortest one
+        bool cancelled; ///< The race was cancelled before it was done
+        qint64 expanded; ///< Expansions, live while it runs
+        qint64 elapsedUs; ///< Time on its thread, live while it runs
+        QString note; ///< Why it gave up, if it did
+        QVector<int> path; ///< Node ids from the start to the goal
+    };
+
+    explicit SolverRace(QObject *parent = 0);
+    ~SolverRace();
+    static QString racerName(int racer);
+    void start(const MazeGrid &maze, int start, int goal, const Settings &raceSettings); ///< Starts all racers, cancelling a running race first
+    void cancel(); ///< Asks all racers to stop and waits for them
+    bool isRunning() const;
+    bool isEntered(int racer) const; ///< False for racers left out by the settings
+    const MazeGrid &getGrid() const; ///< The maze being raced on
+    Outcome getOutcome(int racer) const; ///< The final outcome, or the live counters of a running racer
+    QVector<int> getPlaces() const; ///< Racers with a path by time, then the others
+
+signals:
+    void racerFinished(int racer);
+    void finished();
+
+private:
+    /// What a racer needs on its thread
+    struct Job
+    {
+        int racer;
+        const MazeGrid *grid;
+        int start;
+        int goal;
+        Settings settings;
+        SearchControl *control;
+        AnytimeSearch *anytime;
+    };
+
+    MazeGrid grid; ///< The copy of the maze all racers read
+    int startId;
+    int goalId;
+    Settings settings;
+    QThreadPool *pool; ///< One thread per racer, so none has to wait for another
+    SearchControl controls[RacerCount]; ///< Cancel flag and live counters of each racer
+    QFutureWatcher<Outcome> *watchers[RacerCount];
+    Outcome outcomes[RacerCount];
+    AnytimeSearch *anytime; ///< ARA* state, only used on the thread of its racer
+    QElapsedTimer clock; ///< Started with the race, for the live times
+    int running; ///< Racers that haven't returned yet
+
+    static Outcome run(Job job); ///< Runs one racer, on its thread
+
+private slots:
+    void finishRacer();
+};
+
+#endif // SOLVERRACE_H
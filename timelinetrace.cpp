@@ -0,0 +1,325 @@
+#include "timelinetrace.h"
+
+#ifdef MAZESOLVER_TIMELINE
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QThreadStorage>
+#include <QVector>
+
+namespace TimelineTrace {
+
+/// Events kept per thread, a power of two
+static const int ringCapacity = 65536;
+/// Threads that hold a ring at the same time, events of further threads are dropped
+static const int maxRings = 256;
+/// Events kept of threads that have finished, the oldest are dropped beyond
+static const int maxRetiredEvents = 4 * ringCapacity;
+
+/// A finished event
+struct Event
+{
+    const char *name;
+    const char *category;
+    qint64 start;
+    qint64 end;
+};
+
+/// The events of one thread. Only the thread writes, the export reads while it does.
+struct Ring
+{
+    Ring() : written(0), full(false), events(ringCapacity), threadNumber(0) {}
+    QAtomicInt written; ///< Events recorded so far, wraps around
+    bool full; ///< Set once the oldest events are being overwritten
+    QVector<Event> events;
+    QString threadName;
+    int threadNumber; ///< Thread id in the trace, threads that reuse a ring get a new one
+};
+
+/// The events of a thread that has finished, kept for the export after its ring went back
+struct RetiredThread
+{
+    QString threadName;
+    int threadNumber;
+    QVector<Event> events;
+};
+
+/// Hands the ring of a thread back when the thread finishes
+class RingHolder
+{
+public:
+    explicit RingHolder(int ringIndex) : index(ringIndex) {}
+    ~RingHolder();
+    int index;
+};
+
+// The ring table, the retired events and the counts of lost events are guarded by ringLock.
+// Rings and retired events are never freed, a thread may finish while the statics are being
+// destroyed.
+static Ring *rings[maxRings];
+static bool ringInUse[maxRings];
+static int freeRings[maxRings]; ///< Indices of rings whose thread has finished
+static int freeRingCount = 0;
+static QAtomicInt ringCount(0);
+static QVector<RetiredThread> *retiredThreads = 0;
+static int retiredEventCount = 0;
+static int threadCount = 0;
+static qint64 overwrittenEvents = 0; ///< Overwritten in the rings of finished threads
+static qint64 discardedEvents = 0; ///< Of finished threads, beyond maxRetiredEvents
+static QAtomicInt unrecordedEvents(0); ///< Of threads that found no ring
+static QMutex ringLock; ///< Taken when a thread takes or hands back a ring, and by the export
+static QThreadStorage<RingHolder*> ringOfThread; ///< Deleted by Qt when the thread finishes
+
+qint64 now()
+{
+    static QElapsedTimer clock = [](){ QElapsedTimer started; started.start(); return started; }();
+    return clock.nsecsElapsed();
+}
+
+/**
+ * @brief Gets the ring of the calling thread. On the first event the thread takes a ring a
+ * finished thread handed back, or a new one.
+ * @return The ring, 0 if as many threads as there are rings hold one
+ */
+static Ring *localRing()
+{
+    RingHolder *holder = ringOfThread.localData();
+    if(holder != 0){
+        return rings[holder->index];
+    }
+
+    QMutexLocker locker(&ringLock);
+    int index;
+    if(freeRingCount > 0){
+        index = freeRings[--freeRingCount];
+    }
+    else if(ringCount.load() < maxRings){
+        index = ringCount.load();
+        rings[index] = new Ring;
+        ringCount.storeRelease(index + 1);
+    }
+    else{
+        return 0;
+    }
+
+    Ring *ring = rings[index];
+    ring->threadNumber = ++threadCount;
+    ring->threadName = QThread::currentThread()->objectName();
+    if(ring->threadName.isEmpty()){
+        bool mainThread = QCoreApplication::instance() != 0 && QThread::currentThread() == QCoreApplication::instance()->thread();
+        ring->threadName = mainThread ? QString("Main thread") : "Thread " + QString::number(ring->threadNumber);
+    }
+    ringInUse[index] = true;
+    ringOfThread.setLocalData(new RingHolder(index));
+    return ring;
+}
+
+/**
+ * @brief Appends an event to the ring of the calling thread, overwriting the oldest one if
+ * the ring is full
+ * @param name What ran, a string that lives as long as the program
+ * @param category The part of the application, a string that lives as long as the program
+ * @param startNs When it started, from now()
+ * @param endNs When it ended, from now()
+ */
+void record(const char *name, const char *category, qint64 startNs, qint64 endNs)
+{
+    Ring *ring = localRing();
+    if(ring == 0){
+        unrecordedEvents.ref();
+        return;
+    }
+    quint32 written = quint32(ring->written.load());
+    Event &event = ring->events[int(written & (ringCapacity - 1))];
+    event.name = name;
+    event.category = category;
+    event.start = startNs;
+    event.end = endNs;
+    if(written + 1 == quint32(ringCapacity)){
+        ring->full = true;
+    }
+    ring->written.storeRelease(int(written + 1));
+}
+
+/**
+ * @brief Drops the events of all threads, the finished ones included, and the counts of lost
+ * events. The threads should be idle, events recorded at the same time may survive.
+ */
+void clear()
+{
+    QMutexLocker locker(&ringLock);
+    for(int index = 0; index < ringCount.load(); index++){
+        rings[index]->full = false;
+        rings[index]->written.storeRelease(0);
+    }
+    if(retiredThreads != 0){
+        retiredThreads->clear();
+    }
+    retiredEventCount = 0;
+    overwrittenEvents = 0;
+    discardedEvents = 0;
+    unrecordedEvents.store(0);
+}
+
+/**
+ * @brief Puts a string between quotes, escaped for JSON
+ */
+static QByteArray quoted(const QString &text)
+{
+    QByteArray escaped = text.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    return '"' + escaped + '"';
+}
+
+/**
+ * @brief Copies the events of a ring, oldest first. Events the thread overwrote while they
+ * were being copied are left out.
+ */
+static QVector<Event> snapshot(Ring *ring)
+{
+    quint32 before = quint32(ring->written.loadAcquire());
+    quint32 available = ring->full ? quint32(ringCapacity) : qMin(before, quint32(ringCapacity));
+    QVector<Event> copy;
+    copy.reserve(int(available));
+    for(quint32 ii = before - available; ii != before; ii++){
+        copy.append(ring->events.at(int(ii & (ringCapacity - 1))));
+    }
+    quint32 overwritten = quint32(ring->written.loadAcquire()) - before;
+    copy.remove(0, int(qMin(overwritten, available)));
+    return copy;
+}
+
+/**
+ * @brief Gets the number of events a ring has overwritten
+ * @param ring The ring
+ * @return Events recorded beyond the capacity
+ */
+static qint64 overwrittenIn(Ring *ring)
+{
+    return ring->full ? qint64(quint32(ring->written.loadAcquire()) - quint32(ringCapacity)) : 0;
+}
+
+/**
+ * @brief Keeps the events of the finished thread for the export and hands its ring back. The
+ * oldest retired events go once there are more than maxRetiredEvents.
+ */
+RingHolder::~RingHolder()
+{
+    QMutexLocker locker(&ringLock);
+    Ring *ring = rings[index];
+    QVector<Event> events = snapshot(ring);
+    overwrittenEvents += overwrittenIn(ring);
+    if(!events.isEmpty()){
+        if(retiredThreads == 0){
+            retiredThreads = new QVector<RetiredThread>;
+        }
+        RetiredThread retired;
+        retired.threadName = ring->threadName;
+        retired.threadNumber = ring->threadNumber;
+        retired.events = events;
+        retiredThreads->append(retired);
+        retiredEventCount += events.size();
+
+        while(retiredEventCount > maxRetiredEvents){
+            QVector<Event> &oldest = (*retiredThreads)[0].events;
+            int excess = qMin(retiredEventCount - maxRetiredEvents, oldest.size());
+            oldest.remove(0, excess);
+            retiredEventCount -= excess;
+            discardedEvents += excess;
+            if(oldest.isEmpty()){
+                retiredThreads->remove(0);
+            }
+        }
+    }
+
+    ring->full = false;
+    ring->written.storeRelease(0);
+    ringInUse[index] = false;
+    freeRings[freeRingCount++] = index;
+}
+
+/**
+ * @brief Appends the name and the events of one thread to the trace, writing out what has
+ * been put together whenever it grows large
+ * @param file The trace file
+ * @param json The part of the trace not written yet
+ * @param separator Put in front of the first event, a comma after it
+ * @param pid The process id
+ * @param threadNumber The thread id in the trace
+ * @param threadName The name of the thread
+ * @param events The events, oldest first
+ */
+static void appendThread(QFile &file, QByteArray &json, QByteArray &separator, const QByteArray &pid,
+                         int threadNumber, const QString &threadName, const QVector<Event> &events)
+{
+    QByteArray tid = QByteArray::number(threadNumber);
+    json += separator + "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+            + ",\"args\":{\"name\":" + quoted(threadName) + "}}";
+    separator = ",\n";
+
+    foreach(const Event &event, events){
+        json += ",\n{\"name\":\"" + QByteArray(event.name) + "\",\"cat\":\"" + QByteArray(event.category)
+                + "\",\"ph\":\"X\",\"pid\":" + pid + ",\"tid\":" + tid
+                + ",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3)
+                + ",\"dur\":" + QByteArray::number((event.end - event.start) / 1000.0, 'f', 3) + "}";
+
+        // Written in pieces, a full trace is tens of megabytes
+        if(json.size() > (1 << 20)){
+            file.write(json);
+            json.clear();
+        }
+    }
+}
+
+/**
+ * @brief Writes the events of all threads in the Chrome trace event format: one complete
+ * ("X") event per scope with its start and duration in microseconds, and a name per thread.
+ * Threads that have finished are written first. The events that were lost are counted in
+ * otherData: overwritten in full rings, discarded from finished threads beyond the retained
+ * limit and never recorded by threads that found no free ring.
+ * @param fileName The JSON file to write
+ * @return The number of events written, -1 if the file could not be written
+ */
+int exportJson(const QString &fileName)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        return -1;
+    }
+
+    // Holding the lock keeps threads from handing back their rings while they're written
+    QMutexLocker locker(&ringLock);
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    QByteArray separator = "\n";
+    int eventCount = 0;
+    qint64 overwritten = overwrittenEvents;
+    if(retiredThreads != 0){
+        foreach(const RetiredThread &retired, *retiredThreads){
+            appendThread(file, json, separator, pid, retired.threadNumber, retired.threadName, retired.events);
+            eventCount += retired.events.size();
+        }
+    }
+    for(int index = 0; index < ringCount.load(); index++){
+        if(ringInUse[index]){
+            QVector<Event> events = snapshot(rings[index]);
+            appendThread(file, json, separator, pid, rings[index]->threadNumber, rings[index]->threadName, events);
+            eventCount += events.size();
+            overwritten += overwrittenIn(rings[index]);
+        }
+    }
+    json += "\n],\"otherData\":{\"overwrittenEvents\":\"" + QByteArray::number(overwritten)
+            + "\",\"discardedEvents\":\"" + QByteArray::number(discardedEvents)
+            + "\",\"unrecordedEvents\":\"" + QByteArray::number(unrecordedEvents.load()) + "\"}}\n";
+    file.write(json);
+    file.close();
+    return file.error() == QFile::NoError ? eventCount : -1;
+}
+}
+
+#endif // MAZESOLVER_TIMELINE
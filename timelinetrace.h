@@ -0,0 +1,67 @@
+#ifndef TIMELINETRACE_H
+#define TIMELINETRACE_H
+
+/**
+ * @brief Scoped timeline events for finding out where the time of a run goes: in the solver,
+ * in the event handlers, in the scene updates or in painting.
+ *
+ * TIMELINE_SCOPE(name, category) at the top of a block records the time from there to the end
+ * of the block. Every thread writes its events into a ring of its own, so recording takes two
+ * clock reads and no lock; once the ring is full the oldest events are overwritten. When a
+ * thread finishes, as idle pool threads do, its events are kept up to a limit and its ring goes
+ * to the next new thread, so the memory stays bounded however many threads come and go. The
+ * events are written in the Chrome trace event format, which chrome://tracing and Perfetto
+ * open, with the number of events that were lost on the way.
+ *
+ * Tracing is only compiled in with MAZESOLVER_TIMELINE defined (qmake CONFIG+=timeline).
+ * Otherwise the macros expand to nothing and none of this exists.
+ */
+
+#ifdef MAZESOLVER_TIMELINE
+
+#include <QString>
+
+namespace TimelineTrace {
+
+qint64 now(); ///< Nanoseconds since the first call, the clock of all events
+void record(const char *name, const char *category, qint64 startNs, qint64 endNs); ///< Appends a finished event to the ring of the calling thread
+void clear(); ///< Drops the events of all threads and the counts of lost events
+int exportJson(const QString &fileName); ///< Writes the events of all threads as a Chrome trace, returns the number of events or -1
+
+/// Records the time from its construction to its destruction
+class Scope
+{
+public:
+    Scope(const char *eventName, const char *eventCategory) : name(eventName), category(eventCategory), start(now()) {}
+    ~Scope() { record(name, category, start, now()); }
+
+private:
+    const char *name;
+    const char *category;
+    qint64 start;
+};
+
+/// Writes the events to a file when it goes out of scope
+class ExportOnExit
+{
+public:
+    explicit ExportOnExit(const QString &traceFileName) : fileName(traceFileName) {}
+    ~ExportOnExit() { if(!fileName.isEmpty()) exportJson(fileName); }
+
+private:
+    QString fileName;
+};
+
+}
+
+#define TIMELINE_CONCAT_(a, b) a##b
+#define TIMELINE_CONCAT(a, b) TIMELINE_CONCAT_(a, b)
+#define TIMELINE_SCOPE(name, category) TimelineTrace::Scope TIMELINE_CONCAT(timelineScope, __LINE__)(name, category)
+
+#else
+
+#define TIMELINE_SCOPE(name, category)
+
+#endif // MAZESOLVER_TIMELINE
+
+#endif // TIMELINETRACE_H